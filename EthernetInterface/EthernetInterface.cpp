@@ -83,10 +83,15 @@ static void set_mac_address(void) {
 }
 
 int EthernetInterface::init() {
+#if LWIP_DHCP
     use_dhcp = true;
     set_mac_address();
     init_netif(NULL, NULL, NULL);
     return 0;
+#else
+    // DHCP is disabled in lwipopts.h, a static address is required
+    return -1;
+#endif
 }
 
 int EthernetInterface::init(const char* ip, const char* mask, const char* gateway) {
@@ -109,7 +114,9 @@ int EthernetInterface::connect(unsigned int timeout_ms) {
 
     int inited;
     if (use_dhcp) {
+#if LWIP_DHCP
         dhcp_start(&netif);
+#endif
         
         // Wait for an IP Address
         // -1: error, 0: timeout
@@ -126,8 +133,10 @@ int EthernetInterface::connect(unsigned int timeout_ms) {
 
 int EthernetInterface::disconnect() {
     if (use_dhcp) {
+#if LWIP_DHCP
         dhcp_release(&netif);
         dhcp_stop(&netif);
+#endif
     } else {
         netif_set_down(&netif);
     }
@@ -79,9 +79,12 @@ extern "C"
 #define LPC_EMAC_RMII 1         /**< Use the RMII or MII driver variant .*/
 
 /** \brief  Defines the number of descriptors used for RX. This
- *          must be a minimum value of 2.
+ *          must be a minimum value of 2. It may be overridden in
+ *          lwipopts.h.
  */
+#ifndef LPC_NUM_BUFF_RXDESCS
 #define LPC_NUM_BUFF_RXDESCS 3
+#endif
 
 /** \brief  Defines the number of descriptors used for TX. Must
  *          be a minimum value of 2.
@@ -28,6 +28,7 @@
 #include "lwip/def.h"
 #include "lwip/sys.h"
 #include "lwip/mem.h"
+#include "lwip/stats.h"
 
  #if NO_SYS==1
 #include "cmsis.h"
@@ -136,7 +137,11 @@ void sys_mbox_post(sys_mbox_t *mbox, void *msg) {
  *---------------------------------------------------------------------------*/
 err_t sys_mbox_trypost(sys_mbox_t *mbox, void *msg) {
     osStatus status = osMessagePut(mbox->id, (uint32_t)msg, 0);
-    return (status == osOK) ? (ERR_OK) : (ERR_MEM);
+    if (status != osOK) {
+        SYS_STATS_INC(mbox.err);
+        return ERR_MEM;
+    }
+    return ERR_OK;
 }
 
 /*---------------------------------------------------------------------------*
@@ -45,7 +45,9 @@ typedef struct {
 } sys_mutex_t;
 
 // === MAIL BOX ===
+#ifndef MB_SIZE
 #define MB_SIZE      8
+#endif
 
 typedef struct {
     osMessageQId    id;
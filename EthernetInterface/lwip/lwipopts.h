@@ -21,6 +21,15 @@
 
 #include "lwipopts_conf.h"
 
+// Build profiles, selected from the Makefile:
+// - LWIP_PROFILE_UDP_ONLY (NET_PROFILE=udp): no TCP and no DHCP (static address),
+//   the receive path is sized from the heap, see below.
+// - LWIP_PROFILE_STATS (NET_STATS=1): collect lwIP statistics, exported by the
+//   network statistics LwM2M object.
+#ifdef LWIP_PROFILE_UDP_ONLY
+#define LWIP_TCP                    0
+#endif
+
 // Operating System 
 #define NO_SYS                      0
 
@@ -48,15 +57,33 @@
 // 32-bit alignment
 #define MEM_ALIGNMENT               4
 
-#define PBUF_POOL_SIZE              5
 #define MEMP_NUM_TCP_PCB_LISTEN     4
 #define MEMP_NUM_TCP_PCB            4
 #define MEMP_NUM_PBUF               8
+#ifdef LWIP_PROFILE_UDP_ONLY
+// The EMAC driver receives into 1536 bytes heap pbufs, which it does not trim:
+// a frame takes 1560 bytes of the heap (MEM_SIZE, all of AHBSRAM0) from its RX
+// descriptor until the application reads it, so the heap holds 10 frames.
+// 6 frames are kept in RX descriptors for the bursts, 3 may wait in the UDP
+// receive mailbox (one netbuf each) and the rest is left for the bounce buffer
+// of a datagram sent from main RAM.
+#define LPC_NUM_BUFF_RXDESCS        6
+#define MEMP_NUM_NETBUF             3
+// no pbuf of this port comes from the pool, SNMP and PPP being disabled:
+// 4 of its 1532 bytes buffers are left free in AHBSRAM1
+#define PBUF_POOL_SIZE              1
+#else
+#define PBUF_POOL_SIZE              5
+#endif
 
 #define TCP_QUEUE_OOSEQ             0
 #define TCP_OVERSIZE                0
 
+#ifdef LWIP_PROFILE_UDP_ONLY
+#define LWIP_DHCP                   0
+#else
 #define LWIP_DHCP                   1
+#endif
 #define LWIP_DNS                    1
 
 // Support Multicast
@@ -100,6 +127,12 @@
 #define MEMP_SANITY_CHECK           1
 #else
 #define LWIP_NOASSERT               1
+#endif
+
+#ifdef LWIP_PROFILE_STATS
+#define LWIP_STATS                  1
+#define LWIP_STATS_DISPLAY          0
+#elif !defined(LWIP_DEBUG)
 #define LWIP_STATS                  0
 #endif
 
@@ -106,6 +106,12 @@ void MMA7660::setSampleRate(int samplerate)
     setActive(active_old);                              //Restore previous active state
 }
 
+int MMA7660::getSampleRate( void )
+{
+    int rates[] = {120, 64, 32, 16, 8, 4, 2, 1};    //Same order as in setSampleRate
+    return rates[read(MMA7660_SR_R) & 0x07];
+}
+
 
 MMA7660::Orientation MMA7660::getSide( void )
 {
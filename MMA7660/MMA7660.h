@@ -147,6 +147,15 @@ public:
     */
     void setSampleRate(int samplerate);
 
+    /**
+    * Returns the active samplerate
+    *
+    * This is read from MMA7760s SR register, so it is the rate the device uses.
+    *
+    * @param return - samplerate in samples/second
+    */
+    int getSampleRate( void );
+
     /**
     * Returns if it is on its front, back, or unknown side
     *
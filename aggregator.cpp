@@ -0,0 +1,56 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - initial API and implementation
+ *******************************************************************************/
+
+#include "aggregator.h"
+
+#include <string.h>
+
+void aggregator_init(aggregator_t * aggP, uint32_t window) {
+    memset(aggP, 0, sizeof(aggregator_t));
+    aggP->window = window > 0 ? window : 1;
+}
+
+bool aggregator_add(aggregator_t * aggP, float sample) {
+    // min/max since last reset
+    if (aggP->total == 0 || sample < aggP->min)
+        aggP->min = sample;
+    if (aggP->total == 0 || sample > aggP->max)
+        aggP->max = sample;
+    aggP->total++;
+
+    // Welford's online mean and variance
+    aggP->count++;
+    float delta = sample - aggP->mean;
+    aggP->mean += delta / aggP->count;
+    aggP->m2 += delta * (sample - aggP->mean);
+
+    if (aggP->count < aggP->window)
+        return false;
+
+    // window completed: publish it and start a new one
+    aggP->windowMean = aggP->mean;
+    aggP->windowVariance = aggP->count > 1 ? aggP->m2 / (aggP->count - 1) : 0.0f;
+    aggP->count = 0;
+    aggP->mean = 0.0f;
+    aggP->m2 = 0.0f;
+    return true;
+}
+
+void aggregator_reset_min_max(aggregator_t * aggP) {
+    aggP->total = 0;
+    aggP->min = 0.0f;
+    aggP->max = 0.0f;
+}
@@ -0,0 +1,57 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - initial API and implementation
+ *******************************************************************************/
+
+#ifndef AGGREGATOR_H_
+#define AGGREGATOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Incremental statistics over a sensor stream, in constant memory.
+ *
+ * min and max are kept since the last reset (IPSO "Min/Max Measured Value").
+ * mean and variance are computed with Welford's algorithm over windows of
+ * 'window' samples; the values of the last completed window are exposed.
+ */
+typedef struct {
+    uint32_t window;        // number of samples per window
+    uint32_t total;         // samples since the last min/max reset
+    float    min;
+    float    max;
+    // running window
+    uint32_t count;
+    float    mean;
+    float    m2;            // sum of squares of differences from the mean
+    // last completed window
+    float    windowMean;
+    float    windowVariance;
+} aggregator_t;
+
+void aggregator_init(aggregator_t * aggP, uint32_t window);
+// add a sample, return true when it completes a window
+bool aggregator_add(aggregator_t * aggP, float sample);
+void aggregator_reset_min_max(aggregator_t * aggP);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AGGREGATOR_H_ */
@@ -17,9 +17,18 @@
 #include "mbed.h"
 #include "EthernetInterface.h"
 #include "C12832.h"
+#include "rtos.h"
+#include "udp_transport.h"
+
+// the I2C bus shared by the accelerometer and the temperature sensor
+Mutex i2c_mutex;
+
 #include "object_accelerometer.cpp"
 #include "object_rgb_led.cpp"
 #include "object_temperature.cpp"
+#if LWIP_STATS
+#include "object_net_stats.cpp"
+#endif
 #include "dbg.h"
 
 extern "C" {
@@ -40,6 +49,12 @@ extern char * get_server_uri(lwm2m_object_t * objectP, uint16_t serverID);
 #ifndef LOOP_TIMEOUT
 #define LOOP_TIMEOUT 1000 //ms
 #endif
+#if !LWIP_DHCP && !defined(IP_ADDRESS)
+#error "DHCP is disabled, IP_ADDRESS, NETMASK and GATEWAY must be defined"
+#endif
+#ifndef SESSION_FILE
+#define SESSION_FILE "/local/LWM2M.BIN" // 8.3 name on the mbed USB drive
+#endif
 #ifndef SERVER_URI
 #define SERVER_URI "coap://5.39.83.206:5683" // leshan sandbox : http://leshan.eclipse.org
 #endif
@@ -50,24 +65,26 @@ typedef struct session_t {
     char * host;
     int port;
     Endpoint ep;
+    ip_addr_t addr;
 } session_t;
 
 // the lcd screen
 C12832 lcd(p5, p7, p6, p8, p11);
 
-// the server UDP socket
-UDPSocket udp;
+// the flash drive of the mbed interface, keeps the session state across resets
+LocalFileSystem local("local");
 
 void ethSetup() {
     EthernetInterface eth;
+#if LWIP_DHCP
     eth.init(); // use DHCP
+#else
+    eth.init(IP_ADDRESS, NETMASK, GATEWAY);
+#endif
     eth.connect();
     INFO("IP Address is %s", eth.getIPAddress());
 
-    udp.init();
-    udp.bind(5683);
-
-    udp.set_blocking(false, LOOP_TIMEOUT);
+    udp_transport_open(5683);
 }
 
 // globals for accessing configuration
@@ -128,7 +145,9 @@ static void * prv_connect_server(uint16_t serverID, void * userData) {
         sessionP->port = port;
         sessionP->host = strdup(host);
         sessionP->next = sessionList;
+        // resolve the host once, packets are then matched on the address
         sessionP->ep.set_address(sessionP->host, port);
+        ipaddr_aton(sessionP->ep.get_address(), &sessionP->addr);
 
         sessionList = sessionP;
         INFO("Lwm2m session created");
@@ -150,7 +169,7 @@ static uint8_t prv_buffer_send(void * sessionH, uint8_t * buffer, size_t length,
     }
 
     INFO("Sending %u bytes to %s", length, session->ep.get_address());
-    int err = udp.sendTo(session->ep, (char*) buffer, length);
+    int err = udp_transport_send(&session->addr, session->port, buffer, length);
     if (err < 0) {
         ERR("Failed sending %u bytes to %s, error %d", length, session->ep.get_address(), err);
         return COAP_500_INTERNAL_SERVER_ERROR ;
@@ -158,6 +177,69 @@ static uint8_t prv_buffer_send(void * sessionH, uint8_t * buffer, size_t length,
     return COAP_NO_ERROR ;
 }
 
+/* provide a pbuf to serialize a message in, the session is resolved at send time */
+static uint8_t * prv_buffer_alloc(void * sessionH, size_t length, void ** handleP, void * userdata) {
+    struct pbuf * p = udp_transport_alloc(length);
+    if (p == NULL) {
+        ERR("Failed allocating %u bytes transmit buffer", length);
+        return NULL;
+    }
+    *handleP = p;
+    return (uint8_t *) p->payload;
+}
+
+/* send a serialized pbuf for a given session, the pbuf is released in any case */
+static uint8_t prv_handle_send(void * sessionH, void * handle, size_t length, void * userdata) {
+    struct pbuf * p = (struct pbuf *) handle;
+    session_t * session = (session_t*) sessionH;
+
+    if (session == NULL || length == 0) {
+        pbuf_free(p);
+        return COAP_500_INTERNAL_SERVER_ERROR ;
+    }
+
+    // the payload was allocated for the largest message, shrink it to the serialized length
+    pbuf_realloc(p, length);
+    INFO("Sending %u bytes to %s", length, session->ep.get_address());
+    if (udp_transport_send_pbuf(&session->addr, session->port, p) < 0) {
+        ERR("Failed sending %u bytes to %s", length, session->ep.get_address());
+        return COAP_500_INTERNAL_SERVER_ERROR ;
+    }
+    return COAP_NO_ERROR ;
+}
+
+/* save the session state, a new file replaces the previous one */
+static bool prv_store_session(uint8_t * buffer, size_t length, void * userdata) {
+    FILE * file = fopen(SESSION_FILE, "wb");
+    if (file == NULL) {
+        ERR("Failed opening %s", SESSION_FILE);
+        return false;
+    }
+    size_t written = fwrite(buffer, 1, length, file);
+    fclose(file);
+    if (written != length) {
+        ERR("Failed saving %u bytes of session state", length);
+        return false;
+    }
+    return true;
+}
+
+/* load the session state saved before the reset */
+static size_t prv_load_session(uint8_t * buffer, size_t length, void * userdata) {
+    FILE * file = fopen(SESSION_FILE, "rb");
+    if (file == NULL) {
+        INFO("No session state to restore");
+        return 0;
+    }
+    size_t loaded = fread(buffer, 1, length, file);
+    // a larger file was not written by this client
+    if (fgetc(file) != EOF) {
+        loaded = 0;
+    }
+    fclose(file);
+    return loaded;
+}
+
 int main() {
     INFO("Start");
     lcd.cls();
@@ -169,7 +251,9 @@ int main() {
 
     INFO("Initializing Wakaama");
     // create objects
-    lwm2m_object_t * objArray[7];
+    lwm2m_object_t * objArray[8];
+    int objCount = 7;
+    lwm2m_object_t * accelerometerObj;
     objArray[0] = get_security_object(123, SERVER_URI, false);
     securityObjP = objArray[0];
     objArray[1] = get_server_object(123, "U", 40, false);
@@ -177,8 +261,12 @@ int main() {
     objArray[2] = get_object_device();
     objArray[3] = get_object_firmware();
     objArray[4] = get_object_accelerometer();
+    accelerometerObj = objArray[4];
     objArray[5] = get_object_rgb_led();
     objArray[6] = get_object_temperature();
+#if LWIP_STATS
+    objArray[objCount++] = get_object_net_stats();
+#endif
 
     // initialize Wakaama library with the functions that will be in
     // charge of communication
@@ -187,15 +275,45 @@ int main() {
         ERR("Wakaama initialization failed");
         return -1;
     }
+    // responses are serialized directly in lwIP buffers
+    lwm2m_set_transmit_callbacks(lwm2mH, prv_buffer_alloc, prv_handle_send);
+    // registrations and observations are resumed after a reset
+    lwm2m_set_persistence_callbacks(lwm2mH, prv_store_session, prv_load_session, NULL);
 
     // configure wakaama
     int result;
-    result = lwm2m_configure(lwm2mH, ENDPOINT_NAME, NULL, NULL, 7, objArray);
+    result = lwm2m_configure(lwm2mH, ENDPOINT_NAME, NULL, NULL, objCount, objArray);
     if (result != 0) {
         ERR("Wakaama configuration failed: 0x%X", result);
         return -1;
     }
 
+    // resolve once the URIs notified from the main loop
+    lwm2m_uri_t accelerometer_URI = LWM2M_URI_OBJECT(3313);
+    lwm2m_uri_t samples_URI = LWM2M_URI_RESOURCE(3313, 0, 6001);
+    lwm2m_uri_t accelerometer_mean_URI = LWM2M_URI_RESOURCE(3313, 0, 6003);
+    lwm2m_uri_t accelerometer_variance_URI = LWM2M_URI_RESOURCE(3313, 0, 6004);
+    lwm2m_uri_t temperature_URI = LWM2M_URI_RESOURCE(3303, 0, 5700);
+    lwm2m_uri_t temperature_mean_URI = LWM2M_URI_RESOURCE(3303, 0, 6003);
+    lwm2m_uri_t temperature_variance_URI = LWM2M_URI_RESOURCE(3303, 0, 6004);
+    lwm2m_uri_t device_time_URI = LWM2M_URI_RESOURCE(3, 0, 13);
+    lwm2m_uri_t switch_light_URI = LWM2M_URI_RESOURCE(3311, 0, 5850);
+    lwm2m_uri_handle_t * accelerometerH = lwm2m_uri_handle_new(lwm2mH, &accelerometer_URI);
+    lwm2m_uri_handle_t * samplesH = lwm2m_uri_handle_new(lwm2mH, &samples_URI);
+    lwm2m_uri_handle_t * accelerometerMeanH = lwm2m_uri_handle_new(lwm2mH, &accelerometer_mean_URI);
+    lwm2m_uri_handle_t * accelerometerVarianceH = lwm2m_uri_handle_new(lwm2mH, &accelerometer_variance_URI);
+    lwm2m_uri_handle_t * temperatureH = lwm2m_uri_handle_new(lwm2mH, &temperature_URI);
+    lwm2m_uri_handle_t * temperatureMeanH = lwm2m_uri_handle_new(lwm2mH, &temperature_mean_URI);
+    lwm2m_uri_handle_t * temperatureVarianceH = lwm2m_uri_handle_new(lwm2mH, &temperature_variance_URI);
+    lwm2m_uri_handle_t * deviceTimeH = lwm2m_uri_handle_new(lwm2mH, &device_time_URI);
+    lwm2m_uri_handle_t * switchLightH = lwm2m_uri_handle_new(lwm2mH, &switch_light_URI);
+    if (NULL == accelerometerH || NULL == samplesH || NULL == accelerometerMeanH || NULL == accelerometerVarianceH
+            || NULL == temperatureH || NULL == temperatureMeanH || NULL == temperatureVarianceH || NULL == deviceTimeH
+            || NULL == switchLightH) {
+        ERR("Wakaama URI handles allocation failed");
+        return -1;
+    }
+
     // start Wakaama
     result = lwm2m_start(lwm2mH);
     if (result != 0) {
@@ -230,40 +348,43 @@ int main() {
             INFO("Wakaama step failed : error 0x%X", result);
         }
 
-        // read on socket
-        char buffer[1024];
-        Endpoint server;
-        int n = udp.receiveFrom(server, buffer, sizeof(buffer));
-        if (n > 0) {
-            INFO("Received packet from: %s of size %d", server.get_address(), n);
+        // wait for a datagram, it is parsed in place from the received pbuf
+        udp_transport_packet_t packet;
+        if (udp_transport_receive(&packet, LOOP_TIMEOUT)) {
+            INFO("Received packet from: %s of size %u", ipaddr_ntoa(&packet.addr), packet.length);
             INFO("Search corresponding session...");
             session_t * session = sessionList;
             while (session != NULL) {
-                if (strcmp(session->host, server.get_address()) == 0) {
+                if (ip_addr_cmp(&session->addr, &packet.addr)) {
                     INFO("Session found, handle packet");
-                    lwm2m_handle_packet(lwm2mH, (uint8_t*) buffer, n, (void*) session);
+                    lwm2m_handle_packet(lwm2mH, packet.data, packet.length, (void*) session);
                     break;
                 }
+                session = session->next;
             }
             if (session == NULL)
                 INFO("No Session found, ignore packet");
+            udp_transport_release(&packet);
         }else{
             INFO("Fire object accelerometer, temperature and time changed");
-            lwm2m_uri_t accelerometer_URI;
-            lwm2m_stringToUri("/3313",5, &accelerometer_URI);
-            lwm2m_resource_value_changed(lwm2mH, &accelerometer_URI);
+            lwm2m_handle_value_changed(lwm2mH, accelerometerH);
+
+            // a full buffer of samples is also a completed statistics window
+            if (accelerometer_batch_ready(accelerometerObj)) {
+                lwm2m_handle_value_changed(lwm2mH, samplesH);
+                lwm2m_handle_value_changed(lwm2mH, accelerometerMeanH);
+                lwm2m_handle_value_changed(lwm2mH, accelerometerVarianceH);
+            }
 
-            lwm2m_uri_t temperature_URI;
-            lwm2m_stringToUri("/3303/0/5700",12, &temperature_URI);
-            lwm2m_resource_value_changed(lwm2mH, &temperature_URI);
+            lwm2m_handle_value_changed(lwm2mH, temperatureH);
 
-            lwm2m_uri_t device_time_URI;
-            lwm2m_stringToUri("/3/0/13",7, &device_time_URI);
-            lwm2m_resource_value_changed(lwm2mH, &device_time_URI);
+            if (temperature_window_done()) {
+                lwm2m_handle_value_changed(lwm2mH, temperatureMeanH);
+                lwm2m_handle_value_changed(lwm2mH, temperatureVarianceH);
+            }
 
-            lwm2m_uri_t switch_light_URI;
-            lwm2m_stringToUri("/3311/0/5850",12, &switch_light_URI);
-            lwm2m_resource_value_changed(lwm2mH, &switch_light_URI);
+            lwm2m_handle_value_changed(lwm2mH, deviceTimeH);
+            lwm2m_handle_value_changed(lwm2mH, switchLightH);
         }
     }
 }
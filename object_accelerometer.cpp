@@ -22,7 +22,9 @@
 #include <ctype.h>
 
 #include "mbed.h"
+#include "rtos.h"
 #include "MMA7660.h"
+#include "aggregator.h"
 
 MMA7660 MMA(p28, p27);
 
@@ -30,22 +32,99 @@ MMA7660 MMA(p28, p27);
 #define PRV_MAX_RANGE_VALUE              1.0f
 #define PRV_ACCELEROMETER_SENSOR_UNITS   "g"
 
+// time-series buffer: number of X-Y-Z samples kept and default sampling rate (Hz)
+#define PRV_SAMPLE_CAPACITY              100
+#define PRV_DEFAULT_SAMPLE_RATE          32
+#define PRV_MAX_SAMPLE_RATE              120
+
 #define LWM2M_ACCELEROMETER_OBJECT_ID   3313
 
 // Resource Id's:
+#define RES_MIN_MEASURED_VALUE  5601 // per axis, resource instances 0-1-2 are X-Y-Z
+#define RES_MAX_MEASURED_VALUE  5602 // per axis
 #define RES_MIN_RANGE_VALUE 5603
 #define RES_MAX_RANCE_VALUE 5604
 #define RES_SENSOR_UNITS    5701
 #define RES_X_VALUE         5702
 #define RES_Y_VALUE         5703
 #define RES_Z_VALUE         5704
+#define RES_RESET_MIN_MAX   5605
+// Custom resources (not defined by IPSO):
+#define RES_SAMPLES         6001 // opaque, raw X-Y-Z int8 triplets (1/21.33 g), oldest first
+#define RES_SAMPLE_RATE     6002 // integer, sampling rate in Hz (1 to 120)
+#define RES_MEAN_VALUE      6003 // per axis, mean of the last completed window
+#define RES_VARIANCE_VALUE  6004 // per axis, variance of the last completed window
 
 typedef struct {
     float previous_x;
     float previous_y;
     float previous_z;
+    // sampling rate of the time-series buffer
+    int sample_rate;
+    // ring buffer of raw samples, written by the sampler timer
+    int8_t samples[PRV_SAMPLE_CAPACITY * 3];
+    uint16_t head;  // slot of the next sample
+    uint16_t count; // number of valid samples
+    uint16_t fresh; // samples acquired since the last batch notification
+    // statistics in g per axis, a window is the capacity of the ring buffer
+    aggregator_t stats[3];
 } accelometer_data_t;
 
+// periodic timer feeding the time-series buffer
+RtosTimer * sampler;
+
+// called from the timer thread, must hold the I2C bus while reading the sensor
+static void prv_sample(void const * argument) {
+    accelometer_data_t * data = (accelometer_data_t *) argument;
+    int raw[3];
+
+    i2c_mutex.lock();
+    MMA.readData(raw);
+
+    int8_t * slot = data->samples + data->head * 3;
+    slot[0] = raw[0];
+    slot[1] = raw[1];
+    slot[2] = raw[2];
+    data->head = (data->head + 1) % PRV_SAMPLE_CAPACITY;
+    if (data->count < PRV_SAMPLE_CAPACITY)
+        data->count++;
+    if (data->fresh < PRV_SAMPLE_CAPACITY)
+        data->fresh++;
+    for (int i = 0; i < 3; i++) {
+        aggregator_add(data->stats + i, raw[i] / MMA7660_SENSITIVITY);
+    }
+    i2c_mutex.unlock();
+}
+
+// the sensor rounds the rate to one it supports, the one it took is reported and paces the timer
+static void prv_set_sample_rate(accelometer_data_t * data, int rate) {
+    sampler->stop();
+    i2c_mutex.lock();
+    MMA.setSampleRate(rate);
+    data->sample_rate = MMA.getSampleRate();
+    i2c_mutex.unlock();
+    sampler->start(1000 / data->sample_rate);
+}
+
+// copy the ring buffer content, oldest sample first
+static uint8_t * prv_copy_samples(accelometer_data_t * data, size_t * lengthP) {
+    size_t length = data->count * 3;
+    uint8_t * buffer = (uint8_t *) lwm2m_malloc(length > 0 ? length : 1);
+    if (buffer == NULL)
+        return NULL;
+
+    size_t oldest = (data->head + PRV_SAMPLE_CAPACITY - data->count) % PRV_SAMPLE_CAPACITY;
+    size_t first = (PRV_SAMPLE_CAPACITY - oldest) * 3;
+    if (first >= length) {
+        memcpy(buffer, data->samples + oldest * 3, length);
+    } else {
+        memcpy(buffer, data->samples + oldest * 3, first);
+        memcpy(buffer + first, data->samples, length - first);
+    }
+    *lengthP = length;
+    return buffer;
+}
+
 static float round(float v) {
     float r = v * 10.0f;
     r = (r > (floor(r) + 0.5f)) ? ceil(r) : floor(r);
@@ -53,109 +132,149 @@ static float round(float v) {
     return r;
 }
 
-static uint8_t prv_set_value(lwm2m_tlv_t * tlvP, accelometer_data_t * devDataP) {
-    // a simple switch structure is used to respond at the specified resource asked
-    switch (tlvP->id) {
-    case RES_MIN_RANGE_VALUE:
-        lwm2m_tlv_encode_float(PRV_MIN_RANGE_VALUE, tlvP);
-        tlvP->type = LWM2M_TYPE_RESOURCE;
-        return COAP_205_CONTENT ;
-
-    case RES_MAX_RANCE_VALUE:
-        lwm2m_tlv_encode_float(PRV_MAX_RANGE_VALUE, tlvP);
-        tlvP->type = LWM2M_TYPE_RESOURCE;
-        return COAP_205_CONTENT ;
+// encode one float per axis as a multiple resource
+static uint8_t prv_set_axes(lwm2m_tlv_t * tlvP, float x, float y, float z) {
+    float values[3] = { x, y, z };
+    lwm2m_tlv_t * subTlvP = lwm2m_tlv_new(3);
+    if (subTlvP == NULL)
+        return COAP_500_INTERNAL_SERVER_ERROR ;
+
+    for (int i = 0; i < 3; i++) {
+        subTlvP[i].type = LWM2M_TYPE_RESOURCE_INSTANCE;
+        subTlvP[i].id = i;
+        lwm2m_tlv_encode_float(values[i], subTlvP + i);
+        if (0 == subTlvP[i].length) {
+            lwm2m_tlv_free(3, subTlvP);
+            return COAP_500_INTERNAL_SERVER_ERROR ;
+        }
+    }
+    lwm2m_tlv_include(subTlvP, 3, tlvP);
+    return COAP_205_CONTENT ;
+}
 
-    case RES_SENSOR_UNITS:
-        tlvP->value = (uint8_t*) PRV_ACCELEROMETER_SENSOR_UNITS;
-        tlvP->length = strlen(PRV_ACCELEROMETER_SENSOR_UNITS);
-        tlvP->flags = LWM2M_TLV_FLAG_STATIC_DATA;
-        tlvP->type = LWM2M_TYPE_RESOURCE;
-        tlvP->dataType = LWM2M_TYPE_STRING;
-        return COAP_205_CONTENT ;
+// the sampler shares the I2C bus and the ring buffer, the callbacks hold i2c_mutex
+static uint8_t prv_read_axis(uint16_t instanceId, lwm2m_tlv_t * tlvP, lwm2m_object_t * objectP) {
+    uint8_t result = COAP_205_CONTENT;
 
-    case RES_X_VALUE:
-        if (MMA.testConnection()) {
+    i2c_mutex.lock();
+    if (MMA.testConnection()) {
+        switch (tlvP->id) {
+        case RES_X_VALUE:
             lwm2m_tlv_encode_float(round(MMA.x()), tlvP);
-            tlvP->type = LWM2M_TYPE_RESOURCE;
-            if (0 != tlvP->length)
-                return COAP_205_CONTENT ;
-            else
-                return COAP_500_INTERNAL_SERVER_ERROR ;
-        } else {
-            return COAP_503_SERVICE_UNAVAILABLE ;
-        }
-
-    case RES_Y_VALUE:
-        if (MMA.testConnection()) {
+            break;
+        case RES_Y_VALUE:
             lwm2m_tlv_encode_float(round(MMA.y()), tlvP);
-            tlvP->type = LWM2M_TYPE_RESOURCE;
-            if (0 != tlvP->length)
-                return COAP_205_CONTENT ;
-            else
-                return COAP_500_INTERNAL_SERVER_ERROR ;
-        } else {
-            return COAP_503_SERVICE_UNAVAILABLE ;
-        }
-
-    case RES_Z_VALUE:
-        if (MMA.testConnection()) {
+            break;
+        default:
             lwm2m_tlv_encode_float(round(MMA.z()), tlvP);
-            tlvP->type = LWM2M_TYPE_RESOURCE;
-            if (0 != tlvP->length)
-                return COAP_205_CONTENT ;
-            else
-                return COAP_500_INTERNAL_SERVER_ERROR ;
-        } else {
-            return COAP_503_SERVICE_UNAVAILABLE ;
+            break;
         }
+        if (0 == tlvP->length)
+            result = COAP_500_INTERNAL_SERVER_ERROR;
+    } else {
+        result = COAP_503_SERVICE_UNAVAILABLE;
+    }
+    i2c_mutex.unlock();
 
-    default:
-        return COAP_404_NOT_FOUND ;
+    return result;
+}
+
+static uint8_t prv_read_statistics(uint16_t instanceId, lwm2m_tlv_t * tlvP, lwm2m_object_t * objectP) {
+    aggregator_t * stats = ((accelometer_data_t *) objectP->userData)->stats;
+    float values[3];
+
+    i2c_mutex.lock();
+    for (int i = 0; i < 3; i++) {
+        switch (tlvP->id) {
+        case RES_MIN_MEASURED_VALUE:
+            values[i] = stats[i].min;
+            break;
+        case RES_MAX_MEASURED_VALUE:
+            values[i] = stats[i].max;
+            break;
+        case RES_MEAN_VALUE:
+            values[i] = stats[i].windowMean;
+            break;
+        default:
+            values[i] = stats[i].windowVariance;
+            break;
+        }
     }
+    i2c_mutex.unlock();
+
+    return prv_set_axes(tlvP, values[0], values[1], values[2]);
 }
 
-static uint8_t prv_accelerometer_read(uint16_t instanceId, int * numDataP, lwm2m_tlv_t ** dataArrayP,
-        lwm2m_object_t * objectP) {
-    uint8_t result;
-    int i;
+static uint8_t prv_read_samples(uint16_t instanceId, lwm2m_tlv_t * tlvP, lwm2m_object_t * objectP) {
+    size_t length = 0;
 
-    // this is a single instance object
-    if (instanceId != 0) {
-        return COAP_404_NOT_FOUND ;
-    }
+    i2c_mutex.lock();
+    uint8_t * buffer = prv_copy_samples((accelometer_data_t *) objectP->userData, &length);
+    i2c_mutex.unlock();
+    if (buffer == NULL)
+        return COAP_500_INTERNAL_SERVER_ERROR ;
 
-    // is the server asking for the full object ?
-    if (*numDataP == 0) {
+    tlvP->value = buffer;
+    tlvP->length = length;
+    tlvP->flags &= ~LWM2M_TLV_FLAG_STATIC_DATA;
+    tlvP->dataType = LWM2M_TYPE_OPAQUE;
+    return COAP_205_CONTENT ;
+}
 
-        uint16_t resList[] = {
-        RES_MIN_RANGE_VALUE,
-        RES_MAX_RANCE_VALUE,
-        RES_SENSOR_UNITS,
-        RES_X_VALUE,
-        RES_Y_VALUE,
-        RES_Z_VALUE };
-        int nbRes = sizeof(resList) / sizeof(uint16_t);
+static uint8_t prv_read_sample_rate(uint16_t instanceId, lwm2m_tlv_t * tlvP, lwm2m_object_t * objectP) {
+    lwm2m_tlv_encode_int(((accelometer_data_t *) objectP->userData)->sample_rate, tlvP);
+    if (0 != tlvP->length)
+        return COAP_205_CONTENT ;
+    else
+        return COAP_500_INTERNAL_SERVER_ERROR ;
+}
 
-        *dataArrayP = lwm2m_tlv_new(nbRes);
-        if (*dataArrayP == NULL)
-            return COAP_500_INTERNAL_SERVER_ERROR ;
-        *numDataP = nbRes;
-        for (i = 0; i < nbRes; i++) {
-            (*dataArrayP)[i].id = resList[i];
-        }
-    }
+static uint8_t prv_write_sample_rate(uint16_t instanceId, lwm2m_tlv_t * tlvP, lwm2m_object_t * objectP) {
+    int64_t rate;
 
-    i = 0;
-    do {
-        result = prv_set_value((*dataArrayP) + i, (accelometer_data_t*) (objectP->userData));
-        i++;
-    } while (i < *numDataP && result == COAP_205_CONTENT );
+    if (1 != lwm2m_tlv_decode_int(tlvP, &rate) || rate < 1 || rate > PRV_MAX_SAMPLE_RATE)
+        return COAP_400_BAD_REQUEST ;
 
-    return result;
+    prv_set_sample_rate((accelometer_data_t *) objectP->userData, (int) rate);
+    return COAP_204_CHANGED ;
+}
+
+static uint8_t prv_reset_min_max(uint16_t instanceId, uint16_t resourceId, uint8_t * buffer, int length,
+        lwm2m_object_t * objectP) {
+    accelometer_data_t * data = (accelometer_data_t *) objectP->userData;
+
+    i2c_mutex.lock();
+    for (int i = 0; i < 3; i++) {
+        aggregator_reset_min_max(data->stats + i);
+    }
+    i2c_mutex.unlock();
+    return COAP_204_CHANGED ;
 }
 
+// sorted by resource id
+static const lwm2m_resource_desc_t prv_accelerometer_resources[] = {
+    LWM2M_RESOURCE(RES_MIN_MEASURED_VALUE, LWM2M_TYPE_FLOAT, LWM2M_RES_READ | LWM2M_RES_MULTIPLE, prv_read_statistics, NULL),
+    LWM2M_RESOURCE(RES_MAX_MEASURED_VALUE, LWM2M_TYPE_FLOAT, LWM2M_RES_READ | LWM2M_RES_MULTIPLE, prv_read_statistics, NULL),
+    LWM2M_RESOURCE_STATIC_FLOAT(RES_MIN_RANGE_VALUE, PRV_MIN_RANGE_VALUE),
+    LWM2M_RESOURCE_STATIC_FLOAT(RES_MAX_RANCE_VALUE, PRV_MAX_RANGE_VALUE),
+    LWM2M_RESOURCE_EXECUTE(RES_RESET_MIN_MAX, prv_reset_min_max),
+    LWM2M_RESOURCE_STATIC_STRING(RES_SENSOR_UNITS, PRV_ACCELEROMETER_SENSOR_UNITS),
+    LWM2M_RESOURCE(RES_X_VALUE, LWM2M_TYPE_FLOAT, LWM2M_RES_READ, prv_read_axis, NULL),
+    LWM2M_RESOURCE(RES_Y_VALUE, LWM2M_TYPE_FLOAT, LWM2M_RES_READ, prv_read_axis, NULL),
+    LWM2M_RESOURCE(RES_Z_VALUE, LWM2M_TYPE_FLOAT, LWM2M_RES_READ, prv_read_axis, NULL),
+    LWM2M_RESOURCE(RES_SAMPLES, LWM2M_TYPE_OPAQUE, LWM2M_RES_READ, prv_read_samples, NULL),
+    LWM2M_RESOURCE(RES_SAMPLE_RATE, LWM2M_TYPE_INTEGER, LWM2M_RES_READ | LWM2M_RES_WRITE, prv_read_sample_rate,
+            prv_write_sample_rate),
+    LWM2M_RESOURCE(RES_MEAN_VALUE, LWM2M_TYPE_FLOAT, LWM2M_RES_READ | LWM2M_RES_MULTIPLE, prv_read_statistics, NULL),
+    LWM2M_RESOURCE(RES_VARIANCE_VALUE, LWM2M_TYPE_FLOAT, LWM2M_RES_READ | LWM2M_RES_MULTIPLE, prv_read_statistics, NULL)
+};
+
 static void prv_accelerometer_close(lwm2m_object_t * objectP) {
+    if (NULL != sampler) {
+        sampler->stop();
+        delete sampler;
+        sampler = NULL;
+    }
     if (NULL != objectP->userData) {
         lwm2m_free(objectP->userData);
         objectP->userData = NULL;
@@ -207,13 +326,9 @@ lwm2m_object_t * get_object_accelerometer() {
         }
 
         /*
-         * And the private function that will access the object.
-         * Those function will be called when a read/write/execute query is made by the server. In fact the library don't need to
-         * know the resources of the object, only the server does.
+         * The library dispatches the read/write/execute queries made by the server on the resource table.
          */
-        accelerometerObj->readFunc = prv_accelerometer_read;
-        accelerometerObj->writeFunc = NULL;
-        accelerometerObj->executeFunc = NULL;
+        lwm2m_object_set_resources(accelerometerObj, prv_accelerometer_resources);
         accelerometerObj->closeFunc = prv_accelerometer_close;
         accelerometerObj->userData = lwm2m_malloc(sizeof(accelometer_data_t));
 
@@ -224,6 +339,18 @@ lwm2m_object_t * get_object_accelerometer() {
             ((accelometer_data_t*) accelerometerObj->userData)->previous_x = -1;
             ((accelometer_data_t*) accelerometerObj->userData)->previous_y = -1;
             ((accelometer_data_t*) accelerometerObj->userData)->previous_z = -1;
+            ((accelometer_data_t*) accelerometerObj->userData)->head = 0;
+            ((accelometer_data_t*) accelerometerObj->userData)->count = 0;
+            ((accelometer_data_t*) accelerometerObj->userData)->fresh = 0;
+            for (int i = 0; i < 3; i++) {
+                aggregator_init(((accelometer_data_t*) accelerometerObj->userData)->stats + i, PRV_SAMPLE_CAPACITY);
+            }
+
+            /*
+             * Start to fill the time-series buffer
+             */
+            sampler = new RtosTimer(prv_sample, osTimerPeriodic, accelerometerObj->userData);
+            prv_set_sample_rate((accelometer_data_t*) accelerometerObj->userData, PRV_DEFAULT_SAMPLE_RATE);
         } else {
             lwm2m_free(accelerometerObj);
             accelerometerObj = NULL;
@@ -232,3 +359,21 @@ lwm2m_object_t * get_object_accelerometer() {
 
     return accelerometerObj;
 }
+
+// return true once a full window of new samples is buffered, the caller is expected to notify observers
+bool accelerometer_batch_ready(lwm2m_object_t * object) {
+    accelometer_data_t * data = (accelometer_data_t *) object->userData;
+    bool ready = false;
+
+    if (NULL == data)
+        return false;
+
+    i2c_mutex.lock();
+    if (data->fresh >= PRV_SAMPLE_CAPACITY) {
+        data->fresh = 0;
+        ready = true;
+    }
+    i2c_mutex.unlock();
+
+    return ready;
+}
@@ -0,0 +1,216 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - initial API and implementation
+ *******************************************************************************/
+
+/*
+ * Network statistics object, only built when lwIP statistics are enabled
+ * (make NET_STATS=1).
+ *
+ * Pool resources are multiple resources, one resource instance per lwIP memp
+ * pool in memp_std.h order, followed by the heap (mem.c). Counters are read
+ * without locking the tcpip thread, a value may be one update behind.
+ */
+
+#include "liblwm2m.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "mbed.h"
+#include "dbg.h"
+#include "lwip/stats.h"
+#include "lwip/memp.h"
+
+#define LWM2M_NET_STATS_OBJECT_ID   10250 // vendor specific range
+
+// Resource Id's:
+#define RES_NET_POOL_NAME           0 // string, per pool
+#define RES_NET_POOL_SIZE           1 // integer, per pool, number of elements (bytes for the heap)
+#define RES_NET_POOL_USED           2 // integer, per pool
+#define RES_NET_POOL_MAX_USED       3 // integer, per pool, high-water mark
+#define RES_NET_POOL_ERRORS         4 // integer, per pool, allocation failures
+#define RES_NET_LINK_DROPS          5 // integer, frames dropped by the ethernet driver
+#define RES_NET_IP_DROPS            6 // integer
+#define RES_NET_UDP_DROPS           7 // integer
+#define RES_NET_MBOX_ERRORS         8 // integer, messages dropped on a full mailbox (e.g. UDP receive)
+
+// the heap is exposed after the memp pools
+#define PRV_NET_POOL_COUNT          (MEMP_MAX + 1)
+
+static const char * const prv_net_pool_names[PRV_NET_POOL_COUNT] = {
+#define LWIP_MEMPOOL(name,num,size,desc) desc,
+#include "lwip/memp_std.h"
+        "HEAP" };
+
+static const struct stats_mem * prv_net_pool_stats(int pool) {
+    if (pool < MEMP_MAX)
+        return lwip_stats.memp + pool;
+    return &lwip_stats.mem;
+}
+
+static uint8_t prv_net_set_pools(lwm2m_tlv_t * tlvP) {
+    lwm2m_tlv_t * subTlvP = lwm2m_tlv_new(PRV_NET_POOL_COUNT);
+    if (subTlvP == NULL)
+        return COAP_500_INTERNAL_SERVER_ERROR ;
+
+    for (int i = 0; i < PRV_NET_POOL_COUNT; i++) {
+        const struct stats_mem * stats = prv_net_pool_stats(i);
+
+        subTlvP[i].type = LWM2M_TYPE_RESOURCE_INSTANCE;
+        subTlvP[i].id = i;
+        switch (tlvP->id) {
+        case RES_NET_POOL_NAME:
+            subTlvP[i].value = (uint8_t*) prv_net_pool_names[i];
+            subTlvP[i].length = strlen(prv_net_pool_names[i]);
+            subTlvP[i].flags = LWM2M_TLV_FLAG_STATIC_DATA;
+            subTlvP[i].dataType = LWM2M_TYPE_STRING;
+            break;
+        case RES_NET_POOL_SIZE:
+            lwm2m_tlv_encode_int(stats->avail, subTlvP + i);
+            break;
+        case RES_NET_POOL_USED:
+            lwm2m_tlv_encode_int(stats->used, subTlvP + i);
+            break;
+        case RES_NET_POOL_MAX_USED:
+            lwm2m_tlv_encode_int(stats->max, subTlvP + i);
+            break;
+        default:
+            lwm2m_tlv_encode_int(stats->err, subTlvP + i);
+            break;
+        }
+        if (0 == subTlvP[i].length) {
+            lwm2m_tlv_free(PRV_NET_POOL_COUNT, subTlvP);
+            return COAP_500_INTERNAL_SERVER_ERROR ;
+        }
+    }
+    lwm2m_tlv_include(subTlvP, PRV_NET_POOL_COUNT, tlvP);
+    return COAP_205_CONTENT ;
+}
+
+static uint8_t prv_net_set_value(lwm2m_tlv_t * tlvP) {
+    // a simple switch structure is used to respond at the specified resource asked
+    switch (tlvP->id) {
+    case RES_NET_POOL_NAME:
+    case RES_NET_POOL_SIZE:
+    case RES_NET_POOL_USED:
+    case RES_NET_POOL_MAX_USED:
+    case RES_NET_POOL_ERRORS:
+        return prv_net_set_pools(tlvP);
+
+    case RES_NET_LINK_DROPS:
+        lwm2m_tlv_encode_int(lwip_stats.link.drop, tlvP);
+        tlvP->type = LWM2M_TYPE_RESOURCE;
+        return COAP_205_CONTENT ;
+
+    case RES_NET_IP_DROPS:
+        lwm2m_tlv_encode_int(lwip_stats.ip.drop, tlvP);
+        tlvP->type = LWM2M_TYPE_RESOURCE;
+        return COAP_205_CONTENT ;
+
+    case RES_NET_UDP_DROPS:
+        lwm2m_tlv_encode_int(lwip_stats.udp.drop, tlvP);
+        tlvP->type = LWM2M_TYPE_RESOURCE;
+        return COAP_205_CONTENT ;
+
+    case RES_NET_MBOX_ERRORS:
+        lwm2m_tlv_encode_int(lwip_stats.sys.mbox.err, tlvP);
+        tlvP->type = LWM2M_TYPE_RESOURCE;
+        return COAP_205_CONTENT ;
+
+    default:
+        return COAP_404_NOT_FOUND ;
+    }
+}
+
+static uint8_t prv_net_stats_read(uint16_t instanceId, int * numDataP, lwm2m_tlv_t ** dataArrayP,
+        lwm2m_object_t * objectP) {
+    uint8_t result;
+    int i;
+
+    // this is a single instance object
+    if (instanceId != 0) {
+        return COAP_404_NOT_FOUND ;
+    }
+
+    // is the server asking for the full object ?
+    if (*numDataP == 0) {
+
+        uint16_t resList[] = {
+        RES_NET_POOL_NAME,
+        RES_NET_POOL_SIZE,
+        RES_NET_POOL_USED,
+        RES_NET_POOL_MAX_USED,
+        RES_NET_POOL_ERRORS,
+        RES_NET_LINK_DROPS,
+        RES_NET_IP_DROPS,
+        RES_NET_UDP_DROPS,
+        RES_NET_MBOX_ERRORS };
+        int nbRes = sizeof(resList) / sizeof(uint16_t);
+
+        *dataArrayP = lwm2m_tlv_new(nbRes);
+        if (*dataArrayP == NULL)
+            return COAP_500_INTERNAL_SERVER_ERROR ;
+        *numDataP = nbRes;
+        for (i = 0; i < nbRes; i++) {
+            (*dataArrayP)[i].id = resList[i];
+        }
+    }
+
+    i = 0;
+    do {
+        result = prv_net_set_value((*dataArrayP) + i);
+        i++;
+    } while (i < *numDataP && result == COAP_205_CONTENT );
+
+    return result;
+}
+
+static void prv_net_stats_close(lwm2m_object_t * objectP) {
+    if (NULL != objectP->instanceList) {
+        lwm2m_free(objectP->instanceList);
+        objectP->instanceList = NULL;
+    }
+}
+
+lwm2m_object_t * get_object_net_stats() {
+    lwm2m_object_t * netStatsObj;
+
+    netStatsObj = (lwm2m_object_t *) lwm2m_malloc(sizeof(lwm2m_object_t));
+
+    if (NULL != netStatsObj) {
+        memset(netStatsObj, 0, sizeof(lwm2m_object_t));
+
+        netStatsObj->objID = LWM2M_NET_STATS_OBJECT_ID;
+
+        // there is only one network interface
+        netStatsObj->instanceList = (lwm2m_list_t *) lwm2m_malloc(sizeof(lwm2m_list_t));
+        if (NULL != netStatsObj->instanceList) {
+            memset(netStatsObj->instanceList, 0, sizeof(lwm2m_list_t));
+        } else {
+            lwm2m_free(netStatsObj);
+            return NULL;
+        }
+
+        netStatsObj->readFunc = prv_net_stats_read;
+        netStatsObj->writeFunc = NULL;
+        netStatsObj->executeFunc = NULL;
+        netStatsObj->closeFunc = prv_net_stats_close;
+        netStatsObj->userData = NULL;
+    }
+
+    return netStatsObj;
+}
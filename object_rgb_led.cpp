@@ -111,105 +111,48 @@ static char * get_color(rgb_data_t * rgb) {
     return color;
 }
 
-static uint8_t prv_set_value(lwm2m_tlv_t * tlvP, rgb_data_t * devDataP) {
-    // a simple switch structure is used to respond at the specified resource asked
-    switch (tlvP->id) {
-    case RES_COLOUR: {
-        char * color = get_color(devDataP);
-        tlvP->value = (uint8_t*) color;
-        tlvP->length = strlen(color);
-        tlvP->type = LWM2M_TYPE_RESOURCE;
-        tlvP->dataType = LWM2M_TYPE_STRING;
-        return COAP_205_CONTENT ;
-    }
-    case RES_ON_OFF: {
-        bool on = (rpw->read() < 1.0f || gpw->read() < 1.0f || bpw->read() < 1.0f);
-        lwm2m_tlv_encode_bool(on, tlvP);
-        tlvP->type = LWM2M_TYPE_RESOURCE;
-        return COAP_205_CONTENT ;
-    }
-    default:
-        return COAP_404_NOT_FOUND ;
-    }
+static uint8_t prv_read_colour(uint16_t instanceId, lwm2m_tlv_t * tlvP, lwm2m_object_t * objectP) {
+    char * color = get_color((rgb_data_t *) objectP->userData);
+    if (color == NULL)
+        return COAP_500_INTERNAL_SERVER_ERROR ;
+
+    tlvP->value = (uint8_t*) color;
+    tlvP->length = strlen(color);
+    tlvP->dataType = LWM2M_TYPE_STRING;
+    return COAP_205_CONTENT ;
 }
 
-static uint8_t prv_rgb_read(uint16_t instanceId, int * numDataP, lwm2m_tlv_t ** dataArrayP, lwm2m_object_t * objectP) {
-    uint8_t result;
-    int i;
+static uint8_t prv_write_colour(uint16_t instanceId, lwm2m_tlv_t * tlvP, lwm2m_object_t * objectP) {
+    if (-1 == set_color((char*) tlvP->value, tlvP->length, (rgb_data_t*) objectP->userData))
+        return COAP_500_INTERNAL_SERVER_ERROR ;
+    return COAP_204_CHANGED ;
+}
 
-    // this is a single instance object
-    if (instanceId != 0) {
-        return COAP_404_NOT_FOUND ;
-    }
+static uint8_t prv_read_on_off(uint16_t instanceId, lwm2m_tlv_t * tlvP, lwm2m_object_t * objectP) {
+    bool on = (rpw->read() < 1.0f || gpw->read() < 1.0f || bpw->read() < 1.0f);
+    lwm2m_tlv_encode_bool(on, tlvP);
+    return COAP_205_CONTENT ;
+}
 
-    // is the server asking for the full object ?
-    if (*numDataP == 0) {
+static uint8_t prv_write_on_off(uint16_t instanceId, lwm2m_tlv_t * tlvP, lwm2m_object_t * objectP) {
+    bool on;
 
-        uint16_t resList[] = {
-        RES_COLOUR,
-        RES_ON_OFF, };
-        int nbRes = sizeof(resList) / sizeof(uint16_t);
+    if (1 != lwm2m_tlv_decode_bool(tlvP, &on))
+        return COAP_400_BAD_REQUEST ;
 
-        *dataArrayP = lwm2m_tlv_new(nbRes);
-        if (*dataArrayP == NULL)
-            return COAP_500_INTERNAL_SERVER_ERROR ;
-        *numDataP = nbRes;
-        for (i = 0; i < nbRes; i++) {
-            (*dataArrayP)[i].id = resList[i];
-        }
+    if (on) {
+        switchon();
+    } else {
+        switchoff();
     }
-
-    i = 0;
-    do {
-        result = prv_set_value((*dataArrayP) + i, (rgb_data_t*) (objectP->userData));
-        i++;
-    } while (i < *numDataP && result == COAP_205_CONTENT );
-
-    return result;
+    return COAP_204_CHANGED ;
 }
 
-static uint8_t prv_rgb_write(uint16_t instanceId, int numData, lwm2m_tlv_t * dataArray, lwm2m_object_t * objectP) {
-    int i;
-    uint8_t result;
-
-    // this is a single instance object
-    if (instanceId != 0) {
-        return COAP_404_NOT_FOUND ;
-    }
-
-    i = 0;
-
-    do {
-        switch (dataArray[i].id) {
-        case RES_COLOUR:
-            if (-1 != set_color((char*) dataArray[i].value, dataArray[i].length, (rgb_data_t*) (objectP->userData))) {
-                result = COAP_204_CHANGED;
-            } else {
-                result = COAP_500_INTERNAL_SERVER_ERROR;
-            }
-            break;
-        case RES_ON_OFF:
-            bool on;
-            if (1 == lwm2m_tlv_decode_bool(dataArray + i, &on)) {
-                if (on) {
-                    switchon();
-                } else {
-                    switchoff();
-                }
-                result = COAP_204_CHANGED;
-            } else {
-                result = COAP_400_BAD_REQUEST;
-            }
-            break;
-        default:
-            result = COAP_405_METHOD_NOT_ALLOWED;
-        }
-
-        i++;
-    } while (i < numData && result == COAP_204_CHANGED );
-
-    return result;
-}
+// sorted by resource id
+static const lwm2m_resource_desc_t prv_rgb_resources[] = {
+    LWM2M_RESOURCE(RES_COLOUR, LWM2M_TYPE_STRING, LWM2M_RES_READ | LWM2M_RES_WRITE, prv_read_colour, prv_write_colour),
+    LWM2M_RESOURCE(RES_ON_OFF, LWM2M_TYPE_BOOLEAN, LWM2M_RES_READ | LWM2M_RES_WRITE, prv_read_on_off, prv_write_on_off)
+};
 
 static void prv_rgb_close(lwm2m_object_t * objectP) {
     if (NULL != objectP->userData) {
@@ -263,13 +206,9 @@ lwm2m_object_t * get_object_rgb_led() {
         }
 
         /*
-         * And the private function that will access the object.
-         * Those function will be called when a read/write/execute query is made by the server. In fact the library don't need to
-         * know the resources of the object, only the server does.
+         * The library dispatches the read/write/execute queries made by the server on the resource table.
          */
-        rgbObj->readFunc = prv_rgb_read;
-        rgbObj->writeFunc = prv_rgb_write;
-        rgbObj->executeFunc = NULL;
+        lwm2m_object_set_resources(rgbObj, prv_rgb_resources);
         rgbObj->closeFunc = prv_rgb_close;
         state = (rgb_data_t *) lwm2m_malloc(sizeof(rgb_data_t));
         rgbObj->userData = state;
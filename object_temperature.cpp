@@ -24,73 +24,76 @@
 #include "mbed.h"
 #include "dbg.h"
 #include "LM75B.h"
+#include "aggregator.h"
 
 #define LWM2M_TEMPERATURE_OBJECT_ID   3303
 #define PRV_TEMPERATURE_SENSOR_UNITS    "Cel"
+// samples per statistics window, the temperature is sampled once per main loop
+#define PRV_TEMPERATURE_WINDOW          60
 
 // Resource Id's:
-#define RES_SENSOR_VALUE    5700
-#define RES_SENSOR_UNITS    5701
+#define RES_MIN_MEASURED_VALUE  5601
+#define RES_MAX_MEASURED_VALUE  5602
+#define RES_RESET_MIN_MAX       5605
+#define RES_SENSOR_VALUE        5700
+#define RES_SENSOR_UNITS        5701
+// Custom resources (not defined by IPSO):
+#define RES_MEAN_VALUE          6003 // mean of the last completed window
+#define RES_VARIANCE_VALUE      6004 // variance of the last completed window
 
 LM75B sensor(p28, p27);
 bool opened = false;
+aggregator_t temperatureStats;
+bool temperatureWindowDone = false;
+
+// the LM75B shares the I2C bus with the accelerometer sampler
+static uint8_t prv_temperature_value(uint16_t instanceId, lwm2m_tlv_t * tlvP, lwm2m_object_t * objectP) {
+    i2c_mutex.lock();
+    lwm2m_tlv_encode_float((float) sensor, tlvP);
+    i2c_mutex.unlock();
+    return COAP_205_CONTENT ;
+}
 
-static uint8_t prv_set_value(lwm2m_tlv_t * tlvP) {
-    // a simple switch structure is used to respond at the specified resource asked
-    switch (tlvP->id) {
-    case RES_SENSOR_VALUE:
-        lwm2m_tlv_encode_float((float) sensor, tlvP);
-        tlvP->type = LWM2M_TYPE_RESOURCE;
-        return COAP_205_CONTENT ;
-
-    case RES_SENSOR_UNITS:
-        tlvP->value = (uint8_t*) PRV_TEMPERATURE_SENSOR_UNITS;
-        tlvP->length = strlen(PRV_TEMPERATURE_SENSOR_UNITS);
-        tlvP->flags = LWM2M_TLV_FLAG_STATIC_DATA;
-        tlvP->type = LWM2M_TYPE_RESOURCE;
-        tlvP->dataType = LWM2M_TYPE_STRING;
-        return COAP_205_CONTENT ;
+// temperatureStats is only fed by getCurrentTemp(), from the main loop which also runs lwm2m_step()
+static uint8_t prv_temperature_statistics(uint16_t instanceId, lwm2m_tlv_t * tlvP, lwm2m_object_t * objectP) {
+    float value;
 
+    switch (tlvP->id) {
+    case RES_MIN_MEASURED_VALUE:
+        value = temperatureStats.min;
+        break;
+    case RES_MAX_MEASURED_VALUE:
+        value = temperatureStats.max;
+        break;
+    case RES_MEAN_VALUE:
+        value = temperatureStats.windowMean;
+        break;
     default:
-        return COAP_404_NOT_FOUND ;
+        value = temperatureStats.windowVariance;
+        break;
     }
+
+    lwm2m_tlv_encode_float(value, tlvP);
+    return COAP_205_CONTENT ;
 }
 
-static uint8_t prv_temperature_read(uint16_t instanceId, int * numDataP, lwm2m_tlv_t ** dataArrayP,
+static uint8_t prv_temperature_reset(uint16_t instanceId, uint16_t resourceId, uint8_t * buffer, int length,
         lwm2m_object_t * objectP) {
-    uint8_t result;
-    int i;
-
-    // this is a single instance object
-    if (instanceId != 0) {
-        return COAP_404_NOT_FOUND ;
-    }
-
-    // is the server asking for the full object ?
-    if (*numDataP == 0) {
-
-        uint16_t resList[] = { RES_SENSOR_VALUE,
-        RES_SENSOR_UNITS, };
-        int nbRes = sizeof(resList) / sizeof(uint16_t);
-
-        *dataArrayP = lwm2m_tlv_new(nbRes);
-        if (*dataArrayP == NULL)
-            return COAP_500_INTERNAL_SERVER_ERROR ;
-        *numDataP = nbRes;
-        for (i = 0; i < nbRes; i++) {
-            (*dataArrayP)[i].id = resList[i];
-        }
-    }
-
-    i = 0;
-    do {
-        result = prv_set_value((*dataArrayP) + i);
-        i++;
-    } while (i < *numDataP && result == COAP_205_CONTENT );
-
-    return result;
+    aggregator_reset_min_max(&temperatureStats);
+    return COAP_204_CHANGED ;
 }
 
+// sorted by resource id
+static const lwm2m_resource_desc_t prv_temperature_resources[] = {
+    LWM2M_RESOURCE(RES_MIN_MEASURED_VALUE, LWM2M_TYPE_FLOAT, LWM2M_RES_READ, prv_temperature_statistics, NULL),
+    LWM2M_RESOURCE(RES_MAX_MEASURED_VALUE, LWM2M_TYPE_FLOAT, LWM2M_RES_READ, prv_temperature_statistics, NULL),
+    LWM2M_RESOURCE_EXECUTE(RES_RESET_MIN_MAX, prv_temperature_reset),
+    LWM2M_RESOURCE(RES_SENSOR_VALUE, LWM2M_TYPE_FLOAT, LWM2M_RES_READ, prv_temperature_value, NULL),
+    LWM2M_RESOURCE_STATIC_STRING(RES_SENSOR_UNITS, PRV_TEMPERATURE_SENSOR_UNITS),
+    LWM2M_RESOURCE(RES_MEAN_VALUE, LWM2M_TYPE_FLOAT, LWM2M_RES_READ, prv_temperature_statistics, NULL),
+    LWM2M_RESOURCE(RES_VARIANCE_VALUE, LWM2M_TYPE_FLOAT, LWM2M_RES_READ, prv_temperature_statistics, NULL)
+};
+
 static void prv_temperature_close(lwm2m_object_t * objectP) {
     if (NULL != objectP->instanceList) {
         lwm2m_free(objectP->instanceList);
@@ -104,7 +107,10 @@ lwm2m_object_t * get_object_temperature() {
      */
     lwm2m_object_t * temperatureObj;
 
-    if (!sensor.open()) {
+    i2c_mutex.lock();
+    bool detected = sensor.open();
+    i2c_mutex.unlock();
+    if (!detected) {
         ERR("Unable to open temperature sensor.");
         return NULL;
     }
@@ -134,16 +140,14 @@ lwm2m_object_t * get_object_temperature() {
         }
 
         /*
-         * And the private function that will access the object.
-         * Those function will be called when a read/write/execute query is made by the server. In fact the library don't need to
-         * know the resources of the object, only the server does.
+         * The library dispatches the read/write/execute queries made by the server on the resource table.
          */
-        temperatureObj->readFunc = prv_temperature_read;
-        temperatureObj->writeFunc = NULL;
-        temperatureObj->executeFunc = NULL;
+        lwm2m_object_set_resources(temperatureObj, prv_temperature_resources);
         temperatureObj->closeFunc = prv_temperature_close;
         temperatureObj->userData = NULL;
 
+        aggregator_init(&temperatureStats, PRV_TEMPERATURE_WINDOW);
+
     }
 
     return temperatureObj;
@@ -153,6 +157,20 @@ bool isTempSensorOpened() {
     return opened;
 }
 
+// read the sensor and feed the statistics
 float getCurrentTemp() {
-    return (float) sensor;
+    i2c_mutex.lock();
+    float temp = (float) sensor;
+    i2c_mutex.unlock();
+    if (aggregator_add(&temperatureStats, temp)) {
+        temperatureWindowDone = true;
+    }
+    return temp;
+}
+
+// return true once per completed statistics window, the caller is expected to notify observers
+bool temperature_window_done() {
+    bool done = temperatureWindowDone;
+    temperatureWindowDone = false;
+    return done;
 }
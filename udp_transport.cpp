@@ -0,0 +1,162 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - initial API and implementation
+ *******************************************************************************/
+
+#include "udp_transport.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtos.h"
+#include "lwip/udp.h"
+#include "lwip/tcpip.h"
+#include "lwip/stats.h"
+#include "dbg.h"
+
+// raw API calls must run in the tcpip thread, requests are posted there and
+// the caller waits for their completion
+typedef struct {
+    uint16_t port;
+    struct pbuf * p;
+    ip_addr_t * addrP;
+    err_t err;
+} prv_request_t;
+
+static struct udp_pcb * prv_pcb = NULL;
+static Semaphore prv_done(0);
+// received datagrams waiting for the application thread
+static Mail<udp_transport_packet_t, DEFAULT_UDP_RECVMBOX_SIZE> prv_received;
+
+// tcpip thread
+static void prv_recv(void * arg, struct udp_pcb * pcb, struct pbuf * p, ip_addr_t * addr, u16_t port) {
+    udp_transport_packet_t * packetP = prv_received.alloc();
+    if (packetP == NULL) {
+        // the application does not keep up, same as a full socket receive mailbox
+        UDP_STATS_INC(udp.drop);
+        pbuf_free(p);
+        return;
+    }
+    packetP->p = p;
+    ip_addr_copy(packetP->addr, *addr);
+    packetP->port = port;
+    prv_received.put(packetP);
+}
+
+// tcpip thread
+static void prv_open(void * ctx) {
+    prv_request_t * requestP = (prv_request_t *) ctx;
+
+    requestP->err = ERR_MEM;
+    prv_pcb = udp_new();
+    if (prv_pcb != NULL) {
+        requestP->err = udp_bind(prv_pcb, IP_ADDR_ANY, requestP->port);
+        if (requestP->err == ERR_OK) {
+            udp_recv(prv_pcb, prv_recv, NULL);
+        } else {
+            udp_remove(prv_pcb);
+            prv_pcb = NULL;
+        }
+    }
+    prv_done.release();
+}
+
+// tcpip thread
+static void prv_send(void * ctx) {
+    prv_request_t * requestP = (prv_request_t *) ctx;
+
+    requestP->err = udp_sendto(prv_pcb, requestP->p, requestP->addrP, requestP->port);
+    prv_done.release();
+}
+
+static err_t prv_call(tcpip_callback_fn function, prv_request_t * requestP) {
+    if (tcpip_callback(function, requestP) != ERR_OK)
+        return ERR_MEM;
+    prv_done.wait();
+    return requestP->err;
+}
+
+int udp_transport_open(uint16_t port) {
+    prv_request_t request;
+
+    request.port = port;
+    if (prv_call(prv_open, &request) != ERR_OK) {
+        ERR("Unable to bind UDP port %d", port);
+        return -1;
+    }
+    return 0;
+}
+
+bool udp_transport_receive(udp_transport_packet_t * packetP, uint32_t timeoutMs) {
+    osEvent evt = prv_received.get(timeoutMs);
+    if (evt.status != osEventMail)
+        return false;
+
+    udp_transport_packet_t * receivedP = (udp_transport_packet_t *) evt.value.p;
+    *packetP = *receivedP;
+    prv_received.free(receivedP);
+
+    packetP->length = packetP->p->tot_len;
+    if (packetP->p->len == packetP->p->tot_len) {
+        // single pbuf, parse in place
+        packetP->data = (uint8_t *) packetP->p->payload;
+    } else {
+        // chained pbufs (e.g. reassembled datagram), linearize
+        packetP->data = (uint8_t *) malloc(packetP->length);
+        if (packetP->data == NULL) {
+            pbuf_free(packetP->p);
+            return false;
+        }
+        pbuf_copy_partial(packetP->p, packetP->data, packetP->length, 0);
+    }
+    return true;
+}
+
+void udp_transport_release(udp_transport_packet_t * packetP) {
+    if (packetP->data != packetP->p->payload)
+        free(packetP->data);
+    pbuf_free(packetP->p);
+    packetP->p = NULL;
+    packetP->data = NULL;
+}
+
+int udp_transport_send(ip_addr_t * addrP, uint16_t port, uint8_t * buffer, size_t length) {
+    // reference the caller buffer, the call is synchronous and the driver
+    // copies payloads that are not in DMA capable memory
+    struct pbuf * p = pbuf_alloc(PBUF_TRANSPORT, length, PBUF_REF);
+    if (p == NULL)
+        return -1;
+    p->payload = buffer;
+
+    return udp_transport_send_pbuf(addrP, port, p);
+}
+
+struct pbuf * udp_transport_alloc(size_t length) {
+    return pbuf_alloc(PBUF_TRANSPORT, length, PBUF_RAM);
+}
+
+int udp_transport_send_pbuf(ip_addr_t * addrP, uint16_t port, struct pbuf * p) {
+    prv_request_t request;
+    err_t err = ERR_CONN;
+
+    if (prv_pcb != NULL) {
+        request.p = p;
+        request.addrP = addrP;
+        request.port = port;
+        err = prv_call(prv_send, &request);
+    }
+    // the driver keeps its own reference until the frame is transmitted
+    pbuf_free(p);
+    return err == ERR_OK ? 0 : -1;
+}
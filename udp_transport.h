@@ -0,0 +1,57 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - initial API and implementation
+ *******************************************************************************/
+
+#ifndef UDP_TRANSPORT_H_
+#define UDP_TRANSPORT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
+
+/*
+ * CoAP transport on the lwIP raw UDP API.
+ *
+ * Datagrams are received in the tcpip thread and handed over, still in their
+ * pbuf, to the thread calling udp_transport_receive(); the sockets and netconn
+ * layers are not involved. The pbuf stays referenced until the packet is
+ * released, so the CoAP parser can point into it while the response is built
+ * and sent.
+ */
+typedef struct {
+    struct pbuf * p;
+    ip_addr_t addr;
+    uint16_t port;
+    uint8_t * data;     // contiguous payload, in the pbuf when possible
+    size_t length;
+} udp_transport_packet_t;
+
+// bind the transport to a local port, return 0 on success
+int udp_transport_open(uint16_t port);
+// wait up to timeoutMs for a datagram, return false on timeout
+bool udp_transport_receive(udp_transport_packet_t * packetP, uint32_t timeoutMs);
+void udp_transport_release(udp_transport_packet_t * packetP);
+// send a datagram from the bound port, return 0 on success
+int udp_transport_send(ip_addr_t * addrP, uint16_t port, uint8_t * buffer, size_t length);
+
+// Zero-copy transmit: allocate a pbuf from the lwIP heap (DMA capable, with
+// room for the UDP/IP/Ethernet headers), write the datagram in its payload,
+// then send it. udp_transport_send_pbuf() consumes the pbuf.
+struct pbuf * udp_transport_alloc(size_t length);
+int udp_transport_send_pbuf(ip_addr_t * addrP, uint16_t port, struct pbuf * p);
+
+#endif /* UDP_TRANSPORT_H_ */
@@ -106,6 +106,12 @@ void handle_bootstrap_response(lwm2m_context_t * context,
     else
     {
         bootstrap_failed(context);
+        if (COAP_503_SERVICE_UNAVAILABLE == message->code
+         && IS_OPTION(message, COAP_OPTION_MAX_AGE))
+        {
+            // retry hint of an overloaded bootstrap server
+            context->bsRetryDelay += message->max_age;
+        }
     }
 }
 
@@ -113,6 +119,8 @@ void bootstrap_failed(lwm2m_context_t * context)
 {
     reset_bootstrap_timer(context);
     context->bsState = BOOTSTRAP_FAILED;
+    // spread the retries of clients which failed at the same time
+    context->bsRetryDelay = utils_retryDelay(context, &context->bsRetryCount);
     LOG("[BOOTSTRAP] Bootstrap failed\r\n");
 }
 
@@ -164,11 +172,8 @@ void update_bootstrap_state(lwm2m_context_t * context,
         if (0 >= timeToBootstrap)
         {
             // Time out and no error => bootstrap OK
-            // TODO: add smarter condition for bootstrap success:
-            // 1) security object contains at least one bootstrap server
-            // 2) there are coherent configurations for provisioned DM servers
-            // if these conditions are not met, then bootstrap has failed and previous security
-            // and server object configurations might be restored by client
+            // Bootstrap servers sending a Bootstrap-Finish don't wait for this delay,
+            // see handle_bootstrap_finish()
             LOG("\r\n[BOOTSTRAP] Bootstrap finished at: %lu (difftime: %lu s)\r\n",
                     (unsigned long)currentTime, (unsigned long)(currentTime - context->bsStart));
             context->bsState = BOOTSTRAP_FINISHED;
@@ -186,6 +191,9 @@ void update_bootstrap_state(lwm2m_context_t * context,
         if (0 <= lwm2m_start(context))
         {
             context->bsState = BOOTSTRAPPED;
+            context->bsRetryCount = 0;
+            // save the configuration written by the bootstrap server
+            context->persistDirty = true;
         }
         else
         {
@@ -200,8 +208,8 @@ void update_bootstrap_state(lwm2m_context_t * context,
         {
             // get ClientHoldOffTime from bootstrapServer->lifetime
             // (see objects.c => object_getServers())
-            int32_t timeToBootstrap = (context->bsStart + bootstrapServer->lifetime) - currentTime;
-            LOG("[BOOTSTRAP] Bootstrap failed: %lu, now waiting during ClientHoldOffTime %ld ...\r\n",
+            int32_t timeToBootstrap = (context->bsStart + bootstrapServer->lifetime + context->bsRetryDelay) - currentTime;
+            LOG("[BOOTSTRAP] Bootstrap failed: %lu, now waiting during ClientHoldOffTime and backoff %ld ...\r\n",
                     (unsigned long)context->bsStart, (long)timeToBootstrap);
             if (0 >= timeToBootstrap)
             {
@@ -217,6 +225,29 @@ void update_bootstrap_state(lwm2m_context_t * context,
         }
     }
 }
+
+coap_status_t handle_bootstrap_finish(lwm2m_context_t * contextP,
+                                      void * fromSessionH,
+                                      coap_packet_t * message)
+{
+    if (COAP_POST != message->code) return COAP_400_BAD_REQUEST;
+    if (NULL == utils_findBootstrapServer(contextP, fromSessionH)) return COAP_401_UNAUTHORIZED;
+    if (BOOTSTRAP_PENDING != contextP->bsState) return COAP_IGNORE;
+
+    if (!object_isBootstrapConsistent(contextP))
+    {
+        // the server can fix the configuration and finish again
+        LOG("[BOOTSTRAP] Bootstrap-Finish rejected, inconsistent configuration\r\n");
+        return COAP_406_NOT_ACCEPTABLE;
+    }
+
+    LOG("[BOOTSTRAP] Bootstrap-Finish received at: %lu\r\n", (unsigned long)lwm2m_gettime());
+    // the next lwm2m_step() connects to the provisioned servers
+    contextP->bsState = BOOTSTRAP_FINISHED;
+    reset_bootstrap_timer(contextP);
+
+    return COAP_204_CHANGED;
+}
 #endif
 
 #endif
@@ -376,4 +407,36 @@ int lwm2m_bootstrap_write(lwm2m_context_t * contextP,
 
     return transaction_send(contextP, transaction);
 }
+
+int lwm2m_bootstrap_finish(lwm2m_context_t * contextP,
+                           void * sessionH)
+{
+    lwm2m_transaction_t * transaction;
+    bs_data_t * dataP;
+
+    transaction = transaction_new(COAP_TYPE_CON, COAP_POST, NULL, NULL, contextP->nextMID++, 4, NULL, ENDPOINT_UNKNOWN, sessionH);
+    if (transaction == NULL) return INTERNAL_SERVER_ERROR_5_00;
+
+    coap_set_header_uri_path(transaction->message, "/"URI_BOOTSTRAP_SEGMENT);
+
+    dataP = (bs_data_t *)lwm2m_malloc(sizeof(bs_data_t));
+    if (dataP == NULL)
+    {
+        transaction_free(transaction);
+        return COAP_500_INTERNAL_SERVER_ERROR;
+    }
+    // told apart from a "Delete /" by a URI without object ID
+    dataP->isUri = true;
+    memset(&dataP->uri, 0, sizeof(lwm2m_uri_t));
+    dataP->uri.flag = LWM2M_URI_FLAG_BOOTSTRAP;
+    dataP->callback = contextP->bootstrapCallback;
+    dataP->userData = contextP->bootstrapUserData;
+
+    transaction->callback = bs_result_callback;
+    transaction->userData = (void *)dataP;
+
+    contextP->transactionList = (lwm2m_transaction_t *)LWM2M_LIST_ADD(contextP->transactionList, transaction);
+
+    return transaction_send(contextP, transaction);
+}
 #endif
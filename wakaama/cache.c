@@ -0,0 +1,246 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - initial API and implementation
+ *
+ *******************************************************************************/
+
+/************************************************************************
+ *  Values cache of the clients, server side.
+ *
+ *  The payloads of the read responses and of the notifications are kept
+ *  per client and per URI, with the Max-Age of the message, so that
+ *  lwm2m_dm_read_cached() can answer without a round trip to the device.
+ *  A client keeps at most LWM2M_CACHE_MAX_ENTRIES values, the least
+ *  recently used one is dropped first. A successful write, execute,
+ *  create or delete drops the values of the URIs it overlaps.
+ *  A notification older than the stored one, by the ordering of the
+ *  Observe option (RFC 7641 section 3.4), is not stored.
+ */
+
+#include "internals.h"
+
+#ifdef LWM2M_SERVER_MODE
+
+// true if one of the URIs is a parent of the other or if they are equal
+static bool prv_overlap(lwm2m_uri_t * uri1P,
+                        lwm2m_uri_t * uri2P)
+{
+    if (uri1P->objectId != uri2P->objectId) return false;
+    if (!LWM2M_URI_IS_SET_INSTANCE(uri1P) || !LWM2M_URI_IS_SET_INSTANCE(uri2P)) return true;
+    if (uri1P->instanceId != uri2P->instanceId) return false;
+    if (!LWM2M_URI_IS_SET_RESOURCE(uri1P) || !LWM2M_URI_IS_SET_RESOURCE(uri2P)) return true;
+    return (uri1P->resourceId == uri2P->resourceId);
+}
+
+static bool prv_match(lwm2m_uri_t * uri1P,
+                      lwm2m_uri_t * uri2P)
+{
+    return (uri1P->flag & LWM2M_URI_MASK_ID) == (uri2P->flag & LWM2M_URI_MASK_ID)
+        && prv_overlap(uri1P, uri2P);
+}
+
+// unlinks the entry matching uriP and moves it to the head of the list
+static lwm2m_cache_entry_t * prv_find(lwm2m_client_t * clientP,
+                                      lwm2m_uri_t * uriP)
+{
+    lwm2m_cache_entry_t ** entryP;
+
+    for (entryP = &clientP->cacheList ; *entryP != NULL ; entryP = &(*entryP)->next)
+    {
+        if (prv_match(&(*entryP)->uri, uriP))
+        {
+            lwm2m_cache_entry_t * targetP = *entryP;
+
+            *entryP = targetP->next;
+            targetP->next = clientP->cacheList;
+            clientP->cacheList = targetP;
+            return targetP;
+        }
+    }
+
+    return NULL;
+}
+
+static void prv_remove(lwm2m_client_t * clientP,
+                       lwm2m_uri_t * uriP)
+{
+    lwm2m_cache_entry_t * entryP;
+
+    entryP = prv_find(clientP, uriP);
+    if (entryP != NULL)
+    {
+        clientP->cacheList = entryP->next;
+        lwm2m_free(entryP);
+    }
+}
+
+// RFC 7641 section 3.4: Observe values are 24 bits long and wrap around
+static bool prv_isFresher(lwm2m_cache_entry_t * entryP,
+                          uint32_t count,
+                          time_t now)
+{
+    uint32_t previous = entryP->observeCount;
+
+    if (previous < count && count - previous < ((uint32_t)1 << 23)) return true;
+    if (previous > count && previous - count > ((uint32_t)1 << 23)) return true;
+    return (now > entryP->time + 128);
+}
+
+void cache_store(lwm2m_client_t * clientP,
+                 lwm2m_uri_t * uriP,
+                 coap_packet_t * packet)
+{
+    lwm2m_cache_entry_t * entryP;
+    lwm2m_cache_entry_t ** tailP;
+    uint32_t maxAge;
+    time_t now;
+    bool observed;
+    uint32_t observeCount = 0;
+    int count;
+
+    coap_get_header_max_age(packet, &maxAge);
+    observed = (1 == coap_get_header_observe(packet, &observeCount));
+    now = lwm2m_gettime();
+
+    entryP = prv_find(clientP, uriP);
+    if (entryP != NULL
+     && observed
+     && entryP->observed
+     && !prv_isFresher(entryP, observeCount, now))
+    {
+        return;
+    }
+
+    if (maxAge == 0
+     || now < 0
+     || packet->payload_len > LWM2M_CACHE_MAX_PAYLOAD)
+    {
+        prv_remove(clientP, uriP);
+        return;
+    }
+
+    if (entryP != NULL && entryP->payloadLength != packet->payload_len)
+    {
+        clientP->cacheList = entryP->next;
+        lwm2m_free(entryP);
+        entryP = NULL;
+    }
+    if (entryP == NULL)
+    {
+        entryP = (lwm2m_cache_entry_t *)lwm2m_malloc(sizeof(lwm2m_cache_entry_t) + packet->payload_len);
+        if (entryP == NULL) return;
+        memcpy(&entryP->uri, uriP, sizeof(lwm2m_uri_t));
+        entryP->payloadLength = packet->payload_len;
+        entryP->payload = (uint8_t *)(entryP + 1);
+        entryP->next = clientP->cacheList;
+        clientP->cacheList = entryP;
+    }
+    memcpy(entryP->payload, packet->payload, packet->payload_len);
+    entryP->time = now;
+    entryP->expiry = now + maxAge;
+    entryP->observed = observed;
+    entryP->observeCount = observeCount;
+
+    // drop the least recently used values
+    count = 0;
+    for (tailP = &clientP->cacheList ; *tailP != NULL && count < LWM2M_CACHE_MAX_ENTRIES ; tailP = &(*tailP)->next)
+    {
+        count++;
+    }
+    while (*tailP != NULL)
+    {
+        lwm2m_cache_entry_t * targetP = *tailP;
+
+        *tailP = targetP->next;
+        lwm2m_free(targetP);
+    }
+}
+
+// returns NULL if there is no value of uriP younger than maxAge and within its Max-Age
+lwm2m_cache_entry_t * cache_get(lwm2m_client_t * clientP,
+                                lwm2m_uri_t * uriP,
+                                uint32_t maxAge)
+{
+    lwm2m_cache_entry_t * entryP;
+    time_t now;
+
+    entryP = prv_find(clientP, uriP);
+    if (entryP == NULL) return NULL;
+
+    now = lwm2m_gettime();
+    if (now < entryP->time) return NULL;
+    if (now >= entryP->expiry)
+    {
+        clientP->cacheList = entryP->next;
+        lwm2m_free(entryP);
+        return NULL;
+    }
+    if (now - entryP->time > maxAge) return NULL;
+
+    return entryP;
+}
+
+void cache_invalidate(lwm2m_client_t * clientP,
+                      lwm2m_uri_t * uriP)
+{
+    lwm2m_cache_entry_t ** entryP;
+
+    entryP = &clientP->cacheList;
+    while (*entryP != NULL)
+    {
+        if (prv_overlap(&(*entryP)->uri, uriP))
+        {
+            lwm2m_cache_entry_t * targetP = *entryP;
+
+            *entryP = targetP->next;
+            lwm2m_free(targetP);
+        }
+        else
+        {
+            entryP = &(*entryP)->next;
+        }
+    }
+}
+
+// updates the cache with the response to a request sent to the client
+void cache_result(lwm2m_client_t * clientP,
+                  lwm2m_uri_t * uriP,
+                  coap_packet_t * request,
+                  coap_packet_t * response)
+{
+    if (request->code == COAP_GET)
+    {
+        if (response->code == COAP_205_CONTENT)
+        {
+            cache_store(clientP, uriP, response);
+        }
+    }
+    else if (response->code >= COAP_201_CREATED && response->code <= COAP_205_CONTENT)
+    {
+        cache_invalidate(clientP, uriP);
+    }
+}
+
+void cache_free(lwm2m_client_t * clientP)
+{
+    while (clientP->cacheList != NULL)
+    {
+        lwm2m_cache_entry_t * targetP = clientP->cacheList;
+
+        clientP->cacheList = targetP->next;
+        lwm2m_free(targetP);
+    }
+}
+
+#endif
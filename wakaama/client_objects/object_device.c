@@ -160,332 +160,128 @@ static int prv_check_time_offset(char * buffer,
     return 1;
 }
 
-static uint8_t prv_set_value(lwm2m_tlv_t * tlvP,
-                             device_data_t * devDataP)
+// encode the values as a multiple resource
+static uint8_t prv_set_instances(lwm2m_tlv_t * tlvP,
+                                 const int64_t * values,
+                                 int count)
 {
-    // a simple switch structure is used to respond at the specified resource asked
-    switch (tlvP->id)
-    {
-    case RES_O_MANUFACTURER:
-        tlvP->value  = (uint8_t*)PRV_MANUFACTURER;
-        tlvP->length = strlen(PRV_MANUFACTURER);
-        tlvP->flags  = LWM2M_TLV_FLAG_STATIC_DATA;
-        tlvP->type     = LWM2M_TYPE_RESOURCE;
-        tlvP->dataType = LWM2M_TYPE_STRING;
-        return COAP_205_CONTENT;
-
-    case RES_O_MODEL_NUMBER:
-        tlvP->value  = (uint8_t*)PRV_MODEL_NUMBER;
-        tlvP->length = strlen(PRV_MODEL_NUMBER);
-        tlvP->flags  = LWM2M_TLV_FLAG_STATIC_DATA;
-        tlvP->type     = LWM2M_TYPE_RESOURCE;
-        tlvP->dataType = LWM2M_TYPE_STRING;
-        return COAP_205_CONTENT;
-
-    case RES_O_SERIAL_NUMBER:
-        tlvP->value  = (uint8_t*)PRV_SERIAL_NUMBER;
-        tlvP->length = strlen(PRV_SERIAL_NUMBER);
-        tlvP->flags  = LWM2M_TLV_FLAG_STATIC_DATA;
-        tlvP->type     = LWM2M_TYPE_RESOURCE;
-        tlvP->dataType = LWM2M_TYPE_STRING;
-        return COAP_205_CONTENT;
-
-    case RES_O_FIRMWARE_VERSION:
-        tlvP->value  = (uint8_t*)PRV_FIRMWARE_VERSION;
-        tlvP->length = strlen(PRV_FIRMWARE_VERSION);
-        tlvP->flags  = LWM2M_TLV_FLAG_STATIC_DATA;
-        tlvP->type     = LWM2M_TYPE_RESOURCE;
-        tlvP->dataType = LWM2M_TYPE_STRING;
-        return COAP_205_CONTENT;
-
-    case RES_M_REBOOT:
-        return COAP_405_METHOD_NOT_ALLOWED;
+    lwm2m_tlv_t * subTlvP;
+    int i;
 
-    case RES_O_FACTORY_RESET:
-        return COAP_405_METHOD_NOT_ALLOWED;
+    subTlvP = lwm2m_tlv_new(count);
+    if (NULL == subTlvP) return COAP_500_INTERNAL_SERVER_ERROR;
 
-    case RES_O_AVL_POWER_SOURCES: 
+    for (i = 0 ; i < count ; i++)
     {
-        lwm2m_tlv_t * subTlvP;
-
-        subTlvP = lwm2m_tlv_new(2);
-
-        subTlvP[0].flags = 0;
-        subTlvP[0].id = 0;
-        subTlvP[0].type = LWM2M_TYPE_RESOURCE_INSTANCE;
-        lwm2m_tlv_encode_int(PRV_POWER_SOURCE_1, subTlvP);
-        if (0 == subTlvP[0].length)
+        subTlvP[i].id = i;
+        subTlvP[i].type = LWM2M_TYPE_RESOURCE_INSTANCE;
+        lwm2m_tlv_encode_int(values[i], subTlvP + i);
+        if (0 == subTlvP[i].length)
         {
-            lwm2m_tlv_free(2, subTlvP);
+            lwm2m_tlv_free(count, subTlvP);
             return COAP_500_INTERNAL_SERVER_ERROR;
         }
-
-        subTlvP[1].flags = 0;
-        subTlvP[1].id = 1;
-        subTlvP[1].type = LWM2M_TYPE_RESOURCE_INSTANCE;
-        lwm2m_tlv_encode_int(PRV_POWER_SOURCE_2, subTlvP + 1);
-        if (0 == subTlvP[1].length)
-        {
-            lwm2m_tlv_free(2, subTlvP);
-            return COAP_500_INTERNAL_SERVER_ERROR;
-        }
-
-        lwm2m_tlv_include(subTlvP, 2, tlvP);
-
-        return COAP_205_CONTENT;
     }
 
-    case RES_O_POWER_SOURCE_VOLTAGE:
-    {
-        lwm2m_tlv_t * subTlvP;
+    lwm2m_tlv_include(subTlvP, count, tlvP);
 
-        subTlvP = lwm2m_tlv_new(2);
-
-        subTlvP[0].flags = 0;
-        subTlvP[0].id = 0;
-        subTlvP[0].type = LWM2M_TYPE_RESOURCE_INSTANCE;
-        lwm2m_tlv_encode_int(PRV_POWER_VOLTAGE_1, subTlvP);
-        if (0 == subTlvP[0].length)
-        {
-            lwm2m_tlv_free(2, subTlvP);
-            return COAP_500_INTERNAL_SERVER_ERROR;
-        }
-
-        subTlvP[1].flags = 0;
-        subTlvP[1].id = 1;
-        subTlvP[1].type = LWM2M_TYPE_RESOURCE_INSTANCE;
-        lwm2m_tlv_encode_int(PRV_POWER_VOLTAGE_2, subTlvP + 1);
-        if (0 == subTlvP[1].length)
-        {
-            lwm2m_tlv_free(2, subTlvP);
-            return COAP_500_INTERNAL_SERVER_ERROR;
-        }
-
-        lwm2m_tlv_include(subTlvP, 2, tlvP);
+    return COAP_205_CONTENT;
+}
 
-        return COAP_205_CONTENT;
-    }
+static uint8_t prv_read_power(uint16_t instanceId,
+                              lwm2m_tlv_t * tlvP,
+                              lwm2m_object_t * objectP)
+{
+    static const int64_t sources[] = { PRV_POWER_SOURCE_1, PRV_POWER_SOURCE_2 };
+    static const int64_t voltages[] = { PRV_POWER_VOLTAGE_1, PRV_POWER_VOLTAGE_2 };
+    static const int64_t currents[] = { PRV_POWER_CURRENT_1, PRV_POWER_CURRENT_2 };
 
-    case RES_O_POWER_SOURCE_CURRENT:
+    switch (tlvP->id)
     {
-        lwm2m_tlv_t * subTlvP;
-
-        subTlvP = lwm2m_tlv_new(2);
-
-        subTlvP[0].flags = 0;
-        subTlvP[0].id = 0;
-        subTlvP[0].type = LWM2M_TYPE_RESOURCE_INSTANCE;
-        lwm2m_tlv_encode_int(PRV_POWER_CURRENT_1, &subTlvP[0]);
-        if (0 == subTlvP[0].length)
-        {
-            lwm2m_tlv_free(2, subTlvP);
-            return COAP_500_INTERNAL_SERVER_ERROR;
-        }
-
-        subTlvP[1].flags = 0;
-        subTlvP[1].id = 1;
-        subTlvP[1].type = LWM2M_TYPE_RESOURCE_INSTANCE;
-        lwm2m_tlv_encode_int(PRV_POWER_CURRENT_2, &subTlvP[1]);
-        if (0 == subTlvP[1].length)
-        {
-            lwm2m_tlv_free(2, subTlvP);
-            return COAP_500_INTERNAL_SERVER_ERROR;
-        }
-
-        lwm2m_tlv_include(subTlvP, 2, tlvP);
-
-        return COAP_205_CONTENT;
+    case RES_O_AVL_POWER_SOURCES:
+        return prv_set_instances(tlvP, sources, 2);
+    case RES_O_POWER_SOURCE_VOLTAGE:
+        return prv_set_instances(tlvP, voltages, 2);
+    default:
+        return prv_set_instances(tlvP, currents, 2);
     }
+}
 
+static uint8_t prv_read_integer(uint16_t instanceId,
+                                lwm2m_tlv_t * tlvP,
+                                lwm2m_object_t * objectP)
+{
+    device_data_t * devDataP = (device_data_t*)(objectP->userData);
+
+    switch (tlvP->id)
+    {
     case RES_O_BATTERY_LEVEL:
         lwm2m_tlv_encode_int(devDataP->battery_level, tlvP);
-        tlvP->type = LWM2M_TYPE_RESOURCE;
-
-        if (0 != tlvP->length) return COAP_205_CONTENT;
-        else return COAP_500_INTERNAL_SERVER_ERROR;
-
+        break;
     case RES_O_MEMORY_FREE:
         lwm2m_tlv_encode_int(devDataP->free_memory, tlvP);
-        tlvP->type = LWM2M_TYPE_RESOURCE;
-
-        if (0 != tlvP->length) return COAP_205_CONTENT;
-        else return COAP_500_INTERNAL_SERVER_ERROR;
-
-    case RES_M_ERROR_CODE:
-    {
-        lwm2m_tlv_t * subTlvP;
-
-        subTlvP = lwm2m_tlv_new(1);
-
-        subTlvP[0].flags = 0;
-        subTlvP[0].id = 0;
-        subTlvP[0].type = LWM2M_TYPE_RESOURCE_INSTANCE;
-        lwm2m_tlv_encode_int(devDataP->error, subTlvP);
-        if (0 == subTlvP[0].length)
-        {
-            lwm2m_tlv_free(2, subTlvP);
-            return COAP_500_INTERNAL_SERVER_ERROR;
-        }
-
-        lwm2m_tlv_include(subTlvP, 1, tlvP);
-
-        return COAP_205_CONTENT;
-    }        
-    case RES_O_RESET_ERROR_CODE:
-        return COAP_405_METHOD_NOT_ALLOWED;
-
-    case RES_O_CURRENT_TIME:
+        break;
+    default:
         lwm2m_tlv_encode_int(time(NULL), tlvP);
-        tlvP->type = LWM2M_TYPE_RESOURCE;
         tlvP->dataType = LWM2M_TYPE_TIME;
-
-        if (0 != tlvP->length) return COAP_205_CONTENT;
-        else return COAP_500_INTERNAL_SERVER_ERROR;
-
-    case RES_O_UTC_OFFSET:
-        tlvP->value  = (uint8_t*)devDataP->time_offset;
-        tlvP->length = strlen(devDataP->time_offset);
-        tlvP->flags  = LWM2M_TLV_FLAG_STATIC_DATA;
-        tlvP->type     = LWM2M_TYPE_RESOURCE;
-        tlvP->dataType = LWM2M_TYPE_STRING;
-        return COAP_205_CONTENT;
-
-    case RES_O_TIMEZONE:
-        tlvP->value  = (uint8_t*)PRV_TIME_ZONE;
-        tlvP->length = strlen(PRV_TIME_ZONE);
-        tlvP->flags  = LWM2M_TLV_FLAG_STATIC_DATA;
-        tlvP->type     = LWM2M_TYPE_RESOURCE;
-        tlvP->dataType = LWM2M_TYPE_STRING;
-        return COAP_205_CONTENT;
-      
-    case RES_M_BINDING_MODES:
-        tlvP->value  = (uint8_t*)PRV_BINDING_MODE;
-        tlvP->length = strlen(PRV_BINDING_MODE);
-        tlvP->flags  = LWM2M_TLV_FLAG_STATIC_DATA;
-        tlvP->type     = LWM2M_TYPE_RESOURCE;
-        tlvP->dataType = LWM2M_TYPE_STRING;
-        return COAP_205_CONTENT;
-
-    default:
-        return COAP_404_NOT_FOUND;
+        break;
     }
+
+    if (0 != tlvP->length) return COAP_205_CONTENT;
+    else return COAP_500_INTERNAL_SERVER_ERROR;
 }
 
-static uint8_t prv_device_read(uint16_t instanceId,
-                               int * numDataP,
-                               lwm2m_tlv_t ** dataArrayP,
-                               lwm2m_object_t * objectP)
+static uint8_t prv_read_error_code(uint16_t instanceId,
+                                   lwm2m_tlv_t * tlvP,
+                                   lwm2m_object_t * objectP)
 {
-    uint8_t result;
-    int i;
-
-    // this is a single instance object
-    if (instanceId != 0)
-    {
-        return COAP_404_NOT_FOUND;
-    }
-
-    // is the server asking for the full object ?
-    if (*numDataP == 0)
-    {
-        uint16_t resList[] = {
-                RES_O_MANUFACTURER,
-                RES_O_MODEL_NUMBER,
-                RES_O_SERIAL_NUMBER,
-                RES_O_FIRMWARE_VERSION,
-                //E: RES_M_REBOOT,
-                //E: RES_O_FACTORY_RESET,
-                RES_O_AVL_POWER_SOURCES,
-                RES_O_POWER_SOURCE_VOLTAGE,
-                RES_O_POWER_SOURCE_CURRENT,
-                RES_O_BATTERY_LEVEL,
-                RES_O_MEMORY_FREE,
-                RES_M_ERROR_CODE,
-                //E: RES_O_RESET_ERROR_CODE,
-                RES_O_CURRENT_TIME,
-                RES_O_UTC_OFFSET,
-                RES_O_TIMEZONE,
-                RES_M_BINDING_MODES
-        };
-        int nbRes = sizeof(resList)/sizeof(uint16_t);
-
-        *dataArrayP = lwm2m_tlv_new(nbRes);
-        if (*dataArrayP == NULL) return COAP_500_INTERNAL_SERVER_ERROR;
-        *numDataP = nbRes;
-        for (i = 0 ; i < nbRes ; i++)
-        {
-            (*dataArrayP)[i].id = resList[i];
-        }
-    }
+    return prv_set_instances(tlvP, &((device_data_t*)(objectP->userData))->error, 1);
+}
 
-    i = 0;
-    do
-    {
-        result = prv_set_value((*dataArrayP) + i, (device_data_t*)(objectP->userData));
-        i++;
-    } while (i < *numDataP && result == COAP_205_CONTENT);
+static uint8_t prv_read_utc_offset(uint16_t instanceId,
+                                   lwm2m_tlv_t * tlvP,
+                                   lwm2m_object_t * objectP)
+{
+    device_data_t * devDataP = (device_data_t*)(objectP->userData);
 
-    return result;
+    tlvP->value  = (uint8_t*)devDataP->time_offset;
+    tlvP->length = strlen(devDataP->time_offset);
+    tlvP->flags  = LWM2M_TLV_FLAG_STATIC_DATA;
+    tlvP->dataType = LWM2M_TYPE_STRING;
+    return COAP_205_CONTENT;
 }
 
-static uint8_t prv_device_write(uint16_t instanceId,
-                                int numData,
-                                lwm2m_tlv_t * dataArray,
-                                lwm2m_object_t * objectP)
+static uint8_t prv_write_current_time(uint16_t instanceId,
+                                      lwm2m_tlv_t * tlvP,
+                                      lwm2m_object_t * objectP)
 {
-    int i;
-    uint8_t result;
+    device_data_t * devDataP = (device_data_t*)(objectP->userData);
 
-    // this is a single instance object
-    if (instanceId != 0)
-    {
-        return COAP_404_NOT_FOUND;
-    }
+    if (1 != lwm2m_tlv_decode_int(tlvP, &devDataP->time)) return COAP_400_BAD_REQUEST;
 
-    i = 0;
-
-    do
-    {
-        switch (dataArray[i].id)
-        {
-        case RES_O_CURRENT_TIME:
-            if (1 == lwm2m_tlv_decode_int(dataArray + i, &((device_data_t*)(objectP->userData))->time))
-            {
-                set_time((time_t)((device_data_t*)(objectP->userData))->time);
-                result = COAP_204_CHANGED;
-            }
-            else
-            {
-                result = COAP_400_BAD_REQUEST;
-            }
-            break;
+    set_time((time_t)devDataP->time);
+    return COAP_204_CHANGED;
+}
 
-        case RES_O_UTC_OFFSET:
-            if (1 == prv_check_time_offset((char*)dataArray[i].value, dataArray[i].length))
-            {
-                strncpy(((device_data_t*)(objectP->userData))->time_offset, (char*)dataArray[i].value, dataArray[i].length);
-                ((device_data_t*)(objectP->userData))->time_offset[dataArray[i].length] = 0;
-                result = COAP_204_CHANGED;
-            }
-            else
-            {
-                result = COAP_400_BAD_REQUEST;
-            }
-            break;
+static uint8_t prv_write_utc_offset(uint16_t instanceId,
+                                    lwm2m_tlv_t * tlvP,
+                                    lwm2m_object_t * objectP)
+{
+    device_data_t * devDataP = (device_data_t*)(objectP->userData);
 
-        case RES_O_TIMEZONE:
-            //ToDo IANA TZ Format
-            result = COAP_501_NOT_IMPLEMENTED;
-            break;
-            
-        default:
-            result = COAP_405_METHOD_NOT_ALLOWED;
-        }
+    if (1 != prv_check_time_offset((char*)tlvP->value, tlvP->length)) return COAP_400_BAD_REQUEST;
 
-        i++;
-    } while (i < numData && result == COAP_204_CHANGED);
+    strncpy(devDataP->time_offset, (char*)tlvP->value, tlvP->length);
+    devDataP->time_offset[tlvP->length] = 0;
+    return COAP_204_CHANGED;
+}
 
-    return result;
+static uint8_t prv_write_timezone(uint16_t instanceId,
+                                  lwm2m_tlv_t * tlvP,
+                                  lwm2m_object_t * objectP)
+{
+    //ToDo IANA TZ Format
+    return COAP_501_NOT_IMPLEMENTED;
 }
 
 static uint8_t prv_device_execute(uint16_t instanceId,
@@ -494,12 +290,6 @@ static uint8_t prv_device_execute(uint16_t instanceId,
                                   int length,
                                   lwm2m_object_t * objectP)
 {
-    // this is a single instance object
-    if (instanceId != 0)
-    {
-        return COAP_404_NOT_FOUND;
-    }
-
     if (length != 0) return COAP_400_BAD_REQUEST;
 
     switch (resourceId)
@@ -511,15 +301,36 @@ static uint8_t prv_device_execute(uint16_t instanceId,
     case RES_O_FACTORY_RESET:
         fprintf(stdout, "\n\t FACTORY RESET\r\n\n");
         return COAP_204_CHANGED;
-    case RES_O_RESET_ERROR_CODE:
+    default:
         fprintf(stdout, "\n\t RESET ERROR CODE\r\n\n");
         ((device_data_t*)(objectP->userData))->error = 0;
         return COAP_204_CHANGED;
-    default:
-        return COAP_405_METHOD_NOT_ALLOWED;
     }
 }
 
+// sorted by resource id
+static const lwm2m_resource_desc_t prv_device_resources[] =
+{
+    LWM2M_RESOURCE_STATIC_STRING(RES_O_MANUFACTURER, PRV_MANUFACTURER),
+    LWM2M_RESOURCE_STATIC_STRING(RES_O_MODEL_NUMBER, PRV_MODEL_NUMBER),
+    LWM2M_RESOURCE_STATIC_STRING(RES_O_SERIAL_NUMBER, PRV_SERIAL_NUMBER),
+    LWM2M_RESOURCE_STATIC_STRING(RES_O_FIRMWARE_VERSION, PRV_FIRMWARE_VERSION),
+    LWM2M_RESOURCE_EXECUTE(RES_M_REBOOT, prv_device_execute),
+    LWM2M_RESOURCE_EXECUTE(RES_O_FACTORY_RESET, prv_device_execute),
+    LWM2M_RESOURCE(RES_O_AVL_POWER_SOURCES, LWM2M_TYPE_INTEGER, LWM2M_RES_READ | LWM2M_RES_MULTIPLE, prv_read_power, NULL),
+    LWM2M_RESOURCE(RES_O_POWER_SOURCE_VOLTAGE, LWM2M_TYPE_INTEGER, LWM2M_RES_READ | LWM2M_RES_MULTIPLE, prv_read_power, NULL),
+    LWM2M_RESOURCE(RES_O_POWER_SOURCE_CURRENT, LWM2M_TYPE_INTEGER, LWM2M_RES_READ | LWM2M_RES_MULTIPLE, prv_read_power, NULL),
+    LWM2M_RESOURCE(RES_O_BATTERY_LEVEL, LWM2M_TYPE_INTEGER, LWM2M_RES_READ, prv_read_integer, NULL),
+    LWM2M_RESOURCE(RES_O_MEMORY_FREE, LWM2M_TYPE_INTEGER, LWM2M_RES_READ, prv_read_integer, NULL),
+    LWM2M_RESOURCE(RES_M_ERROR_CODE, LWM2M_TYPE_INTEGER, LWM2M_RES_READ | LWM2M_RES_MULTIPLE, prv_read_error_code, NULL),
+    LWM2M_RESOURCE_EXECUTE(RES_O_RESET_ERROR_CODE, prv_device_execute),
+    LWM2M_RESOURCE(RES_O_CURRENT_TIME, LWM2M_TYPE_TIME, LWM2M_RES_READ | LWM2M_RES_WRITE, prv_read_integer, prv_write_current_time),
+    LWM2M_RESOURCE(RES_O_UTC_OFFSET, LWM2M_TYPE_STRING, LWM2M_RES_READ | LWM2M_RES_WRITE, prv_read_utc_offset, prv_write_utc_offset),
+    // static value, writing is not implemented
+    { RES_O_TIMEZONE, LWM2M_RES_READ | LWM2M_RES_WRITE | LWM2M_RES_STATIC, LWM2M_TYPE_STRING, NULL, prv_write_timezone, NULL, PRV_TIME_ZONE, sizeof(PRV_TIME_ZONE) - 1, 0 },
+    LWM2M_RESOURCE_STATIC_STRING(RES_M_BINDING_MODES, PRV_BINDING_MODE)
+};
+
 static void prv_device_close(lwm2m_object_t * objectP) {
     if (NULL != objectP->userData)
     {
@@ -581,13 +392,9 @@ lwm2m_object_t * get_object_device()
         }
         
         /*
-         * And the private function that will access the object.
-         * Those function will be called when a read/write/execute query is made by the server. In fact the library don't need to
-         * know the resources of the object, only the server does.
+         * The library dispatches the read/write/execute queries made by the server on the resource table.
          */
-        deviceObj->readFunc    = prv_device_read;
-        deviceObj->writeFunc   = prv_device_write;
-        deviceObj->executeFunc = prv_device_execute;
+        lwm2m_object_set_resources(deviceObj, prv_device_resources, sizeof(prv_device_resources) / sizeof(lwm2m_resource_desc_t));
         deviceObj->closeFunc = prv_device_close;
         deviceObj->userData = lwm2m_malloc(sizeof(device_data_t));
 
@@ -0,0 +1,179 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - initial API and implementation
+ *
+ *******************************************************************************/
+
+/************************************************************************
+ *  Message deduplication (rfc7252 section 4.5).
+ *
+ *  The serialized response to a confirmable request is kept for
+ *  EXCHANGE_LIFETIME, keyed by the session and the request's message ID.
+ *  When the peer retransmits the request because our ACK was lost, the
+ *  response is sent again instead of processing the request twice.
+ *
+ *  The cache is bounded in number of entries, per peer and in total, and
+ *  in bytes. The oldest entries are evicted first.
+ */
+
+#include "internals.h"
+
+
+struct _lwm2m_dedup_entry_
+{
+    struct _lwm2m_dedup_entry_ * next;
+    void *   sessionH;
+    uint16_t mid;
+    time_t   expiry;
+    size_t   length;
+    uint8_t  buffer[1];
+};
+
+static void prv_remove(lwm2m_context_t * contextP,
+                       lwm2m_dedup_entry_t * previousP,
+                       lwm2m_dedup_entry_t * entryP)
+{
+    if (previousP == NULL)
+    {
+        contextP->dedupList = entryP->next;
+    }
+    else
+    {
+        previousP->next = entryP->next;
+    }
+    contextP->dedupStats.entries--;
+    contextP->dedupStats.bytes -= entryP->length;
+    lwm2m_free(entryP);
+}
+
+// remove expired entries, the list is sorted by expiry
+static void prv_purge(lwm2m_context_t * contextP,
+                      time_t now)
+{
+    while (contextP->dedupList != NULL && contextP->dedupList->expiry <= now)
+    {
+        prv_remove(contextP, NULL, contextP->dedupList);
+    }
+}
+
+// evict the oldest entry, of the given session if not NULL
+static void prv_evict(lwm2m_context_t * contextP,
+                      void * sessionH)
+{
+    lwm2m_dedup_entry_t * previousP = NULL;
+    lwm2m_dedup_entry_t * entryP = contextP->dedupList;
+
+    while (entryP != NULL && sessionH != NULL && entryP->sessionH != sessionH)
+    {
+        previousP = entryP;
+        entryP = entryP->next;
+    }
+    if (entryP != NULL)
+    {
+        prv_remove(contextP, previousP, entryP);
+        contextP->dedupStats.evictions++;
+    }
+}
+
+bool dedup_replay(lwm2m_context_t * contextP,
+                  void * sessionH,
+                  uint16_t mid)
+{
+    lwm2m_dedup_entry_t * entryP;
+
+    prv_purge(contextP, lwm2m_gettime());
+
+    for (entryP = contextP->dedupList ; entryP != NULL ; entryP = entryP->next)
+    {
+        if (entryP->sessionH == sessionH && entryP->mid == mid)
+        {
+            LOG("Duplicate request MID %u, replaying %u bytes\r\n", mid, (unsigned int)entryP->length);
+            contextP->dedupStats.hits++;
+            contextP->bufferSendCallback(sessionH, entryP->buffer, entryP->length, contextP->userData);
+            return true;
+        }
+    }
+
+    contextP->dedupStats.misses++;
+    return false;
+}
+
+void dedup_store(lwm2m_context_t * contextP,
+                 void * sessionH,
+                 uint16_t mid,
+                 uint8_t * buffer,
+                 size_t length)
+{
+    lwm2m_dedup_entry_t * entryP;
+    lwm2m_dedup_entry_t * lastP;
+    int peerEntries;
+    time_t now;
+
+    if (length > LWM2M_DEDUP_MAX_BYTES) return;
+
+    now = lwm2m_gettime();
+    prv_purge(contextP, now);
+
+    peerEntries = 0;
+    for (entryP = contextP->dedupList ; entryP != NULL ; entryP = entryP->next)
+    {
+        if (entryP->sessionH == sessionH) peerEntries++;
+    }
+    if (peerEntries >= LWM2M_DEDUP_MAX_PEER_ENTRIES)
+    {
+        prv_evict(contextP, sessionH);
+    }
+    while (contextP->dedupStats.entries >= LWM2M_DEDUP_MAX_ENTRIES
+        || contextP->dedupStats.bytes + length > LWM2M_DEDUP_MAX_BYTES)
+    {
+        prv_evict(contextP, NULL);
+    }
+
+    entryP = (lwm2m_dedup_entry_t *)lwm2m_malloc(sizeof(lwm2m_dedup_entry_t) + length - 1);
+    if (entryP == NULL) return;
+
+    entryP->next = NULL;
+    entryP->sessionH = sessionH;
+    entryP->mid = mid;
+    entryP->expiry = now + COAP_EXCHANGE_LIFETIME;
+    entryP->length = length;
+    memcpy(entryP->buffer, buffer, length);
+
+    // all entries have the same lifetime, appending keeps the list sorted by expiry
+    if (contextP->dedupList == NULL)
+    {
+        contextP->dedupList = entryP;
+    }
+    else
+    {
+        for (lastP = contextP->dedupList ; lastP->next != NULL ; lastP = lastP->next);
+        lastP->next = entryP;
+    }
+    contextP->dedupStats.entries++;
+    contextP->dedupStats.bytes += length;
+}
+
+void dedup_free_all(lwm2m_context_t * contextP)
+{
+    while (contextP->dedupList != NULL)
+    {
+        prv_remove(contextP, NULL, contextP->dedupList);
+    }
+}
+
+void lwm2m_get_dedup_stats(lwm2m_context_t * contextP,
+                           lwm2m_dedup_stats_t * statsP)
+{
+    memcpy(statsP, &contextP->dedupStats, sizeof(lwm2m_dedup_stats_t));
+}
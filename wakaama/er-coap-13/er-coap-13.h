@@ -253,6 +253,9 @@ typedef struct {
   uint16_t payload_len;
   uint8_t *payload;
 
+  /* human-readable reason of a parsing or serialization error */
+  const char *error_message;
+
 } coap_packet_t;
 
 /* Option format serialization*/
@@ -311,9 +314,6 @@ typedef struct {
       current_number = number; \
     }
 
-/* To store error code and human-readable payload */
-extern char *coap_error_message;
-
 uint16_t coap_get_mid(void);
 
 void coap_init_message(void *packet, coap_message_type_t type, uint8_t code, uint16_t mid);
@@ -0,0 +1,403 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - initial API and implementation
+ *
+ *******************************************************************************/
+
+/************************************************************************
+ *  Operations sent to a set of clients, server side.
+ *
+ *  The request of a group is serialized once. Each client gets a copy of
+ *  this buffer with its own MID and token patched in the CoAP header, and
+ *  a transaction which only holds what is needed to match the response.
+ *  Clients with an alternative path get a regular transaction.
+ *
+ *  The requests of all the groups share a token bucket of groupRate
+ *  requests per second and a window of groupCwnd requests in flight, so
+ *  that the transaction list never holds more than the window. A response
+ *  frees its slot and sends the next request at once, lwm2m_step() resumes
+ *  the groups waiting for the rate. The window is halved on a timeout or a
+ *  retransmission and grows back by one request per window of responses,
+ *  up to groupWindow.
+ */
+
+#include "internals.h"
+
+#ifdef LWM2M_SERVER_MODE
+
+#define GROUP_TOKEN_LEN     4
+#define GROUP_HEADER_LEN    (4 + GROUP_TOKEN_LEN)
+#define GROUP_MAX_ELAPSED   10000
+
+struct _lwm2m_group_
+{
+    struct _lwm2m_group_ *  next;       // matches lwm2m_list_t::next
+    uint16_t                id;         // matches lwm2m_list_t::id
+    lwm2m_context_t *       contextP;
+    coap_method_t           method;
+    lwm2m_uri_t             uri;
+    uint8_t *               buffer;     // the serialized request
+    uint16_t                bufferLength;
+    uint8_t *               payload;    // for the clients with an alternative path
+    uint16_t                payloadLength;
+    uint16_t *              clientIDs;
+    size_t                  count;
+    size_t                  index;      // of the next client to send the request to
+    size_t                  pending;    // requests in flight
+    lwm2m_result_callback_t callback;
+    void *                  userData;
+};
+
+static void prv_free(lwm2m_group_t * groupP)
+{
+    lwm2m_free(groupP->buffer);
+    lwm2m_free(groupP->clientIDs);
+    lwm2m_free(groupP);
+}
+
+// adds the requests allowed since the last call, returns false if none can be sent
+static bool prv_refill(lwm2m_context_t * contextP)
+{
+    uint32_t now;
+    uint32_t elapsed;
+    uint64_t credit;
+    uint32_t maxCredit;
+
+    now = lwm2m_gettime_ms();
+    elapsed = now - contextP->groupTime;
+    if (elapsed > GROUP_MAX_ELAPSED) elapsed = GROUP_MAX_ELAPSED;
+    contextP->groupTime = now;
+
+    maxCredit = (uint32_t)contextP->groupWindow * 1000;
+    // in 64 bits, with 10 s elapsed the product overflows 32 bits above 429496 requests per second
+    credit = contextP->groupCredit + (uint64_t)elapsed * contextP->groupRate;
+    contextP->groupCredit = (credit > maxCredit) ? maxCredit : (uint32_t)credit;
+
+    return contextP->groupCredit >= 1000;
+}
+
+// the token of the requests of a group is their MID followed by the group ID
+static void prv_set_token(uint8_t * tokenP,
+                          uint16_t mID,
+                          uint16_t groupID)
+{
+    tokenP[0] = mID >> 8;
+    tokenP[1] = mID;
+    tokenP[2] = groupID >> 8;
+    tokenP[3] = groupID;
+}
+
+static void prv_result_callback(lwm2m_transaction_t * transacP,
+                                void * message);
+
+static lwm2m_transaction_t * prv_new_transaction(lwm2m_context_t * contextP,
+                                                 lwm2m_group_t * groupP,
+                                                 lwm2m_client_t * clientP)
+{
+    lwm2m_transaction_t * transacP;
+    uint8_t token[GROUP_TOKEN_LEN];
+    uint16_t mID;
+
+    mID = contextP->nextMID++;
+    prv_set_token(token, mID, groupP->id);
+
+    if (clientP->altPath != NULL)
+    {
+        transacP = transaction_new(COAP_TYPE_CON, groupP->method, clientP->altPath, &groupP->uri, mID, GROUP_TOKEN_LEN, token, ENDPOINT_CLIENT, (void *)clientP);
+        if (transacP == NULL) return NULL;
+        if (groupP->payload != NULL)
+        {
+            coap_set_payload(transacP->message, groupP->payload, groupP->payloadLength);
+        }
+    }
+    else
+    {
+        transacP = (lwm2m_transaction_t *)lwm2m_malloc(sizeof(lwm2m_transaction_t));
+        if (transacP == NULL) return NULL;
+        memset(transacP, 0, sizeof(lwm2m_transaction_t));
+        transacP->message = lwm2m_malloc(sizeof(coap_packet_t));
+        transacP->buffer = (uint8_t *)lwm2m_malloc(groupP->bufferLength);
+        if (transacP->message == NULL || transacP->buffer == NULL)
+        {
+            transaction_free(transacP);
+            return NULL;
+        }
+
+        // what prv_transaction_check_finished() looks at
+        coap_init_message(transacP->message, COAP_TYPE_CON, groupP->method, mID);
+        coap_set_header_token(transacP->message, token, GROUP_TOKEN_LEN);
+
+        memcpy(transacP->buffer, groupP->buffer, groupP->bufferLength);
+        transacP->buffer[2] = mID >> 8;
+        transacP->buffer[3] = mID;
+        memcpy(transacP->buffer + 4, token, GROUP_TOKEN_LEN);
+        transacP->buffer_len = groupP->bufferLength;
+
+        transacP->mID = mID;
+        transacP->peerType = ENDPOINT_CLIENT;
+        transacP->peerP = (void *)clientP;
+    }
+
+    transacP->callback = prv_result_callback;
+    transacP->userData = (void *)groupP;
+
+    return transacP;
+}
+
+// returns true if the group is finished and was freed
+static bool prv_send(lwm2m_context_t * contextP,
+                     lwm2m_group_t * groupP)
+{
+    while (groupP->index < groupP->count
+        && contextP->groupInFlight < contextP->groupCwnd
+        && prv_refill(contextP))
+    {
+        lwm2m_client_t * clientP;
+        lwm2m_transaction_t * transacP;
+        uint16_t clientID;
+
+        clientID = groupP->clientIDs[groupP->index++];
+        clientP = lifetime_get_client(contextP, clientID);
+        if (clientP == NULL)
+        {
+            groupP->callback(clientID, &groupP->uri, COAP_404_NOT_FOUND, NULL, 0, groupP->userData);
+            continue;
+        }
+
+        transacP = prv_new_transaction(contextP, groupP, clientP);
+        if (transacP == NULL)
+        {
+            groupP->callback(clientID, &groupP->uri, COAP_500_INTERNAL_SERVER_ERROR, NULL, 0, groupP->userData);
+            continue;
+        }
+
+        contextP->groupCredit -= 1000;
+        contextP->groupInFlight++;
+        groupP->pending++;
+        contextP->transactionList = (lwm2m_transaction_t *)LWM2M_LIST_ADD(contextP->transactionList, transacP);
+        (void)transaction_send(contextP, transacP);
+    }
+
+    if (groupP->index < groupP->count || groupP->pending != 0) return false;
+
+    contextP->groupList = (lwm2m_group_t *)LWM2M_LIST_RM(contextP->groupList, groupP->id, NULL);
+    groupP->callback(0, NULL, COAP_NO_ERROR, NULL, 0, groupP->userData);
+    prv_free(groupP);
+
+    return true;
+}
+
+static void prv_result_callback(lwm2m_transaction_t * transacP,
+                                void * message)
+{
+    lwm2m_group_t * groupP = (lwm2m_group_t *)transacP->userData;
+    lwm2m_context_t * contextP = groupP->contextP;
+    lwm2m_client_t * clientP = (lwm2m_client_t *)transacP->peerP;
+    coap_packet_t * packet = (coap_packet_t *)message;
+
+    contextP->groupInFlight--;
+    groupP->pending--;
+
+    // a timeout or a retransmitted request is taken as a sign of congestion
+    if (packet == NULL || transacP->retrans_counter > 1)
+    {
+        contextP->groupCwnd = (contextP->groupCwnd > 1) ? contextP->groupCwnd / 2 : 1;
+        contextP->groupAcked = 0;
+    }
+    else if (contextP->groupCwnd < contextP->groupWindow
+          && ++contextP->groupAcked >= contextP->groupCwnd)
+    {
+        contextP->groupCwnd++;
+        contextP->groupAcked = 0;
+    }
+
+    if (packet == NULL)
+    {
+        groupP->callback(clientP->internalID, &groupP->uri, COAP_503_SERVICE_UNAVAILABLE, NULL, 0, groupP->userData);
+    }
+    else
+    {
+        cache_result(clientP, &groupP->uri, (coap_packet_t *)transacP->message, packet);
+        groupP->callback(clientP->internalID, &groupP->uri, packet->code, packet->payload, packet->payload_len, groupP->userData);
+    }
+
+    (void)prv_send(contextP, groupP);
+}
+
+static int prv_make_group(lwm2m_context_t * contextP,
+                          const uint16_t * clientIDs,
+                          size_t count,
+                          lwm2m_uri_t * uriP,
+                          coap_method_t method,
+                          uint8_t * buffer,
+                          int length,
+                          lwm2m_result_callback_t callback,
+                          void * userData)
+{
+    lwm2m_group_t * groupP;
+    lwm2m_transaction_t * templateP;
+    uint8_t token[GROUP_TOKEN_LEN];
+
+    if (count == 0 || callback == NULL) return COAP_400_BAD_REQUEST;
+
+    groupP = (lwm2m_group_t *)lwm2m_malloc(sizeof(lwm2m_group_t) + length);
+    if (groupP == NULL) return COAP_500_INTERNAL_SERVER_ERROR;
+    memset(groupP, 0, sizeof(lwm2m_group_t));
+    groupP->id = lwm2m_list_newId((lwm2m_list_t *)contextP->groupList);
+    groupP->contextP = contextP;
+    groupP->method = method;
+    memcpy(&groupP->uri, uriP, sizeof(lwm2m_uri_t));
+    groupP->count = count;
+    groupP->callback = callback;
+    groupP->userData = userData;
+    if (buffer != NULL)
+    {
+        groupP->payload = (uint8_t *)(groupP + 1);
+        groupP->payloadLength = length;
+        memcpy(groupP->payload, buffer, length);
+    }
+
+    groupP->clientIDs = (uint16_t *)lwm2m_malloc(count * sizeof(uint16_t));
+    if (groupP->clientIDs == NULL)
+    {
+        prv_free(groupP);
+        return COAP_500_INTERNAL_SERVER_ERROR;
+    }
+    memcpy(groupP->clientIDs, clientIDs, count * sizeof(uint16_t));
+
+    // serialize the request once, the MID and the token are patched for each client.
+    // The template is never sent, the group stands for its peer.
+    memset(token, 0, GROUP_TOKEN_LEN);
+    templateP = transaction_new(COAP_TYPE_CON, method, NULL, uriP, 0, GROUP_TOKEN_LEN, token, ENDPOINT_CLIENT, (void *)groupP);
+    if (templateP == NULL)
+    {
+        prv_free(groupP);
+        return COAP_500_INTERNAL_SERVER_ERROR;
+    }
+    if (groupP->payload != NULL)
+    {
+        coap_set_payload(templateP->message, groupP->payload, groupP->payloadLength);
+    }
+    groupP->buffer = (uint8_t *)lwm2m_malloc(COAP_MAX_HEADER_SIZE + groupP->payloadLength);
+    if (groupP->buffer != NULL)
+    {
+        groupP->bufferLength = coap_serialize_message(templateP->message, groupP->buffer);
+    }
+    transaction_free(templateP);
+    if (groupP->bufferLength < GROUP_HEADER_LEN)
+    {
+        prv_free(groupP);
+        return COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    if (contextP->groupRate == 0) lwm2m_set_group_pacing(contextP, LWM2M_GROUP_RATE, LWM2M_GROUP_WINDOW);
+    if (contextP->groupList == NULL && contextP->groupInFlight == 0)
+    {
+        // a full window can be sent at once
+        contextP->groupTime = lwm2m_gettime_ms();
+        contextP->groupCredit = (uint32_t)contextP->groupWindow * 1000;
+    }
+    contextP->groupList = (lwm2m_group_t *)LWM2M_LIST_ADD(contextP->groupList, groupP);
+
+    (void)prv_send(contextP, groupP);
+
+    return COAP_NO_ERROR;
+}
+
+int lwm2m_dm_group_read(lwm2m_context_t * contextP,
+                        const uint16_t * clientIDs,
+                        size_t count,
+                        lwm2m_uri_t * uriP,
+                        lwm2m_result_callback_t callback,
+                        void * userData)
+{
+    return prv_make_group(contextP, clientIDs, count, uriP,
+                          COAP_GET, NULL, 0,
+                          callback, userData);
+}
+
+int lwm2m_dm_group_write(lwm2m_context_t * contextP,
+                         const uint16_t * clientIDs,
+                         size_t count,
+                         lwm2m_uri_t * uriP,
+                         uint8_t * buffer,
+                         int length,
+                         lwm2m_result_callback_t callback,
+                         void * userData)
+{
+    if (!LWM2M_URI_IS_SET_INSTANCE(uriP)
+     || length == 0)
+    {
+        return COAP_400_BAD_REQUEST;
+    }
+
+    return prv_make_group(contextP, clientIDs, count, uriP,
+                          LWM2M_URI_IS_SET_RESOURCE(uriP) ? COAP_PUT : COAP_POST,
+                          buffer, length,
+                          callback, userData);
+}
+
+void lwm2m_set_group_pacing(lwm2m_context_t * contextP,
+                            uint32_t rate,
+                            uint16_t window)
+{
+    contextP->groupRate = (rate != 0) ? rate : 1;
+    contextP->groupWindow = (window != 0) ? window : 1;
+    if (contextP->groupCwnd == 0 || contextP->groupCwnd > contextP->groupWindow)
+    {
+        contextP->groupCwnd = contextP->groupWindow;
+    }
+}
+
+// resumes the groups waiting for the rate
+void group_step(lwm2m_context_t * contextP,
+                time_t * timeoutP)
+{
+    lwm2m_group_t * groupP;
+
+    groupP = contextP->groupList;
+    while (groupP != NULL)
+    {
+        lwm2m_group_t * nextP = groupP->next;
+
+        if (!prv_send(contextP, groupP)
+         && groupP->index < groupP->count
+         && contextP->groupInFlight < contextP->groupCwnd)
+        {
+            // the next requests are allowed within the second
+            if (*timeoutP > 1) *timeoutP = 1;
+        }
+        groupP = nextP;
+    }
+}
+
+void group_free_all(lwm2m_context_t * contextP)
+{
+    lwm2m_transaction_t * transacP;
+
+    // the transactions of the groups are freed with the transaction list
+    for (transacP = contextP->transactionList ; transacP != NULL ; transacP = transacP->next)
+    {
+        if (transacP->callback == prv_result_callback) transacP->callback = NULL;
+    }
+    while (contextP->groupList != NULL)
+    {
+        lwm2m_group_t * groupP = contextP->groupList;
+
+        contextP->groupList = groupP->next;
+        prv_free(groupP);
+    }
+}
+
+#endif
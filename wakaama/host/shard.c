@@ -0,0 +1,721 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - sharded server runtime
+ *
+ *******************************************************************************/
+
+/*
+ * Each worker owns a context, a socket, the sessions of the addresses
+ * received on it and a queue of requests. The queue is a stack pushed with
+ * a compare-and-swap by any thread and emptied at once by the worker, which
+ * runs the requests in their order; the worker is woken through an eventfd
+ * only by the push finding the stack empty.
+ *
+ * A client keeps its worker while its address does not change. After a NAT
+ * rebinding, its update may reach another worker which answers 4.04, and the
+ * client registers again there; the former registration expires with its
+ * lifetime.
+ */
+
+#define _GNU_SOURCE
+
+#include "shard.h"
+#include "internals.h"
+
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define SHARD_BATCH         32      // datagrams read by a recvmmsg()
+#define SHARD_BATCHES       8       // read before looking at the queue again
+#define SHARD_PACKET_SIZE   2048
+#define SHARD_STEP_MS       1000    // at most between two lwm2m_step()
+#define SHARD_KEY_LEN       18      // port and IPv6 address
+#define SHARD_RCVBUF        (1 << 20)   // for the bursts of datagrams between two reads, capped by net.core.rmem_max
+
+typedef enum
+{
+    SHARD_READ,
+    SHARD_WRITE,
+    SHARD_EXECUTE,
+    SHARD_CREATE,
+    SHARD_DELETE,
+    SHARD_OBSERVE,
+    SHARD_OBSERVE_CANCEL,
+    SHARD_CALL
+} shard_operation_t;
+
+typedef struct _shard_command_
+{
+    struct _shard_command_ * next;
+    shard_operation_t       operation;
+    uint16_t                clientID;
+    lwm2m_uri_t             uri;
+    lwm2m_result_callback_t callback;
+    lwm2m_shard_function_t  function;
+    void *                  userData;
+    int                     length;
+    uint8_t                 buffer[];
+} shard_command_t;
+
+// the session of the clients sending from an address
+typedef struct _shard_connection_
+{
+    struct _shard_connection_ * next;
+    uint32_t                hash;
+    uint8_t                 key[SHARD_KEY_LEN];
+    socklen_t               addrLen;
+    struct sockaddr_storage addr;
+} shard_connection_t;
+
+typedef struct
+{
+    lwm2m_shard_runtime_t * runtimeP;
+    int                     index;
+    int                     sock;
+    int                     wakeFd;
+    pthread_t               thread;
+    bool                    started;
+    lwm2m_context_t *       contextP;
+    shard_command_t *       commandStack;       // pushed by any thread, newest first
+    shard_connection_t **   connectionTable;
+    size_t                  connectionCount;
+    size_t                  connectionTableSize;
+    uint8_t                 (* buffers)[SHARD_PACKET_SIZE];
+} shard_t;
+
+struct _lwm2m_shard_runtime_
+{
+    int                         count;
+    uint16_t                    port;
+    int                         stop;
+    lwm2m_shard_init_callback_t initCallback;
+    void *                      userData;
+    shard_t *                   shards[LWM2M_SHARD_MAX];
+};
+
+static __thread int currentShard = -1;
+
+// port and address, the IPv4 clients of a dual-stack socket come as mapped addresses
+static size_t prv_key(const struct sockaddr_storage * addrP,
+                      uint8_t * key)
+{
+    if (addrP->ss_family == AF_INET6)
+    {
+        const struct sockaddr_in6 * in6P = (const struct sockaddr_in6 *)addrP;
+
+        memcpy(key, &in6P->sin6_port, 2);
+        memcpy(key + 2, &in6P->sin6_addr, 16);
+        return 18;
+    }
+    else
+    {
+        const struct sockaddr_in * inP = (const struct sockaddr_in *)addrP;
+
+        memcpy(key, &inP->sin_port, 2);
+        memcpy(key + 2, &inP->sin_addr, 4);
+        memset(key + 6, 0, SHARD_KEY_LEN - 6);
+        return 6;
+    }
+}
+
+static bool prv_growConnections(shard_t * shardP)
+{
+    shard_connection_t ** tableP;
+    size_t size;
+    size_t i;
+
+    size = (shardP->connectionTableSize != 0) ? shardP->connectionTableSize * 2 : 256;
+    tableP = (shard_connection_t **)lwm2m_malloc(size * sizeof(shard_connection_t *));
+    if (tableP == NULL) return false;
+    memset(tableP, 0, size * sizeof(shard_connection_t *));
+
+    for (i = 0 ; i < shardP->connectionTableSize ; i++)
+    {
+        while (shardP->connectionTable[i] != NULL)
+        {
+            shard_connection_t * connP = shardP->connectionTable[i];
+
+            shardP->connectionTable[i] = connP->next;
+            connP->next = tableP[connP->hash & (size - 1)];
+            tableP[connP->hash & (size - 1)] = connP;
+        }
+    }
+    lwm2m_free(shardP->connectionTable);
+    shardP->connectionTable = tableP;
+    shardP->connectionTableSize = size;
+
+    return true;
+}
+
+static shard_connection_t * prv_getConnection(shard_t * shardP,
+                                              const struct sockaddr_storage * addrP,
+                                              socklen_t addrLen)
+{
+    shard_connection_t * connP;
+    uint8_t key[SHARD_KEY_LEN];
+    uint32_t hash;
+
+    prv_key(addrP, key);
+    hash = utils_hash(key, SHARD_KEY_LEN);
+    if (shardP->connectionTableSize != 0)
+    {
+        for (connP = shardP->connectionTable[hash & (shardP->connectionTableSize - 1)] ; connP != NULL ; connP = connP->next)
+        {
+            if (connP->hash == hash && memcmp(connP->key, key, SHARD_KEY_LEN) == 0) return connP;
+        }
+    }
+
+    if (shardP->connectionCount >= shardP->connectionTableSize
+     && !prv_growConnections(shardP))
+    {
+        return NULL;
+    }
+    connP = (shard_connection_t *)lwm2m_malloc(sizeof(shard_connection_t));
+    if (connP == NULL) return NULL;
+    connP->hash = hash;
+    memcpy(connP->key, key, SHARD_KEY_LEN);
+    connP->addrLen = addrLen;
+    memcpy(&connP->addr, addrP, addrLen);
+    connP->next = shardP->connectionTable[hash & (shardP->connectionTableSize - 1)];
+    shardP->connectionTable[hash & (shardP->connectionTableSize - 1)] = connP;
+    shardP->connectionCount++;
+
+    return connP;
+}
+
+static uint8_t prv_send(void * sessionH,
+                        uint8_t * buffer,
+                        size_t length,
+                        void * userData)
+{
+    shard_t * shardP = (shard_t *)userData;
+    shard_connection_t * connP = (shard_connection_t *)sessionH;
+
+    if (connP == NULL) return COAP_500_INTERNAL_SERVER_ERROR;
+    if (sendto(shardP->sock, buffer, length, 0, (struct sockaddr *)&connP->addr, connP->addrLen) < 0)
+    {
+        return COAP_500_INTERNAL_SERVER_ERROR;
+    }
+    return COAP_NO_ERROR;
+}
+
+static void prv_receive(shard_t * shardP)
+{
+    struct mmsghdr messages[SHARD_BATCH];
+    struct iovec iovecs[SHARD_BATCH];
+    struct sockaddr_storage addrs[SHARD_BATCH];
+    int batch;
+    int count;
+    int i;
+
+    for (batch = 0 ; batch < SHARD_BATCHES ; batch++)
+    {
+        memset(messages, 0, sizeof(messages));
+        for (i = 0 ; i < SHARD_BATCH ; i++)
+        {
+            iovecs[i].iov_base = shardP->buffers[i];
+            iovecs[i].iov_len = SHARD_PACKET_SIZE;
+            messages[i].msg_hdr.msg_iov = iovecs + i;
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_name = addrs + i;
+            messages[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+        }
+        count = recvmmsg(shardP->sock, messages, SHARD_BATCH, MSG_DONTWAIT, NULL);
+        if (count <= 0) return;
+
+        for (i = 0 ; i < count ; i++)
+        {
+            shard_connection_t * connP;
+
+            // truncated
+            if ((messages[i].msg_hdr.msg_flags & MSG_TRUNC) != 0) continue;
+            connP = prv_getConnection(shardP, addrs + i, messages[i].msg_hdr.msg_namelen);
+            if (connP == NULL) continue;
+            lwm2m_handle_packet(shardP->contextP, shardP->buffers[i], messages[i].msg_len, connP);
+        }
+        if (count < SHARD_BATCH) return;
+    }
+}
+
+static void prv_runCommand(shard_t * shardP,
+                           shard_command_t * commandP)
+{
+    lwm2m_context_t * contextP = shardP->contextP;
+    int result;
+
+    switch (commandP->operation)
+    {
+    case SHARD_READ:
+        result = lwm2m_dm_read(contextP, commandP->clientID, &commandP->uri, commandP->callback, commandP->userData);
+        break;
+    case SHARD_WRITE:
+        result = lwm2m_dm_write(contextP, commandP->clientID, &commandP->uri, commandP->buffer, commandP->length, commandP->callback, commandP->userData);
+        break;
+    case SHARD_EXECUTE:
+        result = lwm2m_dm_execute(contextP, commandP->clientID, &commandP->uri, commandP->buffer, commandP->length, commandP->callback, commandP->userData);
+        break;
+    case SHARD_CREATE:
+        result = lwm2m_dm_create(contextP, commandP->clientID, &commandP->uri, commandP->buffer, commandP->length, commandP->callback, commandP->userData);
+        break;
+    case SHARD_DELETE:
+        result = lwm2m_dm_delete(contextP, commandP->clientID, &commandP->uri, commandP->callback, commandP->userData);
+        break;
+    case SHARD_OBSERVE:
+        result = lwm2m_observe(contextP, commandP->clientID, &commandP->uri, commandP->callback, commandP->userData);
+        break;
+    case SHARD_OBSERVE_CANCEL:
+        result = lwm2m_observe_cancel(contextP, commandP->clientID, &commandP->uri, commandP->callback, commandP->userData);
+        break;
+    case SHARD_CALL:
+    default:
+        commandP->function(contextP, commandP->userData);
+        result = COAP_NO_ERROR;
+        break;
+    }
+    if (result != COAP_NO_ERROR && commandP->callback != NULL)
+    {
+        commandP->callback(commandP->clientID, &commandP->uri, result, NULL, 0, commandP->userData);
+    }
+}
+
+// with refused, the commands are not run but reported as such
+static void prv_runCommands(shard_t * shardP,
+                            int refused)
+{
+    shard_command_t * commandP;
+    shard_command_t * orderedP;
+
+    commandP = __atomic_exchange_n(&shardP->commandStack, NULL, __ATOMIC_ACQUIRE);
+    orderedP = NULL;
+    while (commandP != NULL)
+    {
+        shard_command_t * nextP = commandP->next;
+
+        commandP->next = orderedP;
+        orderedP = commandP;
+        commandP = nextP;
+    }
+
+    while (orderedP != NULL)
+    {
+        commandP = orderedP;
+        orderedP = commandP->next;
+        if (refused == COAP_NO_ERROR)
+        {
+            prv_runCommand(shardP, commandP);
+        }
+        else if (commandP->callback != NULL)
+        {
+            commandP->callback(commandP->clientID, &commandP->uri, refused, NULL, 0, commandP->userData);
+        }
+        lwm2m_free(commandP);
+    }
+}
+
+static void * prv_run(void * arg)
+{
+    shard_t * shardP = (shard_t *)arg;
+    lwm2m_shard_runtime_t * runtimeP = shardP->runtimeP;
+    uint32_t nextStep;
+
+    currentShard = shardP->index;
+    if (runtimeP->initCallback != NULL)
+    {
+        runtimeP->initCallback(shardP->contextP, shardP->index, runtimeP->userData);
+    }
+
+    nextStep = lwm2m_gettime_ms();
+    while (!__atomic_load_n(&runtimeP->stop, __ATOMIC_ACQUIRE))
+    {
+        struct pollfd fds[2];
+        uint32_t now;
+        int32_t wait;
+
+        now = lwm2m_gettime_ms();
+        if ((int32_t)(now - nextStep) >= 0)
+        {
+            time_t timeout = SHARD_STEP_MS / 1000;
+
+            lwm2m_step(shardP->contextP, &timeout);
+            nextStep = now + ((timeout < SHARD_STEP_MS / 1000) ? timeout * 1000 : SHARD_STEP_MS);
+        }
+        wait = (int32_t)(nextStep - now);
+        if (wait < 0) wait = 0;
+
+        fds[0].fd = shardP->sock;
+        fds[0].events = POLLIN;
+        fds[1].fd = shardP->wakeFd;
+        fds[1].events = POLLIN;
+        if (poll(fds, 2, wait) < 0 && errno != EINTR) break;
+
+        if ((fds[0].revents & POLLIN) != 0)
+        {
+            prv_receive(shardP);
+        }
+        if ((fds[1].revents & POLLIN) != 0)
+        {
+            uint64_t value;
+
+            if (read(shardP->wakeFd, &value, sizeof(value)) < 0) value = 0;
+        }
+        prv_runCommands(shardP, COAP_NO_ERROR);
+    }
+
+    prv_runCommands(shardP, COAP_503_SERVICE_UNAVAILABLE);
+    lwm2m_close(shardP->contextP);
+    shardP->contextP = NULL;
+
+    return NULL;
+}
+
+static int prv_push(lwm2m_shard_runtime_t * runtimeP,
+                    int shard,
+                    shard_command_t * commandP)
+{
+    shard_t * shardP;
+    shard_command_t * headP;
+
+    if (shard < 0 || shard >= runtimeP->count)
+    {
+        lwm2m_free(commandP);
+        return COAP_400_BAD_REQUEST;
+    }
+    shardP = runtimeP->shards[shard];
+
+    headP = __atomic_load_n(&shardP->commandStack, __ATOMIC_RELAXED);
+    do
+    {
+        commandP->next = headP;
+    } while (!__atomic_compare_exchange_n(&shardP->commandStack, &headP, commandP, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    // the worker empties the whole stack: only the first command needs to wake it
+    if (headP == NULL)
+    {
+        uint64_t one = 1;
+
+        if (write(shardP->wakeFd, &one, sizeof(one)) < 0)
+        {
+            // the counter is already set
+        }
+    }
+
+    return COAP_NO_ERROR;
+}
+
+static int prv_request(lwm2m_shard_runtime_t * runtimeP,
+                       shard_operation_t operation,
+                       lwm2m_shard_client_t client,
+                       lwm2m_uri_t * uriP,
+                       uint8_t * buffer,
+                       int length,
+                       lwm2m_result_callback_t callback,
+                       void * userData)
+{
+    shard_command_t * commandP;
+
+    if (length < 0 || (length > 0 && buffer == NULL)) return COAP_400_BAD_REQUEST;
+
+    commandP = (shard_command_t *)lwm2m_malloc(sizeof(shard_command_t) + length);
+    if (commandP == NULL) return COAP_500_INTERNAL_SERVER_ERROR;
+    memset(commandP, 0, sizeof(shard_command_t));
+    commandP->operation = operation;
+    commandP->clientID = LWM2M_SHARD_CLIENT_ID(client);
+    if (uriP != NULL) commandP->uri = *uriP;
+    commandP->callback = callback;
+    commandP->userData = userData;
+    commandP->length = length;
+    if (length > 0) memcpy(commandP->buffer, buffer, length);
+
+    return prv_push(runtimeP, LWM2M_SHARD_INDEX(client), commandP);
+}
+
+static void prv_free(lwm2m_shard_runtime_t * runtimeP)
+{
+    int i;
+
+    for (i = 0 ; i < runtimeP->count ; i++)
+    {
+        shard_t * shardP = runtimeP->shards[i];
+        size_t j;
+
+        if (shardP == NULL) continue;
+        // queued after the worker stopped
+        prv_runCommands(shardP, COAP_503_SERVICE_UNAVAILABLE);
+        if (shardP->contextP != NULL) lwm2m_close(shardP->contextP);
+        if (shardP->sock >= 0) close(shardP->sock);
+        if (shardP->wakeFd >= 0) close(shardP->wakeFd);
+        for (j = 0 ; j < shardP->connectionTableSize ; j++)
+        {
+            while (shardP->connectionTable[j] != NULL)
+            {
+                shard_connection_t * connP = shardP->connectionTable[j];
+
+                shardP->connectionTable[j] = connP->next;
+                lwm2m_free(connP);
+            }
+        }
+        lwm2m_free(shardP->connectionTable);
+        lwm2m_free(shardP->buffers);
+        lwm2m_free(shardP);
+    }
+    lwm2m_free(runtimeP);
+}
+
+// a dual-stack socket, or an IPv4 one without IPv6
+static int prv_open(uint16_t port)
+{
+    int size = SHARD_RCVBUF;
+    struct sockaddr_in6 addr6;
+    struct sockaddr_in addr;
+    int sock;
+    int on = 1;
+    int off = 0;
+
+    sock = socket(AF_INET6, SOCK_DGRAM, 0);
+    if (sock >= 0)
+    {
+        memset(&addr6, 0, sizeof(addr6));
+        addr6.sin6_family = AF_INET6;
+        addr6.sin6_port = htons(port);
+        addr6.sin6_addr = in6addr_any;
+        if (setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off)) == 0
+         && setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == 0
+         && bind(sock, (struct sockaddr *)&addr6, sizeof(addr6)) == 0)
+        {
+            // the default buffer is best effort
+            (void)setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+            return sock;
+        }
+        close(sock);
+    }
+
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0
+     || bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        close(sock);
+        return -1;
+    }
+    (void)setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    return sock;
+}
+
+static uint16_t prv_boundPort(int sock)
+{
+    struct sockaddr_storage addr;
+    socklen_t addrLen = sizeof(addr);
+
+    if (getsockname(sock, (struct sockaddr *)&addr, &addrLen) != 0) return 0;
+    if (addr.ss_family == AF_INET6) return ntohs(((struct sockaddr_in6 *)&addr)->sin6_port);
+    return ntohs(((struct sockaddr_in *)&addr)->sin_port);
+}
+
+lwm2m_shard_runtime_t * lwm2m_shard_start(const char * port,
+                                          int shardCount,
+                                          bool pin,
+                                          lwm2m_shard_init_callback_t initCallback,
+                                          void * userData)
+{
+    lwm2m_shard_runtime_t * runtimeP;
+    long cores;
+    int i;
+
+    if (port == NULL || shardCount < 1 || shardCount > LWM2M_SHARD_MAX) return NULL;
+
+    runtimeP = (lwm2m_shard_runtime_t *)lwm2m_malloc(sizeof(lwm2m_shard_runtime_t));
+    if (runtimeP == NULL) return NULL;
+    memset(runtimeP, 0, sizeof(lwm2m_shard_runtime_t));
+    runtimeP->count = shardCount;
+    runtimeP->port = (uint16_t)atoi(port);
+    runtimeP->initCallback = initCallback;
+    runtimeP->userData = userData;
+
+    for (i = 0 ; i < shardCount ; i++)
+    {
+        shard_t * shardP;
+
+        shardP = (shard_t *)lwm2m_malloc(sizeof(shard_t));
+        if (shardP == NULL) goto error;
+        memset(shardP, 0, sizeof(shard_t));
+        shardP->sock = -1;
+        shardP->wakeFd = -1;
+        runtimeP->shards[i] = shardP;
+        shardP->runtimeP = runtimeP;
+        shardP->index = i;
+
+        // the first socket takes the port when any, the others join it
+        shardP->sock = prv_open(runtimeP->port);
+        if (shardP->sock < 0) goto error;
+        if (runtimeP->port == 0) runtimeP->port = prv_boundPort(shardP->sock);
+        shardP->wakeFd = eventfd(0, EFD_NONBLOCK);
+        if (shardP->wakeFd < 0) goto error;
+        shardP->buffers = (uint8_t (*)[SHARD_PACKET_SIZE])lwm2m_malloc(SHARD_BATCH * SHARD_PACKET_SIZE);
+        if (shardP->buffers == NULL) goto error;
+        shardP->contextP = lwm2m_init(NULL, prv_send, shardP);
+        if (shardP->contextP == NULL) goto error;
+    }
+
+    cores = sysconf(_SC_NPROCESSORS_ONLN);
+    for (i = 0 ; i < shardCount ; i++)
+    {
+        shard_t * shardP = runtimeP->shards[i];
+
+        if (pthread_create(&shardP->thread, NULL, prv_run, shardP) != 0) goto error;
+        shardP->started = true;
+        if (pin && cores > 0)
+        {
+            cpu_set_t set;
+
+            CPU_ZERO(&set);
+            CPU_SET(i % cores, &set);
+            pthread_setaffinity_np(shardP->thread, sizeof(set), &set);
+        }
+    }
+
+    return runtimeP;
+
+error:
+    lwm2m_shard_stop(runtimeP);
+    return NULL;
+}
+
+void lwm2m_shard_stop(lwm2m_shard_runtime_t * runtimeP)
+{
+    int i;
+
+    __atomic_store_n(&runtimeP->stop, 1, __ATOMIC_RELEASE);
+    for (i = 0 ; i < runtimeP->count ; i++)
+    {
+        shard_t * shardP = runtimeP->shards[i];
+        uint64_t one = 1;
+
+        if (shardP == NULL || !shardP->started) continue;
+        if (write(shardP->wakeFd, &one, sizeof(one)) < 0)
+        {
+            // the counter is already set
+        }
+        pthread_join(shardP->thread, NULL);
+    }
+    prv_free(runtimeP);
+}
+
+uint16_t lwm2m_shard_port(lwm2m_shard_runtime_t * runtimeP)
+{
+    return runtimeP->port;
+}
+
+int lwm2m_shard_current(void)
+{
+    return currentShard;
+}
+
+int lwm2m_shard_dm_read(lwm2m_shard_runtime_t * runtimeP,
+                        lwm2m_shard_client_t client,
+                        lwm2m_uri_t * uriP,
+                        lwm2m_result_callback_t callback,
+                        void * userData)
+{
+    return prv_request(runtimeP, SHARD_READ, client, uriP, NULL, 0, callback, userData);
+}
+
+int lwm2m_shard_dm_write(lwm2m_shard_runtime_t * runtimeP,
+                         lwm2m_shard_client_t client,
+                         lwm2m_uri_t * uriP,
+                         uint8_t * buffer,
+                         int length,
+                         lwm2m_result_callback_t callback,
+                         void * userData)
+{
+    return prv_request(runtimeP, SHARD_WRITE, client, uriP, buffer, length, callback, userData);
+}
+
+int lwm2m_shard_dm_execute(lwm2m_shard_runtime_t * runtimeP,
+                           lwm2m_shard_client_t client,
+                           lwm2m_uri_t * uriP,
+                           uint8_t * buffer,
+                           int length,
+                           lwm2m_result_callback_t callback,
+                           void * userData)
+{
+    return prv_request(runtimeP, SHARD_EXECUTE, client, uriP, buffer, length, callback, userData);
+}
+
+int lwm2m_shard_dm_create(lwm2m_shard_runtime_t * runtimeP,
+                          lwm2m_shard_client_t client,
+                          lwm2m_uri_t * uriP,
+                          uint8_t * buffer,
+                          int length,
+                          lwm2m_result_callback_t callback,
+                          void * userData)
+{
+    return prv_request(runtimeP, SHARD_CREATE, client, uriP, buffer, length, callback, userData);
+}
+
+int lwm2m_shard_dm_delete(lwm2m_shard_runtime_t * runtimeP,
+                          lwm2m_shard_client_t client,
+                          lwm2m_uri_t * uriP,
+                          lwm2m_result_callback_t callback,
+                          void * userData)
+{
+    return prv_request(runtimeP, SHARD_DELETE, client, uriP, NULL, 0, callback, userData);
+}
+
+int lwm2m_shard_observe(lwm2m_shard_runtime_t * runtimeP,
+                        lwm2m_shard_client_t client,
+                        lwm2m_uri_t * uriP,
+                        lwm2m_result_callback_t callback,
+                        void * userData)
+{
+    return prv_request(runtimeP, SHARD_OBSERVE, client, uriP, NULL, 0, callback, userData);
+}
+
+int lwm2m_shard_observe_cancel(lwm2m_shard_runtime_t * runtimeP,
+                               lwm2m_shard_client_t client,
+                               lwm2m_uri_t * uriP,
+                               lwm2m_result_callback_t callback,
+                               void * userData)
+{
+    return prv_request(runtimeP, SHARD_OBSERVE_CANCEL, client, uriP, NULL, 0, callback, userData);
+}
+
+int lwm2m_shard_call(lwm2m_shard_runtime_t * runtimeP,
+                     int shard,
+                     lwm2m_shard_function_t function,
+                     void * arg)
+{
+    shard_command_t * commandP;
+
+    if (function == NULL) return COAP_400_BAD_REQUEST;
+
+    commandP = (shard_command_t *)lwm2m_malloc(sizeof(shard_command_t));
+    if (commandP == NULL) return COAP_500_INTERNAL_SERVER_ERROR;
+    memset(commandP, 0, sizeof(shard_command_t));
+    commandP->operation = SHARD_CALL;
+    commandP->function = function;
+    commandP->userData = arg;
+
+    return prv_push(runtimeP, shard, commandP);
+}
@@ -0,0 +1,79 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - sharded server runtime
+ *
+ *******************************************************************************/
+
+/*
+ * Sharded LwM2M server runtime for Linux hosts, see shard.c.
+ *
+ * N workers each run a server context on a thread pinned to a core, with
+ * their own UDP socket bound to the same port with SO_REUSEPORT: the kernel
+ * hashes the address of each datagram to one socket, so a client registers,
+ * updates and answers on the worker owning its address. The contexts share
+ * no state and need no lock; a request for a client is queued to its worker.
+ *
+ * Built with LWM2M_SERVER_MODE, not part of the firmware. The platform
+ * functions (lwm2m_malloc(), lwm2m_free(), lwm2m_gettime()...) are called
+ * from all the workers and must be thread-safe.
+ */
+
+#ifndef LWM2M_SHARD_H_
+#define LWM2M_SHARD_H_
+
+#include "liblwm2m.h"
+
+#define LWM2M_SHARD_MAX     64
+
+// a client of the runtime: the index of its worker in the high 16 bits, its ID in the context of the worker in the low ones
+typedef uint32_t lwm2m_shard_client_t;
+
+#define LWM2M_SHARD_CLIENT(shard, clientID) (((uint32_t)(shard) << 16) | (uint16_t)(clientID))
+#define LWM2M_SHARD_INDEX(client)           ((int)((client) >> 16))
+#define LWM2M_SHARD_CLIENT_ID(client)       ((uint16_t)(client))
+
+typedef struct _lwm2m_shard_runtime_ lwm2m_shard_runtime_t;
+
+// Called on the thread of each worker once its context is created, e.g. to set its monitoring callback.
+typedef void (*lwm2m_shard_init_callback_t)(lwm2m_context_t * contextP, int shard, void * userData);
+// Run on the thread of a worker by lwm2m_shard_call().
+typedef void (*lwm2m_shard_function_t)(lwm2m_context_t * contextP, void * arg);
+
+// Start shardCount workers on the UDP port, "0" for any. With pin, worker i runs on core i modulo the cores count.
+// Returns NULL if the sockets or the threads could not be created.
+lwm2m_shard_runtime_t * lwm2m_shard_start(const char * port, int shardCount, bool pin, lwm2m_shard_init_callback_t initCallback, void * userData);
+// Stop the workers and close their contexts. The requests still queued are reported with COAP_503_SERVICE_UNAVAILABLE.
+void lwm2m_shard_stop(lwm2m_shard_runtime_t * runtimeP);
+// the UDP port of the workers
+uint16_t lwm2m_shard_port(lwm2m_shard_runtime_t * runtimeP);
+// the index of the worker running the caller, -1 outside the workers
+int lwm2m_shard_current(void);
+
+// Cross-shard Device Management and Information Reporting APIs.
+// Callable from any thread, the request is queued to the worker owning the client and sent from its thread. The uri
+// and the buffer are copied. The callback is called on that worker, with the ID of the client in its context: the
+// client is LWM2M_SHARD_CLIENT(lwm2m_shard_current(), clientID). If the context refuses the request, the callback is
+// called with the error, e.g. COAP_404_NOT_FOUND for a client gone.
+// Return COAP_NO_ERROR once queued, COAP_400_BAD_REQUEST for an unknown worker or COAP_500_INTERNAL_SERVER_ERROR.
+int lwm2m_shard_dm_read(lwm2m_shard_runtime_t * runtimeP, lwm2m_shard_client_t client, lwm2m_uri_t * uriP, lwm2m_result_callback_t callback, void * userData);
+int lwm2m_shard_dm_write(lwm2m_shard_runtime_t * runtimeP, lwm2m_shard_client_t client, lwm2m_uri_t * uriP, uint8_t * buffer, int length, lwm2m_result_callback_t callback, void * userData);
+int lwm2m_shard_dm_execute(lwm2m_shard_runtime_t * runtimeP, lwm2m_shard_client_t client, lwm2m_uri_t * uriP, uint8_t * buffer, int length, lwm2m_result_callback_t callback, void * userData);
+int lwm2m_shard_dm_create(lwm2m_shard_runtime_t * runtimeP, lwm2m_shard_client_t client, lwm2m_uri_t * uriP, uint8_t * buffer, int length, lwm2m_result_callback_t callback, void * userData);
+int lwm2m_shard_dm_delete(lwm2m_shard_runtime_t * runtimeP, lwm2m_shard_client_t client, lwm2m_uri_t * uriP, lwm2m_result_callback_t callback, void * userData);
+int lwm2m_shard_observe(lwm2m_shard_runtime_t * runtimeP, lwm2m_shard_client_t client, lwm2m_uri_t * uriP, lwm2m_result_callback_t callback, void * userData);
+int lwm2m_shard_observe_cancel(lwm2m_shard_runtime_t * runtimeP, lwm2m_shard_client_t client, lwm2m_uri_t * uriP, lwm2m_result_callback_t callback, void * userData);
+// Run function with the context of the worker shard, e.g. for the group requests to its clients.
+int lwm2m_shard_call(lwm2m_shard_runtime_t * runtimeP, int shard, lwm2m_shard_function_t function, void * arg);
+
+#endif
@@ -70,6 +70,81 @@
 
 #define LWM2M_DEFAULT_LIFETIME  86400
 
+// rfc7252 EXCHANGE_LIFETIME with the default transmission parameters, in seconds
+#define COAP_EXCHANGE_LIFETIME  247
+
+// memory caps of the duplicate request cache
+#ifndef LWM2M_DEDUP_MAX_ENTRIES
+#define LWM2M_DEDUP_MAX_ENTRIES         8
+#endif
+#ifndef LWM2M_DEDUP_MAX_PEER_ENTRIES
+#define LWM2M_DEDUP_MAX_PEER_ENTRIES    4
+#endif
+#ifndef LWM2M_DEDUP_MAX_BYTES
+#define LWM2M_DEDUP_MAX_BYTES           1024
+#endif
+
+// limits of the requests deferred by object callbacks returning COAP_PENDING
+#ifndef LWM2M_PENDING_MAX
+#define LWM2M_PENDING_MAX               4
+#endif
+#ifndef LWM2M_PENDING_TIMEOUT
+#define LWM2M_PENDING_TIMEOUT           60 // seconds
+#endif
+
+// registration and bootstrap retries after a failure, in seconds: the delay is drawn at
+// random up to a window doubling from the base delay at each failure, up to the max delay
+#ifndef LWM2M_RETRY_BASE_DELAY
+#define LWM2M_RETRY_BASE_DELAY          30
+#endif
+#ifndef LWM2M_RETRY_MAX_DELAY
+#define LWM2M_RETRY_MAX_DELAY           3600
+#endif
+
+// size of the saved session state and skip of the observe counters restored from it
+#ifndef LWM2M_PERSIST_MAX_SIZE
+#define LWM2M_PERSIST_MAX_SIZE          512
+#endif
+#ifndef LWM2M_PERSIST_COUNTER_SKIP
+#define LWM2M_PERSIST_COUNTER_SKIP      1024
+#endif
+// notifications after which the counters are saved again, below LWM2M_PERSIST_COUNTER_SKIP
+#ifndef LWM2M_PERSIST_COUNTER_INTERVAL
+#define LWM2M_PERSIST_COUNTER_INTERVAL  (LWM2M_PERSIST_COUNTER_SKIP / 2)
+#endif
+
+// observations of the remote clients, server side: initial size of the slot table
+#ifndef LWM2M_OBSERVATION_MIN_SLOTS
+#define LWM2M_OBSERVATION_MIN_SLOTS     16
+#endif
+#define LWM2M_OBSERVATION_NO_SLOT       0xFFFF
+
+// registry of the clients, server side: maximum length of a session address
+#ifndef LWM2M_REGISTRY_MAX_SESSION
+#define LWM2M_REGISTRY_MAX_SESSION      64
+#endif
+
+// values cache of the remote clients, server side: entries per client and largest value kept
+#ifndef LWM2M_CACHE_MAX_ENTRIES
+#define LWM2M_CACHE_MAX_ENTRIES         8
+#endif
+#ifndef LWM2M_CACHE_MAX_PAYLOAD
+#define LWM2M_CACHE_MAX_PAYLOAD         256
+#endif
+
+// group operations, server side: default requests per second and requests in flight
+#ifndef LWM2M_GROUP_RATE
+#define LWM2M_GROUP_RATE                1000
+#endif
+#ifndef LWM2M_GROUP_WINDOW
+#define LWM2M_GROUP_WINDOW              64
+#endif
+
+// object lists of the remote clients, server side: size of the table of the shared lists
+#ifndef LWM2M_SHARED_OBJECTS_BUCKETS
+#define LWM2M_SHARED_OBJECTS_BUCKETS    32
+#endif
+
 #define REG_LWM2M_RESOURCE_TYPE     ">;rt=\"oma.lwm2m\","
 #define REG_LWM2M_RESOURCE_TYPE_LEN 17
 #define REG_ALT_PATH_LINK           "<%s"REG_LWM2M_RESOURCE_TYPE
@@ -133,14 +208,24 @@ lwm2m_uri_t * lwm2m_decode_uri(char * altPath, multi_option_t *uriPath);
 int prv_get_number(uint8_t * uriString, size_t uriLength);
 
 // defined in objects.c
-coap_status_t object_read(lwm2m_context_t * contextP, lwm2m_uri_t * uriP, uint8_t ** bufferP, size_t * lengthP);
-coap_status_t object_write(lwm2m_context_t * contextP, lwm2m_uri_t * uriP, uint8_t * buffer, size_t length);
+coap_status_t object_read(lwm2m_context_t * contextP, lwm2m_uri_t * uriP, lwm2m_media_type_t * formatP, uint8_t ** bufferP, size_t * lengthP);
+coap_status_t object_write(lwm2m_context_t * contextP, lwm2m_uri_t * uriP, lwm2m_media_type_t format, uint8_t * buffer, size_t length);
 coap_status_t object_create(lwm2m_context_t * contextP, lwm2m_uri_t * uriP, uint8_t * buffer, size_t length);
 coap_status_t object_execute(lwm2m_context_t * contextP, lwm2m_uri_t * uriP, uint8_t * buffer, size_t length);
 coap_status_t object_delete(lwm2m_context_t * contextP, lwm2m_uri_t * uriP);
 bool object_isInstanceNew(lwm2m_context_t * contextP, uint16_t objectId, uint16_t instanceId);
 int prv_getRegisterPayload(lwm2m_context_t * contextP, uint8_t * buffer, size_t length);
 int object_getServers(lwm2m_context_t * contextP);
+#ifdef LWM2M_BOOTSTRAP
+bool object_isBootstrapConsistent(lwm2m_context_t * contextP);
+#endif
+
+// defined in object_table.c
+void object_table_free(lwm2m_object_t * objectP);
+
+// defined in tlv.c
+// writes at most LWM2M_TLV_HEADER_MAX_LENGTH bytes and returns their number
+int tlv_create_header(uint8_t * header, lwm2m_tlv_type_t type, uint16_t id, size_t length);
 
 // defined in transaction.c
 lwm2m_transaction_t * transaction_new(coap_message_type_t type, coap_method_t method, char * altPath, lwm2m_uri_t * uriP, uint16_t mID, uint8_t token_len, uint8_t* token, lwm2m_endpoint_type_t peerType, void * peerP);
@@ -148,28 +233,96 @@ lwm2m_transaction_t * transaction_new(coap_message_type_t type, coap_method_t me
 int transaction_send(lwm2m_context_t * contextP, lwm2m_transaction_t * transacP);
 void transaction_free(lwm2m_transaction_t * transacP);
 void transaction_remove(lwm2m_context_t * contextP, lwm2m_transaction_t * transacP);
+void transaction_remove_peer(lwm2m_context_t * contextP, void * peerP);
 bool transaction_handle_response(lwm2m_context_t * contextP, void * fromSessionH, coap_packet_t * message, coap_packet_t * response);
 
+// defined in senml_cbor.c
+typedef int (*senml_parser_t)(uint8_t * buffer, size_t length, lwm2m_senml_callback_t callback, void * userData);
+bool senml_decode_tlv(lwm2m_tlv_t * tlvP, lwm2m_senml_record_t * recordP);
+int senml_cbor_serialize(lwm2m_uri_t * uriP, int size, lwm2m_tlv_t * tlvP, uint8_t ** bufferP);
+int senml_cbor_parse_tlv(lwm2m_uri_t * uriP, uint8_t * buffer, size_t length, lwm2m_tlv_t ** dataP);
+// build the lwm2m_tlv_t array from the count records of a pack
+int senml_parse_tlv(lwm2m_uri_t * uriP, senml_parser_t parser, int count, uint8_t * buffer, size_t length, lwm2m_tlv_t ** dataP);
+
+// defined in json.c
+int json_serialize(lwm2m_uri_t * uriP, int size, lwm2m_tlv_t * tlvP, uint8_t ** bufferP);
+int json_parse_tlv(lwm2m_uri_t * uriP, uint8_t * buffer, size_t length, lwm2m_tlv_t ** dataP);
+
+// defined in dedup.c
+bool dedup_replay(lwm2m_context_t * contextP, void * sessionH, uint16_t mid);
+void dedup_store(lwm2m_context_t * contextP, void * sessionH, uint16_t mid, uint8_t * buffer, size_t length);
+void dedup_free_all(lwm2m_context_t * contextP);
+
+// defined in separate.c
+#ifdef LWM2M_CLIENT_MODE
+bool separate_is_pending(lwm2m_context_t * contextP, void * sessionH, uint16_t mid);
+coap_status_t separate_store(lwm2m_context_t * contextP, lwm2m_uri_t * uriP, void * sessionH, coap_packet_t * message);
+void separate_step(lwm2m_context_t * contextP, time_t currentTime, time_t * timeoutP);
+void separate_free_all(lwm2m_context_t * contextP);
+#endif
+
+// defined in persist.c
+#ifdef LWM2M_CLIENT_MODE
+// return the validated saved state after restoring the bootstrap configuration, NULL if there is none
+uint8_t * persist_load(lwm2m_context_t * contextP, size_t * lengthP);
+// resume the registrations and observations once the servers are known
+void persist_resume(lwm2m_context_t * contextP, uint8_t * buffer, size_t length);
+void persist_step(lwm2m_context_t * contextP);
+#endif
+#ifdef LWM2M_SERVER_MODE
+// append the record of the client, or its removal, to the registry
+void registry_store(lwm2m_context_t * contextP, lwm2m_client_t * clientP);
+void registry_remove(lwm2m_context_t * contextP, uint16_t clientID);
+#endif
+
 // defined in management.c
 coap_status_t handle_dm_request(lwm2m_context_t * contextP, lwm2m_uri_t * uriP, void * fromSessionH, coap_packet_t * message, coap_packet_t * response);
 coap_status_t handle_delete_all(lwm2m_context_t * context);
 
 // defined in observe.c
-coap_status_t handle_observe_request(lwm2m_context_t * contextP, lwm2m_uri_t * uriP, lwm2m_server_t * serverP, coap_packet_t * message, coap_packet_t * response);
+coap_status_t handle_observe_request(lwm2m_context_t * contextP, lwm2m_uri_t * uriP, lwm2m_server_t * serverP, lwm2m_media_type_t format, coap_packet_t * message, coap_packet_t * response);
 void cancel_observe(lwm2m_context_t * contextP, uint16_t mid, void * fromSessionH);
+void delete_uri_handle_list(lwm2m_context_t * contextP);
 
 // defined in registration.c
 coap_status_t handle_registration_request(lwm2m_context_t * contextP, lwm2m_uri_t * uriP, void * fromSessionH, coap_packet_t * message, coap_packet_t * response);
 void registration_deregister(lwm2m_context_t * contextP, lwm2m_server_t * serverP);
-void prv_freeClient(lwm2m_client_t * clientP);
+void prv_freeClient(lwm2m_context_t * contextP, lwm2m_client_t * clientP);
+void prv_freeClientObjectList(lwm2m_client_object_t * objects);
+lwm2m_shared_objects_t * registration_findObjects(lwm2m_context_t * contextP, const uint8_t * payload, uint16_t payloadLength);
+lwm2m_shared_objects_t * registration_addObjects(lwm2m_context_t * contextP, lwm2m_client_object_t * objects, char * altPath, const uint8_t * payload, uint16_t payloadLength);
 void registration_update(lwm2m_context_t * contextP, time_t currentTime, time_t * timeoutP);
 
+// defined in lifetime.c
+bool lifetime_new_id(lwm2m_context_t * contextP, uint16_t * idP);
+bool lifetime_add(lwm2m_context_t * contextP, lwm2m_client_t * clientP);
+void lifetime_update(lwm2m_context_t * contextP, lwm2m_client_t * clientP);
+void lifetime_remove(lwm2m_context_t * contextP, lwm2m_client_t * clientP);
+lwm2m_client_t * lifetime_get_client(lwm2m_context_t * contextP, uint16_t clientID);
+lwm2m_client_t * lifetime_find_client(lwm2m_context_t * contextP, const char * name);
+void lifetime_link(lwm2m_context_t * contextP, lwm2m_client_t * clientP);
+void lifetime_unlink(lwm2m_context_t * contextP, lwm2m_client_t * clientP);
+void lifetime_step(lwm2m_context_t * contextP, time_t currentTime, time_t * timeoutP);
+void lifetime_free(lwm2m_context_t * contextP);
+
+// defined in cache.c
+void cache_store(lwm2m_client_t * clientP, lwm2m_uri_t * uriP, coap_packet_t * packet);
+lwm2m_cache_entry_t * cache_get(lwm2m_client_t * clientP, lwm2m_uri_t * uriP, uint32_t maxAge);
+void cache_invalidate(lwm2m_client_t * clientP, lwm2m_uri_t * uriP);
+void cache_result(lwm2m_client_t * clientP, lwm2m_uri_t * uriP, coap_packet_t * request, coap_packet_t * response);
+void cache_free(lwm2m_client_t * clientP);
+
+// defined in group.c
+void group_step(lwm2m_context_t * contextP, time_t * timeoutP);
+void group_free_all(lwm2m_context_t * contextP);
+
 // defined in packet.c
 coap_status_t message_send(lwm2m_context_t * contextP, coap_packet_t * message, void * sessionH);
 
 // defined in observe.c
 bool handle_observe_notify(lwm2m_context_t * contextP, void * fromSessionH, coap_packet_t * message, coap_packet_t * response);
-void observation_remove(lwm2m_client_t * clientP, lwm2m_observation_t * observationP);
+void observation_remove(lwm2m_context_t * contextP, lwm2m_client_t * clientP, lwm2m_observation_t * observationP);
+void observation_free_all(lwm2m_context_t * contextP);
 
 // defined in bootstrap.c
 void handle_bootstrap_response(lwm2m_context_t * context, coap_packet_t * message, void * fromSessionH);
@@ -177,6 +330,7 @@ void bootstrap_failed(lwm2m_context_t * context);
 void reset_bootstrap_timer(lwm2m_context_t * context);
 void update_bootstrap_state(lwm2m_context_t * contextP, uint32_t currentTime, time_t* timeoutP);
 void delete_bootstrap_server_list(lwm2m_context_t * contextP);
+coap_status_t handle_bootstrap_finish(lwm2m_context_t * contextP, void * fromSessionH, coap_packet_t * message);
 uint8_t handle_bootstrap_request(lwm2m_context_t * contextP, lwm2m_uri_t * uriP, void * fromSessionH, coap_packet_t * message, coap_packet_t * response);
 
 // defined in liblwm2m.c
@@ -187,9 +341,21 @@ void delete_observed_list(lwm2m_context_t * contextP);
 // defined in utils.c
 lwm2m_binding_t lwm2m_stringToBinding(uint8_t *buffer, size_t length);
 int prv_isAltPathValid(const char * altPath);
+bool utils_getAcceptFormat(coap_packet_t * message, lwm2m_uri_t * uriP, lwm2m_media_type_t * formatP);
+bool utils_getContentFormat(coap_packet_t * message, lwm2m_uri_t * uriP, lwm2m_media_type_t * formatP);
+// allocation-free, return the number of characters written or 0 if it does not fit in length
+size_t utils_intToText(int64_t data, uint8_t * string, size_t length);
+size_t utils_floatToText(double data, uint8_t * string, size_t length);
+uint32_t utils_hash(const uint8_t * data, size_t length);
+// random state of each context, so that contexts run by different threads share none
+void utils_initRandom(lwm2m_context_t * contextP);
+uint32_t utils_random(lwm2m_context_t * contextP);
 #ifdef LWM2M_CLIENT_MODE
 lwm2m_server_t * prv_findServer(lwm2m_context_t * contextP, void * fromSessionH);
 lwm2m_server_t * utils_findBootstrapServer(lwm2m_context_t * contextP, void * fromSessionH);
+void utils_seedRandom(lwm2m_context_t * contextP);
+// delay before the next attempt after *attemptP failures, *attemptP is incremented
+time_t utils_retryDelay(lwm2m_context_t * contextP, uint8_t * attemptP);
 #endif
 
 #endif
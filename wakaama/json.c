@@ -0,0 +1,864 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - initial API and implementation
+ *
+ *******************************************************************************/
+
+/************************************************************************
+ *  LwM2M JSON content format (application/vnd.oma.lwm2m+json).
+ *
+ *  {"bn":"/3303/0/","bt":1420070400,"e":[{"n":"5700","v":23.5},
+ *                                        {"n":"5701","sv":"Cel"}]}
+ *
+ *  The base name is the request URI down to the instance, the base time is
+ *  sent when the clock is set. Opaque values are sent base64 encoded in
+ *  "sv".
+ *
+ *  Like the SenML CBOR encoder, the writer runs twice over the lwm2m_tlv_t
+ *  array returned by the object, once to compute the length and once to
+ *  write the response buffer. Numbers are formatted by utils_intToText()
+ *  and utils_floatToText(), directly in the buffer.
+ *
+ *  The reader is a tokenizer over the payload. Records are reported through
+ *  the same callback as SenML CBOR; names are copied in the record, string
+ *  values point in the payload and are unescaped in place.
+ */
+
+#include "internals.h"
+#include <stdlib.h>
+#include <string.h>
+
+// SenML times below 2^28 are relative to now, an unset clock is not sent
+#define PRV_ABSOLUTE_TIME_MIN   ((time_t)1 << 28)
+
+// object, instance, resource, resource instance
+#define PRV_MAX_DEPTH           4
+// "-0.00000" followed by 17 digits is the longest float, integers are shorter
+#define PRV_NUMBER_MAX_LEN      25
+// JSON nesting accepted when skipping unknown values
+#define PRV_MAX_NESTING         8
+
+typedef struct
+{
+    uint8_t * buffer;       // NULL to only compute the length
+    size_t    length;
+    size_t    index;
+    bool      first;
+} prv_writer_t;
+
+typedef enum
+{
+    PRV_TOKEN_BEGIN_OBJECT,
+    PRV_TOKEN_END_OBJECT,
+    PRV_TOKEN_BEGIN_ARRAY,
+    PRV_TOKEN_END_ARRAY,
+    PRV_TOKEN_COLON,
+    PRV_TOKEN_COMMA,
+    PRV_TOKEN_STRING,
+    PRV_TOKEN_NUMBER,
+    PRV_TOKEN_TRUE,
+    PRV_TOKEN_FALSE,
+    PRV_TOKEN_NULL,
+    PRV_TOKEN_END
+} prv_token_type_t;
+
+typedef struct
+{
+    prv_token_type_t type;
+    uint8_t *        start;     // after the opening quote for strings
+    size_t           length;
+    bool             escaped;   // a string containing backslashes
+} prv_token_t;
+
+typedef struct
+{
+    uint8_t * buffer;
+    size_t    length;
+    size_t    index;
+} prv_reader_t;
+
+static const char prv_base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char prv_hex[] = "0123456789abcdef";
+
+
+/*
+ * Writer
+ */
+
+static void prv_write_char(prv_writer_t * writerP,
+                           char c)
+{
+    if (writerP->buffer != NULL)
+    {
+        writerP->buffer[writerP->index] = (uint8_t)c;
+    }
+    writerP->index++;
+}
+
+static void prv_write_raw(prv_writer_t * writerP,
+                          const char * data,
+                          size_t length)
+{
+    if (writerP->buffer != NULL)
+    {
+        memcpy(writerP->buffer + writerP->index, data, length);
+    }
+    writerP->index += length;
+}
+
+static void prv_write_string(prv_writer_t * writerP,
+                             const uint8_t * data,
+                             size_t length)
+{
+    size_t i;
+
+    prv_write_char(writerP, '"');
+    for (i = 0 ; i < length ; i++)
+    {
+        switch (data[i])
+        {
+        case '"':
+        case '\\':
+            prv_write_char(writerP, '\\');
+            prv_write_char(writerP, (char)data[i]);
+            break;
+        case '\n':
+            prv_write_raw(writerP, "\\n", 2);
+            break;
+        case '\r':
+            prv_write_raw(writerP, "\\r", 2);
+            break;
+        case '\t':
+            prv_write_raw(writerP, "\\t", 2);
+            break;
+        default:
+            if (data[i] < 0x20)
+            {
+                prv_write_raw(writerP, "\\u00", 4);
+                prv_write_char(writerP, prv_hex[data[i] >> 4]);
+                prv_write_char(writerP, prv_hex[data[i] & 0x0F]);
+            }
+            else
+            {
+                prv_write_char(writerP, (char)data[i]);
+            }
+            break;
+        }
+    }
+    prv_write_char(writerP, '"');
+}
+
+static void prv_write_base64(prv_writer_t * writerP,
+                             const uint8_t * data,
+                             size_t length)
+{
+    size_t i;
+
+    prv_write_char(writerP, '"');
+    for (i = 0 ; i + 2 < length ; i += 3)
+    {
+        prv_write_char(writerP, prv_base64[data[i] >> 2]);
+        prv_write_char(writerP, prv_base64[((data[i] & 0x03) << 4) | (data[i + 1] >> 4)]);
+        prv_write_char(writerP, prv_base64[((data[i + 1] & 0x0F) << 2) | (data[i + 2] >> 6)]);
+        prv_write_char(writerP, prv_base64[data[i + 2] & 0x3F]);
+    }
+    if (i < length)
+    {
+        prv_write_char(writerP, prv_base64[data[i] >> 2]);
+        if (i + 1 < length)
+        {
+            prv_write_char(writerP, prv_base64[((data[i] & 0x03) << 4) | (data[i + 1] >> 4)]);
+            prv_write_char(writerP, prv_base64[(data[i + 1] & 0x0F) << 2]);
+        }
+        else
+        {
+            prv_write_char(writerP, prv_base64[(data[i] & 0x03) << 4]);
+            prv_write_char(writerP, '=');
+        }
+        prv_write_char(writerP, '=');
+    }
+    prv_write_char(writerP, '"');
+}
+
+// numbers are formatted in place in the response buffer, in a scratch
+// buffer when only computing the length
+static bool prv_write_number(prv_writer_t * writerP,
+                             lwm2m_senml_record_t * numberP)
+{
+    uint8_t scratch[PRV_NUMBER_MAX_LEN];
+    uint8_t * destP;
+    size_t room;
+    size_t length;
+
+    if (writerP->buffer != NULL)
+    {
+        destP = writerP->buffer + writerP->index;
+        room = writerP->length - writerP->index;
+    }
+    else
+    {
+        destP = scratch;
+        room = sizeof(scratch);
+    }
+
+    if (numberP->type == LWM2M_TYPE_INTEGER)
+    {
+        length = utils_intToText(numberP->value.asInteger, destP, room);
+    }
+    else
+    {
+        length = utils_floatToText(numberP->value.asFloat, destP, room);
+    }
+    writerP->index += length;
+
+    return length != 0;
+}
+
+static void prv_write_id(prv_writer_t * writerP,
+                         uint16_t id)
+{
+    lwm2m_senml_record_t number;
+
+    number.type = LWM2M_TYPE_INTEGER;
+    number.value.asInteger = id;
+    (void)prv_write_number(writerP, &number);
+}
+
+static bool prv_write_record(prv_writer_t * writerP,
+                             uint16_t * ids,
+                             int depth,
+                             lwm2m_tlv_t * tlvP)
+{
+    lwm2m_senml_record_t record;
+    int i;
+
+    if (!senml_decode_tlv(tlvP, &record)) return false;
+
+    if (!writerP->first)
+    {
+        prv_write_char(writerP, ',');
+    }
+    writerP->first = false;
+
+    prv_write_raw(writerP, "{\"n\":\"", 6);
+    for (i = 0 ; i <= depth ; i++)
+    {
+        if (i != 0) prv_write_char(writerP, '/');
+        prv_write_id(writerP, ids[i]);
+    }
+    prv_write_raw(writerP, "\",", 2);
+
+    switch (record.type)
+    {
+    case LWM2M_TYPE_INTEGER:
+    case LWM2M_TYPE_FLOAT:
+        prv_write_raw(writerP, "\"v\":", 4);
+        if (!prv_write_number(writerP, &record)) return false;
+        break;
+    case LWM2M_TYPE_BOOLEAN:
+        prv_write_raw(writerP, "\"bv\":", 5);
+        if (record.value.asBoolean)
+        {
+            prv_write_raw(writerP, "true", 4);
+        }
+        else
+        {
+            prv_write_raw(writerP, "false", 5);
+        }
+        break;
+    case LWM2M_TYPE_STRING:
+        prv_write_raw(writerP, "\"sv\":", 5);
+        prv_write_string(writerP, record.value.asBuffer.buffer, record.value.asBuffer.length);
+        break;
+    default:
+        prv_write_raw(writerP, "\"sv\":", 5);
+        prv_write_base64(writerP, record.value.asBuffer.buffer, record.value.asBuffer.length);
+        break;
+    }
+    prv_write_char(writerP, '}');
+
+    return true;
+}
+
+static bool prv_write_list(prv_writer_t * writerP,
+                           uint16_t * ids,
+                           int depth,
+                           int size,
+                           lwm2m_tlv_t * tlvP)
+{
+    int i;
+
+    if (depth >= PRV_MAX_DEPTH) return false;
+
+    for (i = 0 ; i < size ; i++)
+    {
+        ids[depth] = tlvP[i].id;
+        switch (tlvP[i].type)
+        {
+        case LWM2M_TYPE_OBJECT_INSTANCE:
+        case LWM2M_TYPE_MULTIPLE_RESOURCE:
+            if (!prv_write_list(writerP, ids, depth + 1, tlvP[i].length, (lwm2m_tlv_t *)tlvP[i].value)) return false;
+            break;
+        case LWM2M_TYPE_RESOURCE:
+        case LWM2M_TYPE_RESOURCE_INSTANCE:
+            if (!prv_write_record(writerP, ids, depth, tlvP + i)) return false;
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+int json_serialize(lwm2m_uri_t * uriP,
+                   int size,
+                   lwm2m_tlv_t * tlvP,
+                   uint8_t ** bufferP)
+{
+    prv_writer_t writer;
+    uint16_t ids[PRV_MAX_DEPTH];
+    time_t now;
+    int pass;
+
+    *bufferP = NULL;
+    if (size <= 0) return 0;
+
+    now = lwm2m_gettime();
+
+    memset(&writer, 0, sizeof(prv_writer_t));
+
+    // first pass computes the length, second pass writes
+    for (pass = 0 ; pass < 2 ; pass++)
+    {
+        if (pass == 1)
+        {
+            *bufferP = (uint8_t *)lwm2m_malloc(writer.index);
+            if (*bufferP == NULL) return 0;
+            writer.buffer = *bufferP;
+            writer.length = writer.index;
+        }
+        writer.index = 0;
+        writer.first = true;
+
+        prv_write_raw(&writer, "{\"bn\":\"/", 8);
+        prv_write_id(&writer, uriP->objectId);
+        prv_write_char(&writer, '/');
+        if (LWM2M_URI_IS_SET_INSTANCE(uriP))
+        {
+            prv_write_id(&writer, uriP->instanceId);
+            prv_write_char(&writer, '/');
+        }
+        prv_write_char(&writer, '"');
+        if (now >= PRV_ABSOLUTE_TIME_MIN)
+        {
+            lwm2m_senml_record_t number;
+
+            number.type = LWM2M_TYPE_INTEGER;
+            number.value.asInteger = now;
+            prv_write_raw(&writer, ",\"bt\":", 6);
+            (void)prv_write_number(&writer, &number);
+        }
+        prv_write_raw(&writer, ",\"e\":[", 6);
+        if (!prv_write_list(&writer, ids, 0, size, tlvP))
+        {
+            lwm2m_free(*bufferP);
+            *bufferP = NULL;
+            return 0;
+        }
+        prv_write_raw(&writer, "]}", 2);
+    }
+
+    return writer.index;
+}
+
+
+/*
+ * Reader
+ */
+
+static bool prv_match_literal(prv_reader_t * readerP,
+                              const char * literal,
+                              size_t length)
+{
+    if (readerP->length - readerP->index < length) return false;
+    if (0 != memcmp(readerP->buffer + readerP->index, literal, length)) return false;
+    readerP->index += length;
+    return true;
+}
+
+static bool prv_next_token(prv_reader_t * readerP,
+                           prv_token_t * tokenP)
+{
+    uint8_t c;
+
+    while (readerP->index < readerP->length
+        && (readerP->buffer[readerP->index] == ' '
+         || readerP->buffer[readerP->index] == '\t'
+         || readerP->buffer[readerP->index] == '\r'
+         || readerP->buffer[readerP->index] == '\n'))
+    {
+        readerP->index++;
+    }
+
+    tokenP->start = readerP->buffer + readerP->index;
+    tokenP->length = 0;
+    tokenP->escaped = false;
+
+    if (readerP->index == readerP->length)
+    {
+        tokenP->type = PRV_TOKEN_END;
+        return true;
+    }
+
+    c = readerP->buffer[readerP->index++];
+    switch (c)
+    {
+    case '{': tokenP->type = PRV_TOKEN_BEGIN_OBJECT; return true;
+    case '}': tokenP->type = PRV_TOKEN_END_OBJECT;   return true;
+    case '[': tokenP->type = PRV_TOKEN_BEGIN_ARRAY;  return true;
+    case ']': tokenP->type = PRV_TOKEN_END_ARRAY;    return true;
+    case ':': tokenP->type = PRV_TOKEN_COLON;        return true;
+    case ',': tokenP->type = PRV_TOKEN_COMMA;        return true;
+
+    case '"':
+        tokenP->type = PRV_TOKEN_STRING;
+        tokenP->start++;
+        while (readerP->index < readerP->length)
+        {
+            c = readerP->buffer[readerP->index++];
+            if (c == '"') return true;
+            if (c < 0x20) return false;
+            if (c == '\\')
+            {
+                tokenP->escaped = true;
+                tokenP->length++;
+                if (readerP->index == readerP->length) return false;
+                readerP->index++;
+            }
+            tokenP->length++;
+        }
+        return false;
+
+    case 't':
+        tokenP->type = PRV_TOKEN_TRUE;
+        return prv_match_literal(readerP, "rue", 3);
+    case 'f':
+        tokenP->type = PRV_TOKEN_FALSE;
+        return prv_match_literal(readerP, "alse", 4);
+    case 'n':
+        tokenP->type = PRV_TOKEN_NULL;
+        return prv_match_literal(readerP, "ull", 3);
+
+    default:
+        if (c != '-' && (c < '0' || c > '9')) return false;
+        tokenP->type = PRV_TOKEN_NUMBER;
+        tokenP->length = 1;
+        while (readerP->index < readerP->length)
+        {
+            c = readerP->buffer[readerP->index];
+            if ((c < '0' || c > '9') && c != '.' && c != 'e' && c != 'E' && c != '+' && c != '-') break;
+            readerP->index++;
+            tokenP->length++;
+        }
+        return true;
+    }
+}
+
+static bool prv_expect(prv_reader_t * readerP,
+                       prv_token_type_t type)
+{
+    prv_token_t token;
+
+    return prv_next_token(readerP, &token) && token.type == type;
+}
+
+// skip the rest of a value starting with tokenP
+static bool prv_skip_value(prv_reader_t * readerP,
+                           prv_token_t * tokenP)
+{
+    prv_token_t token;
+    int nesting;
+
+    switch (tokenP->type)
+    {
+    case PRV_TOKEN_STRING:
+    case PRV_TOKEN_NUMBER:
+    case PRV_TOKEN_TRUE:
+    case PRV_TOKEN_FALSE:
+    case PRV_TOKEN_NULL:
+        return true;
+    case PRV_TOKEN_BEGIN_OBJECT:
+    case PRV_TOKEN_BEGIN_ARRAY:
+        break;
+    default:
+        return false;
+    }
+
+    nesting = 1;
+    while (nesting > 0)
+    {
+        if (!prv_next_token(readerP, &token)) return false;
+        switch (token.type)
+        {
+        case PRV_TOKEN_BEGIN_OBJECT:
+        case PRV_TOKEN_BEGIN_ARRAY:
+            if (++nesting > PRV_MAX_NESTING) return false;
+            break;
+        case PRV_TOKEN_END_OBJECT:
+        case PRV_TOKEN_END_ARRAY:
+            nesting--;
+            break;
+        case PRV_TOKEN_END:
+            return false;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+static int prv_hex_value(uint8_t c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// decode the escape sequences of a string token in destP, which can be the
+// token itself. Return the decoded length or -1.
+static int prv_unescape(prv_token_t * tokenP,
+                        uint8_t * destP,
+                        size_t size)
+{
+    size_t i;
+    size_t length;
+
+    length = 0;
+    for (i = 0 ; i < tokenP->length ; i++)
+    {
+        uint8_t c;
+
+        c = tokenP->start[i];
+        if (c == '\\')
+        {
+            i++;
+            switch (tokenP->start[i])
+            {
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'n': c = '\n'; break;
+            case 'r': c = '\r'; break;
+            case 't': c = '\t'; break;
+            case '"':
+            case '\\':
+            case '/':
+                c = tokenP->start[i];
+                break;
+            case 'u':
+                {
+                    uint16_t code;
+                    int j;
+
+                    if (i + 4 >= tokenP->length) return -1;
+                    code = 0;
+                    for (j = 1 ; j <= 4 ; j++)
+                    {
+                        int digit = prv_hex_value(tokenP->start[i + j]);
+
+                        if (digit < 0) return -1;
+                        code = (code << 4) | digit;
+                    }
+                    i += 4;
+                    // surrogate pairs are not supported
+                    if (code >= 0xD800 && code <= 0xDFFF) return -1;
+                    if (code >= 0x80)
+                    {
+                        if (code >= 0x800)
+                        {
+                            if (length + 3 > size) return -1;
+                            destP[length++] = 0xE0 | (code >> 12);
+                            destP[length++] = 0x80 | ((code >> 6) & 0x3F);
+                        }
+                        else
+                        {
+                            if (length + 2 > size) return -1;
+                            destP[length++] = 0xC0 | (code >> 6);
+                        }
+                        destP[length++] = 0x80 | (code & 0x3F);
+                        continue;
+                    }
+                    c = (uint8_t)code;
+                }
+                break;
+            default:
+                return -1;
+            }
+        }
+        if (length == size) return -1;
+        destP[length++] = c;
+    }
+    return (int)length;
+}
+
+// copy a string token in a NULL terminated buffer of size + 1 bytes
+static int prv_copy_string(prv_token_t * tokenP,
+                           char * destP,
+                           size_t size)
+{
+    int length;
+
+    if (tokenP->type != PRV_TOKEN_STRING) return -1;
+    length = prv_unescape(tokenP, (uint8_t *)destP, size);
+    if (length < 0) return -1;
+    destP[length] = 0;
+    return length;
+}
+
+// numbers are read in recordP as LWM2M_TYPE_INTEGER or LWM2M_TYPE_FLOAT
+static bool prv_read_number(prv_token_t * tokenP,
+                            lwm2m_senml_record_t * recordP)
+{
+    size_t i;
+    bool integer;
+
+    if (tokenP->type != PRV_TOKEN_NUMBER) return false;
+
+    i = tokenP->start[0] == '-' ? 1 : 0;
+    if (i == tokenP->length || tokenP->start[i] < '0' || tokenP->start[i] > '9') return false;
+
+    integer = true;
+    for ( ; i < tokenP->length && integer ; i++)
+    {
+        integer = tokenP->start[i] >= '0' && tokenP->start[i] <= '9';
+    }
+
+    if (integer
+     && 1 == lwm2m_PlainTextToInt64(tokenP->start, tokenP->length, &recordP->value.asInteger))
+    {
+        recordP->type = LWM2M_TYPE_INTEGER;
+        return true;
+    }
+
+    recordP->type = LWM2M_TYPE_FLOAT;
+    return 1 == lwm2m_PlainTextToFloat64(tokenP->start, tokenP->length, &recordP->value.asFloat);
+}
+
+static double prv_to_double(lwm2m_senml_record_t * numberP)
+{
+    return numberP->type == LWM2M_TYPE_INTEGER ? (double)numberP->value.asInteger : numberP->value.asFloat;
+}
+
+// read the "key": of a member, or the end of the object
+static bool prv_read_key(prv_reader_t * readerP,
+                         bool first,
+                         prv_token_t * keyP)
+{
+    if (!prv_next_token(readerP, keyP)) return false;
+    if (keyP->type == PRV_TOKEN_END_OBJECT) return true;
+    if (!first)
+    {
+        if (keyP->type != PRV_TOKEN_COMMA) return false;
+        if (!prv_next_token(readerP, keyP)) return false;
+    }
+    if (keyP->type != PRV_TOKEN_STRING) return false;
+    return prv_expect(readerP, PRV_TOKEN_COLON);
+}
+
+static bool prv_is_key(prv_token_t * keyP,
+                       const char * name)
+{
+    size_t length = strlen(name);
+
+    return keyP->length == length && 0 == memcmp(keyP->start, name, length);
+}
+
+static bool prv_read_record(prv_reader_t * readerP,
+                            bool decode,
+                            lwm2m_senml_record_t * recordP,
+                            char * nameP)
+{
+    prv_token_t key;
+    prv_token_t value;
+    bool first;
+
+    memset(recordP, 0, sizeof(lwm2m_senml_record_t));
+    recordP->type = LWM2M_TYPE_UNDEFINED;
+    nameP[0] = 0;
+
+    first = true;
+    while (prv_read_key(readerP, first, &key))
+    {
+        lwm2m_senml_record_t number;
+
+        if (key.type == PRV_TOKEN_END_OBJECT) return true;
+        first = false;
+
+        if (!prv_next_token(readerP, &value)) return false;
+
+        if (prv_is_key(&key, "n"))
+        {
+            if (prv_copy_string(&value, nameP, LWM2M_SENML_NAME_MAX_LEN) < 0) return false;
+        }
+        else if (prv_is_key(&key, "v"))
+        {
+            if (!prv_read_number(&value, recordP)) return false;
+        }
+        else if (prv_is_key(&key, "t"))
+        {
+            if (!prv_read_number(&value, &number)) return false;
+            recordP->time = prv_to_double(&number);
+        }
+        else if (prv_is_key(&key, "bv"))
+        {
+            if (value.type != PRV_TOKEN_TRUE && value.type != PRV_TOKEN_FALSE) return false;
+            recordP->type = LWM2M_TYPE_BOOLEAN;
+            recordP->value.asBoolean = value.type == PRV_TOKEN_TRUE;
+        }
+        else if (prv_is_key(&key, "sv") || prv_is_key(&key, "ov"))
+        {
+            if (value.type != PRV_TOKEN_STRING) return false;
+            recordP->type = prv_is_key(&key, "sv") ? LWM2M_TYPE_STRING : LWM2M_TYPE_OBJECT_LINK;
+            recordP->value.asBuffer.buffer = value.start;
+            recordP->value.asBuffer.length = value.length;
+            if (decode && value.escaped)
+            {
+                int length;
+
+                length = prv_unescape(&value, value.start, value.length);
+                if (length < 0) return false;
+                recordP->value.asBuffer.length = length;
+            }
+        }
+        else
+        {
+            if (!prv_skip_value(readerP, &value)) return false;
+        }
+    }
+    return false;
+}
+
+static int prv_parse(uint8_t * buffer,
+                     size_t length,
+                     bool decode,
+                     lwm2m_senml_callback_t callback,
+                     void * userData)
+{
+    prv_reader_t reader;
+    prv_token_t key;
+    prv_token_t value;
+    bool first;
+    char baseName[LWM2M_SENML_NAME_MAX_LEN + 1];
+    int baseNameLen;
+    double baseTime;
+    size_t recordsIndex;
+    int count;
+
+    reader.buffer = buffer;
+    reader.length = length;
+    reader.index = 0;
+
+    // the base fields can follow the records, look for them first
+    if (!prv_expect(&reader, PRV_TOKEN_BEGIN_OBJECT)) return 0;
+
+    baseNameLen = 0;
+    baseTime = 0;
+    recordsIndex = 0;
+    first = true;
+    while (true)
+    {
+        if (!prv_read_key(&reader, first, &key)) return 0;
+        if (key.type == PRV_TOKEN_END_OBJECT) break;
+        first = false;
+
+        if (!prv_next_token(&reader, &value)) return 0;
+
+        if (prv_is_key(&key, "bn"))
+        {
+            baseNameLen = prv_copy_string(&value, baseName, LWM2M_SENML_NAME_MAX_LEN);
+            if (baseNameLen < 0) return 0;
+        }
+        else if (prv_is_key(&key, "bt"))
+        {
+            lwm2m_senml_record_t number;
+
+            if (!prv_read_number(&value, &number)) return 0;
+            baseTime = prv_to_double(&number);
+        }
+        else
+        {
+            if (prv_is_key(&key, "e"))
+            {
+                if (value.type != PRV_TOKEN_BEGIN_ARRAY) return 0;
+                recordsIndex = reader.index;
+            }
+            if (!prv_skip_value(&reader, &value)) return 0;
+        }
+    }
+    if (!prv_expect(&reader, PRV_TOKEN_END)) return 0;
+    if (recordsIndex == 0) return 0;
+
+    reader.index = recordsIndex;
+    count = 0;
+    while (true)
+    {
+        lwm2m_senml_record_t record;
+        char name[LWM2M_SENML_NAME_MAX_LEN + 1];
+        size_t nameLen;
+
+        if (!prv_next_token(&reader, &value)) return 0;
+        if (value.type == PRV_TOKEN_END_ARRAY) break;
+        if (count != 0)
+        {
+            if (value.type != PRV_TOKEN_COMMA) return 0;
+            if (!prv_next_token(&reader, &value)) return 0;
+        }
+        if (value.type != PRV_TOKEN_BEGIN_OBJECT) return 0;
+
+        if (!prv_read_record(&reader, decode, &record, name)) return 0;
+
+        // resolve the base fields
+        nameLen = strlen(name);
+        if (baseNameLen + nameLen > LWM2M_SENML_NAME_MAX_LEN) return 0;
+        memcpy(record.name, baseName, baseNameLen);
+        memcpy(record.name + baseNameLen, name, nameLen + 1);
+        record.time += baseTime;
+
+        count++;
+        if (callback != NULL && 0 != callback(&record, userData)) return 0;
+    }
+
+    return count;
+}
+
+int lwm2m_json_parse(uint8_t * buffer,
+                     size_t length,
+                     lwm2m_senml_callback_t callback,
+                     void * userData)
+{
+    return prv_parse(buffer, length, true, callback, userData);
+}
+
+int json_parse_tlv(lwm2m_uri_t * uriP,
+                   uint8_t * buffer,
+                   size_t length,
+                   lwm2m_tlv_t ** dataP)
+{
+    int count;
+
+    // counting must not unescape the strings, they are parsed again
+    count = prv_parse(buffer, length, false, NULL, NULL);
+
+    return senml_parse_tlv(uriP, lwm2m_json_parse, count, buffer, length, dataP);
+}
@@ -75,11 +75,17 @@ lwm2m_context_t * lwm2m_init(lwm2m_connect_server_callback_t connectCallback,
     if (NULL != contextP)
     {
         memset(contextP, 0, sizeof(lwm2m_context_t));
+        contextP->packets = lwm2m_malloc(2 * sizeof(coap_packet_t));
+        if (NULL == contextP->packets)
+        {
+            lwm2m_free(contextP);
+            return NULL;
+        }
         contextP->connectCallback = connectCallback;
         contextP->bufferSendCallback = bufferSendCallback;
         contextP->userData = userData;
-        srand(time(NULL));
-        contextP->nextMID = rand();
+        utils_initRandom(contextP);
+        contextP->nextMID = utils_random(contextP);
     }
 
     return contextP;
@@ -100,6 +106,7 @@ void lwm2m_delete_object_list_content(lwm2m_context_t * context)
                 {
                     objectList[i]->closeFunc(objectList[i]);
                 }
+                object_table_free(objectList[i]);
             }
         }
     }
@@ -149,6 +156,7 @@ void delete_observed_list(lwm2m_context_t * contextP)
 
         lwm2m_free(targetP);
     }
+    contextP->observedVersion++;
 }
 #endif
 
@@ -170,9 +178,13 @@ void lwm2m_close(lwm2m_context_t * contextP)
     int i;
 
     lwm2m_deregister(contextP);
+    // the next start registers again
+    contextP->persistDirty = true;
+    persist_step(contextP);
     delete_server_list(contextP);
     delete_bootstrap_server_list(contextP);
     delete_observed_list(contextP);
+    delete_uri_handle_list(contextP);
     lwm2m_delete_object_list_content(contextP);
     for (i = 0 ; i < contextP->numObject ; i++)
     {
@@ -199,14 +211,36 @@ void lwm2m_close(lwm2m_context_t * contextP)
         clientP = contextP->clientList;
         contextP->clientList = contextP->clientList->next;
 
-        prv_freeClient(clientP);
+        prv_freeClient(contextP, clientP);
     }
+    group_free_all(contextP);
+    lifetime_free(contextP);
+    observation_free_all(contextP);
+    lwm2m_free(contextP->sharedObjectsTable);
 #endif
 
     delete_transaction_list(contextP);
+    dedup_free_all(contextP);
+#ifdef LWM2M_CLIENT_MODE
+    separate_free_all(contextP);
+#endif
+    lwm2m_free(contextP->packets);
     lwm2m_free(contextP);
 }
 
+void lwm2m_set_transmit_callbacks(lwm2m_context_t * contextP,
+                                  lwm2m_buffer_alloc_callback_t allocCallback,
+                                  lwm2m_handle_send_callback_t sendCallback)
+{
+    if (NULL == allocCallback || NULL == sendCallback)
+    {
+        allocCallback = NULL;
+        sendCallback = NULL;
+    }
+    contextP->bufferAllocCallback = allocCallback;
+    contextP->handleSendCallback = sendCallback;
+}
+
 #ifdef LWM2M_CLIENT_MODE
 int lwm2m_configure(lwm2m_context_t * contextP,
                     const char * endpointName,
@@ -248,6 +282,7 @@ int lwm2m_configure(lwm2m_context_t * contextP,
     {
         return COAP_500_INTERNAL_SERVER_ERROR;
     }
+    utils_seedRandom(contextP);
 
     if (msisdn != NULL)
     {
@@ -290,12 +325,16 @@ int lwm2m_step(lwm2m_context_t * contextP,
 {
     lwm2m_transaction_t * transacP;
     time_t tv_sec;
-#ifdef LWM2M_SERVER_MODE
-    lwm2m_client_t * clientP;
-#endif
+    uint32_t now;
 
     tv_sec = lwm2m_gettime();
     if (tv_sec < 0) return COAP_500_INTERNAL_SERVER_ERROR;
+    now = lwm2m_gettime_ms();
+
+#ifdef LWM2M_SERVER_MODE
+    // before the transactions, to schedule the retransmissions of the requests it sends
+    group_step(contextP, timeoutP);
+#endif
 
     transacP = contextP->transactionList;
     while (transacP != NULL)
@@ -304,7 +343,8 @@ int lwm2m_step(lwm2m_context_t * contextP,
         lwm2m_transaction_t * nextP = transacP->next;
         int removed = 0;
 
-        if (transacP->retrans_time <= tv_sec)
+        // retransmission dates are in ms and wrap around
+        if ((int32_t)(transacP->retrans_time - now) <= 0)
         {
             removed = transaction_send(contextP, transacP);
         }
@@ -313,9 +353,9 @@ int lwm2m_step(lwm2m_context_t * contextP,
         {
             time_t interval;
 
-            if (transacP->retrans_time > tv_sec)
+            if ((int32_t)(transacP->retrans_time - now) > 0)
             {
-                interval = transacP->retrans_time - tv_sec;
+                interval = (transacP->retrans_time - now + 999) / 1000;
             }
             else
             {
@@ -344,37 +384,13 @@ int lwm2m_step(lwm2m_context_t * contextP,
     }
     update_bootstrap_state(contextP, tv_sec, timeoutP);
 #endif
+    separate_step(contextP, tv_sec, timeoutP);
+    persist_step(contextP);
 #endif
 
 #ifdef LWM2M_SERVER_MODE
     // monitor clients lifetime
-    clientP = contextP->clientList;
-    while (clientP != NULL)
-    {
-        lwm2m_client_t * nextP = clientP->next;
-
-        if (clientP->endOfLife <= tv_sec)
-        {
-            contextP->clientList = (lwm2m_client_t *)LWM2M_LIST_RM(contextP->clientList, clientP->internalID, NULL);
-            if (contextP->monitorCallback != NULL)
-            {
-                contextP->monitorCallback(clientP->internalID, NULL, DELETED_2_02, NULL, 0, contextP->monitorUserData);
-            }
-            prv_freeClient(clientP);
-        }
-        else
-        {
-            time_t interval;
-
-            interval = clientP->endOfLife - tv_sec;
-
-            if (*timeoutP > interval)
-            {
-                *timeoutP = interval;
-            }
-        }
-        clientP = nextP;
-    }
+    lifetime_step(contextP, tv_sec, timeoutP);
 #endif
 
     return 0;
@@ -384,15 +400,23 @@ int lwm2m_step(lwm2m_context_t * contextP,
 int lwm2m_start(lwm2m_context_t * contextP)
 {
     int result;
+    uint8_t * savedP = NULL;
+    size_t savedLength = 0;
     bool cleanup = (NULL != contextP->bootstrapServerList) || (NULL != contextP->serverList);
     delete_transaction_list(contextP);
     delete_observed_list(contextP);
+    separate_free_all(contextP);
     if (cleanup)
     {
         LOG("lwm2m_start: cleanup\n");
         delete_server_list(contextP);
         delete_bootstrap_server_list(contextP);
     }
+    else
+    {
+        // first start, possibly after a restart
+        savedP = persist_load(contextP, &savedLength);
+    }
     result = object_getServers(contextP);
     if (0 > result)
     {
@@ -404,6 +428,11 @@ int lwm2m_start(lwm2m_context_t * contextP)
             delete_bootstrap_server_list(contextP);
         }
     }
+    else if (NULL != savedP)
+    {
+        persist_resume(contextP, savedP, savedLength);
+    }
+    lwm2m_free(savedP);
     return result;
 }
 #endif
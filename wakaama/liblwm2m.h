@@ -85,6 +85,10 @@ int    lwm2m_strncmp(const char * s1, const char * s2, size_t n);
 // Per POSIX specifications, time_t is a signed integer.
 // An implementation for POSIX systems is provided in utils.c
 time_t lwm2m_gettime(void);
+// This function must return a monotonic number of milliseconds, wrapping
+// around at 2^32. It is used to time CoAP retransmissions.
+// An implementation for mbed is provided in utils.c
+uint32_t lwm2m_gettime_ms(void);
 
 /*
  * Error code
@@ -92,6 +96,8 @@ time_t lwm2m_gettime(void);
 
 #define COAP_NO_ERROR                   (uint8_t)0x00
 #define COAP_IGNORE                     (uint8_t)0x01
+// returned by object callbacks when the result is not available yet, see lwm2m_resource_ready()
+#define COAP_PENDING                    (uint8_t)0x02
 
 #define COAP_201_CREATED                (uint8_t)0x41
 #define COAP_202_DELETED                (uint8_t)0x42
@@ -102,6 +108,7 @@ time_t lwm2m_gettime(void);
 #define COAP_404_NOT_FOUND              (uint8_t)0x84
 #define COAP_405_METHOD_NOT_ALLOWED     (uint8_t)0x85
 #define COAP_406_NOT_ACCEPTABLE         (uint8_t)0x86
+#define COAP_412_PRECONDITION_FAILED    (uint8_t)0x8C
 #define COAP_500_INTERNAL_SERVER_ERROR  (uint8_t)0xA0
 #define COAP_501_NOT_IMPLEMENTED        (uint8_t)0xA1
 #define COAP_503_SERVICE_UNAVAILABLE    (uint8_t)0xA3
@@ -213,9 +220,13 @@ size_t lwm2m_boolToPlainText(bool data, uint8_t ** bufferP);
  * points to static memory and must no be freeed by the caller.
  * LWM2M_TLV_FLAG_TEXT_FORMAT specifies that lwm2m_tlv_t::value
  * is expressed or requested in plain text format.
+ * LWM2M_TLV_FLAG_ENCODED specifies that lwm2m_tlv_t::data holds
+ * the TLV header of the value, data[0] bytes long from data[1], and
+ * that it is copied as is in TLV payloads.
  */
 #define LWM2M_TLV_FLAG_STATIC_DATA   0x01
 #define LWM2M_TLV_FLAG_TEXT_FORMAT   0x02
+#define LWM2M_TLV_FLAG_ENCODED       0x08
 
 #ifdef LWM2M_BOOTSTRAP
 #define LWM2M_TLV_FLAG_BOOTSTRAPPING 0x04
@@ -256,6 +267,7 @@ typedef struct
     uint16_t    id;
     size_t      length;
     uint8_t *   value;
+    uint8_t     data[8];    // storage of short values, see lwm2m_tlv_encode_int()
 } lwm2m_tlv_t;
 
 lwm2m_tlv_t * lwm2m_tlv_new(int size);
@@ -263,6 +275,11 @@ int lwm2m_tlv_parse(uint8_t * buffer, size_t bufferLen, lwm2m_tlv_t ** dataP);
 int lwm2m_tlv_serialize(int size, lwm2m_tlv_t * tlvP, uint8_t ** bufferP);
 void lwm2m_tlv_free(int size, lwm2m_tlv_t * tlvP);
 
+/*
+ * The lwm2m_tlv_encode_*() functions keep values of up to 8 bytes in
+ * lwm2m_tlv_t::data, value then points there and LWM2M_TLV_FLAG_STATIC_DATA
+ * is set: such a lwm2m_tlv_t must be encoded again rather than copied.
+ */
 void lwm2m_tlv_encode_int(int64_t data, lwm2m_tlv_t * tlvP);
 int lwm2m_tlv_decode_int(lwm2m_tlv_t * tlvP, int64_t * dataP);
 void lwm2m_tlv_encode_float(double data, lwm2m_tlv_t * tlvP);
@@ -278,12 +295,62 @@ void lwm2m_tlv_include(lwm2m_tlv_t * subTlvP, size_t count, lwm2m_tlv_t * tlvP);
  * of error.
  */
 int lwm2m_intToTLV(lwm2m_tlv_type_t type, int64_t data, uint16_t id, uint8_t * buffer, size_t buffer_len);
+int lwm2m_floatToTLV(lwm2m_tlv_type_t type, double data, uint16_t id, uint8_t * buffer, size_t buffer_len);
 int lwm2m_boolToTLV(lwm2m_tlv_type_t type, bool value, uint16_t id, uint8_t * buffer, size_t buffer_len);
 int lwm2m_opaqueToTLV(lwm2m_tlv_type_t type, uint8_t * dataP, size_t data_len, uint16_t id, uint8_t * buffer, size_t buffer_len);
 int lwm2m_decodeTLV(uint8_t * buffer, size_t buffer_len, lwm2m_tlv_type_t * oType, uint16_t * oID, size_t * oDataIndex, size_t * oDataLen);
 int lwm2m_opaqueToInt(uint8_t * buffer, size_t buffer_len, int64_t * dataP);
 int lwm2m_opaqueToFloat(uint8_t * buffer, size_t buffer_len, double * dataP);
 
+/*
+ * Content formats
+ */
+
+typedef enum
+{
+    LWM2M_CONTENT_TEXT       = 0,       // single resource read or write
+    LWM2M_CONTENT_OPAQUE     = 42,
+    LWM2M_CONTENT_SENML_CBOR = 112,
+    LWM2M_CONTENT_TLV        = 1542,
+    LWM2M_CONTENT_JSON       = 1543     // application/vnd.oma.lwm2m+json
+} lwm2m_media_type_t;
+
+/*
+ * SenML CBOR and LwM2M JSON, see senml_cbor.c and json.c
+ *
+ * lwm2m_senml_cbor_parse() and lwm2m_json_parse() call back for each record of the pack with the base fields
+ * applied: the name is the full path ("/3303/0/5700"), numbers are LWM2M_TYPE_INTEGER or
+ * LWM2M_TYPE_FLOAT, strings and opaque values point in the parsed buffer.
+ */
+
+#define LWM2M_SENML_NAME_MAX_LEN 32
+
+typedef struct
+{
+    char              name[LWM2M_SENML_NAME_MAX_LEN + 1];
+    double            time;     // 0 when not set
+    lwm2m_data_type_t type;     // LWM2M_TYPE_UNDEFINED when the record has no value
+    union
+    {
+        int64_t asInteger;
+        double  asFloat;
+        bool    asBoolean;
+        struct
+        {
+            uint8_t * buffer;
+            size_t    length;
+        } asBuffer;
+    } value;
+} lwm2m_senml_record_t;
+
+// a non zero return value stops the parsing
+typedef int (*lwm2m_senml_callback_t)(lwm2m_senml_record_t * recordP, void * userData);
+
+// return the number of records, 0 in case of error
+int lwm2m_senml_cbor_parse(uint8_t * buffer, size_t length, lwm2m_senml_callback_t callback, void * userData);
+// escaped strings are decoded in place, the buffer can only be parsed once
+int lwm2m_json_parse(uint8_t * buffer, size_t length, lwm2m_senml_callback_t callback, void * userData);
+
 /*
  * URI
  *
@@ -310,6 +377,11 @@ typedef struct
 } lwm2m_uri_t;
 
 
+// Static initializers of lwm2m_uri_t, e.g. static lwm2m_uri_t uri = LWM2M_URI_RESOURCE(3303, 0, 5700);
+#define LWM2M_URI_OBJECT(O)         { LWM2M_URI_FLAG_OBJECT_ID, (O), 0, 0 }
+#define LWM2M_URI_INSTANCE(O, I)    { LWM2M_URI_FLAG_OBJECT_ID | LWM2M_URI_FLAG_INSTANCE_ID, (O), (I), 0 }
+#define LWM2M_URI_RESOURCE(O, I, R) { LWM2M_URI_FLAG_OBJECT_ID | LWM2M_URI_FLAG_INSTANCE_ID | LWM2M_URI_FLAG_RESOURCE_ID, (O), (I), (R) }
+
 #define LWM2M_STRING_ID_MAX_LEN 6
 
 // Parse an URI in LWM2M format and fill the lwm2m_uri_t.
@@ -336,6 +408,60 @@ typedef uint8_t (*lwm2m_create_callback_t) (uint16_t instanceId, int numData, lw
 typedef uint8_t (*lwm2m_delete_callback_t) (uint16_t instanceId, lwm2m_object_t * objectP);
 typedef void (*lwm2m_close_callback_t) (lwm2m_object_t * objectP);
 
+/*
+ * Table driven objects
+ *
+ * Instead of writing its read, write and execute callbacks, an object can
+ * describe its resources in an array sorted by increasing id and register
+ * it with lwm2m_object_set_resources(). The library then provides the
+ * callbacks, looking the resources up by binary search, and checks the
+ * instance against objectP->instanceList.
+ *
+ * Static resources carry their value in the table and need no callback.
+ * Their TLV headers, and the values of numbers, are serialized once in a
+ * small image when the table is registered. Reads point at the strings in
+ * the table and at the numbers in the image without encoding anything.
+ * Other resources have per resource callbacks, called with tlvP->id set.
+ * The read callback fills the value of tlvP, the type is set to
+ * LWM2M_TYPE_RESOURCE unless the resource is declared multiple, in which
+ * case the callback uses lwm2m_tlv_include().
+ */
+
+#define LWM2M_RES_READ      0x01
+#define LWM2M_RES_WRITE     0x02
+#define LWM2M_RES_EXECUTE   0x04
+#define LWM2M_RES_MULTIPLE  0x08
+#define LWM2M_RES_STATIC    0x10
+
+typedef uint8_t (*lwm2m_resource_callback_t) (uint16_t instanceId, lwm2m_tlv_t * tlvP, lwm2m_object_t * objectP);
+
+typedef struct
+{
+    uint16_t                  id;
+    uint8_t                   operations;   // bitmask of LWM2M_RES_*
+    lwm2m_data_type_t         dataType;
+    lwm2m_resource_callback_t readFunc;
+    lwm2m_resource_callback_t writeFunc;
+    lwm2m_execute_callback_t  executeFunc;
+    // value of a static resource: bytes for strings and opaque, number otherwise
+    const void *              value;
+    size_t                    length;
+    double                    number;
+} lwm2m_resource_desc_t;
+
+// The fields are positional so that tables can be initialized in C and C++
+#define LWM2M_RESOURCE(ID, TYPE, OPERATIONS, READ, WRITE) \
+    { (ID), (OPERATIONS), (TYPE), (READ), (WRITE), NULL, NULL, 0, 0 }
+#define LWM2M_RESOURCE_EXECUTE(ID, EXECUTE) \
+    { (ID), LWM2M_RES_EXECUTE, LWM2M_TYPE_UNDEFINED, NULL, NULL, (EXECUTE), NULL, 0, 0 }
+// TEXT must be a string literal
+#define LWM2M_RESOURCE_STATIC_STRING(ID, TEXT) \
+    { (ID), LWM2M_RES_READ | LWM2M_RES_STATIC, LWM2M_TYPE_STRING, NULL, NULL, NULL, (TEXT), sizeof(TEXT) - 1, 0 }
+#define LWM2M_RESOURCE_STATIC_INT(ID, VALUE) \
+    { (ID), LWM2M_RES_READ | LWM2M_RES_STATIC, LWM2M_TYPE_INTEGER, NULL, NULL, NULL, NULL, 0, (VALUE) }
+#define LWM2M_RESOURCE_STATIC_FLOAT(ID, VALUE) \
+    { (ID), LWM2M_RES_READ | LWM2M_RES_STATIC, LWM2M_TYPE_FLOAT, NULL, NULL, NULL, NULL, 0, (VALUE) }
+
 struct _lwm2m_object_t
 {
     uint16_t                 objID;
@@ -347,8 +473,16 @@ struct _lwm2m_object_t
     lwm2m_delete_callback_t  deleteFunc;
     lwm2m_close_callback_t   closeFunc;
     void *                   userData;
+    const lwm2m_resource_desc_t * resourceArray;
+    size_t                   resourceCount;
+    uint8_t *                resourceImage; // freed by the library
 };
 
+// defined in object_table.c
+// Set the object callbacks for the operations found in resourceArray.
+// Return false if the array is not sorted by strictly increasing id.
+bool lwm2m_object_set_resources(lwm2m_object_t * objectP, const lwm2m_resource_desc_t * resourceArray, size_t resourceCount);
+
 /*
  * LWM2M Servers
  *
@@ -377,6 +511,30 @@ typedef enum
     BINDING_UQS  // UDP queue mode plus SMS
 } lwm2m_binding_t;
 
+/*
+ * CoAP congestion control state of a peer
+ *
+ * Retransmission timeout estimated from the measured RTTs as in CoCoA
+ * (draft-ietf-core-cocoa): a strong estimator fed by exchanges without
+ * retransmission and a weak one fed by exchanges that needed retransmissions.
+ * All times are in milliseconds, RTT estimators are 0 until a first sample.
+ */
+typedef struct
+{
+    uint32_t rto;               // current retransmission timeout
+    uint32_t rtoUpdate;         // date of the last RTO update, for aging
+    uint32_t strongRtt;
+    uint32_t strongRttVar;
+    uint32_t weakRtt;
+    uint32_t weakRttVar;
+    uint32_t lastRtt;
+    uint8_t  inFlight;          // outstanding confirmable messages, bounded by NSTART
+    // instrumentation
+    uint32_t transmissions;     // confirmable messages sent, retransmissions excluded
+    uint32_t retransmissions;
+    uint32_t timeouts;          // exchanges given up after the last retransmission
+} lwm2m_peer_cc_t;
+
 typedef struct _lwm2m_server_
 {
     struct _lwm2m_server_ * next;   // matches lwm2m_list_t::next
@@ -388,6 +546,9 @@ typedef struct _lwm2m_server_
     void *            sessionH;
     lwm2m_status_t    status;
     char *            location;
+    uint8_t           retryCount;   // registration failures in a row
+    time_t            retryDelay;   // after the date of the last failure, in sec
+    lwm2m_peer_cc_t   cc;
 } lwm2m_server_t;
 
 
@@ -409,13 +570,24 @@ typedef void (*lwm2m_result_callback_t) (uint16_t clientID, lwm2m_uri_t * uriP,
 typedef struct _lwm2m_observation_
 {
     struct _lwm2m_observation_ * next;  // matches lwm2m_list_t::next
-    uint16_t                     id;    // matches lwm2m_list_t::id
+    uint16_t                     id;    // matches lwm2m_list_t::id, the slot in lwm2m_context_t::observationSlots
     struct _lwm2m_client_ * clientP;
+    lwm2m_status_t          status;
     lwm2m_uri_t             uri;
     lwm2m_result_callback_t callback;
     void *                  userData;
 } lwm2m_observation_t;
 
+typedef struct
+{
+    lwm2m_observation_t * observationP;   // NULL when the slot is free
+    uint16_t              generation;     // incremented when the slot is released
+    uint16_t              nextFree;
+} lwm2m_observation_slot_t;
+
+// operation sent to a set of clients, see group.c
+typedef struct _lwm2m_group_ lwm2m_group_t;
+
 /*
  * LWM2M Clients
  *
@@ -431,6 +603,40 @@ typedef struct _lwm2m_client_object_
     lwm2m_list_t *           instanceList;
 } lwm2m_client_object_t;
 
+/*
+ * Object list shared by the clients which sent the same registration payload.
+ * The lwm2m_client_object_t, their instances, the payload and the alternative path
+ * are stored after this header in the same block and are never modified.
+ */
+
+typedef struct _lwm2m_shared_objects_
+{
+    struct _lwm2m_shared_objects_ * next;
+    uint32_t                hash;       // of the payload
+    uint32_t                refCount;
+    lwm2m_client_object_t * objectList;
+    char *                  altPath;
+    uint16_t                payloadLength;
+    uint8_t *               payload;
+} lwm2m_shared_objects_t;
+
+/*
+ * Last value read from or notified by a client, see cache.c.
+ * The payload is stored after this header in the same block.
+ */
+
+typedef struct _lwm2m_cache_entry_
+{
+    struct _lwm2m_cache_entry_ * next;
+    lwm2m_uri_t             uri;
+    time_t                  time;       // of the reception
+    time_t                  expiry;     // time + Max-Age of the response
+    bool                    observed;   // the value came with an Observe option
+    uint32_t                observeCount;
+    uint16_t                payloadLength;
+    uint8_t *               payload;
+} lwm2m_cache_entry_t;
+
 typedef struct _lwm2m_client_
 {
     struct _lwm2m_client_ * next;       // matches lwm2m_list_t::next
@@ -441,9 +647,15 @@ typedef struct _lwm2m_client_
     char *                  altPath;
     uint32_t                lifetime;
     time_t                  endOfLife;
+    size_t                  lifetimeIndex;  // position in lwm2m_context_t::lifetimeHeap
+    uint32_t                nameHash;
+    struct _lwm2m_client_ * nameNext;       // chain of lwm2m_context_t::clientNameTable
     void *                  sessionH;
-    lwm2m_client_object_t * objectList;
+    lwm2m_client_object_t * objectList;     // sharedObjects->objectList, read-only
+    lwm2m_shared_objects_t * sharedObjects;
     lwm2m_observation_t *   observationList;
+    lwm2m_cache_entry_t *   cacheList;      // most recently used first
+    lwm2m_peer_cc_t         cc;
 } lwm2m_client_t;
 
 
@@ -472,8 +684,11 @@ struct _lwm2m_transaction_
     void *                peerP;
     uint8_t               ack_received; // indicates, that the ACK was received
     time_t                response_timeout; // timeout to wait for response, if token is used. When 0, use calculated acknowledge timeout.
-    uint8_t  retrans_counter;
-    time_t   retrans_time;
+    uint8_t  retrans_counter;   // number of transmissions
+    uint32_t retrans_time;      // date of the next transmission or timeout, in ms
+    uint32_t retrans_timeout;   // current retransmission timeout, in ms
+    uint32_t first_send_time;   // date of the first transmission, for RTT measurement
+    bool     outstanding;       // counted in the peer's NSTART
     char objStringID[LWM2M_STRING_ID_MAX_LEN];
     char instanceStringID[LWM2M_STRING_ID_MAX_LEN];
     char resourceStringID[LWM2M_STRING_ID_MAX_LEN];
@@ -496,6 +711,7 @@ typedef struct _lwm2m_watcher_
     size_t tokenLen;
     uint32_t counter;
     uint16_t lastMid;
+    lwm2m_media_type_t format;
 } lwm2m_watcher_t;
 
 typedef struct _lwm2m_observed_
@@ -528,6 +744,12 @@ typedef enum {
 typedef void * (*lwm2m_connect_server_callback_t)(uint16_t secObjInstID, void * userData);
 // The session handle MUST uniquely identify a peer.
 typedef uint8_t (*lwm2m_buffer_send_callback_t)(void * sessionH, uint8_t * buffer, size_t length, void * userData);
+// Optional transmit buffer management, see lwm2m_set_transmit_callbacks().
+// The alloc callback returns a buffer of at least length bytes and sets an opaque handle on it.
+typedef uint8_t * (*lwm2m_buffer_alloc_callback_t)(void * sessionH, size_t length, void ** handleP, void * userData);
+// The handle send callback sends the first length bytes of the buffer and releases the handle.
+// It is called with length 0 to only release the handle.
+typedef uint8_t (*lwm2m_handle_send_callback_t)(void * sessionH, void * handle, size_t length, void * userData);
 
 #ifdef LWM2M_BOOTSTRAP_SERVER_MODE
 // In all the following APIs, the session handle MUST uniquely identify a peer.
@@ -537,15 +759,62 @@ typedef uint8_t (*lwm2m_buffer_send_callback_t)(void * sessionH, uint8_t * buffe
 // name is set. The callback must return a COAP_* error code. COAP_204_CHANGED for success.
 // After a lwm2m_bootstrap_delete() or a lwm2m_bootstrap_write(), the callback is called with the status returned by the
 // client, the URI of the operation (may be nil) and name is nil. The callback return value is ignored.
+// After a lwm2m_bootstrap_finish(), the URI has no object ID, see LWM2M_URI_IS_BOOTSTRAP_FINISH().
 typedef int (*lwm2m_bootstrap_callback_t) (void * sessionH, uint8_t status, lwm2m_uri_t * uriP, char * name, void * userData);
+
+#define LWM2M_URI_IS_BOOTSTRAP_FINISH(uri) ((uri) != NULL && ((uri)->flag & LWM2M_URI_FLAG_OBJECT_ID) == 0)
 #endif
 
+/*
+ * Duplicate request detection, see dedup.c
+ */
+typedef struct _lwm2m_dedup_entry_ lwm2m_dedup_entry_t;
+
+typedef struct
+{
+    uint32_t hits;      // retransmitted requests answered from the cache
+    uint32_t misses;    // confirmable requests processed
+    uint32_t evictions; // entries dropped before their lifetime because of the memory caps
+    uint16_t entries;
+    size_t   bytes;
+} lwm2m_dedup_stats_t;
+
+/*
+ * Requests deferred by an object callback, see separate.c
+ */
+typedef struct _lwm2m_pending_ lwm2m_pending_t;
+
+/*
+ * URI resolved once for lwm2m_handle_value_changed(), see observe.c
+ */
+typedef struct _lwm2m_uri_handle_ lwm2m_uri_handle_t;
+
+/*
+ * Session state saved for a warm restart, see persist.c
+ */
+// Replace the saved state with the length bytes of buffer. Returns false if it could not be saved.
+typedef bool (*lwm2m_store_callback_t)(uint8_t * buffer, size_t length, void * userData);
+// Copy the saved state in buffer and return its length, or 0 if there is none or it is larger than length.
+typedef size_t (*lwm2m_load_callback_t)(uint8_t * buffer, size_t length, void * userData);
+
+/*
+ * Registry of the clients kept by a server across restarts, see persist.c
+ */
+// Append the length bytes of record, e.g. to a file. The last record of a client supersedes the previous ones.
+typedef void (*lwm2m_registry_callback_t)(const uint8_t * record, size_t length, void * userData);
+// Write the address of the session in buffer and return its length, or 0 if it does not fit in length.
+typedef size_t (*lwm2m_session_encode_callback_t)(void * sessionH, uint8_t * buffer, size_t length, void * userData);
+// Return the session matching an address written by the encode callback.
+typedef void * (*lwm2m_session_decode_callback_t)(const uint8_t * buffer, size_t length, void * userData);
+
 typedef struct
 {
 #ifdef LWM2M_CLIENT_MODE
 #ifdef LWM2M_BOOTSTRAP
     lwm2m_bootstrap_state_t bsState;
     time_t              bsStart;
+    uint8_t             bsRetryCount;       // bootstrap failures in a row
+    time_t              bsRetryDelay;
 #endif
     char *              endpointName;
     char *              msisdn;
@@ -555,21 +824,59 @@ typedef struct
     lwm2m_object_t **   objectList;
     uint16_t            numObject;
     lwm2m_observed_t *  observedList;
+    uint32_t            observedVersion;    // incremented when an entry is added to or removed from observedList
+    lwm2m_uri_handle_t * uriHandleList;
+    lwm2m_pending_t *   pendingList;
+    lwm2m_store_callback_t storeCallback;
+    lwm2m_load_callback_t  loadCallback;
+    void *              persistUserData;
+    bool                persistDirty;       // the saved state is outdated
+    uint16_t            persistNotifyCount; // notifications sent since the state was saved
 #endif
 #ifdef LWM2M_SERVER_MODE
     lwm2m_client_t *        clientList;
+    lwm2m_client_t **       lifetimeHeap;   // clientList ordered by endOfLife
+    lwm2m_client_t **       clientTable;    // clientList indexed by internalID
+    lwm2m_client_t **       clientNameTable;    // clientList hashed by name
+    lwm2m_shared_objects_t ** sharedObjectsTable;   // LWM2M_SHARED_OBJECTS_BUCKETS chains
+    size_t                  lifetimeCount;
+    size_t                  lifetimeSize;
+    size_t                  clientTableSize;
+    size_t                  clientFreeID;   // the IDs below are all used
+    size_t                  clientNameTableSize;
+    lwm2m_observation_slot_t * observationSlots;
+    uint16_t                observationSlotCount;
+    uint16_t                observationFreeSlot;
     lwm2m_result_callback_t monitorCallback;
     void *                  monitorUserData;
+    lwm2m_registry_callback_t       registryCallback;
+    lwm2m_session_encode_callback_t sessionEncodeCallback;
+    lwm2m_session_decode_callback_t sessionDecodeCallback;
+    void *                          registryUserData;
+    lwm2m_group_t *         groupList;
+    uint32_t                groupRate;      // requests per second
+    uint16_t                groupWindow;    // maximum requests in flight
+    uint16_t                groupCwnd;      // current window, halved on a loss
+    uint16_t                groupInFlight;
+    uint16_t                groupAcked;     // responses since the last growth of the window
+    uint32_t                groupCredit;    // requests allowed by the rate, in 1/1000
+    uint32_t                groupTime;      // of the last credit update, in ms
 #endif
 #ifdef LWM2M_BOOTSTRAP_SERVER_MODE
     lwm2m_bootstrap_callback_t bootstrapCallback;
     void *                     bootstrapUserData;
 #endif
     uint16_t                nextMID;
+    uint32_t                randomState;    // of the retransmission jitter and the retry delays, see utils_random()
     lwm2m_transaction_t *   transactionList;
+    lwm2m_dedup_entry_t *   dedupList;
+    lwm2m_dedup_stats_t     dedupStats;
+    void *                  packets;    // coap_packet_t[2]: the received message and its response
     // communication layer callbacks
     lwm2m_connect_server_callback_t connectCallback;
     lwm2m_buffer_send_callback_t    bufferSendCallback;
+    lwm2m_buffer_alloc_callback_t   bufferAllocCallback;
+    lwm2m_handle_send_callback_t    handleSendCallback;
     void *                          userData;
 } lwm2m_context_t;
 
@@ -578,6 +885,13 @@ typedef struct
 lwm2m_context_t * lwm2m_init(lwm2m_connect_server_callback_t connectCallback, lwm2m_buffer_send_callback_t bufferSendCallback, void * userData);
 // close a liblwm2m context.
 void lwm2m_close(lwm2m_context_t * contextP);
+// let the communication layer provide the buffers in which messages sent once (responses, acknowledgements)
+// are serialized, e.g. network stack buffers, instead of a temporary heap buffer then copied by bufferSendCallback.
+// Messages which may be retransmitted still use bufferSendCallback.
+void lwm2m_set_transmit_callbacks(lwm2m_context_t * contextP, lwm2m_buffer_alloc_callback_t allocCallback, lwm2m_handle_send_callback_t sendCallback);
+
+// copy the duplicate request detection counters
+void lwm2m_get_dedup_stats(lwm2m_context_t * contextP, lwm2m_dedup_stats_t * statsP);
 
 // perform any required pending operation and adjust timeoutP to the maximal time interval to wait in seconds.
 int lwm2m_step(lwm2m_context_t * contextP, time_t * timeoutP);
@@ -592,12 +906,34 @@ void lwm2m_handle_packet(lwm2m_context_t * contextP, uint8_t * buffer, int lengt
 int lwm2m_configure(lwm2m_context_t * contextP, const char * endpointName, const char * msisdn, const char * altPath, uint16_t numObject, lwm2m_object_t * objectList[]);
 
 // create objects for known LWM2M Servers.
+// On the first call, the session state saved before a restart is restored if the persistence callbacks are set.
 int lwm2m_start(lwm2m_context_t * contextP);
 
+// save the bootstrap configuration, the registrations and the observations whenever they change, so that
+// after a restart lwm2m_start() resumes the registrations with an update instead of registering again.
+// Must be called before lwm2m_start().
+void lwm2m_set_persistence_callbacks(lwm2m_context_t * contextP, lwm2m_store_callback_t storeCallback, lwm2m_load_callback_t loadCallback, void * userData);
+
 // send a registration update to the server specified by the server short identifier
 int lwm2m_update_registration(lwm2m_context_t * contextP, uint16_t shortServerID);
 
 void lwm2m_resource_value_changed(lwm2m_context_t * contextP, lwm2m_uri_t * uriP);
+
+// For values changing often: the URI is resolved once into a handle keeping the list of the observations
+// it concerns, so that lwm2m_handle_value_changed() does not search them. The handle stays valid until
+// lwm2m_close(). Returns NULL if out of memory.
+lwm2m_uri_handle_t * lwm2m_uri_handle_new(lwm2m_context_t * contextP, lwm2m_uri_t * uriP);
+void lwm2m_handle_value_changed(lwm2m_context_t * contextP, lwm2m_uri_handle_t * handleP);
+
+// A read, write or execute callback returning COAP_PENDING defers the request: the server receives an empty
+// ACK and the response is sent later in a separate confirmable message. Once the data is available, call
+// lwm2m_resource_ready() with the URI (or a parent URI) of the deferred requests: they are dispatched again
+// to the object callbacks, which must then return the final result.
+void lwm2m_resource_ready(lwm2m_context_t * contextP, lwm2m_uri_t * uriP);
+
+// copy the CoAP transmission state (RTO, RTT estimations, retransmission counters) of the server specified
+// by the server short identifier. Returns COAP_NO_ERROR or COAP_404_NOT_FOUND.
+int lwm2m_get_server_transmission_stats(lwm2m_context_t * contextP, uint16_t shortServerID, lwm2m_peer_cc_t * statsP);
 #endif
 
 #ifdef LWM2M_SERVER_MODE
@@ -609,16 +945,43 @@ void lwm2m_resource_value_changed(lwm2m_context_t * contextP, lwm2m_uri_t * uriP
 // The lwm2m_client_t is present in the lwm2m_context_t's clientList when the callback is called. On a deregistration, it deleted when the callback returns.
 void lwm2m_set_monitoring_callback(lwm2m_context_t * contextP, lwm2m_result_callback_t callback, void * userData);
 
+// Clients registry API.
+// The registry callback receives a record each time a client registers, updates its registration or is removed.
+// The session callbacks let the records keep the clients addresses, they can be nil.
+void lwm2m_set_registry_callbacks(lwm2m_context_t * contextP, lwm2m_registry_callback_t registryCallback, lwm2m_session_encode_callback_t encodeCallback, lwm2m_session_decode_callback_t decodeCallback, void * userData);
+// After a restart, rebuild the clients from the records in the order they were written, before handling any packet.
+// The monitoring callback is not called for the restored clients. Returns COAP_NO_ERROR, or COAP_412_PRECONDITION_FAILED
+// if clients already registered.
+int lwm2m_registry_restore(lwm2m_context_t * contextP, const uint8_t * buffer, size_t length);
+// Write the records of all the clients, e.g. to start a compacted registry file.
+void lwm2m_registry_snapshot(lwm2m_context_t * contextP);
+
 // Device Management APIs
 int lwm2m_dm_read(lwm2m_context_t * contextP, uint16_t clientID, lwm2m_uri_t * uriP, lwm2m_result_callback_t callback, void * userData);
+// Same as lwm2m_dm_read() but if a value of uriP at most maxAge seconds old, and still within the Max-Age given by the client,
+// was received by a read or a notification, callback is called with it before returning instead of sending a request.
+int lwm2m_dm_read_cached(lwm2m_context_t * contextP, uint16_t clientID, lwm2m_uri_t * uriP, uint32_t maxAge, lwm2m_result_callback_t callback, void * userData);
 int lwm2m_dm_write(lwm2m_context_t * contextP, uint16_t clientID, lwm2m_uri_t * uriP, uint8_t * buffer, int length, lwm2m_result_callback_t callback, void * userData);
 int lwm2m_dm_execute(lwm2m_context_t * contextP, uint16_t clientID, lwm2m_uri_t * uriP, uint8_t * buffer, int length, lwm2m_result_callback_t callback, void * userData);
 int lwm2m_dm_create(lwm2m_context_t * contextP, uint16_t clientID, lwm2m_uri_t * uriP, uint8_t * buffer, int length, lwm2m_result_callback_t callback, void * userData);
 int lwm2m_dm_delete(lwm2m_context_t * contextP, uint16_t clientID, lwm2m_uri_t * uriP, lwm2m_result_callback_t callback, void * userData);
 
+// Group Device Management APIs
+// The request is sent to each of the count clients of clientIDs, paced by lwm2m_step() and by the responses.
+// callback is called with the result of each client, then a last time with a nil uriP once all the clients answered.
+int lwm2m_dm_group_read(lwm2m_context_t * contextP, const uint16_t * clientIDs, size_t count, lwm2m_uri_t * uriP, lwm2m_result_callback_t callback, void * userData);
+int lwm2m_dm_group_write(lwm2m_context_t * contextP, const uint16_t * clientIDs, size_t count, lwm2m_uri_t * uriP, uint8_t * buffer, int length, lwm2m_result_callback_t callback, void * userData);
+// At most rate requests per second and window requests in flight for all the groups. The window is halved on a
+// timeout or a retransmission and grows back by one request per window of responses.
+void lwm2m_set_group_pacing(lwm2m_context_t * contextP, uint32_t rate, uint16_t window);
+
 // Information Reporting APIs
 int lwm2m_observe(lwm2m_context_t * contextP, uint16_t clientID, lwm2m_uri_t * uriP, lwm2m_result_callback_t callback, void * userData);
 int lwm2m_observe_cancel(lwm2m_context_t * contextP, uint16_t clientID, lwm2m_uri_t * uriP, lwm2m_result_callback_t callback, void * userData);
+
+// copy the CoAP transmission state (RTO, RTT estimations, retransmission counters) of a client.
+// Returns COAP_NO_ERROR or COAP_404_NOT_FOUND.
+int lwm2m_get_client_transmission_stats(lwm2m_context_t * contextP, uint16_t clientID, lwm2m_peer_cc_t * statsP);
 #endif
 
 #ifdef LWM2M_BOOTSTRAP_SERVER_MODE
@@ -630,11 +993,22 @@ void lwm2m_set_bootstrap_callback(lwm2m_context_t * contextP, lwm2m_bootstrap_ca
 // if uriP is nil, a "Delete /" is sent to the client
 int lwm2m_bootstrap_delete(lwm2m_context_t * contextP, void * sessionH, lwm2m_uri_t * uriP);
 int lwm2m_bootstrap_write(lwm2m_context_t * contextP, void * sessionH, lwm2m_uri_t * uriP, uint8_t * buffer, size_t length);
+// End the bootstrap: the client checks its configuration and registers at once instead of waiting for its
+// bootstrap timeout. The callback is called with the status returned by the client, a URI without object ID
+// and a nil name.
+int lwm2m_bootstrap_finish(lwm2m_context_t * contextP, void * sessionH);
 
 #endif
 
 #ifdef __cplusplus
 }
+
+// the size of the table is deduced from its declaration
+template <size_t N>
+inline bool lwm2m_object_set_resources(lwm2m_object_t * objectP, const lwm2m_resource_desc_t (&resourceArray)[N])
+{
+    return lwm2m_object_set_resources(objectP, resourceArray, N);
+}
 #endif
 
 #endif
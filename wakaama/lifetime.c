@@ -0,0 +1,383 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - initial API and implementation
+ *
+ *******************************************************************************/
+
+/************************************************************************
+ *  Registration lifetime of the clients, server side.
+ *
+ *  The registered clients are kept in a binary min-heap ordered by their
+ *  endOfLife, so that lwm2m_step() only looks at the clients whose
+ *  registration expired and at the next one to expire, instead of
+ *  sweeping the whole client list. Each client keeps its position in the
+ *  heap, a registration update moves it in O(log n).
+ *
+ *  The same clients are also indexed by their ID in clientTable, the IDs
+ *  being allocated from 0 without gaps, to find a client in O(1). The
+ *  lowest free ID is searched from clientFreeID, below which every ID is
+ *  used, and LWM2M_MAX_ID being reserved, at most 65535 clients register.
+ *  clientList stays sorted by ID: the client before another one is the
+ *  closest one below it in clientTable, right below for a new ID.
+ *
+ *  A client registering again is found by its name in clientNameTable,
+ *  a hash table growing with the clients.
+ */
+
+#include "internals.h"
+
+#ifdef LWM2M_SERVER_MODE
+
+#define LIFETIME_HEAP_MIN_SIZE  16
+
+static void prv_set(lwm2m_context_t * contextP,
+                    size_t index,
+                    lwm2m_client_t * clientP)
+{
+    contextP->lifetimeHeap[index] = clientP;
+    clientP->lifetimeIndex = index;
+}
+
+static void prv_sift_up(lwm2m_context_t * contextP,
+                        size_t index)
+{
+    lwm2m_client_t * clientP = contextP->lifetimeHeap[index];
+
+    while (index > 0)
+    {
+        size_t parent = (index - 1) / 2;
+
+        if (contextP->lifetimeHeap[parent]->endOfLife <= clientP->endOfLife) break;
+        prv_set(contextP, index, contextP->lifetimeHeap[parent]);
+        index = parent;
+    }
+    prv_set(contextP, index, clientP);
+}
+
+static void prv_sift_down(lwm2m_context_t * contextP,
+                          size_t index)
+{
+    lwm2m_client_t * clientP = contextP->lifetimeHeap[index];
+
+    while (true)
+    {
+        size_t child = 2 * index + 1;
+
+        if (child >= contextP->lifetimeCount) break;
+        if (child + 1 < contextP->lifetimeCount
+         && contextP->lifetimeHeap[child + 1]->endOfLife < contextP->lifetimeHeap[child]->endOfLife)
+        {
+            child++;
+        }
+        if (clientP->endOfLife <= contextP->lifetimeHeap[child]->endOfLife) break;
+        prv_set(contextP, index, contextP->lifetimeHeap[child]);
+        index = child;
+    }
+    prv_set(contextP, index, clientP);
+}
+
+static bool prv_index(lwm2m_context_t * contextP,
+                      lwm2m_client_t * clientP)
+{
+    if (clientP->internalID < contextP->clientTableSize
+     && contextP->clientTable[clientP->internalID] != NULL)
+    {
+        // the ID of another client
+        return contextP->clientTable[clientP->internalID] == clientP;
+    }
+    if (clientP->internalID >= contextP->clientTableSize)
+    {
+        lwm2m_client_t ** tableP;
+        size_t size;
+
+        size = (contextP->clientTableSize == 0) ? LIFETIME_HEAP_MIN_SIZE : 2 * contextP->clientTableSize;
+        if (size <= clientP->internalID) size = (size_t)clientP->internalID + 1;
+        tableP = (lwm2m_client_t **)lwm2m_malloc(size * sizeof(lwm2m_client_t *));
+        if (tableP == NULL) return false;
+        memset(tableP, 0, size * sizeof(lwm2m_client_t *));
+        if (contextP->clientTableSize != 0)
+        {
+            memcpy(tableP, contextP->clientTable, contextP->clientTableSize * sizeof(lwm2m_client_t *));
+        }
+        lwm2m_free(contextP->clientTable);
+        contextP->clientTable = tableP;
+        contextP->clientTableSize = size;
+    }
+
+    contextP->clientTable[clientP->internalID] = clientP;
+    return true;
+}
+
+// returns false if all the IDs are used
+bool lifetime_new_id(lwm2m_context_t * contextP,
+                     uint16_t * idP)
+{
+    size_t id = contextP->clientFreeID;
+
+    while (id < contextP->clientTableSize && contextP->clientTable[id] != NULL)
+    {
+        id++;
+    }
+    contextP->clientFreeID = id;
+    if (id >= LWM2M_MAX_ID) return false;
+
+    *idP = (uint16_t)id;
+    return true;
+}
+
+static bool prv_hash_name(lwm2m_context_t * contextP,
+                          lwm2m_client_t * clientP)
+{
+    size_t bucket;
+
+    if (contextP->lifetimeCount >= contextP->clientNameTableSize)
+    {
+        lwm2m_client_t ** tableP;
+        size_t size;
+        size_t i;
+
+        size = (contextP->clientNameTableSize == 0) ? LIFETIME_HEAP_MIN_SIZE : 2 * contextP->clientNameTableSize;
+        tableP = (lwm2m_client_t **)lwm2m_malloc(size * sizeof(lwm2m_client_t *));
+        if (tableP == NULL) return false;
+        memset(tableP, 0, size * sizeof(lwm2m_client_t *));
+        for (i = 0 ; i < contextP->clientNameTableSize ; i++)
+        {
+            while (contextP->clientNameTable[i] != NULL)
+            {
+                lwm2m_client_t * targetP = contextP->clientNameTable[i];
+
+                contextP->clientNameTable[i] = targetP->nameNext;
+                targetP->nameNext = tableP[targetP->nameHash % size];
+                tableP[targetP->nameHash % size] = targetP;
+            }
+        }
+        lwm2m_free(contextP->clientNameTable);
+        contextP->clientNameTable = tableP;
+        contextP->clientNameTableSize = size;
+    }
+
+    clientP->nameHash = utils_hash((uint8_t *)clientP->name, strlen(clientP->name));
+    bucket = clientP->nameHash % contextP->clientNameTableSize;
+    clientP->nameNext = contextP->clientNameTable[bucket];
+    contextP->clientNameTable[bucket] = clientP;
+
+    return true;
+}
+
+static void prv_unhash_name(lwm2m_context_t * contextP,
+                            lwm2m_client_t * clientP)
+{
+    lwm2m_client_t ** nextP;
+
+    if (contextP->clientNameTableSize == 0) return;
+
+    nextP = &contextP->clientNameTable[clientP->nameHash % contextP->clientNameTableSize];
+    while (*nextP != NULL && *nextP != clientP) nextP = &(*nextP)->nameNext;
+    if (*nextP != NULL) *nextP = clientP->nameNext;
+}
+
+// the closest client below this ID
+static lwm2m_client_t * prv_previous(lwm2m_context_t * contextP,
+                                     uint16_t clientID)
+{
+    size_t index = clientID;
+
+    if (index > contextP->clientTableSize) index = contextP->clientTableSize;
+    while (index > 0)
+    {
+        index--;
+        if (contextP->clientTable[index] != NULL) return contextP->clientTable[index];
+    }
+
+    return NULL;
+}
+
+bool lifetime_add(lwm2m_context_t * contextP,
+                  lwm2m_client_t * clientP)
+{
+    if (!prv_index(contextP, clientP)) return false;
+    if (!prv_hash_name(contextP, clientP))
+    {
+        contextP->clientTable[clientP->internalID] = NULL;
+        return false;
+    }
+
+    if (contextP->lifetimeCount == contextP->lifetimeSize)
+    {
+        lwm2m_client_t ** heapP;
+        size_t size;
+
+        size = (contextP->lifetimeSize == 0) ? LIFETIME_HEAP_MIN_SIZE : 2 * contextP->lifetimeSize;
+        heapP = (lwm2m_client_t **)lwm2m_malloc(size * sizeof(lwm2m_client_t *));
+        if (heapP == NULL)
+        {
+            contextP->clientTable[clientP->internalID] = NULL;
+            prv_unhash_name(contextP, clientP);
+            return false;
+        }
+        if (contextP->lifetimeCount != 0)
+        {
+            memcpy(heapP, contextP->lifetimeHeap, contextP->lifetimeCount * sizeof(lwm2m_client_t *));
+        }
+        lwm2m_free(contextP->lifetimeHeap);
+        contextP->lifetimeHeap = heapP;
+        contextP->lifetimeSize = size;
+    }
+
+    prv_set(contextP, contextP->lifetimeCount, clientP);
+    contextP->lifetimeCount++;
+    prv_sift_up(contextP, clientP->lifetimeIndex);
+
+    return true;
+}
+
+// to call after a change of clientP->endOfLife
+void lifetime_update(lwm2m_context_t * contextP,
+                     lwm2m_client_t * clientP)
+{
+    prv_sift_up(contextP, clientP->lifetimeIndex);
+    prv_sift_down(contextP, clientP->lifetimeIndex);
+}
+
+void lifetime_remove(lwm2m_context_t * contextP,
+                     lwm2m_client_t * clientP)
+{
+    size_t index = clientP->lifetimeIndex;
+
+    if (clientP->internalID < contextP->clientTableSize
+     && contextP->clientTable[clientP->internalID] == clientP)
+    {
+        contextP->clientTable[clientP->internalID] = NULL;
+        if (clientP->internalID < contextP->clientFreeID) contextP->clientFreeID = clientP->internalID;
+        prv_unhash_name(contextP, clientP);
+    }
+    if (index >= contextP->lifetimeCount || contextP->lifetimeHeap[index] != clientP) return;
+
+    contextP->lifetimeCount--;
+    if (index != contextP->lifetimeCount)
+    {
+        prv_set(contextP, index, contextP->lifetimeHeap[contextP->lifetimeCount]);
+        lifetime_update(contextP, contextP->lifetimeHeap[index]);
+    }
+}
+
+// returns NULL if no client is registered with this ID
+lwm2m_client_t * lifetime_get_client(lwm2m_context_t * contextP,
+                                     uint16_t clientID)
+{
+    if (clientID >= contextP->clientTableSize) return NULL;
+    return contextP->clientTable[clientID];
+}
+
+// returns NULL if no client is registered with this name
+lwm2m_client_t * lifetime_find_client(lwm2m_context_t * contextP,
+                                      const char * name)
+{
+    lwm2m_client_t * clientP;
+    uint32_t hash;
+
+    if (contextP->clientNameTableSize == 0) return NULL;
+
+    hash = utils_hash((uint8_t *)name, strlen(name));
+    clientP = contextP->clientNameTable[hash % contextP->clientNameTableSize];
+    while (clientP != NULL
+        && (clientP->nameHash != hash || strcmp(clientP->name, name) != 0))
+    {
+        clientP = clientP->nameNext;
+    }
+
+    return clientP;
+}
+
+// inserts a client added by lifetime_add() in clientList
+void lifetime_link(lwm2m_context_t * contextP,
+                   lwm2m_client_t * clientP)
+{
+    lwm2m_client_t * previousP = prv_previous(contextP, clientP->internalID);
+
+    if (previousP == NULL)
+    {
+        clientP->next = contextP->clientList;
+        contextP->clientList = clientP;
+    }
+    else
+    {
+        clientP->next = previousP->next;
+        previousP->next = clientP;
+    }
+}
+
+void lifetime_unlink(lwm2m_context_t * contextP,
+                     lwm2m_client_t * clientP)
+{
+    lwm2m_client_t * previousP = prv_previous(contextP, clientP->internalID);
+
+    if (previousP == NULL)
+    {
+        if (contextP->clientList == clientP) contextP->clientList = clientP->next;
+    }
+    else if (previousP->next == clientP)
+    {
+        previousP->next = clientP->next;
+    }
+}
+
+// deregister the clients whose lifetime expired
+void lifetime_step(lwm2m_context_t * contextP,
+                   time_t currentTime,
+                   time_t * timeoutP)
+{
+    while (contextP->lifetimeCount != 0)
+    {
+        lwm2m_client_t * clientP = contextP->lifetimeHeap[0];
+
+        if (clientP->endOfLife > currentTime)
+        {
+            time_t interval = clientP->endOfLife - currentTime;
+
+            if (*timeoutP > interval)
+            {
+                *timeoutP = interval;
+            }
+            break;
+        }
+
+        lifetime_remove(contextP, clientP);
+        lifetime_unlink(contextP, clientP);
+        registry_remove(contextP, clientP->internalID);
+        if (contextP->monitorCallback != NULL)
+        {
+            contextP->monitorCallback(clientP->internalID, NULL, DELETED_2_02, NULL, 0, contextP->monitorUserData);
+        }
+        transaction_remove_peer(contextP, clientP);
+        prv_freeClient(contextP, clientP);
+    }
+}
+
+void lifetime_free(lwm2m_context_t * contextP)
+{
+    lwm2m_free(contextP->lifetimeHeap);
+    contextP->lifetimeHeap = NULL;
+    contextP->lifetimeCount = 0;
+    contextP->lifetimeSize = 0;
+    lwm2m_free(contextP->clientTable);
+    contextP->clientTable = NULL;
+    contextP->clientTableSize = 0;
+    contextP->clientFreeID = 0;
+    lwm2m_free(contextP->clientNameTable);
+    contextP->clientNameTable = NULL;
+    contextP->clientNameTableSize = 0;
+}
+
+#endif
@@ -53,6 +53,17 @@
 
 
 #ifdef LWM2M_CLIENT_MODE
+static coap_status_t prv_write(lwm2m_context_t * contextP,
+                               lwm2m_uri_t * uriP,
+                               coap_packet_t * message)
+{
+    lwm2m_media_type_t format;
+
+    if (!utils_getContentFormat(message, uriP, &format)) return UNSUPPORTED_MEDIA_TYPE_4_15;
+
+    return object_write(contextP, uriP, format, message->payload, message->payload_len);
+}
+
 coap_status_t handle_dm_request(lwm2m_context_t * contextP,
                                 lwm2m_uri_t * uriP,
                                 void * fromSessionH,
@@ -111,16 +122,25 @@ coap_status_t handle_dm_request(lwm2m_context_t * contextP,
         {
             uint8_t * buffer = NULL;
             size_t length = 0;
+            lwm2m_media_type_t format;
+            lwm2m_media_type_t contentFormat;
 
-            result = object_read(contextP, uriP, &buffer, &length);
+            if (!utils_getAcceptFormat(message, uriP, &format))
+            {
+                result = COAP_406_NOT_ACCEPTABLE;
+                break;
+            }
+            contentFormat = format;
+            result = object_read(contextP, uriP, &contentFormat, &buffer, &length);
             if (COAP_205_CONTENT == result)
             {
                 if (IS_OPTION(message, COAP_OPTION_OBSERVE))
                 {
-                    result = handle_observe_request(contextP, uriP, serverP, message, response);
+                    result = handle_observe_request(contextP, uriP, serverP, format, message, response);
                 }
                 if (COAP_205_CONTENT == result)
                 {
+                    coap_set_header_content_type(response, contentFormat);
                     coap_set_payload(response, buffer, length);
                     // lwm2m_handle_packet will free buffer
                 }
@@ -168,7 +188,7 @@ coap_status_t handle_dm_request(lwm2m_context_t * contextP,
                 }
                 else
                 {
-                    result = object_write(contextP, uriP, message->payload, message->payload_len);
+                    result = prv_write(contextP, uriP, message);
                 }
             }
             else
@@ -194,7 +214,7 @@ coap_status_t handle_dm_request(lwm2m_context_t * contextP,
                 else
 #endif
                 {
-                    result = object_write(contextP, uriP, message->payload, message->payload_len);
+                    result = prv_write(contextP, uriP, message);
                 }
             }
             else
@@ -310,6 +330,8 @@ static void dm_result_callback(lwm2m_transaction_t * transacP,
             lwm2m_free(locationString);
         }
 
+        cache_result((lwm2m_client_t *)transacP->peerP, &dataP->uri, (coap_packet_t *)transacP->message, packet);
+
         dataP->callback(((lwm2m_client_t*)transacP->peerP)->internalID,
                         &dataP->uri,
                         packet->code,
@@ -333,7 +355,7 @@ static int prv_make_operation(lwm2m_context_t * contextP,
     lwm2m_transaction_t * transaction;
     dm_data_t * dataP;
 
-    clientP = (lwm2m_client_t *)lwm2m_list_find((lwm2m_list_t *)contextP->clientList, clientID);
+    clientP = lifetime_get_client(contextP, clientID);
     if (clientP == NULL) return COAP_404_NOT_FOUND;
 
     transaction = transaction_new(COAP_TYPE_CON, method, clientP->altPath, uriP, contextP->nextMID++, 4, NULL, ENDPOINT_CLIENT, (void *)clientP);
@@ -377,6 +399,30 @@ int lwm2m_dm_read(lwm2m_context_t * contextP,
                               callback, userData);
 }
 
+int lwm2m_dm_read_cached(lwm2m_context_t * contextP,
+                         uint16_t clientID,
+                         lwm2m_uri_t * uriP,
+                         uint32_t maxAge,
+                         lwm2m_result_callback_t callback,
+                         void * userData)
+{
+    lwm2m_client_t * clientP;
+    lwm2m_cache_entry_t * entryP;
+
+    clientP = lifetime_get_client(contextP, clientID);
+    if (clientP == NULL) return COAP_404_NOT_FOUND;
+
+    entryP = cache_get(clientP, uriP, maxAge);
+    if (entryP == NULL || callback == NULL)
+    {
+        return lwm2m_dm_read(contextP, clientID, uriP, callback, userData);
+    }
+
+    callback(clientID, uriP, COAP_205_CONTENT, entryP->payload, entryP->payloadLength, userData);
+
+    return COAP_NO_ERROR;
+}
+
 int lwm2m_dm_write(lwm2m_context_t * contextP,
                    uint16_t clientID,
                    lwm2m_uri_t * uriP,
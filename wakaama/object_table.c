@@ -0,0 +1,389 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - initial API and implementation
+ *
+ *******************************************************************************/
+
+/************************************************************************
+ *  Table driven objects.
+ *
+ *  The read, write and execute callbacks of an object registered with
+ *  lwm2m_object_set_resources() dispatch on its resource descriptors.
+ *  The descriptors are sorted by id: a full object read walks the table,
+ *  other requests find their resource by binary search.
+ *
+ *  Static resources are serialized once, when the table is registered, in
+ *  an image starting with one entry per descriptor and followed by their
+ *  TLV headers. The value bytes of numbers follow their header, the ones
+ *  of strings stay in the table. A read copies the header in the
+ *  lwm2m_tlv_t with LWM2M_TLV_FLAG_ENCODED set and points its value at the
+ *  table or in the image, the TLV serializer copies the header and the
+ *  other formats use the value bytes.
+ */
+
+#include "internals.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+typedef struct
+{
+    uint16_t offset;        // of the TLV header in the image, 0 if the resource is not static
+    uint16_t length;        // of the value
+    uint8_t  headerLength;
+} prv_image_entry_t;
+
+static bool prv_is_number(const lwm2m_resource_desc_t * descP)
+{
+    return descP->dataType == LWM2M_TYPE_INTEGER
+        || descP->dataType == LWM2M_TYPE_FLOAT
+        || descP->dataType == LWM2M_TYPE_BOOLEAN;
+}
+
+// worst case size of the image part of a static resource
+static size_t prv_record_size(const lwm2m_resource_desc_t * descP)
+{
+    return LWM2M_TLV_HEADER_MAX_LENGTH + (prv_is_number(descP) ? 8 : 0);
+}
+
+// the TLV record of a number, the header only for strings
+static int prv_write_record(const lwm2m_resource_desc_t * descP,
+                            uint8_t * buffer,
+                            size_t length)
+{
+    switch (descP->dataType)
+    {
+    case LWM2M_TYPE_INTEGER:
+        return lwm2m_intToTLV(LWM2M_TYPE_RESOURCE, (int64_t)descP->number, descP->id, buffer, length);
+    case LWM2M_TYPE_FLOAT:
+        return lwm2m_floatToTLV(LWM2M_TYPE_RESOURCE, descP->number, descP->id, buffer, length);
+    case LWM2M_TYPE_BOOLEAN:
+        return lwm2m_boolToTLV(LWM2M_TYPE_RESOURCE, descP->number != 0, descP->id, buffer, length);
+    default:
+        if (length < LWM2M_TLV_HEADER_MAX_LENGTH) return 0;
+        return tlv_create_header(buffer, LWM2M_TYPE_RESOURCE, descP->id, descP->length);
+    }
+}
+
+// return NULL if the object has no static resource or in case of error
+static uint8_t * prv_build_image(const lwm2m_resource_desc_t * resourceArray,
+                                 size_t resourceCount)
+{
+    prv_image_entry_t * entryP;
+    uint8_t * imageP;
+    size_t length;
+    size_t index;
+    size_t i;
+
+    length = 0;
+    for (i = 0 ; i < resourceCount ; i++)
+    {
+        if ((resourceArray[i].operations & LWM2M_RES_STATIC) != 0)
+        {
+            if (resourceArray[i].length > 0xFFFF) return NULL;
+            length += prv_record_size(resourceArray + i);
+        }
+    }
+    if (length == 0) return NULL;
+
+    index = resourceCount * sizeof(prv_image_entry_t);
+    length += index;
+    if (length > 0xFFFF) return NULL;
+
+    imageP = (uint8_t *)lwm2m_malloc(length);
+    if (imageP == NULL) return NULL;
+
+    entryP = (prv_image_entry_t *)imageP;
+    for (i = 0 ; i < resourceCount ; i++)
+    {
+        lwm2m_tlv_type_t type;
+        uint16_t id;
+        size_t dataIndex;
+        size_t dataLen;
+        int result;
+
+        entryP[i].offset = 0;
+        if ((resourceArray[i].operations & LWM2M_RES_STATIC) == 0) continue;
+
+        result = prv_write_record(resourceArray + i, imageP + index, length - index);
+        if (result > 0 && !prv_is_number(resourceArray + i))
+        {
+            dataIndex = result;
+            dataLen = resourceArray[i].length;
+        }
+        else if (result <= 0
+              || 0 == lwm2m_decodeTLV(imageP + index, result, &type, &id, &dataIndex, &dataLen))
+        {
+            lwm2m_free(imageP);
+            return NULL;
+        }
+        entryP[i].offset = index;
+        entryP[i].length = dataLen;
+        entryP[i].headerLength = dataIndex;
+        index += result;
+    }
+
+    return imageP;
+}
+
+static const lwm2m_resource_desc_t * prv_find(lwm2m_object_t * objectP,
+                                              uint16_t id)
+{
+    size_t low;
+    size_t high;
+
+    low = 0;
+    high = objectP->resourceCount;
+    while (low < high)
+    {
+        size_t middle = (low + high) / 2;
+
+        if (objectP->resourceArray[middle].id < id)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    if (low < objectP->resourceCount
+     && objectP->resourceArray[low].id == id)
+    {
+        return objectP->resourceArray + low;
+    }
+    return NULL;
+}
+
+static uint8_t prv_read_resource(const lwm2m_resource_desc_t * descP,
+                                 uint16_t instanceId,
+                                 lwm2m_tlv_t * tlvP,
+                                 lwm2m_object_t * objectP)
+{
+    uint8_t result;
+
+    if ((descP->operations & LWM2M_RES_READ) == 0) return COAP_405_METHOD_NOT_ALLOWED;
+
+    if ((descP->operations & LWM2M_RES_STATIC) != 0)
+    {
+        bool isText;
+
+        isText = descP->dataType == LWM2M_TYPE_STRING || descP->dataType == LWM2M_TYPE_OPAQUE;
+        if (objectP->resourceImage != NULL
+         && (isText || (tlvP->flags & LWM2M_TLV_FLAG_TEXT_FORMAT) == 0))
+        {
+            prv_image_entry_t * entryP;
+
+            entryP = (prv_image_entry_t *)objectP->resourceImage + (descP - objectP->resourceArray);
+            if (prv_is_number(descP))
+            {
+                tlvP->value = objectP->resourceImage + entryP->offset + entryP->headerLength;
+            }
+            else
+            {
+                tlvP->value = (uint8_t *)descP->value;
+            }
+            tlvP->length = entryP->length;
+            tlvP->data[0] = entryP->headerLength;
+            memcpy(tlvP->data + 1, objectP->resourceImage + entryP->offset, entryP->headerLength);
+            tlvP->flags = (tlvP->flags & LWM2M_TLV_FLAG_TEXT_FORMAT) | LWM2M_TLV_FLAG_STATIC_DATA | LWM2M_TLV_FLAG_ENCODED;
+            tlvP->dataType = descP->dataType;
+            tlvP->type = LWM2M_TYPE_RESOURCE;
+            return COAP_205_CONTENT;
+        }
+
+        switch (descP->dataType)
+        {
+        case LWM2M_TYPE_INTEGER:
+            lwm2m_tlv_encode_int((int64_t)descP->number, tlvP);
+            break;
+        case LWM2M_TYPE_FLOAT:
+            lwm2m_tlv_encode_float(descP->number, tlvP);
+            break;
+        case LWM2M_TYPE_BOOLEAN:
+            lwm2m_tlv_encode_bool(descP->number != 0, tlvP);
+            break;
+        default:
+            tlvP->value = (uint8_t *)descP->value;
+            tlvP->length = descP->length;
+            tlvP->flags = (tlvP->flags & LWM2M_TLV_FLAG_TEXT_FORMAT) | LWM2M_TLV_FLAG_STATIC_DATA;
+            tlvP->dataType = descP->dataType;
+            break;
+        }
+        tlvP->type = LWM2M_TYPE_RESOURCE;
+        return COAP_205_CONTENT;
+    }
+
+    if (descP->readFunc == NULL) return COAP_405_METHOD_NOT_ALLOWED;
+
+    result = descP->readFunc(instanceId, tlvP, objectP);
+    if (result == COAP_205_CONTENT
+     && (descP->operations & LWM2M_RES_MULTIPLE) == 0)
+    {
+        tlvP->type = LWM2M_TYPE_RESOURCE;
+    }
+    return result;
+}
+
+static uint8_t prv_table_read(uint16_t instanceId,
+                              int * numDataP,
+                              lwm2m_tlv_t ** dataArrayP,
+                              lwm2m_object_t * objectP)
+{
+    uint8_t result;
+    size_t i;
+    int nbRes;
+
+    if (NULL == lwm2m_list_find(objectP->instanceList, instanceId)) return COAP_404_NOT_FOUND;
+
+    if (*numDataP == 0)
+    {
+        const lwm2m_resource_desc_t * descP;
+
+        nbRes = 0;
+        for (i = 0 ; i < objectP->resourceCount ; i++)
+        {
+            if ((objectP->resourceArray[i].operations & LWM2M_RES_READ) != 0) nbRes++;
+        }
+        if (nbRes == 0) return COAP_205_CONTENT;
+
+        *dataArrayP = lwm2m_tlv_new(nbRes);
+        if (*dataArrayP == NULL) return COAP_500_INTERNAL_SERVER_ERROR;
+        *numDataP = nbRes;
+
+        result = COAP_205_CONTENT;
+        nbRes = 0;
+        for (descP = objectP->resourceArray ; descP < objectP->resourceArray + objectP->resourceCount && result == COAP_205_CONTENT ; descP++)
+        {
+            if ((descP->operations & LWM2M_RES_READ) == 0) continue;
+
+            (*dataArrayP)[nbRes].id = descP->id;
+            result = prv_read_resource(descP, instanceId, (*dataArrayP) + nbRes, objectP);
+            nbRes++;
+        }
+        return result;
+    }
+
+    result = COAP_205_CONTENT;
+    for (nbRes = 0 ; nbRes < *numDataP && result == COAP_205_CONTENT ; nbRes++)
+    {
+        lwm2m_tlv_t * tlvP = (*dataArrayP) + nbRes;
+        const lwm2m_resource_desc_t * descP;
+
+        descP = prv_find(objectP, tlvP->id);
+        if (descP == NULL)
+        {
+            result = COAP_404_NOT_FOUND;
+        }
+        else
+        {
+            result = prv_read_resource(descP, instanceId, tlvP, objectP);
+        }
+    }
+    return result;
+}
+
+static uint8_t prv_table_write(uint16_t instanceId,
+                               int numData,
+                               lwm2m_tlv_t * dataArray,
+                               lwm2m_object_t * objectP)
+{
+    uint8_t result;
+    int i;
+
+    if (NULL == lwm2m_list_find(objectP->instanceList, instanceId)) return COAP_404_NOT_FOUND;
+
+    result = COAP_204_CHANGED;
+    for (i = 0 ; i < numData && result == COAP_204_CHANGED ; i++)
+    {
+        const lwm2m_resource_desc_t * descP;
+
+        descP = prv_find(objectP, dataArray[i].id);
+        if (descP == NULL)
+        {
+            result = COAP_404_NOT_FOUND;
+        }
+        else if ((descP->operations & LWM2M_RES_WRITE) == 0
+              || descP->writeFunc == NULL)
+        {
+            result = COAP_405_METHOD_NOT_ALLOWED;
+        }
+        else
+        {
+            result = descP->writeFunc(instanceId, dataArray + i, objectP);
+        }
+    }
+    return result;
+}
+
+static uint8_t prv_table_execute(uint16_t instanceId,
+                                 uint16_t resourceId,
+                                 uint8_t * buffer,
+                                 int length,
+                                 lwm2m_object_t * objectP)
+{
+    const lwm2m_resource_desc_t * descP;
+
+    if (NULL == lwm2m_list_find(objectP->instanceList, instanceId)) return COAP_404_NOT_FOUND;
+
+    descP = prv_find(objectP, resourceId);
+    if (descP == NULL) return COAP_404_NOT_FOUND;
+    if ((descP->operations & LWM2M_RES_EXECUTE) == 0
+     || descP->executeFunc == NULL)
+    {
+        return COAP_405_METHOD_NOT_ALLOWED;
+    }
+
+    return descP->executeFunc(instanceId, resourceId, buffer, length, objectP);
+}
+
+bool lwm2m_object_set_resources(lwm2m_object_t * objectP,
+                                const lwm2m_resource_desc_t * resourceArray,
+                                size_t resourceCount)
+{
+    uint8_t operations;
+    size_t i;
+
+    operations = 0;
+    for (i = 0 ; i < resourceCount ; i++)
+    {
+        if (i > 0 && resourceArray[i - 1].id >= resourceArray[i].id)
+        {
+            LOG("Object %u: resource %u is out of order\r\n", objectP->objID, resourceArray[i].id);
+            return false;
+        }
+        operations |= resourceArray[i].operations;
+    }
+
+    object_table_free(objectP);
+    objectP->resourceArray = resourceArray;
+    objectP->resourceCount = resourceCount;
+    // without image, static values are encoded on each read
+    objectP->resourceImage = prv_build_image(resourceArray, resourceCount);
+    objectP->readFunc = (operations & LWM2M_RES_READ) ? prv_table_read : NULL;
+    objectP->writeFunc = (operations & LWM2M_RES_WRITE) ? prv_table_write : NULL;
+    objectP->executeFunc = (operations & LWM2M_RES_EXECUTE) ? prv_table_execute : NULL;
+
+    return true;
+}
+
+void object_table_free(lwm2m_object_t * objectP)
+{
+    if (objectP->resourceImage != NULL)
+    {
+        lwm2m_free(objectP->resourceImage);
+        objectP->resourceImage = NULL;
+    }
+}
@@ -84,8 +84,29 @@ static lwm2m_object_t * prv_find_object(lwm2m_context_t * contextP,
     return NULL;
 }
 
+static int prv_serialize(lwm2m_uri_t * uriP,
+                         lwm2m_media_type_t * formatP,
+                         int size,
+                         lwm2m_tlv_t * tlvP,
+                         uint8_t ** bufferP)
+{
+    if (*formatP == LWM2M_CONTENT_SENML_CBOR)
+    {
+        return senml_cbor_serialize(uriP, size, tlvP, bufferP);
+    }
+    if (*formatP == LWM2M_CONTENT_JSON)
+    {
+        return json_serialize(uriP, size, tlvP, bufferP);
+    }
+    *formatP = LWM2M_CONTENT_TLV;
+    return lwm2m_tlv_serialize(size, tlvP, bufferP);
+}
+
+// *formatP is the requested format, set to the format of the payload: the
+// formats without a serializer fall back to TLV and opaque values are sent raw
 coap_status_t object_read(lwm2m_context_t * contextP,
                           lwm2m_uri_t * uriP,
+                          lwm2m_media_type_t * formatP,
                           uint8_t ** bufferP,
                           size_t * lengthP)
 {
@@ -147,7 +168,7 @@ coap_status_t object_read(lwm2m_context_t * contextP,
 
             if (result == COAP_205_CONTENT)
             {
-                *lengthP = lwm2m_tlv_serialize(size, tlvP, bufferP);
+                *lengthP = prv_serialize(uriP, formatP, size, tlvP, bufferP);
                 if (*lengthP == 0) result = COAP_500_INTERNAL_SERVER_ERROR;
             }
             lwm2m_tlv_free(size, tlvP);
@@ -164,30 +185,47 @@ coap_status_t object_read(lwm2m_context_t * contextP,
         if (tlvP == NULL) return COAP_500_INTERNAL_SERVER_ERROR;
 
         tlvP->type = LWM2M_TYPE_RESOURCE;
-        tlvP->flags = LWM2M_TLV_FLAG_TEXT_FORMAT;
+        if (*formatP == LWM2M_CONTENT_TEXT)
+        {
+            tlvP->flags = LWM2M_TLV_FLAG_TEXT_FORMAT;
+        }
         tlvP->id = uriP->resourceId;
     }
     result = targetP->readFunc(uriP->instanceId, &size, &tlvP, targetP);
     if (result == COAP_205_CONTENT)
     {
-        if (size == 1
+        if (*formatP == LWM2M_CONTENT_TEXT
+         && size == 1
          && tlvP->type == LWM2M_TYPE_RESOURCE
-         && (tlvP->flags && LWM2M_TLV_FLAG_TEXT_FORMAT) != 0 )
+         && (tlvP->flags & LWM2M_TLV_FLAG_TEXT_FORMAT) != 0 )
         {
-            *bufferP = (uint8_t *)malloc(tlvP->length);
+            if ((tlvP->flags & LWM2M_TLV_FLAG_STATIC_DATA) == 0)
+            {
+                // the text was allocated by the lwm2m_tlv_encode_*() call, hand it over
+                *bufferP = tlvP->value;
+                tlvP->value = NULL;
+            }
+            else
+            {
+                *bufferP = (uint8_t *)lwm2m_malloc(tlvP->length);
+                if (*bufferP != NULL)
+                {
+                    memcpy(*bufferP, tlvP->value, tlvP->length);
+                }
+            }
             if (*bufferP == NULL)
             {
                 result = COAP_500_INTERNAL_SERVER_ERROR;
             }
             else
             {
-                memcpy(*bufferP, tlvP->value, tlvP->length);
                 *lengthP = tlvP->length;
+                if (tlvP->dataType == LWM2M_TYPE_OPAQUE) *formatP = LWM2M_CONTENT_OPAQUE;
             }
         }
         else
         {
-            *lengthP = lwm2m_tlv_serialize(size, tlvP, bufferP);
+            *lengthP = prv_serialize(uriP, formatP, size, tlvP, bufferP);
             if (*lengthP == 0) result = COAP_500_INTERNAL_SERVER_ERROR;
         }
     }
@@ -198,6 +236,7 @@ coap_status_t object_read(lwm2m_context_t * contextP,
 
 coap_status_t object_write(lwm2m_context_t * contextP,
                            lwm2m_uri_t * uriP,
+                           lwm2m_media_type_t format,
                            uint8_t * buffer,
                            size_t length)
 {
@@ -217,7 +256,23 @@ coap_status_t object_write(lwm2m_context_t * contextP,
     }
     else
     {
-        if (LWM2M_URI_IS_SET_RESOURCE(uriP))
+        if (format == LWM2M_CONTENT_SENML_CBOR)
+        {
+            size = senml_cbor_parse_tlv(uriP, buffer, length, &tlvP);
+            if (size == 0)
+            {
+                result = COAP_400_BAD_REQUEST;
+            }
+        }
+        else if (format == LWM2M_CONTENT_JSON)
+        {
+            size = json_parse_tlv(uriP, buffer, length, &tlvP);
+            if (size == 0)
+            {
+                result = COAP_400_BAD_REQUEST;
+            }
+        }
+        else if (format == LWM2M_CONTENT_TEXT)
         {
             size = 1;
             tlvP = lwm2m_tlv_new(size);
@@ -623,4 +678,66 @@ int object_getServers(lwm2m_context_t * contextP)
     return 0;
 }
 
+#ifdef LWM2M_BOOTSTRAP
+// check the configuration written by a bootstrap server: there must be at least one
+// LWM2M server and each one needs a Server Object instance with its Short Server ID
+bool object_isBootstrapConsistent(lwm2m_context_t * contextP)
+{
+    lwm2m_object_t * securityObjP = NULL;
+    lwm2m_object_t * serverObjP = NULL;
+    lwm2m_list_t * securityInstP;
+    int serverCount;
+    int i;
+
+    for (i = 0 ; i < contextP->numObject ; i++)
+    {
+        if (contextP->objectList[i]->objID == LWM2M_SECURITY_OBJECT_ID)
+        {
+            securityObjP = contextP->objectList[i];
+        }
+        else if (contextP->objectList[i]->objID == LWM2M_SERVER_OBJECT_ID)
+        {
+            serverObjP = contextP->objectList[i];
+        }
+    }
+    if (NULL == securityObjP || NULL == serverObjP) return false;
+
+    serverCount = 0;
+    for (securityInstP = securityObjP->instanceList ; securityInstP != NULL ; securityInstP = securityInstP->next)
+    {
+        lwm2m_tlv_t * tlvP;
+        int size;
+        bool isBootstrap;
+        int64_t value;
+
+        size = 2;
+        tlvP = lwm2m_tlv_new(size);
+        if (tlvP == NULL) return false;
+        tlvP[0].id = LWM2M_SECURITY_BOOTSTRAP_ID;
+        tlvP[1].id = LWM2M_SECURITY_SHORT_SERVER_ID;
+
+        if (securityObjP->readFunc(securityInstP->id, &size, &tlvP, securityObjP) != COAP_205_CONTENT
+         || 0 == lwm2m_tlv_decode_bool(tlvP + 0, &isBootstrap)
+         || 0 == lwm2m_tlv_decode_int(tlvP + 1, &value))
+        {
+            lwm2m_tlv_free(size, tlvP);
+            return false;
+        }
+        lwm2m_tlv_free(size, tlvP);
+
+        if (isBootstrap) continue;
+
+        if (value < 1 || value > 0xFFFF
+         || NULL == prv_findServerInstance(serverObjP, value))
+        {
+            LOG("[BOOTSTRAP] No server instance for Short Server ID %d\r\n", (int)value);
+            return false;
+        }
+        serverCount++;
+    }
+
+    return serverCount != 0;
+}
+#endif
+
 #endif
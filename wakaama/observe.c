@@ -52,6 +52,15 @@
 
 
 #ifdef LWM2M_CLIENT_MODE
+struct _lwm2m_uri_handle_
+{
+    struct _lwm2m_uri_handle_ * next;
+    lwm2m_uri_t         uri;
+    uint32_t            version;        // of contextP->observedList when observedArray was built
+    uint16_t            observedCount;
+    lwm2m_observed_t ** observedArray;
+};
+
 static lwm2m_observed_t * prv_findObserved(lwm2m_context_t * contextP,
                                            lwm2m_uri_t * uriP)
 {
@@ -70,6 +79,26 @@ static lwm2m_observed_t * prv_findObserved(lwm2m_context_t * contextP,
     return targetP;
 }
 
+// true if a change of uriP concerns the observation of targetP
+static bool prv_isObservedBy(lwm2m_observed_t * targetP,
+                             lwm2m_uri_t * uriP)
+{
+    if (targetP->uri.objectId != uriP->objectId) return false;
+    if (LWM2M_URI_IS_SET_INSTANCE(uriP)
+     && (targetP->uri.flag & LWM2M_URI_FLAG_INSTANCE_ID) != 0
+     && uriP->instanceId != targetP->uri.instanceId)
+    {
+        return false;
+    }
+    if (LWM2M_URI_IS_SET_RESOURCE(uriP)
+     && (targetP->uri.flag & LWM2M_URI_FLAG_RESOURCE_ID) != 0
+     && uriP->resourceId != targetP->uri.resourceId)
+    {
+        return false;
+    }
+    return true;
+}
+
 static obs_list_t * prv_getObservedList(lwm2m_context_t * contextP,
                                         lwm2m_uri_t * uriP)
 {
@@ -81,26 +110,16 @@ static obs_list_t * prv_getObservedList(lwm2m_context_t * contextP,
     targetP = contextP->observedList;
     while (targetP != NULL)
     {
-        if (targetP->uri.objectId == uriP->objectId)
+        if (prv_isObservedBy(targetP, uriP))
         {
-            if (!LWM2M_URI_IS_SET_INSTANCE(uriP)
-             || (targetP->uri.flag & LWM2M_URI_FLAG_INSTANCE_ID) == 0
-             || uriP->instanceId == targetP->uri.instanceId)
+            obs_list_t * newP;
+
+            newP = (obs_list_t *)lwm2m_malloc(sizeof(obs_list_t));
+            if (newP != NULL)
             {
-                if (!LWM2M_URI_IS_SET_RESOURCE(uriP)
-                 || (targetP->uri.flag & LWM2M_URI_FLAG_RESOURCE_ID) == 0
-                 || uriP->resourceId == targetP->uri.resourceId)
-                {
-                    obs_list_t * newP;
-
-                    newP = (obs_list_t *)lwm2m_malloc(sizeof(obs_list_t));
-                    if (newP != NULL)
-                    {
-                        newP->item = targetP;
-                        newP->next = resultP;
-                        resultP = newP;
-                    }
-                }
+                newP->item = targetP;
+                newP->next = resultP;
+                resultP = newP;
             }
         }
         targetP = targetP->next;
@@ -151,6 +170,7 @@ static lwm2m_watcher_t * prv_findWatcher(lwm2m_observed_t * observedP,
 coap_status_t handle_observe_request(lwm2m_context_t * contextP,
                                      lwm2m_uri_t * uriP,
                                      lwm2m_server_t * serverP,
+                                     lwm2m_media_type_t format,
                                      coap_packet_t * message,
                                      coap_packet_t * response)
 {
@@ -171,6 +191,7 @@ coap_status_t handle_observe_request(lwm2m_context_t * contextP,
         memcpy(&(observedP->uri), uriP, sizeof(lwm2m_uri_t));
         observedP->next = contextP->observedList;
         contextP->observedList = observedP;
+        contextP->observedVersion++;
     }
 
     watcherP = prv_findWatcher(observedP, serverP);
@@ -186,6 +207,8 @@ coap_status_t handle_observe_request(lwm2m_context_t * contextP,
 
     watcherP->tokenLen = message->token_len;
     memcpy(watcherP->token, message->token, message->token_len);
+    watcherP->format = format;
+    contextP->persistDirty = true;
 
     coap_set_header_observe(response, watcherP->counter++);
 
@@ -232,53 +255,161 @@ void cancel_observe(lwm2m_context_t * contextP,
         if (targetP != NULL)
         {
             lwm2m_free(targetP);
+            contextP->persistDirty = true;
             if (observedP->watcherList == NULL)
             {
                 prv_unlinkObserved(contextP, observedP);
                 lwm2m_free(observedP);
+                contextP->observedVersion++;
             }
             return;
         }
     }
 }
 
+static void prv_notify(lwm2m_context_t * contextP,
+                       lwm2m_observed_t * observedP)
+{
+    int result;
+    lwm2m_watcher_t * watcherP;
+    uint8_t * buffer = NULL;
+    size_t length = 0;
+    lwm2m_media_type_t format = LWM2M_CONTENT_TLV;
+    lwm2m_media_type_t contentFormat = LWM2M_CONTENT_TLV;
+
+    for (watcherP = observedP->watcherList ; watcherP != NULL ; watcherP = watcherP->next)
+    {
+        coap_packet_t message[1];
+
+        // watchers usually share the format, the value is read once for each one
+        if (buffer == NULL || watcherP->format != format)
+        {
+            lwm2m_free(buffer);
+            buffer = NULL;
+            format = watcherP->format;
+            contentFormat = format;
+            result = object_read(contextP, &observedP->uri, &contentFormat, &buffer, &length);
+            if (result != COAP_205_CONTENT)
+            {
+                buffer = NULL;
+                continue;
+            }
+        }
+
+        coap_init_message(message, COAP_TYPE_NON, COAP_205_CONTENT, 0);
+        coap_set_header_content_type(message, contentFormat);
+        coap_set_payload(message, buffer, length);
+        watcherP->lastMid = contextP->nextMID++;
+        message->mid = watcherP->lastMid;
+        coap_set_header_token(message, watcherP->token, watcherP->tokenLen);
+        coap_set_header_observe(message, watcherP->counter++);
+        if (contextP->persistNotifyCount < 0xFFFF) contextP->persistNotifyCount++;
+        (void)message_send(contextP, message, watcherP->server->sessionH);
+    }
+    lwm2m_free(buffer);
+}
+
 void lwm2m_resource_value_changed(lwm2m_context_t * contextP,
                                   lwm2m_uri_t * uriP)
 {
-    int result;
     obs_list_t * listP;
-    lwm2m_watcher_t * watcherP;
 
     listP = prv_getObservedList(contextP, uriP);
     while (listP != NULL)
     {
         obs_list_t * targetP;
-        uint8_t * buffer = NULL;
-        size_t length = 0;
 
-        result = object_read(contextP, &listP->item->uri, &buffer, &length);
-        if (result == COAP_205_CONTENT)
-        {
-            coap_packet_t message[1];
+        prv_notify(contextP, listP->item);
 
-            coap_init_message(message, COAP_TYPE_NON, COAP_205_CONTENT, 0);
-            coap_set_payload(message, buffer, length);
+        targetP = listP;
+        listP = listP->next;
+        lwm2m_free(targetP);
+    }
+
+}
+
+// collect the observations concerned by the handle, return false in case of error
+static bool prv_resolveHandle(lwm2m_context_t * contextP,
+                              lwm2m_uri_handle_t * handleP)
+{
+    lwm2m_observed_t * targetP;
+    uint16_t count;
+
+    count = 0;
+    for (targetP = contextP->observedList ; targetP != NULL ; targetP = targetP->next)
+    {
+        if (prv_isObservedBy(targetP, &handleP->uri)) count++;
+    }
 
-            for (watcherP = listP->item->watcherList ; watcherP != NULL ; watcherP = watcherP->next)
+    lwm2m_free(handleP->observedArray);
+    handleP->observedArray = NULL;
+    handleP->observedCount = 0;
+    if (count != 0)
+    {
+        handleP->observedArray = (lwm2m_observed_t **)lwm2m_malloc(count * sizeof(lwm2m_observed_t *));
+        if (handleP->observedArray == NULL) return false;
+
+        for (targetP = contextP->observedList ; targetP != NULL ; targetP = targetP->next)
+        {
+            if (prv_isObservedBy(targetP, &handleP->uri))
             {
-                watcherP->lastMid = contextP->nextMID++;
-                message->mid = watcherP->lastMid;
-                coap_set_header_token(message, watcherP->token, watcherP->tokenLen);
-                coap_set_header_observe(message, watcherP->counter++);
-                (void)message_send(contextP, message, watcherP->server->sessionH);
+                handleP->observedArray[handleP->observedCount++] = targetP;
             }
         }
+    }
+    handleP->version = contextP->observedVersion;
 
-        targetP = listP;
-        listP = listP->next;
-        lwm2m_free(targetP);
+    return true;
+}
+
+lwm2m_uri_handle_t * lwm2m_uri_handle_new(lwm2m_context_t * contextP,
+                                          lwm2m_uri_t * uriP)
+{
+    lwm2m_uri_handle_t * handleP;
+
+    handleP = (lwm2m_uri_handle_t *)lwm2m_malloc(sizeof(lwm2m_uri_handle_t));
+    if (handleP == NULL) return NULL;
+
+    memset(handleP, 0, sizeof(lwm2m_uri_handle_t));
+    memcpy(&handleP->uri, uriP, sizeof(lwm2m_uri_t));
+    // resolved on first use
+    handleP->version = contextP->observedVersion - 1;
+    handleP->next = contextP->uriHandleList;
+    contextP->uriHandleList = handleP;
+
+    return handleP;
+}
+
+void lwm2m_handle_value_changed(lwm2m_context_t * contextP,
+                                lwm2m_uri_handle_t * handleP)
+{
+    uint16_t i;
+
+    if (handleP->version != contextP->observedVersion
+     && !prv_resolveHandle(contextP, handleP))
+    {
+        // out of memory, search the observations this time
+        lwm2m_resource_value_changed(contextP, &handleP->uri);
+        return;
     }
 
+    for (i = 0 ; i < handleP->observedCount ; i++)
+    {
+        prv_notify(contextP, handleP->observedArray[i]);
+    }
+}
+
+void delete_uri_handle_list(lwm2m_context_t * contextP)
+{
+    while (NULL != contextP->uriHandleList)
+    {
+        lwm2m_uri_handle_t * handleP;
+
+        handleP = contextP->uriHandleList;
+        contextP->uriHandleList = handleP->next;
+        lwm2m_free(handleP->observedArray);
+        lwm2m_free(handleP);
+    }
 }
 #endif
 
@@ -305,20 +436,121 @@ static lwm2m_observation_t * prv_findObservationByURI(lwm2m_client_t * clientP,
     return targetP;
 }
 
-void observation_remove(lwm2m_client_t * clientP,
+/*
+ * The observations are indexed by slots of a context wide table. The token of
+ * an observation is its slot number followed by the generation of the slot,
+ * incremented each time the slot is released, so that a notification is
+ * matched to its observation in constant time and the tokens of cancelled
+ * observations are rejected even when their slot is reused.
+ */
+
+// returns the slot number, or LWM2M_OBSERVATION_NO_SLOT if the table is full
+static uint16_t prv_allocSlot(lwm2m_context_t * contextP,
+                              lwm2m_observation_t * observationP)
+{
+    uint16_t slot;
+
+    if (contextP->observationFreeSlot >= contextP->observationSlotCount)
+    {
+        lwm2m_observation_slot_t * slotsP;
+        uint32_t count;
+        uint16_t i;
+
+        count = (contextP->observationSlotCount == 0) ? LWM2M_OBSERVATION_MIN_SLOTS : 2 * (uint32_t)contextP->observationSlotCount;
+        if (count > LWM2M_OBSERVATION_NO_SLOT) count = LWM2M_OBSERVATION_NO_SLOT;
+        if (count == contextP->observationSlotCount) return LWM2M_OBSERVATION_NO_SLOT;
+
+        slotsP = (lwm2m_observation_slot_t *)lwm2m_malloc(count * sizeof(lwm2m_observation_slot_t));
+        if (slotsP == NULL) return LWM2M_OBSERVATION_NO_SLOT;
+        if (contextP->observationSlotCount != 0)
+        {
+            memcpy(slotsP, contextP->observationSlots, contextP->observationSlotCount * sizeof(lwm2m_observation_slot_t));
+        }
+        for (i = contextP->observationSlotCount ; i < count ; i++)
+        {
+            slotsP[i].observationP = NULL;
+            slotsP[i].generation = 0;
+            slotsP[i].nextFree = (i + 1 < count) ? i + 1 : LWM2M_OBSERVATION_NO_SLOT;
+        }
+        lwm2m_free(contextP->observationSlots);
+        contextP->observationSlots = slotsP;
+        contextP->observationFreeSlot = contextP->observationSlotCount;
+        contextP->observationSlotCount = count;
+    }
+
+    slot = contextP->observationFreeSlot;
+    contextP->observationFreeSlot = contextP->observationSlots[slot].nextFree;
+    contextP->observationSlots[slot].observationP = observationP;
+
+    return slot;
+}
+
+static void prv_releaseSlot(lwm2m_context_t * contextP,
+                            uint16_t slot)
+{
+    contextP->observationSlots[slot].observationP = NULL;
+    contextP->observationSlots[slot].generation++;
+    contextP->observationSlots[slot].nextFree = contextP->observationFreeSlot;
+    contextP->observationFreeSlot = slot;
+}
+
+static lwm2m_observation_t * prv_getObservationByToken(lwm2m_context_t * contextP,
+                                                       const uint8_t * token,
+                                                       size_t token_len)
+{
+    uint16_t slot;
+    uint16_t generation;
+
+    if (token_len != 4) return NULL;
+
+    slot = (token[0] << 8) | token[1];
+    generation = (token[2] << 8) | token[3];
+
+    if (slot >= contextP->observationSlotCount) return NULL;
+    if (contextP->observationSlots[slot].generation != generation) return NULL;
+
+    return contextP->observationSlots[slot].observationP;
+}
+
+void observation_remove(lwm2m_context_t * contextP,
+                        lwm2m_client_t * clientP,
                         lwm2m_observation_t * observationP)
 {
     clientP->observationList = (lwm2m_observation_t *) LWM2M_LIST_RM(clientP->observationList, observationP->id, NULL);
+    prv_releaseSlot(contextP, observationP->id);
     lwm2m_free(observationP);
 }
 
+// frees the observations whose request is still pending and the slot table
+void observation_free_all(lwm2m_context_t * contextP)
+{
+    uint16_t slot;
+
+    for (slot = 0 ; slot < contextP->observationSlotCount ; slot++)
+    {
+        if (contextP->observationSlots[slot].observationP != NULL)
+        {
+            lwm2m_free(contextP->observationSlots[slot].observationP);
+        }
+    }
+    lwm2m_free(contextP->observationSlots);
+    contextP->observationSlots = NULL;
+    contextP->observationSlotCount = 0;
+    contextP->observationFreeSlot = LWM2M_OBSERVATION_NO_SLOT;
+}
+
 static void prv_obsRequestCallback(lwm2m_transaction_t * transacP,
                                    void * message)
 {
-    lwm2m_observation_t * observationP = (lwm2m_observation_t *)transacP->userData;
+    lwm2m_context_t * contextP = (lwm2m_context_t *)transacP->userData;
+    coap_packet_t * request = (coap_packet_t *)transacP->message;
     coap_packet_t * packet = (coap_packet_t *)message;
+    lwm2m_observation_t * observationP;
     uint8_t code;
 
+    observationP = prv_getObservationByToken(contextP, request->token, request->token_len);
+    if (observationP == NULL) return;
+
     if (message == NULL)
     {
         code = COAP_503_SERVICE_UNAVAILABLE;
@@ -340,10 +572,12 @@ static void prv_obsRequestCallback(lwm2m_transaction_t * transacP,
                                code,
                                NULL, 0,
                                observationP->userData);
-        observation_remove(((lwm2m_client_t*)transacP->peerP), observationP);
+        observation_remove(contextP, ((lwm2m_client_t*)transacP->peerP), observationP);
     }
     else
     {
+        observationP->status = STATE_REGISTERED;
+        cache_store(observationP->clientP, &observationP->uri, packet);
         observationP->clientP->observationList = (lwm2m_observation_t *)LWM2M_LIST_ADD(observationP->clientP->observationList, observationP);
         observationP->callback(((lwm2m_client_t*)transacP->peerP)->internalID,
                                &observationP->uri,
@@ -366,27 +600,35 @@ int lwm2m_observe(lwm2m_context_t * contextP,
 
     if (!LWM2M_URI_IS_SET_INSTANCE(uriP) && LWM2M_URI_IS_SET_RESOURCE(uriP)) return COAP_400_BAD_REQUEST;
 
-    clientP = (lwm2m_client_t *)lwm2m_list_find((lwm2m_list_t *)contextP->clientList, clientID);
+    clientP = lifetime_get_client(contextP, clientID);
     if (clientP == NULL) return COAP_404_NOT_FOUND;
 
     observationP = (lwm2m_observation_t *)lwm2m_malloc(sizeof(lwm2m_observation_t));
     if (observationP == NULL) return COAP_500_INTERNAL_SERVER_ERROR;
     memset(observationP, 0, sizeof(lwm2m_observation_t));
 
-    observationP->id = lwm2m_list_newId((lwm2m_list_t *)clientP->observationList);
+    // the slot number is unique in the context, hence in the client's observationList
+    observationP->id = prv_allocSlot(contextP, observationP);
+    if (observationP->id == LWM2M_OBSERVATION_NO_SLOT)
+    {
+        lwm2m_free(observationP);
+        return COAP_500_INTERNAL_SERVER_ERROR;
+    }
+    observationP->status = STATE_REG_PENDING;
     memcpy(&observationP->uri, uriP, sizeof(lwm2m_uri_t));
     observationP->clientP = clientP;
     observationP->callback = callback;
     observationP->userData = userData;
 
-    token[0] = clientP->internalID >> 8;
-    token[1] = clientP->internalID & 0xFF;
-    token[2] = observationP->id >> 8;
-    token[3] = observationP->id & 0xFF;
+    token[0] = observationP->id >> 8;
+    token[1] = observationP->id & 0xFF;
+    token[2] = contextP->observationSlots[observationP->id].generation >> 8;
+    token[3] = contextP->observationSlots[observationP->id].generation & 0xFF;
 
     transactionP = transaction_new(COAP_TYPE_CON, COAP_GET, clientP->altPath, uriP, contextP->nextMID++, 4, token, ENDPOINT_CLIENT, (void *)clientP);
     if (transactionP == NULL)
     {
+        prv_releaseSlot(contextP, observationP->id);
         lwm2m_free(observationP);
         return COAP_500_INTERNAL_SERVER_ERROR;
     }
@@ -395,7 +637,7 @@ int lwm2m_observe(lwm2m_context_t * contextP,
     coap_set_header_token(transactionP->message, token, sizeof(token));
 
     transactionP->callback = prv_obsRequestCallback;
-    transactionP->userData = (void *)observationP;
+    transactionP->userData = (void *)contextP;
 
     contextP->transactionList = (lwm2m_transaction_t *)LWM2M_LIST_ADD(contextP->transactionList, transactionP);
 
@@ -411,13 +653,13 @@ int lwm2m_observe_cancel(lwm2m_context_t * contextP,
     lwm2m_client_t * clientP;
     lwm2m_observation_t * observationP;
 
-    clientP = (lwm2m_client_t *)lwm2m_list_find((lwm2m_list_t *)contextP->clientList, clientID);
+    clientP = lifetime_get_client(contextP, clientID);
     if (clientP == NULL) return COAP_404_NOT_FOUND;
 
     observationP = prv_findObservationByURI(clientP, uriP);
     if (observationP == NULL) return COAP_404_NOT_FOUND;
 
-    observation_remove(clientP, observationP);
+    observation_remove(contextP, clientP, observationP);
 
     return 0;
 }
@@ -429,9 +671,6 @@ bool handle_observe_notify(lwm2m_context_t * contextP,
 {
     uint8_t * tokenP;
     int token_len;
-    uint16_t clientID;
-    uint16_t obsID;
-    lwm2m_client_t * clientP;
     lwm2m_observation_t * observationP;
     uint32_t count;
 
@@ -440,14 +679,8 @@ bool handle_observe_notify(lwm2m_context_t * contextP,
 
     if (1 != coap_get_header_observe(message, &count)) return false;
 
-    clientID = (tokenP[0] << 8) | tokenP[1];
-    obsID = (tokenP[2] << 8) | tokenP[3];
-
-    clientP = (lwm2m_client_t *)lwm2m_list_find((lwm2m_list_t *)contextP->clientList, clientID);
-    if (clientP == NULL) return false;
-
-    observationP = (lwm2m_observation_t *)lwm2m_list_find((lwm2m_list_t *)clientP->observationList, obsID);
-    if (observationP == NULL)
+    observationP = prv_getObservationByToken(contextP, tokenP, token_len);
+    if (observationP == NULL || observationP->status != STATE_REGISTERED)
     {
         coap_init_message(response, COAP_TYPE_RST, 0, message->mid);
         message_send(contextP, response, fromSessionH);
@@ -458,7 +691,15 @@ bool handle_observe_notify(lwm2m_context_t * contextP,
             coap_init_message(response, COAP_TYPE_ACK, 0, message->mid);
             message_send(contextP, response, fromSessionH);
         }
-        observationP->callback(clientID,
+        if (message->code == COAP_205_CONTENT)
+        {
+            cache_store(observationP->clientP, &observationP->uri, message);
+        }
+        else
+        {
+            cache_invalidate(observationP->clientP, &observationP->uri);
+        }
+        observationP->callback(observationP->clientP->internalID,
                                &observationP->uri,
                                (int)count,
                                message->payload, message->payload_len,
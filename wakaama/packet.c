@@ -124,6 +124,10 @@ static coap_status_t handle_request(lwm2m_context_t * contextP,
     case LWM2M_URI_FLAG_DM:
         // TODO: Authentify server
         result = handle_dm_request(contextP, uriP, fromSessionH, message, response);
+        if (COAP_PENDING == result)
+        {
+            result = separate_store(contextP, uriP, fromSessionH, message);
+        }
         break;
 
 #ifdef LWM2M_BOOTSTRAP
@@ -153,9 +157,19 @@ static coap_status_t handle_request(lwm2m_context_t * contextP,
         result = handle_registration_request(contextP, uriP, fromSessionH, message, response);
         break;
 #endif
-#ifdef LWM2M_BOOTSTRAP_SERVER_MODE
+#if defined(LWM2M_BOOTSTRAP_SERVER_MODE) || (defined(LWM2M_CLIENT_MODE) && defined(LWM2M_BOOTSTRAP))
     case LWM2M_URI_FLAG_BOOTSTRAP:
+#if defined(LWM2M_CLIENT_MODE) && defined(LWM2M_BOOTSTRAP)
+        // unlike a Bootstrap-Request, a Bootstrap-Finish has no query
+        if (message->uri_query == NULL)
+        {
+            result = handle_bootstrap_finish(contextP, fromSessionH, message);
+            break;
+        }
+#endif
+#ifdef LWM2M_BOOTSTRAP_SERVER_MODE
         result = handle_bootstrap_request(contextP, uriP, fromSessionH, message, response);
+#endif
         break;
 #endif
     default:
@@ -163,6 +177,13 @@ static coap_status_t handle_request(lwm2m_context_t * contextP,
         break;
     }
 
+    if (COAP_PENDING == result)
+    {
+        // answered later by lwm2m_resource_ready()
+        lwm2m_free(uriP);
+        return result;
+    }
+
     coap_set_status_code(response, result);
 
     if (COAP_IGNORE < result && result < BAD_REQUEST_4_00)
@@ -184,8 +205,9 @@ void lwm2m_handle_packet(lwm2m_context_t * contextP,
                         void * fromSessionH)
 {
     coap_status_t coap_error_code = NO_ERROR;
-    static coap_packet_t message[1];
-    static coap_packet_t response[1];
+    const char * coap_error_message = "";
+    coap_packet_t * message = (coap_packet_t *)contextP->packets;
+    coap_packet_t * response = message + 1;
 
     coap_error_code = coap_parse_message(message, buffer, (uint16_t)length);
     if (coap_error_code == NO_ERROR)
@@ -201,6 +223,26 @@ void lwm2m_handle_packet(lwm2m_context_t * contextP,
         }
         LOG("  Payload: %.*s\r\n\n", message->payload_len, message->payload);
 #endif
+        if (message->code >= COAP_GET && message->code <= COAP_DELETE
+         && message->type == COAP_TYPE_CON
+         && dedup_replay(contextP, fromSessionH, message->mid))
+        {
+            // retransmitted request, already answered
+            return;
+        }
+
+#ifdef LWM2M_CLIENT_MODE
+        if (message->code >= COAP_GET && message->code <= COAP_DELETE
+         && message->type == COAP_TYPE_CON
+         && separate_is_pending(contextP, fromSessionH, message->mid))
+        {
+            // retransmitted request, the empty ACK was lost
+            coap_init_message(response, COAP_TYPE_ACK, 0, message->mid);
+            message_send(contextP, response, fromSessionH);
+            return;
+        }
+#endif
+
         if (message->code >= COAP_GET && message->code <= COAP_DELETE)
         {
             uint32_t block_num = 0;
@@ -286,6 +328,19 @@ void lwm2m_handle_packet(lwm2m_context_t * contextP,
                 response->payload = NULL;
                 response->payload_len = 0;
             }
+            else if (coap_error_code == COAP_PENDING)
+            {
+                if (message->type == COAP_TYPE_CON)
+                {
+                    /* Acknowledge now, the response will be sent separately. */
+                    coap_init_message(response, COAP_TYPE_ACK, 0, message->mid);
+                    coap_error_code = message_send(contextP, response, fromSessionH);
+                }
+                else
+                {
+                    coap_error_code = NO_ERROR;
+                }
+            }
             else if (coap_error_code != COAP_IGNORE)
             {
                 if (1 == coap_set_status_code(response, coap_error_code))
@@ -338,6 +393,7 @@ void lwm2m_handle_packet(lwm2m_context_t * contextP,
     else
     {
         LOG("Message parsing failed %d\r\n", coap_error_code);
+        coap_error_message = message->error_message;
     }
 
     if (coap_error_code != NO_ERROR && coap_error_code != COAP_IGNORE)
@@ -357,6 +413,21 @@ void lwm2m_handle_packet(lwm2m_context_t * contextP,
 }
 
 
+// keep piggybacked responses for retransmitted requests
+static void prv_store_response(lwm2m_context_t * contextP,
+                               coap_packet_t * message,
+                               void * sessionH,
+                               uint8_t * buffer,
+                               size_t length)
+{
+    if (0 != length
+     && COAP_TYPE_ACK == message->type
+     && 0 != message->code)
+    {
+        dedup_store(contextP, sessionH, message->mid, buffer, length);
+    }
+}
+
 coap_status_t message_send(lwm2m_context_t * contextP,
                            coap_packet_t * message,
                            void * sessionH)
@@ -367,12 +438,33 @@ coap_status_t message_send(lwm2m_context_t * contextP,
     size_t allocLen;
 
     allocLen = COAP_MAX_HEADER_SIZE + message->payload_len;
+
+    if (NULL != contextP->bufferAllocCallback)
+    {
+        void * handle;
+
+        // serialize directly in the communication layer buffer
+        pktBuffer = contextP->bufferAllocCallback(sessionH, allocLen, &handle, contextP->userData);
+        if (pktBuffer != NULL)
+        {
+            pktBufferLen = coap_serialize_message(message, pktBuffer);
+            prv_store_response(contextP, message, sessionH, pktBuffer, pktBufferLen);
+            result = contextP->handleSendCallback(sessionH, handle, pktBufferLen, contextP->userData);
+            if (0 == pktBufferLen)
+            {
+                result = INTERNAL_SERVER_ERROR_5_00;
+            }
+        }
+        return result;
+    }
+
     pktBuffer = (uint8_t *)lwm2m_malloc(allocLen);
     if (pktBuffer != NULL)
     {
         pktBufferLen = coap_serialize_message(message, pktBuffer);
         if (0 != pktBufferLen)
         {
+            prv_store_response(contextP, message, sessionH, pktBuffer, pktBufferLen);
             result = contextP->bufferSendCallback(sessionH, pktBuffer, pktBufferLen, contextP->userData);
         }
         lwm2m_free(pktBuffer);
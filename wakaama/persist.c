@@ -0,0 +1,1167 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - initial API and implementation
+ *
+ *******************************************************************************/
+
+/************************************************************************
+ *  Warm restart.
+ *
+ *  The session state is saved through the application's store callback
+ *  whenever it changes: the Security and Server Objects written by a
+ *  bootstrap server, the location and date of each registration, and the
+ *  observations with their tokens and counters. The counters are also
+ *  saved every LWM2M_PERSIST_COUNTER_INTERVAL notifications.
+ *
+ *  On the first lwm2m_start(), the snapshot is loaded back. A server whose
+ *  registration lifetime has not expired is sent a Registration Update
+ *  instead of a Register, and its observations keep notifying without the
+ *  server having to observe again. The update is refused by a server which
+ *  lost the registration, the client then registers again.
+ *
+ *  Snapshot layout, integers are big endian:
+ *    magic "LWP" and version                         4 bytes
+ *    checksum of the endpoint name and object IDs    2 bytes
+ *    checksum of the registration payload            2 bytes
+ *    bootstrap state                                 1 byte
+ *    Security then Server Object:  TLV length        2 bytes
+ *                                  TLV of all instances, when bootstrapped
+ *    server count                                    1 byte
+ *      short ID 2, lifetime 4, registration date 4, binding 1,
+ *      location length 1, location
+ *    observed URI count                              1 byte
+ *      URI flag 1, object 2, instance 2, resource 2, watcher count 1
+ *        short ID 2, format 2, token length 1, token, counter 4
+ *    checksum of the above                           2 bytes
+ */
+
+#include "internals.h"
+
+#if defined(LWM2M_CLIENT_MODE) || defined(LWM2M_SERVER_MODE)
+
+typedef struct
+{
+    uint8_t * buffer;
+    size_t    length;
+    size_t    index;
+    bool      error;
+} persist_cursor_t;
+
+// Fletcher-16
+static uint16_t prv_checksum(uint16_t sum,
+                             const uint8_t * buffer,
+                             size_t length)
+{
+    uint16_t sum1 = sum & 0xFF;
+    uint16_t sum2 = sum >> 8;
+    size_t i;
+
+    for (i = 0 ; i < length ; i++)
+    {
+        sum1 = (sum1 + buffer[i]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+
+    return (sum2 << 8) | sum1;
+}
+
+static void prv_put(persist_cursor_t * cursorP,
+                    const uint8_t * data,
+                    size_t length)
+{
+    if (cursorP->error || cursorP->index + length > cursorP->length)
+    {
+        cursorP->error = true;
+        return;
+    }
+    // without buffer, only measures
+    if (cursorP->buffer != NULL)
+    {
+        memcpy(cursorP->buffer + cursorP->index, data, length);
+    }
+    cursorP->index += length;
+}
+
+static void prv_put_int(persist_cursor_t * cursorP,
+                        uint32_t value,
+                        size_t length)
+{
+    uint8_t data[4];
+    size_t i;
+
+    for (i = length ; i > 0 ; i--)
+    {
+        data[i - 1] = value & 0xFF;
+        value >>= 8;
+    }
+    prv_put(cursorP, data, length);
+}
+
+static const uint8_t * prv_get(persist_cursor_t * cursorP,
+                               size_t length)
+{
+    const uint8_t * data;
+
+    if (cursorP->error || cursorP->index + length > cursorP->length)
+    {
+        cursorP->error = true;
+        return NULL;
+    }
+    data = cursorP->buffer + cursorP->index;
+    cursorP->index += length;
+
+    return data;
+}
+
+static uint32_t prv_get_int(persist_cursor_t * cursorP,
+                            size_t length)
+{
+    const uint8_t * data;
+    uint32_t value;
+    size_t i;
+
+    data = prv_get(cursorP, length);
+    if (data == NULL) return 0;
+
+    value = 0;
+    for (i = 0 ; i < length ; i++)
+    {
+        value = (value << 8) | data[i];
+    }
+
+    return value;
+}
+
+#endif
+
+#ifdef LWM2M_CLIENT_MODE
+
+#define PERSIST_VERSION     1
+#define PERSIST_HEADER_LEN  9
+// registration payload buffer of registration.c
+#define PERSIST_PAYLOAD_LEN 512
+
+// a snapshot is only valid for the same endpoint exposing the same objects
+static uint16_t prv_identity(lwm2m_context_t * contextP)
+{
+    uint16_t sum;
+    int i;
+
+    sum = prv_checksum(0, (uint8_t *)contextP->endpointName, strlen(contextP->endpointName));
+    for (i = 0 ; i < contextP->numObject ; i++)
+    {
+        uint8_t id[2];
+
+        id[0] = contextP->objectList[i]->objID >> 8;
+        id[1] = contextP->objectList[i]->objID & 0xFF;
+        sum = prv_checksum(sum, id, 2);
+    }
+
+    return sum;
+}
+
+// one link of the registration payload, its ',' is summed before the next link
+static uint16_t prv_link_checksum(uint16_t sum,
+                                  size_t * lengthP,
+                                  const char * altPath,
+                                  const char * tail,
+                                  size_t tailLength)
+{
+    if (*lengthP > 0) sum = prv_checksum(sum, (uint8_t *)",", 1);
+    sum = prv_checksum(sum, (uint8_t *)"<", 1);
+    sum = prv_checksum(sum, (uint8_t *)altPath, strlen(altPath));
+    sum = prv_checksum(sum, (uint8_t *)tail, tailLength);
+    *lengthP += 1 + strlen(altPath) + tailLength + 1;
+
+    return sum;
+}
+
+// a Registration Update without payload tells the server the object instances did not change.
+// Sums the payload of prv_getRegisterPayload() link by link, without building it.
+static uint16_t prv_payload_checksum(lwm2m_context_t * contextP)
+{
+    const char * altPath;
+    uint16_t sum;
+    size_t length;
+    char link[16];
+    int i;
+
+    altPath = (contextP->altPath != NULL) ? contextP->altPath : "";
+    sum = 0;
+    length = 0;
+
+    if (altPath[0] != 0)
+    {
+        sum = prv_link_checksum(sum, &length, altPath, REG_LWM2M_RESOURCE_TYPE, REG_LWM2M_RESOURCE_TYPE_LEN - 1);
+    }
+    for (i = 0 ; i < contextP->numObject ; i++)
+    {
+        lwm2m_object_t * objectP = contextP->objectList[i];
+        lwm2m_list_t * instanceP;
+
+        if (objectP->objID == LWM2M_SECURITY_OBJECT_ID) continue;
+
+        if (objectP->instanceList == NULL)
+        {
+            snprintf(link, sizeof(link), "/%hu>", objectP->objID);
+            sum = prv_link_checksum(sum, &length, altPath, link, strlen(link));
+        }
+        for (instanceP = objectP->instanceList ; instanceP != NULL ; instanceP = instanceP->next)
+        {
+            snprintf(link, sizeof(link), "/%hu/%hu>", objectP->objID, instanceP->id);
+            sum = prv_link_checksum(sum, &length, altPath, link, strlen(link));
+        }
+    }
+
+    // the payload does not fit and is sent empty
+    if (length > PERSIST_PAYLOAD_LEN) return 0;
+
+    return sum;
+}
+
+static lwm2m_object_t * prv_find_object(lwm2m_context_t * contextP,
+                                        uint16_t objectId)
+{
+    int i;
+
+    for (i = 0 ; i < contextP->numObject ; i++)
+    {
+        if (contextP->objectList[i]->objID == objectId)
+        {
+            return contextP->objectList[i];
+        }
+    }
+
+    return NULL;
+}
+
+#ifdef LWM2M_BOOTSTRAP
+// serialize all the instances, object_read() does not give access to the Security Object
+static int prv_serialize_object(lwm2m_object_t * objectP,
+                                uint8_t ** bufferP)
+{
+    lwm2m_list_t * instanceP;
+    lwm2m_tlv_t * tlvP;
+    int size;
+    int length;
+    int i;
+
+    size = 0;
+    for (instanceP = objectP->instanceList ; instanceP != NULL ; instanceP = instanceP->next)
+    {
+        size++;
+    }
+    if (size == 0) return 0;
+
+    tlvP = lwm2m_tlv_new(size);
+    if (tlvP == NULL) return -1;
+
+    length = 0;
+    for (instanceP = objectP->instanceList, i = 0 ; instanceP != NULL ; instanceP = instanceP->next, i++)
+    {
+        tlvP[i].type = LWM2M_TYPE_OBJECT_INSTANCE;
+        tlvP[i].id = instanceP->id;
+        if (objectP->readFunc(instanceP->id, (int*)&(tlvP[i].length), (lwm2m_tlv_t **)&(tlvP[i].value), objectP) != COAP_205_CONTENT)
+        {
+            length = -1;
+            break;
+        }
+    }
+    if (length == 0)
+    {
+        length = lwm2m_tlv_serialize(size, tlvP, bufferP);
+        if (length == 0) length = -1;
+    }
+    lwm2m_tlv_free(size, tlvP);
+
+    return length;
+}
+#endif
+
+static void prv_put_object(lwm2m_context_t * contextP,
+                           persist_cursor_t * cursorP,
+                           uint16_t objectId)
+{
+    uint8_t * buffer = NULL;
+    size_t length = 0;
+
+#ifdef LWM2M_BOOTSTRAP
+    // without bootstrap, the objects are configured by the application
+    if (contextP->bsState == BOOTSTRAPPED)
+    {
+        lwm2m_object_t * objectP;
+        int result;
+
+        objectP = prv_find_object(contextP, objectId);
+        result = (objectP == NULL) ? -1 : prv_serialize_object(objectP, &buffer);
+        if (result < 0)
+        {
+            cursorP->error = true;
+            return;
+        }
+        length = result;
+    }
+#endif
+    prv_put_int(cursorP, length, 2);
+    if (length != 0)
+    {
+        prv_put(cursorP, buffer, length);
+    }
+    lwm2m_free(buffer);
+}
+
+static void prv_put_observed(persist_cursor_t * cursorP,
+                             lwm2m_observed_t * observedP)
+{
+    lwm2m_watcher_t * watcherP;
+    int count;
+
+    count = 0;
+    for (watcherP = observedP->watcherList ; watcherP != NULL ; watcherP = watcherP->next)
+    {
+        if (watcherP->server->status == STATE_REGISTERED
+         || watcherP->server->status == STATE_REG_UPDATE_PENDING)
+        {
+            count++;
+        }
+    }
+
+    prv_put_int(cursorP, observedP->uri.flag, 1);
+    prv_put_int(cursorP, observedP->uri.objectId, 2);
+    prv_put_int(cursorP, observedP->uri.instanceId, 2);
+    prv_put_int(cursorP, observedP->uri.resourceId, 2);
+    prv_put_int(cursorP, count, 1);
+    for (watcherP = observedP->watcherList ; watcherP != NULL ; watcherP = watcherP->next)
+    {
+        if (watcherP->server->status == STATE_REGISTERED
+         || watcherP->server->status == STATE_REG_UPDATE_PENDING)
+        {
+            prv_put_int(cursorP, watcherP->server->shortID, 2);
+            prv_put_int(cursorP, watcherP->format, 2);
+            prv_put_int(cursorP, watcherP->tokenLen, 1);
+            prv_put(cursorP, watcherP->token, watcherP->tokenLen);
+            prv_put_int(cursorP, watcherP->counter, 4);
+        }
+    }
+}
+
+static bool prv_store(lwm2m_context_t * contextP)
+{
+    persist_cursor_t cursor;
+    lwm2m_server_t * serverP;
+    lwm2m_observed_t * observedP;
+    int count;
+    bool result;
+
+    cursor.buffer = (uint8_t *)lwm2m_malloc(LWM2M_PERSIST_MAX_SIZE);
+    if (cursor.buffer == NULL) return false;
+    cursor.length = LWM2M_PERSIST_MAX_SIZE;
+    cursor.index = 0;
+    cursor.error = false;
+
+    prv_put(&cursor, (uint8_t *)"LWP", 3);
+    prv_put_int(&cursor, PERSIST_VERSION, 1);
+    prv_put_int(&cursor, prv_identity(contextP), 2);
+    prv_put_int(&cursor, prv_payload_checksum(contextP), 2);
+#ifdef LWM2M_BOOTSTRAP
+    prv_put_int(&cursor, contextP->bsState == BOOTSTRAPPED ? BOOTSTRAPPED : NOT_BOOTSTRAPPED, 1);
+#else
+    prv_put_int(&cursor, 0, 1);
+#endif
+    prv_put_object(contextP, &cursor, LWM2M_SECURITY_OBJECT_ID);
+    prv_put_object(contextP, &cursor, LWM2M_SERVER_OBJECT_ID);
+
+    // only the registrations which can be resumed
+    count = 0;
+    for (serverP = contextP->serverList ; serverP != NULL ; serverP = serverP->next)
+    {
+        if ((serverP->status == STATE_REGISTERED || serverP->status == STATE_REG_UPDATE_PENDING)
+         && serverP->location != NULL)
+        {
+            count++;
+        }
+    }
+    prv_put_int(&cursor, count, 1);
+    for (serverP = contextP->serverList ; serverP != NULL ; serverP = serverP->next)
+    {
+        if ((serverP->status == STATE_REGISTERED || serverP->status == STATE_REG_UPDATE_PENDING)
+         && serverP->location != NULL)
+        {
+            size_t length = strlen(serverP->location);
+
+            if (length > 0xFF) length = 0;
+            prv_put_int(&cursor, serverP->shortID, 2);
+            prv_put_int(&cursor, serverP->lifetime, 4);
+            prv_put_int(&cursor, serverP->registration, 4);
+            prv_put_int(&cursor, serverP->binding, 1);
+            prv_put_int(&cursor, length, 1);
+            prv_put(&cursor, (uint8_t *)serverP->location, length);
+        }
+    }
+
+    count = 0;
+    for (observedP = contextP->observedList ; observedP != NULL ; observedP = observedP->next)
+    {
+        count++;
+    }
+    if (count > 0xFF) cursor.error = true;
+    prv_put_int(&cursor, count, 1);
+    for (observedP = contextP->observedList ; observedP != NULL ; observedP = observedP->next)
+    {
+        prv_put_observed(&cursor, observedP);
+    }
+
+    prv_put_int(&cursor, prv_checksum(0, cursor.buffer, cursor.index), 2);
+
+    if (cursor.error)
+    {
+        LOG("Session state not saved, larger than %d bytes or unreadable\r\n", LWM2M_PERSIST_MAX_SIZE);
+        result = false;
+    }
+    else
+    {
+        LOG("Saving %u bytes of session state\r\n", (unsigned int)cursor.index);
+        result = contextP->storeCallback(cursor.buffer, cursor.index, contextP->persistUserData);
+    }
+    lwm2m_free(cursor.buffer);
+
+    return result;
+}
+
+#ifdef LWM2M_BOOTSTRAP
+// replace the instances of the object by the saved ones
+static bool prv_restore_object(lwm2m_context_t * contextP,
+                               uint16_t objectId,
+                               uint8_t * buffer,
+                               size_t length)
+{
+    lwm2m_object_t * objectP;
+    lwm2m_tlv_t * tlvP;
+    int size;
+    int i;
+    bool result;
+
+    objectP = prv_find_object(contextP, objectId);
+    if (objectP == NULL || objectP->createFunc == NULL || objectP->deleteFunc == NULL) return false;
+
+    size = lwm2m_tlv_parse(buffer, length, &tlvP);
+    if (size == 0) return false;
+
+    while (objectP->instanceList != NULL)
+    {
+        if (objectP->deleteFunc(objectP->instanceList->id, objectP) != COAP_202_DELETED) break;
+    }
+
+    result = true;
+    for (i = 0 ; i < size && result ; i++)
+    {
+        lwm2m_tlv_t * instanceP = (lwm2m_tlv_t *)tlvP[i].value;
+
+        if (tlvP[i].type != LWM2M_TYPE_OBJECT_INSTANCE || tlvP[i].length == 0)
+        {
+            result = false;
+            break;
+        }
+        // as written by the bootstrap server
+        instanceP->flags |= LWM2M_TLV_FLAG_BOOTSTRAPPING;
+        result = (objectP->createFunc(tlvP[i].id, tlvP[i].length, instanceP, objectP) == COAP_201_CREATED);
+    }
+    lwm2m_tlv_free(size, tlvP);
+
+    return result;
+}
+#endif
+
+uint8_t * persist_load(lwm2m_context_t * contextP,
+                       size_t * lengthP)
+{
+    persist_cursor_t cursor;
+    uint8_t bsState;
+    int i;
+
+    if (contextP->loadCallback == NULL) return NULL;
+
+    cursor.buffer = (uint8_t *)lwm2m_malloc(LWM2M_PERSIST_MAX_SIZE);
+    if (cursor.buffer == NULL) return NULL;
+    cursor.length = contextP->loadCallback(cursor.buffer, LWM2M_PERSIST_MAX_SIZE, contextP->persistUserData);
+    cursor.index = 0;
+    cursor.error = false;
+
+    if (cursor.length < PERSIST_HEADER_LEN + 2
+     || memcmp(cursor.buffer, "LWP", 3) != 0
+     || cursor.buffer[3] != PERSIST_VERSION
+     || prv_checksum(0, cursor.buffer, cursor.length - 2) != ((cursor.buffer[cursor.length - 2] << 8) | cursor.buffer[cursor.length - 1]))
+    {
+        LOG("No valid session state\r\n");
+        lwm2m_free(cursor.buffer);
+        return NULL;
+    }
+    cursor.length -= 2;
+    cursor.index = 4;
+
+    if (prv_get_int(&cursor, 2) != prv_identity(contextP))
+    {
+        LOG("Session state of another configuration\r\n");
+        lwm2m_free(cursor.buffer);
+        return NULL;
+    }
+    cursor.index += 2;
+    bsState = prv_get_int(&cursor, 1);
+
+    for (i = 0 ; i < 2 ; i++)
+    {
+        size_t length = prv_get_int(&cursor, 2);
+        uint8_t * tlvP = (uint8_t *)prv_get(&cursor, length);
+
+        if (cursor.error)
+        {
+            lwm2m_free(cursor.buffer);
+            return NULL;
+        }
+#ifdef LWM2M_BOOTSTRAP
+        if (bsState == BOOTSTRAPPED && length != 0)
+        {
+            // a failure leaves the factory configuration partly replaced,
+            // the registration then fails and the client bootstraps again
+            if (!prv_restore_object(contextP, i == 0 ? LWM2M_SECURITY_OBJECT_ID : LWM2M_SERVER_OBJECT_ID, tlvP, length))
+            {
+                LOG("Bootstrap configuration not restored\r\n");
+                lwm2m_free(cursor.buffer);
+                return NULL;
+            }
+        }
+#else
+        (void)tlvP;
+#endif
+    }
+#ifdef LWM2M_BOOTSTRAP
+    if (bsState == BOOTSTRAPPED)
+    {
+        contextP->bsState = BOOTSTRAPPED;
+    }
+#else
+    (void)bsState;
+#endif
+
+    *lengthP = cursor.length;
+    return cursor.buffer;
+}
+
+static lwm2m_server_t * prv_find_server(lwm2m_context_t * contextP,
+                                        uint16_t shortID)
+{
+    lwm2m_server_t * serverP;
+
+    for (serverP = contextP->serverList ; serverP != NULL ; serverP = serverP->next)
+    {
+        if (serverP->shortID == shortID) return serverP;
+    }
+
+    return NULL;
+}
+
+static void prv_resume_server(lwm2m_context_t * contextP,
+                              persist_cursor_t * cursorP,
+                              time_t now)
+{
+    lwm2m_server_t * serverP;
+    uint16_t shortID;
+    time_t lifetime;
+    time_t registration;
+    lwm2m_binding_t binding;
+    size_t length;
+    const uint8_t * location;
+
+    shortID = prv_get_int(cursorP, 2);
+    lifetime = prv_get_int(cursorP, 4);
+    registration = prv_get_int(cursorP, 4);
+    binding = (lwm2m_binding_t)prv_get_int(cursorP, 1);
+    length = prv_get_int(cursorP, 1);
+    location = prv_get(cursorP, length);
+    if (cursorP->error || length == 0) return;
+
+    serverP = prv_find_server(contextP, shortID);
+    if (serverP == NULL
+     || serverP->status != STATE_DEREGISTERED
+     || serverP->lifetime != lifetime
+     || serverP->binding != binding)
+    {
+        return;
+    }
+    // a clock going backwards (RTC lost) does not tell the age of the registration
+    if (now < registration || now >= registration + lifetime)
+    {
+        LOG("Registration to server %d expired\r\n", shortID);
+        return;
+    }
+
+    if (serverP->sessionH == NULL)
+    {
+        serverP->sessionH = contextP->connectCallback(serverP->secObjInstID, contextP->userData);
+        if (serverP->sessionH == NULL) return;
+    }
+    serverP->location = (char *)lwm2m_malloc(length + 1);
+    if (serverP->location == NULL) return;
+    memcpy(serverP->location, location, length);
+    serverP->location[length] = 0;
+    serverP->registration = registration;
+    serverP->status = STATE_REGISTERED;
+
+    LOG("Resuming registration %s to server %d\r\n", serverP->location, shortID);
+    (void)lwm2m_update_registration(contextP, shortID);
+}
+
+static void prv_resume_observed(lwm2m_context_t * contextP,
+                                persist_cursor_t * cursorP)
+{
+    lwm2m_uri_t uri;
+    lwm2m_observed_t * observedP;
+    int count;
+    int i;
+
+    uri.flag = prv_get_int(cursorP, 1);
+    uri.objectId = prv_get_int(cursorP, 2);
+    uri.instanceId = prv_get_int(cursorP, 2);
+    uri.resourceId = prv_get_int(cursorP, 2);
+    count = prv_get_int(cursorP, 1);
+
+    observedP = NULL;
+    for (i = 0 ; i < count && !cursorP->error ; i++)
+    {
+        lwm2m_server_t * serverP;
+        lwm2m_watcher_t * watcherP;
+        uint16_t shortID;
+        lwm2m_media_type_t format;
+        size_t tokenLen;
+        const uint8_t * token;
+        uint32_t counter;
+
+        shortID = prv_get_int(cursorP, 2);
+        format = (lwm2m_media_type_t)prv_get_int(cursorP, 2);
+        tokenLen = prv_get_int(cursorP, 1);
+        token = prv_get(cursorP, tokenLen);
+        counter = prv_get_int(cursorP, 4);
+        if (cursorP->error || tokenLen > sizeof(watcherP->token)) return;
+
+        // the observations of a server registering again are lost
+        serverP = prv_find_server(contextP, shortID);
+        if (serverP == NULL
+         || (serverP->status != STATE_REGISTERED && serverP->status != STATE_REG_UPDATE_PENDING))
+        {
+            continue;
+        }
+
+        if (observedP == NULL)
+        {
+            observedP = (lwm2m_observed_t *)lwm2m_malloc(sizeof(lwm2m_observed_t));
+            if (observedP == NULL) return;
+            memset(observedP, 0, sizeof(lwm2m_observed_t));
+            memcpy(&observedP->uri, &uri, sizeof(lwm2m_uri_t));
+            observedP->next = contextP->observedList;
+            contextP->observedList = observedP;
+            contextP->observedVersion++;
+        }
+
+        watcherP = (lwm2m_watcher_t *)lwm2m_malloc(sizeof(lwm2m_watcher_t));
+        if (watcherP == NULL) return;
+        memset(watcherP, 0, sizeof(lwm2m_watcher_t));
+        watcherP->server = serverP;
+        watcherP->tokenLen = tokenLen;
+        memcpy(watcherP->token, token, tokenLen);
+        watcherP->format = format;
+        // notifications sent after the snapshot was taken are not counted,
+        // skip ahead so that the server does not discard the next ones as old
+        watcherP->counter = counter + LWM2M_PERSIST_COUNTER_SKIP;
+        watcherP->next = observedP->watcherList;
+        observedP->watcherList = watcherP;
+    }
+}
+
+void persist_resume(lwm2m_context_t * contextP,
+                    uint8_t * buffer,
+                    size_t length)
+{
+    persist_cursor_t cursor;
+    time_t now;
+    int count;
+    int i;
+
+    cursor.buffer = buffer;
+    cursor.length = length;
+    cursor.index = 6;
+    cursor.error = false;
+
+    if (prv_get_int(&cursor, 2) != prv_payload_checksum(contextP))
+    {
+        LOG("Object instances changed, registering again\r\n");
+        return;
+    }
+    cursor.index = PERSIST_HEADER_LEN;
+
+    // skip the objects restored by persist_load()
+    for (i = 0 ; i < 2 ; i++)
+    {
+        (void)prv_get(&cursor, prv_get_int(&cursor, 2));
+    }
+
+    now = lwm2m_gettime();
+    count = prv_get_int(&cursor, 1);
+    for (i = 0 ; i < count && !cursor.error ; i++)
+    {
+        prv_resume_server(contextP, &cursor, now);
+    }
+
+    count = prv_get_int(&cursor, 1);
+    for (i = 0 ; i < count && !cursor.error ; i++)
+    {
+        prv_resume_observed(contextP, &cursor);
+    }
+}
+
+void persist_step(lwm2m_context_t * contextP)
+{
+    if (contextP->storeCallback == NULL || contextP->endpointName == NULL) return;
+
+    // the counters restored are skipped ahead by LWM2M_PERSIST_COUNTER_SKIP,
+    // they are saved often enough to stay within it
+    if (!contextP->persistDirty
+     && contextP->persistNotifyCount < LWM2M_PERSIST_COUNTER_INTERVAL)
+    {
+        return;
+    }
+
+    // on failure, the previous snapshot stays until the next change
+    contextP->persistDirty = false;
+    contextP->persistNotifyCount = 0;
+    (void)prv_store(contextP);
+}
+
+void lwm2m_set_persistence_callbacks(lwm2m_context_t * contextP,
+                                     lwm2m_store_callback_t storeCallback,
+                                     lwm2m_load_callback_t loadCallback,
+                                     void * userData)
+{
+    contextP->storeCallback = storeCallback;
+    contextP->loadCallback = loadCallback;
+    contextP->persistUserData = userData;
+}
+
+#endif
+
+#ifdef LWM2M_SERVER_MODE
+
+/************************************************************************
+ *  Registry of the clients, server side.
+ *
+ *  A record is given to the application's registry callback, to be
+ *  appended to a file for instance, each time a client registers or
+ *  updates its registration, and a removal record when it deregisters or
+ *  expires. After a restart, lwm2m_registry_restore() rebuilds clientList
+ *  from the records without parsing the registration payloads again, so
+ *  that the clients do not have to register again.
+ *
+ *  Record layout, integers are big endian:
+ *    magic "LWR" and version                         4 bytes
+ *    length of the record                            2 bytes
+ *    client ID, its location is /rd/<client ID>      2 bytes
+ *    lifetime 4, end of life 4, binding 1            absent from a removal
+ *    name length 1, name
+ *    MSISDN length 1, MSISDN
+ *    session address length 1, session address       from the application
+ *    alternative path length 1, alternative path
+ *    payload length 2, registration payload
+ *    object count 2
+ *      object ID 2, instance count 2, instance ID 2 each
+ *    checksum of the above                           2 bytes
+ */
+
+#define REGISTRY_VERSION        1
+#define REGISTRY_HEADER_LEN     8
+#define REGISTRY_REMOVAL_LEN    (REGISTRY_HEADER_LEN + 2)
+
+static void prv_put_string(persist_cursor_t * cursorP,
+                           const char * string)
+{
+    size_t length;
+
+    length = (string != NULL) ? strlen(string) : 0;
+    if (length > 0xFF)
+    {
+        cursorP->error = true;
+        return;
+    }
+    prv_put_int(cursorP, length, 1);
+    prv_put(cursorP, (const uint8_t *)string, length);
+}
+
+static void prv_put_header(persist_cursor_t * cursorP,
+                           uint16_t clientID)
+{
+    prv_put(cursorP, (const uint8_t *)"LWR", 3);
+    prv_put_int(cursorP, REGISTRY_VERSION, 1);
+    prv_put_int(cursorP, cursorP->length, 2);
+    prv_put_int(cursorP, clientID, 2);
+}
+
+static void prv_put_checksum(persist_cursor_t * cursorP)
+{
+    uint16_t sum;
+
+    sum = (cursorP->buffer != NULL) ? prv_checksum(0, cursorP->buffer, cursorP->index) : 0;
+    prv_put_int(cursorP, sum, 2);
+}
+
+static void prv_put_record(persist_cursor_t * cursorP,
+                           lwm2m_client_t * clientP,
+                           const uint8_t * session,
+                           size_t sessionLength)
+{
+    lwm2m_shared_objects_t * sharedP = clientP->sharedObjects;
+    lwm2m_client_object_t * objectP;
+    lwm2m_list_t * instanceP;
+    size_t count;
+
+    prv_put_header(cursorP, clientP->internalID);
+    prv_put_int(cursorP, clientP->lifetime, 4);
+    prv_put_int(cursorP, (uint32_t)clientP->endOfLife, 4);
+    prv_put_int(cursorP, clientP->binding, 1);
+    prv_put_string(cursorP, clientP->name);
+    prv_put_string(cursorP, clientP->msisdn);
+    prv_put_int(cursorP, sessionLength, 1);
+    prv_put(cursorP, session, sessionLength);
+    prv_put_string(cursorP, sharedP->altPath);
+    prv_put_int(cursorP, sharedP->payloadLength, 2);
+    prv_put(cursorP, sharedP->payload, sharedP->payloadLength);
+
+    count = 0;
+    for (objectP = sharedP->objectList ; objectP != NULL ; objectP = objectP->next) count++;
+    prv_put_int(cursorP, count, 2);
+    for (objectP = sharedP->objectList ; objectP != NULL ; objectP = objectP->next)
+    {
+        prv_put_int(cursorP, objectP->id, 2);
+        count = 0;
+        for (instanceP = objectP->instanceList ; instanceP != NULL ; instanceP = instanceP->next) count++;
+        prv_put_int(cursorP, count, 2);
+        for (instanceP = objectP->instanceList ; instanceP != NULL ; instanceP = instanceP->next)
+        {
+            prv_put_int(cursorP, instanceP->id, 2);
+        }
+    }
+
+    prv_put_checksum(cursorP);
+}
+
+void registry_store(lwm2m_context_t * contextP,
+                    lwm2m_client_t * clientP)
+{
+    persist_cursor_t cursor;
+    uint8_t session[LWM2M_REGISTRY_MAX_SESSION];
+    size_t sessionLength;
+
+    if (contextP->registryCallback == NULL) return;
+
+    sessionLength = 0;
+    if (contextP->sessionEncodeCallback != NULL)
+    {
+        sessionLength = contextP->sessionEncodeCallback(clientP->sessionH, session, sizeof(session), contextP->registryUserData);
+    }
+
+    // measure then write
+    memset(&cursor, 0, sizeof(persist_cursor_t));
+    cursor.length = 0xFFFF;
+    prv_put_record(&cursor, clientP, session, sessionLength);
+    if (cursor.error) return;
+
+    cursor.length = cursor.index;
+    cursor.index = 0;
+    cursor.buffer = (uint8_t *)lwm2m_malloc(cursor.length);
+    if (cursor.buffer == NULL) return;
+    prv_put_record(&cursor, clientP, session, sessionLength);
+
+    contextP->registryCallback(cursor.buffer, cursor.length, contextP->registryUserData);
+    lwm2m_free(cursor.buffer);
+}
+
+void registry_remove(lwm2m_context_t * contextP,
+                     uint16_t clientID)
+{
+    persist_cursor_t cursor;
+    uint8_t record[REGISTRY_REMOVAL_LEN];
+
+    if (contextP->registryCallback == NULL) return;
+
+    memset(&cursor, 0, sizeof(persist_cursor_t));
+    cursor.buffer = record;
+    cursor.length = sizeof(record);
+    prv_put_header(&cursor, clientID);
+    prv_put_checksum(&cursor);
+
+    contextP->registryCallback(record, sizeof(record), contextP->registryUserData);
+}
+
+// returns the length of the record, 0 if it is invalid or partially written
+static size_t prv_check_record(const uint8_t * buffer,
+                               size_t length)
+{
+    size_t recordLength;
+    uint16_t sum;
+
+    if (length < REGISTRY_REMOVAL_LEN) return 0;
+    if (memcmp(buffer, "LWR", 3) != 0 || buffer[3] != REGISTRY_VERSION) return 0;
+    recordLength = (buffer[4] << 8) | buffer[5];
+    if (recordLength < REGISTRY_REMOVAL_LEN || recordLength > length) return 0;
+    sum = (buffer[recordLength - 2] << 8) | buffer[recordLength - 1];
+    if (sum != prv_checksum(0, buffer, recordLength - 2)) return 0;
+
+    return recordLength;
+}
+
+static char * prv_get_string(persist_cursor_t * cursorP)
+{
+    const uint8_t * data;
+    size_t length;
+    char * string;
+
+    length = prv_get_int(cursorP, 1);
+    data = prv_get(cursorP, length);
+    if (data == NULL || length == 0) return NULL;
+
+    string = (char *)lwm2m_malloc(length + 1);
+    if (string == NULL)
+    {
+        cursorP->error = true;
+        return NULL;
+    }
+    memcpy(string, data, length);
+    string[length] = 0;
+
+    return string;
+}
+
+// the object list of a payload not already shared is rebuilt from the record
+static lwm2m_shared_objects_t * prv_get_objects(lwm2m_context_t * contextP,
+                                                persist_cursor_t * cursorP,
+                                                const uint8_t * payload,
+                                                uint16_t payloadLength,
+                                                char * altPath)
+{
+    lwm2m_shared_objects_t * sharedP;
+    lwm2m_client_object_t * objects;
+    lwm2m_client_object_t ** tailP;
+    size_t count;
+
+    sharedP = registration_findObjects(contextP, payload, payloadLength);
+    if (sharedP != NULL) return sharedP;
+
+    objects = NULL;
+    tailP = &objects;
+    count = prv_get_int(cursorP, 2);
+    while (count-- > 0 && !cursorP->error)
+    {
+        lwm2m_client_object_t * objectP;
+        lwm2m_list_t ** instanceTailP;
+        size_t instanceCount;
+
+        objectP = (lwm2m_client_object_t *)lwm2m_malloc(sizeof(lwm2m_client_object_t));
+        if (objectP == NULL)
+        {
+            cursorP->error = true;
+            break;
+        }
+        memset(objectP, 0, sizeof(lwm2m_client_object_t));
+        objectP->id = prv_get_int(cursorP, 2);
+        *tailP = objectP;
+        tailP = &objectP->next;
+
+        instanceTailP = &objectP->instanceList;
+        instanceCount = prv_get_int(cursorP, 2);
+        while (instanceCount-- > 0 && !cursorP->error)
+        {
+            lwm2m_list_t * instanceP;
+
+            instanceP = (lwm2m_list_t *)lwm2m_malloc(sizeof(lwm2m_list_t));
+            if (instanceP == NULL)
+            {
+                cursorP->error = true;
+                break;
+            }
+            memset(instanceP, 0, sizeof(lwm2m_list_t));
+            instanceP->id = prv_get_int(cursorP, 2);
+            *instanceTailP = instanceP;
+            instanceTailP = &instanceP->next;
+        }
+    }
+
+    if (!cursorP->error && objects != NULL)
+    {
+        sharedP = registration_addObjects(contextP, objects, altPath, payload, payloadLength);
+    }
+    prv_freeClientObjectList(objects);
+
+    return sharedP;
+}
+
+static coap_status_t prv_restore_client(lwm2m_context_t * contextP,
+                                        const uint8_t * record,
+                                        time_t now)
+{
+    persist_cursor_t cursor;
+    lwm2m_client_t * clientP;
+    uint16_t clientID;
+    uint32_t lifetime;
+    time_t endOfLife;
+    lwm2m_binding_t binding;
+    const uint8_t * session;
+    size_t sessionLength;
+    char * altPath;
+    const uint8_t * payload;
+    uint16_t payloadLength;
+
+    memset(&cursor, 0, sizeof(persist_cursor_t));
+    cursor.buffer = (uint8_t *)record;
+    cursor.length = REGISTRY_HEADER_LEN;
+    (void)prv_get(&cursor, 4);
+    cursor.length = prv_get_int(&cursor, 2) - 2;
+    clientID = prv_get_int(&cursor, 2);
+    lifetime = prv_get_int(&cursor, 4);
+    endOfLife = prv_get_int(&cursor, 4);
+    binding = (lwm2m_binding_t)prv_get_int(&cursor, 1);
+    if (cursor.error) return COAP_NO_ERROR;
+
+    // expired while the server was stopped
+    if (endOfLife <= now) return COAP_NO_ERROR;
+
+    clientP = (lwm2m_client_t *)lwm2m_malloc(sizeof(lwm2m_client_t));
+    if (clientP == NULL) return COAP_500_INTERNAL_SERVER_ERROR;
+    memset(clientP, 0, sizeof(lwm2m_client_t));
+    clientP->internalID = clientID;
+    clientP->lifetime = lifetime;
+    clientP->endOfLife = endOfLife;
+    clientP->binding = binding;
+    clientP->name = prv_get_string(&cursor);
+    clientP->msisdn = prv_get_string(&cursor);
+    sessionLength = prv_get_int(&cursor, 1);
+    session = prv_get(&cursor, sessionLength);
+    altPath = prv_get_string(&cursor);
+    payloadLength = prv_get_int(&cursor, 2);
+    payload = prv_get(&cursor, payloadLength);
+
+    if (!cursor.error && clientP->name != NULL && payload != NULL)
+    {
+        clientP->sharedObjects = prv_get_objects(contextP, &cursor, payload, payloadLength, altPath);
+    }
+    if (altPath != NULL) lwm2m_free(altPath);
+    if (clientP->sharedObjects == NULL)
+    {
+        // skip a record which cannot be restored
+        prv_freeClient(contextP, clientP);
+        return COAP_NO_ERROR;
+    }
+    clientP->objectList = clientP->sharedObjects->objectList;
+    clientP->altPath = clientP->sharedObjects->altPath;
+
+    if (contextP->sessionDecodeCallback != NULL && sessionLength != 0)
+    {
+        clientP->sessionH = contextP->sessionDecodeCallback(session, sessionLength, contextP->registryUserData);
+    }
+
+    if (!lifetime_add(contextP, clientP))
+    {
+        prv_freeClient(contextP, clientP);
+        return COAP_500_INTERNAL_SERVER_ERROR;
+    }
+    // the clients are restored by decreasing ID: inserting at the head keeps clientList sorted
+    clientP->next = contextP->clientList;
+    contextP->clientList = clientP;
+
+    return COAP_NO_ERROR;
+}
+
+int lwm2m_registry_restore(lwm2m_context_t * contextP,
+                           const uint8_t * buffer,
+                           size_t length)
+{
+    const uint8_t ** latestP;
+    size_t index;
+    size_t end;
+    size_t recordLength;
+    uint32_t maxID;
+    uint32_t clientID;
+    time_t now;
+    int result;
+
+    if (contextP->clientList != NULL) return COAP_412_PRECONDITION_FAILED;
+
+    now = lwm2m_gettime();
+    if (now < 0) return COAP_500_INTERNAL_SERVER_ERROR;
+
+    // the records after one partially written are ignored
+    index = 0;
+    maxID = 0;
+    while ((recordLength = prv_check_record(buffer + index, length - index)) != 0)
+    {
+        clientID = (buffer[index + 6] << 8) | buffer[index + 7];
+        if (clientID > maxID) maxID = clientID;
+        index += recordLength;
+    }
+    end = index;
+    if (end == 0) return COAP_NO_ERROR;
+
+    // the last record of each client supersedes the previous ones
+    latestP = (const uint8_t **)lwm2m_malloc((maxID + 1) * sizeof(uint8_t *));
+    if (latestP == NULL) return COAP_500_INTERNAL_SERVER_ERROR;
+    memset(latestP, 0, (maxID + 1) * sizeof(uint8_t *));
+    for (index = 0 ; index < end ; index += recordLength)
+    {
+        recordLength = (buffer[index + 4] << 8) | buffer[index + 5];
+        clientID = (buffer[index + 6] << 8) | buffer[index + 7];
+        latestP[clientID] = (recordLength == REGISTRY_REMOVAL_LEN) ? NULL : buffer + index;
+    }
+
+    result = COAP_NO_ERROR;
+    for (clientID = maxID + 1 ; clientID-- > 0 && result == COAP_NO_ERROR ; )
+    {
+        if (latestP[clientID] != NULL)
+        {
+            result = prv_restore_client(contextP, latestP[clientID], now);
+        }
+    }
+    lwm2m_free(latestP);
+
+    return result;
+}
+
+void lwm2m_registry_snapshot(lwm2m_context_t * contextP)
+{
+    lwm2m_client_t * clientP;
+
+    for (clientP = contextP->clientList ; clientP != NULL ; clientP = clientP->next)
+    {
+        registry_store(contextP, clientP);
+    }
+}
+
+void lwm2m_set_registry_callbacks(lwm2m_context_t * contextP,
+                                  lwm2m_registry_callback_t registryCallback,
+                                  lwm2m_session_encode_callback_t encodeCallback,
+                                  lwm2m_session_decode_callback_t decodeCallback,
+                                  void * userData)
+{
+    contextP->registryCallback = registryCallback;
+    contextP->sessionEncodeCallback = encodeCallback;
+    contextP->sessionDecodeCallback = decodeCallback;
+    contextP->registryUserData = userData;
+}
+
+#endif
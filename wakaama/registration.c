@@ -108,11 +108,34 @@ static int prv_getRegistrationQuery(lwm2m_context_t * contextP, lwm2m_server_t *
     return index + res;
 }
 
+// schedule the next registration attempt after a failure
+static void prv_retryLater(lwm2m_context_t * contextP,
+                           lwm2m_server_t * serverP,
+                           coap_packet_t * packet)
+{
+    if (packet != NULL && (packet->code >> 5) == 4)
+    {
+        // the request itself was rejected, retrying soon won't help
+        serverP->retryCount = 0xFF;
+    }
+    serverP->retryDelay = utils_retryDelay(contextP, &serverP->retryCount);
+    if (packet != NULL
+     && packet->code == SERVICE_UNAVAILABLE_5_03
+     && IS_OPTION(packet, COAP_OPTION_MAX_AGE))
+    {
+        // the overloaded server tells when to come back, the jitter still spreads the clients
+        serverP->retryDelay += packet->max_age;
+    }
+    serverP->status = STATE_REG_FAILED;
+    LOG("    => retry in %lu s\r\n", (unsigned long)serverP->retryDelay);
+}
+
 static void prv_handleRegistrationReply(lwm2m_transaction_t * transacP,
                                         void * message)
 {
     coap_packet_t * packet = (coap_packet_t *)message;
     lwm2m_server_t * targetP = (lwm2m_server_t *)(transacP->peerP);
+    lwm2m_context_t * contextP = (lwm2m_context_t *)(transacP->userData);
 
     switch(targetP->status)
     {
@@ -131,13 +154,15 @@ static void prv_handleRegistrationReply(lwm2m_transaction_t * transacP,
                 lwm2m_free(targetP->location);
             }
             targetP->location = coap_get_multi_option_as_string(packet->location_path);
+            targetP->retryCount = 0;
+            contextP->persistDirty = true;
 
             LOG("    => REGISTERED\r\n");
         }
         else
         {
-            targetP->status = STATE_REG_FAILED;
             LOG("    => Registration FAILED\r\n");
+            prv_retryLater(contextP, targetP, packet);
         }
     }
     break;
@@ -192,7 +217,7 @@ static void prv_register(lwm2m_context_t * contextP,
         coap_set_payload(transaction->message, payload, payload_length);
 
         transaction->callback = prv_handleRegistrationReply;
-        transaction->userData = (void *) server;
+        transaction->userData = (void *) contextP;
 
         contextP->transactionList = (lwm2m_transaction_t *)LWM2M_LIST_ADD(contextP->transactionList, transaction);
         if (transaction_send(contextP, transaction) == 0)
@@ -207,6 +232,7 @@ static void prv_handleRegistrationUpdateReply(lwm2m_transaction_t * transacP,
 {
     coap_packet_t * packet = (coap_packet_t *)message;
     lwm2m_server_t * targetP = (lwm2m_server_t *)(transacP->peerP);
+    lwm2m_context_t * contextP = (lwm2m_context_t *)(transacP->userData);
 
     switch(targetP->status)
     {
@@ -220,12 +246,21 @@ static void prv_handleRegistrationUpdateReply(lwm2m_transaction_t * transacP,
         if (packet != NULL && packet->code == CHANGED_2_04)
         {
             targetP->status = STATE_REGISTERED;
+            targetP->retryCount = 0;
+            // the registration date is saved for a warm restart
+            contextP->persistDirty = true;
             LOG("    => REGISTERED\r\n");
         }
+        else if (packet != NULL && packet->code == NOT_FOUND_4_04)
+        {
+            // the server does not know the registration, e.g. resumed after a restart
+            targetP->status = STATE_DEREGISTERED;
+            LOG("    => Registration unknown, registering again\r\n");
+        }
         else
         {
-            targetP->status = STATE_REG_FAILED;
             LOG("    => Registration update FAILED\r\n");
+            prv_retryLater(contextP, targetP, packet);
         }
     }
     break;
@@ -245,7 +280,7 @@ static int prv_update_registration(lwm2m_context_t * contextP,
     coap_set_header_uri_path(transaction->message, server->location);
 
     transaction->callback = prv_handleRegistrationUpdateReply;
-    transaction->userData = (void *) server;
+    transaction->userData = (void *) contextP;
 
     contextP->transactionList = (lwm2m_transaction_t *)LWM2M_LIST_ADD(contextP->transactionList, transaction);
 
@@ -355,7 +390,7 @@ void registration_update(lwm2m_context_t * contextP,
                 if (serverRegistered || NULL == contextP->bootstrapServerList)
                 {
 #endif
-                    interval = targetP->registration + targetP->lifetime - currentTime;
+                    interval = targetP->registration + targetP->retryDelay - currentTime;
                     if (0 >= interval)
                     {
                         LOG("Retry registration...\r\n");
@@ -678,21 +713,7 @@ static lwm2m_client_object_t * prv_decodeRegisterPayload(uint8_t * payload,
     return objList;
 }
 
-static lwm2m_client_t * prv_getClientByName(lwm2m_context_t * contextP,
-                                            char * name)
-{
-    lwm2m_client_t * targetP;
-
-    targetP = contextP->clientList;
-    while (targetP != NULL && strcmp(name, targetP->name) != 0)
-    {
-        targetP = targetP->next;
-    }
-
-    return targetP;
-}
-
-static void prv_freeClientObjectList(lwm2m_client_object_t * objects)
+void prv_freeClientObjectList(lwm2m_client_object_t * objects)
 {
     while (objects != NULL)
     {
@@ -713,23 +734,197 @@ static void prv_freeClientObjectList(lwm2m_client_object_t * objects)
     }
 }
 
-void prv_freeClient(lwm2m_client_t * clientP)
+/*
+ * Clients of the same model send the same registration payload: the object list
+ * decoded from a payload is packed in a single block, found again by the hash of
+ * the payload and shared by all the clients which sent it.
+ */
+
+static lwm2m_shared_objects_t * prv_packObjectList(lwm2m_client_object_t * objects,
+                                                   char * altPath,
+                                                   const uint8_t * payload,
+                                                   uint16_t payloadLength)
+{
+    lwm2m_shared_objects_t * sharedP;
+    lwm2m_client_object_t * objP;
+    lwm2m_client_object_t * targetP;
+    lwm2m_list_t * instanceP;
+    lwm2m_list_t * listP;
+    uint8_t * dataP;
+    size_t objCount;
+    size_t instanceCount;
+    size_t altPathLength;
+
+    objCount = 0;
+    instanceCount = 0;
+    for (objP = objects ; objP != NULL ; objP = objP->next)
+    {
+        objCount++;
+        for (listP = objP->instanceList ; listP != NULL ; listP = listP->next) instanceCount++;
+    }
+    altPathLength = (altPath != NULL) ? strlen(altPath) + 1 : 0;
+
+    sharedP = (lwm2m_shared_objects_t *)lwm2m_malloc(sizeof(lwm2m_shared_objects_t)
+                                                     + objCount * sizeof(lwm2m_client_object_t)
+                                                     + instanceCount * sizeof(lwm2m_list_t)
+                                                     + payloadLength + altPathLength);
+    if (sharedP == NULL) return NULL;
+    memset(sharedP, 0, sizeof(lwm2m_shared_objects_t));
+
+    targetP = (lwm2m_client_object_t *)(sharedP + 1);
+    instanceP = (lwm2m_list_t *)(targetP + objCount);
+    dataP = (uint8_t *)(instanceP + instanceCount);
+
+    sharedP->objectList = targetP;
+    for (objP = objects ; objP != NULL ; objP = objP->next)
+    {
+        targetP->id = objP->id;
+        targetP->instanceList = (objP->instanceList != NULL) ? instanceP : NULL;
+        for (listP = objP->instanceList ; listP != NULL ; listP = listP->next)
+        {
+            instanceP->id = listP->id;
+            instanceP->next = (listP->next != NULL) ? instanceP + 1 : NULL;
+            instanceP++;
+        }
+        targetP->next = (objP->next != NULL) ? targetP + 1 : NULL;
+        targetP++;
+    }
+
+    sharedP->payload = dataP;
+    sharedP->payloadLength = payloadLength;
+    memcpy(dataP, payload, payloadLength);
+    if (altPath != NULL)
+    {
+        sharedP->altPath = (char *)dataP + payloadLength;
+        memcpy(sharedP->altPath, altPath, altPathLength);
+    }
+
+    return sharedP;
+}
+
+// takes a reference on the object list already decoded from this payload, if any
+lwm2m_shared_objects_t * registration_findObjects(lwm2m_context_t * contextP,
+                                                  const uint8_t * payload,
+                                                  uint16_t payloadLength)
+{
+    lwm2m_shared_objects_t * sharedP;
+    uint32_t hash;
+
+    if (contextP->sharedObjectsTable == NULL) return NULL;
+
+    hash = utils_hash(payload, payloadLength);
+    for (sharedP = contextP->sharedObjectsTable[hash % LWM2M_SHARED_OBJECTS_BUCKETS] ; sharedP != NULL ; sharedP = sharedP->next)
+    {
+        if (sharedP->hash == hash
+         && sharedP->payloadLength == payloadLength
+         && memcmp(sharedP->payload, payload, payloadLength) == 0)
+        {
+            sharedP->refCount++;
+            return sharedP;
+        }
+    }
+
+    return NULL;
+}
+
+// shares a copy of objects, with a first reference
+lwm2m_shared_objects_t * registration_addObjects(lwm2m_context_t * contextP,
+                                                 lwm2m_client_object_t * objects,
+                                                 char * altPath,
+                                                 const uint8_t * payload,
+                                                 uint16_t payloadLength)
+{
+    lwm2m_shared_objects_t * sharedP;
+    uint32_t bucket;
+
+    if (contextP->sharedObjectsTable == NULL)
+    {
+        contextP->sharedObjectsTable = (lwm2m_shared_objects_t **)lwm2m_malloc(LWM2M_SHARED_OBJECTS_BUCKETS * sizeof(lwm2m_shared_objects_t *));
+        if (contextP->sharedObjectsTable == NULL) return NULL;
+        memset(contextP->sharedObjectsTable, 0, LWM2M_SHARED_OBJECTS_BUCKETS * sizeof(lwm2m_shared_objects_t *));
+    }
+
+    sharedP = prv_packObjectList(objects, altPath, payload, payloadLength);
+    if (sharedP == NULL) return NULL;
+
+    sharedP->hash = utils_hash(payload, payloadLength);
+    sharedP->refCount = 1;
+    bucket = sharedP->hash % LWM2M_SHARED_OBJECTS_BUCKETS;
+    sharedP->next = contextP->sharedObjectsTable[bucket];
+    contextP->sharedObjectsTable[bucket] = sharedP;
+
+    return sharedP;
+}
+
+// returns NULL if the payload is invalid
+static lwm2m_shared_objects_t * prv_acquireObjects(lwm2m_context_t * contextP,
+                                                   uint8_t * payload,
+                                                   uint16_t payloadLength)
+{
+    lwm2m_shared_objects_t * sharedP;
+    lwm2m_client_object_t * objects;
+    uint8_t * copyP;
+    char * altPath;
+
+    sharedP = registration_findObjects(contextP, payload, payloadLength);
+    if (sharedP != NULL) return sharedP;
+
+    // prv_decodeRegisterPayload() modifies the payload
+    copyP = (uint8_t *)lwm2m_malloc(payloadLength);
+    if (copyP == NULL) return NULL;
+    memcpy(copyP, payload, payloadLength);
+
+    objects = prv_decodeRegisterPayload(copyP, payloadLength, &altPath);
+    if (objects != NULL)
+    {
+        sharedP = registration_addObjects(contextP, objects, altPath, payload, payloadLength);
+        prv_freeClientObjectList(objects);
+    }
+    if (altPath != NULL) lwm2m_free(altPath);
+    lwm2m_free(copyP);
+
+    return sharedP;
+}
+
+static void prv_releaseObjects(lwm2m_context_t * contextP,
+                               lwm2m_shared_objects_t * sharedP)
+{
+    lwm2m_shared_objects_t ** nextP;
+
+    if (sharedP == NULL) return;
+    if (--sharedP->refCount != 0) return;
+
+    nextP = &contextP->sharedObjectsTable[sharedP->hash % LWM2M_SHARED_OBJECTS_BUCKETS];
+    while (*nextP != sharedP) nextP = &(*nextP)->next;
+    *nextP = sharedP->next;
+    lwm2m_free(sharedP);
+}
+
+void prv_freeClient(lwm2m_context_t * contextP,
+                    lwm2m_client_t * clientP)
 {
     if (clientP->name != NULL) lwm2m_free(clientP->name);
     if (clientP->msisdn != NULL) lwm2m_free(clientP->msisdn);
-    if (clientP->altPath != NULL) lwm2m_free(clientP->altPath);
-    prv_freeClientObjectList(clientP->objectList);
+    prv_releaseObjects(contextP, clientP->sharedObjects);
+    cache_free(clientP);
     while(clientP->observationList != NULL)
     {
-        lwm2m_observation_t * targetP;
-
-        targetP = clientP->observationList;
-        clientP->observationList = clientP->observationList->next;
-        lwm2m_free(targetP);
+        observation_remove(contextP, clientP, clientP->observationList);
     }
     lwm2m_free(clientP);
 }
 
+// remove the client from the context and free it
+static void prv_dropClient(lwm2m_context_t * contextP,
+                           lwm2m_client_t * clientP)
+{
+    lifetime_remove(contextP, clientP);
+    lifetime_unlink(contextP, clientP);
+    registry_remove(contextP, clientP->internalID);
+    transaction_remove_peer(contextP, clientP);
+    prv_freeClient(contextP, clientP);
+}
+
 static int prv_getLocationString(uint16_t id,
                                  char location[MAX_LOCATION_LENGTH])
 {
@@ -772,10 +967,10 @@ coap_status_t handle_registration_request(lwm2m_context_t * contextP,
         char * name = NULL;
         uint32_t lifetime;
         char * msisdn;
-        char * altPath;
         lwm2m_binding_t binding;
-        lwm2m_client_object_t * objects;
+        lwm2m_shared_objects_t * sharedP;
         lwm2m_client_t * clientP;
+        bool isNew;
         char location[MAX_LOCATION_LENGTH];
 
         if ((uriP->flag & LWM2M_URI_MASK_ID) != 0) return COAP_400_BAD_REQUEST;
@@ -783,8 +978,8 @@ coap_status_t handle_registration_request(lwm2m_context_t * contextP,
         {
             return COAP_400_BAD_REQUEST;
         }
-        objects = prv_decodeRegisterPayload(message->payload, message->payload_len, &altPath);
-        if (objects == NULL)
+        sharedP = prv_acquireObjects(contextP, message->payload, message->payload_len);
+        if (sharedP == NULL)
         {
             lwm2m_free(name);
             if (msisdn != NULL) lwm2m_free(msisdn);
@@ -794,6 +989,7 @@ coap_status_t handle_registration_request(lwm2m_context_t * contextP,
         if (name == NULL)
         {
             if (msisdn != NULL) lwm2m_free(msisdn);
+            prv_releaseObjects(contextP, sharedP);
             return COAP_400_BAD_REQUEST;
         }
         if (lifetime == 0)
@@ -801,15 +997,14 @@ coap_status_t handle_registration_request(lwm2m_context_t * contextP,
             lifetime = LWM2M_DEFAULT_LIFETIME;
         }
 
-        clientP = prv_getClientByName(contextP, name);
+        clientP = lifetime_find_client(contextP, name);
         if (clientP != NULL)
         {
             // we reset this registration
             lwm2m_free(clientP->name);
             if (clientP->msisdn != NULL) lwm2m_free(clientP->msisdn);
-            if (clientP->altPath != NULL) lwm2m_free(clientP->altPath);
-            prv_freeClientObjectList(clientP->objectList);
-            clientP->objectList = NULL;
+            prv_releaseObjects(contextP, clientP->sharedObjects);
+            isNew = false;
         }
         else
         {
@@ -817,34 +1012,56 @@ coap_status_t handle_registration_request(lwm2m_context_t * contextP,
             if (clientP == NULL)
             {
                 lwm2m_free(name);
-                lwm2m_free(altPath);
                 if (msisdn != NULL) lwm2m_free(msisdn);
-                prv_freeClientObjectList(objects);
+                prv_releaseObjects(contextP, sharedP);
                 return COAP_500_INTERNAL_SERVER_ERROR;
             }
             memset(clientP, 0, sizeof(lwm2m_client_t));
-            clientP->internalID = lwm2m_list_newId((lwm2m_list_t *)contextP->clientList);
-            contextP->clientList = (lwm2m_client_t *)LWM2M_LIST_ADD(contextP->clientList, clientP);
+            if (!lifetime_new_id(contextP, &clientP->internalID))
+            {
+                lwm2m_free(clientP);
+                lwm2m_free(name);
+                if (msisdn != NULL) lwm2m_free(msisdn);
+                prv_releaseObjects(contextP, sharedP);
+                return COAP_503_SERVICE_UNAVAILABLE;
+            }
+            isNew = true;
         }
         clientP->name = name;
         clientP->binding = binding;
         clientP->msisdn = msisdn;
-        clientP->altPath = altPath;
+        clientP->altPath = sharedP->altPath;
         clientP->lifetime = lifetime;
         clientP->endOfLife = tv_sec + lifetime;
-        clientP->objectList = objects;
+        clientP->sharedObjects = sharedP;
+        clientP->objectList = sharedP->objectList;
         clientP->sessionH = fromSessionH;
 
+        if (isNew)
+        {
+            if (!lifetime_add(contextP, clientP))
+            {
+                prv_freeClient(contextP, clientP);
+                return COAP_500_INTERNAL_SERVER_ERROR;
+            }
+            lifetime_link(contextP, clientP);
+        }
+        else
+        {
+            lifetime_update(contextP, clientP);
+        }
+
         if (prv_getLocationString(clientP->internalID, location) == 0)
         {
-            prv_freeClient(clientP);
+            prv_dropClient(contextP, clientP);
             return COAP_500_INTERNAL_SERVER_ERROR;
         }
         if (coap_set_header_location_path(response, location) == 0)
         {
-            prv_freeClient(clientP);
+            prv_dropClient(contextP, clientP);
             return COAP_500_INTERNAL_SERVER_ERROR;
         }
+        registry_store(contextP, clientP);
 
         if (contextP->monitorCallback != NULL)
         {
@@ -859,21 +1076,19 @@ coap_status_t handle_registration_request(lwm2m_context_t * contextP,
         char * name = NULL;
         uint32_t lifetime;
         char * msisdn;
-        char * altPath;
         lwm2m_binding_t binding;
-        lwm2m_client_object_t * objects;
+        lwm2m_shared_objects_t * sharedP;
         lwm2m_client_t * clientP;
 
         if ((uriP->flag & LWM2M_URI_MASK_ID) != LWM2M_URI_FLAG_OBJECT_ID) return COAP_400_BAD_REQUEST;
 
-        clientP = (lwm2m_client_t *)lwm2m_list_find((lwm2m_list_t *)contextP->clientList, uriP->objectId);
+        clientP = lifetime_get_client(contextP, uriP->objectId);
         if (clientP == NULL) return COAP_404_NOT_FOUND;
 
         if (0 != prv_getParameters(message->uri_query, &name, &lifetime, &msisdn, &binding))
         {
             return COAP_400_BAD_REQUEST;
         }
-        objects = prv_decodeRegisterPayload(message->payload, message->payload_len, &altPath);
 
         // Endpoint client name MUST NOT be present
         if (name != NULL)
@@ -882,6 +1097,11 @@ coap_status_t handle_registration_request(lwm2m_context_t * contextP,
             if (msisdn != NULL) lwm2m_free(msisdn);
             return COAP_400_BAD_REQUEST;
         }
+        sharedP = NULL;
+        if (message->payload_len != 0)
+        {
+            sharedP = prv_acquireObjects(contextP, message->payload, message->payload_len);
+        }
 
         if (binding != BINDING_UNKNOWN)
         {
@@ -899,7 +1119,7 @@ coap_status_t handle_registration_request(lwm2m_context_t * contextP,
         // client IP address, port or MSISDN may have changed
         clientP->sessionH = fromSessionH;
 
-        if (objects != NULL)
+        if (sharedP != NULL)
         {
             lwm2m_observation_t * observationP;
 
@@ -912,7 +1132,7 @@ coap_status_t handle_registration_request(lwm2m_context_t * contextP,
 
                 nextP = observationP->next;
 
-                objP = (lwm2m_client_object_t *)lwm2m_list_find((lwm2m_list_t *)objects, observationP->uri.objectId);
+                objP = (lwm2m_client_object_t *)lwm2m_list_find((lwm2m_list_t *)sharedP->objectList, observationP->uri.objectId);
                 if (objP == NULL)
                 {
                     observationP->callback(clientP->internalID,
@@ -920,7 +1140,7 @@ coap_status_t handle_registration_request(lwm2m_context_t * contextP,
                                            COAP_202_DELETED,
                                            NULL, 0,
                                            observationP->userData);
-                    observation_remove(clientP, observationP);
+                    observation_remove(contextP, clientP, observationP);
                 }
                 else
                 {
@@ -933,7 +1153,7 @@ coap_status_t handle_registration_request(lwm2m_context_t * contextP,
                                                    COAP_202_DELETED,
                                                    NULL, 0,
                                                    observationP->userData);
-                            observation_remove(clientP, observationP);
+                            observation_remove(contextP, clientP, observationP);
                         }
                     }
                 }
@@ -941,11 +1161,15 @@ coap_status_t handle_registration_request(lwm2m_context_t * contextP,
                 observationP = nextP;
             }
 
-            prv_freeClientObjectList(clientP->objectList);
-            clientP->objectList = objects;
+            prv_releaseObjects(contextP, clientP->sharedObjects);
+            clientP->sharedObjects = sharedP;
+            clientP->objectList = sharedP->objectList;
+            clientP->altPath = sharedP->altPath;
         }
 
         clientP->endOfLife = tv_sec + clientP->lifetime;
+        lifetime_update(contextP, clientP);
+        registry_store(contextP, clientP);
 
         if (contextP->monitorCallback != NULL)
         {
@@ -961,13 +1185,17 @@ coap_status_t handle_registration_request(lwm2m_context_t * contextP,
 
         if ((uriP->flag & LWM2M_URI_MASK_ID) != LWM2M_URI_FLAG_OBJECT_ID) return COAP_400_BAD_REQUEST;
 
-        contextP->clientList = (lwm2m_client_t *)LWM2M_LIST_RM(contextP->clientList, uriP->objectId, &clientP);
+        clientP = lifetime_get_client(contextP, uriP->objectId);
         if (clientP == NULL) return COAP_400_BAD_REQUEST;
+        lifetime_remove(contextP, clientP);
+        lifetime_unlink(contextP, clientP);
+        registry_remove(contextP, clientP->internalID);
         if (contextP->monitorCallback != NULL)
         {
             contextP->monitorCallback(clientP->internalID, NULL, DELETED_2_02, NULL, 0, contextP->monitorUserData);
         }
-        prv_freeClient(clientP);
+        transaction_remove_peer(contextP, clientP);
+        prv_freeClient(contextP, clientP);
         result = COAP_202_DELETED;
     }
     break;
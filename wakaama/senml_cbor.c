@@ -0,0 +1,1055 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - initial API and implementation
+ *
+ *******************************************************************************/
+
+/************************************************************************
+ *  SenML CBOR content format (draft-ietf-core-senml, rfc7049).
+ *
+ *  A pack is a CBOR array of records, each record a map with integer
+ *  labels. The first record carries the base name (the request URI down to
+ *  the instance, "/3303/0/"), the base time when the clock is set and, when
+ *  all values are integers and it saves bytes, a base value. The other
+ *  records only carry the relative name ("5700", "5601/1") and the value.
+ *
+ *  The encoder writes the pack in two passes over the lwm2m_tlv_t array
+ *  returned by the object: the first one computes the length, the second
+ *  one writes the buffer. The decoder is a streaming parser calling back
+ *  for each record, values are not copied.
+ */
+
+#include "internals.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// SenML labels
+#define PRV_LABEL_BASE_NAME     -2
+#define PRV_LABEL_BASE_TIME     -3
+#define PRV_LABEL_BASE_VALUE    -5
+#define PRV_LABEL_NAME          0
+#define PRV_LABEL_VALUE         2
+#define PRV_LABEL_STRING_VALUE  3
+#define PRV_LABEL_BOOLEAN_VALUE 4
+#define PRV_LABEL_TIME          6
+#define PRV_LABEL_DATA_VALUE    8
+
+// CBOR major types
+#define PRV_MAJOR_UNSIGNED      0
+#define PRV_MAJOR_NEGATIVE      1
+#define PRV_MAJOR_BYTES         2
+#define PRV_MAJOR_TEXT          3
+#define PRV_MAJOR_ARRAY         4
+#define PRV_MAJOR_MAP           5
+#define PRV_MAJOR_TAG           6
+#define PRV_MAJOR_SIMPLE        7
+
+#define PRV_SIMPLE_FALSE        20
+#define PRV_SIMPLE_TRUE         21
+#define PRV_SIMPLE_HALF         25
+#define PRV_SIMPLE_FLOAT        26
+#define PRV_SIMPLE_DOUBLE       27
+
+// SenML times below 2^28 are relative to now, an unset clock is not sent
+#define PRV_ABSOLUTE_TIME_MIN   ((time_t)1 << 28)
+
+// object, instance, resource, resource instance
+#define PRV_MAX_DEPTH           4
+// "/65535/65535/"
+#define PRV_BASE_NAME_MAX_LEN   13
+// doubles are exact integers up to 2^53
+#define PRV_MAX_EXACT_INT       9007199254740992.0
+
+typedef struct
+{
+    uint8_t * buffer;       // NULL to only compute the length
+    size_t    index;
+    bool      first;
+    char      baseName[PRV_BASE_NAME_MAX_LEN];
+    size_t    baseNameLen;
+    time_t    baseTime;     // 0 when not sent
+    bool      hasBaseValue;
+    int64_t   baseValue;
+} prv_encoder_t;
+
+typedef struct
+{
+    bool    integersOnly;
+    int     count;
+    int64_t min;
+    int64_t base;
+    int     gain;           // bytes saved by subtracting base from the values
+} prv_scan_t;
+
+typedef struct
+{
+    uint8_t * buffer;
+    size_t    length;
+    size_t    index;
+} prv_reader_t;
+
+typedef struct
+{
+    lwm2m_uri_t *  uriP;
+    lwm2m_tlv_t *  tlvP;
+    int            size;
+    int            capacity;
+} prv_tlv_builder_t;
+
+
+/*
+ * Encoder
+ */
+
+static void prv_write_byte(prv_encoder_t * encoderP,
+                           uint8_t byte)
+{
+    if (encoderP->buffer != NULL)
+    {
+        encoderP->buffer[encoderP->index] = byte;
+    }
+    encoderP->index++;
+}
+
+static void prv_write_head(prv_encoder_t * encoderP,
+                           uint8_t major,
+                           uint64_t value)
+{
+    int size;
+    uint8_t info;
+
+    if (value < 24)
+    {
+        prv_write_byte(encoderP, (major << 5) | (uint8_t)value);
+        return;
+    }
+    if (value <= 0xFF)
+    {
+        size = 1;
+        info = 24;
+    }
+    else if (value <= 0xFFFF)
+    {
+        size = 2;
+        info = 25;
+    }
+    else if (value <= 0xFFFFFFFF)
+    {
+        size = 4;
+        info = 26;
+    }
+    else
+    {
+        size = 8;
+        info = 27;
+    }
+    prv_write_byte(encoderP, (major << 5) | info);
+    while (size > 0)
+    {
+        size--;
+        prv_write_byte(encoderP, (uint8_t)(value >> (8 * size)));
+    }
+}
+
+static void prv_write_int(prv_encoder_t * encoderP,
+                          int64_t value)
+{
+    if (value < 0)
+    {
+        prv_write_head(encoderP, PRV_MAJOR_NEGATIVE, (uint64_t)(-(value + 1)));
+    }
+    else
+    {
+        prv_write_head(encoderP, PRV_MAJOR_UNSIGNED, (uint64_t)value);
+    }
+}
+
+static void prv_write_data(prv_encoder_t * encoderP,
+                           uint8_t major,
+                           const void * data,
+                           size_t length)
+{
+    prv_write_head(encoderP, major, length);
+    if (encoderP->buffer != NULL && length != 0)
+    {
+        memcpy(encoderP->buffer + encoderP->index, data, length);
+    }
+    encoderP->index += length;
+}
+
+// integral values are sent as integers, others in the shortest exact float
+static void prv_write_float(prv_encoder_t * encoderP,
+                            double value)
+{
+    float shortValue;
+
+    if (value >= -PRV_MAX_EXACT_INT && value <= PRV_MAX_EXACT_INT
+     && value == (double)(int64_t)value)
+    {
+        prv_write_int(encoderP, (int64_t)value);
+        return;
+    }
+
+    shortValue = (float)value;
+    if ((double)shortValue == value || value != value)
+    {
+        uint32_t bits;
+
+        memcpy(&bits, &shortValue, sizeof(bits));
+        prv_write_byte(encoderP, (PRV_MAJOR_SIMPLE << 5) | PRV_SIMPLE_FLOAT);
+        prv_write_byte(encoderP, bits >> 24);
+        prv_write_byte(encoderP, bits >> 16);
+        prv_write_byte(encoderP, bits >> 8);
+        prv_write_byte(encoderP, bits);
+    }
+    else
+    {
+        uint64_t bits;
+        int i;
+
+        memcpy(&bits, &value, sizeof(bits));
+        prv_write_byte(encoderP, (PRV_MAJOR_SIMPLE << 5) | PRV_SIMPLE_DOUBLE);
+        for (i = 7 ; i >= 0 ; i--)
+        {
+            prv_write_byte(encoderP, (uint8_t)(bits >> (8 * i)));
+        }
+    }
+}
+
+static int prv_int_size(int64_t value)
+{
+    uint64_t magnitude;
+
+    magnitude = value < 0 ? (uint64_t)(-(value + 1)) : (uint64_t)value;
+    if (magnitude < 24) return 1;
+    if (magnitude <= 0xFF) return 2;
+    if (magnitude <= 0xFFFF) return 3;
+    if (magnitude <= 0xFFFFFFFF) return 5;
+    return 9;
+}
+
+static size_t prv_write_id(char * buffer,
+                           uint16_t id)
+{
+    char digits[5];
+    size_t length;
+    size_t i;
+
+    length = 0;
+    do
+    {
+        digits[length++] = '0' + id % 10;
+        id /= 10;
+    } while (id != 0);
+
+    for (i = 0 ; i < length ; i++)
+    {
+        buffer[i] = digits[length - i - 1];
+    }
+    return length;
+}
+
+// read the value of a resource or resource instance in a record
+bool senml_decode_tlv(lwm2m_tlv_t * tlvP,
+                      lwm2m_senml_record_t * recordP)
+{
+    switch (tlvP->dataType)
+    {
+    case LWM2M_TYPE_INTEGER:
+    case LWM2M_TYPE_TIME:
+        recordP->type = LWM2M_TYPE_INTEGER;
+        return 0 != lwm2m_tlv_decode_int(tlvP, &recordP->value.asInteger);
+
+    case LWM2M_TYPE_FLOAT:
+        recordP->type = LWM2M_TYPE_FLOAT;
+        return 0 != lwm2m_tlv_decode_float(tlvP, &recordP->value.asFloat);
+
+    case LWM2M_TYPE_BOOLEAN:
+        recordP->type = LWM2M_TYPE_BOOLEAN;
+        return 0 != lwm2m_tlv_decode_bool(tlvP, &recordP->value.asBoolean);
+
+    case LWM2M_TYPE_STRING:
+        recordP->type = LWM2M_TYPE_STRING;
+        break;
+
+    default:
+        recordP->type = (tlvP->flags & LWM2M_TLV_FLAG_TEXT_FORMAT) != 0 ? LWM2M_TYPE_STRING : LWM2M_TYPE_OPAQUE;
+        break;
+    }
+    recordP->value.asBuffer.buffer = tlvP->value;
+    recordP->value.asBuffer.length = tlvP->length;
+    return true;
+}
+
+static int prv_count_records(int size,
+                             lwm2m_tlv_t * tlvP,
+                             int depth)
+{
+    int count;
+    int i;
+
+    if (depth >= PRV_MAX_DEPTH) return -1;
+
+    count = 0;
+    for (i = 0 ; i < size && count >= 0 ; i++)
+    {
+        switch (tlvP[i].type)
+        {
+        case LWM2M_TYPE_OBJECT_INSTANCE:
+        case LWM2M_TYPE_MULTIPLE_RESOURCE:
+            {
+                int subCount;
+
+                subCount = prv_count_records(tlvP[i].length, (lwm2m_tlv_t *)tlvP[i].value, depth + 1);
+                count = subCount < 0 ? -1 : count + subCount;
+            }
+            break;
+        case LWM2M_TYPE_RESOURCE:
+        case LWM2M_TYPE_RESOURCE_INSTANCE:
+            count++;
+            break;
+        default:
+            count = -1;
+            break;
+        }
+    }
+    return count;
+}
+
+// look for the minimum integer value, then for the gain of using it as base value
+static void prv_scan_values(int size,
+                            lwm2m_tlv_t * tlvP,
+                            prv_scan_t * scanP)
+{
+    int i;
+
+    for (i = 0 ; i < size && scanP->integersOnly ; i++)
+    {
+        lwm2m_senml_record_t record;
+
+        if (tlvP[i].type == LWM2M_TYPE_OBJECT_INSTANCE
+         || tlvP[i].type == LWM2M_TYPE_MULTIPLE_RESOURCE)
+        {
+            prv_scan_values(tlvP[i].length, (lwm2m_tlv_t *)tlvP[i].value, scanP);
+            continue;
+        }
+        if (!senml_decode_tlv(tlvP + i, &record))
+        {
+            scanP->integersOnly = false;
+            continue;
+        }
+        switch (record.type)
+        {
+        case LWM2M_TYPE_INTEGER:
+            if (scanP->count == 0 || record.value.asInteger < scanP->min)
+            {
+                scanP->min = record.value.asInteger;
+            }
+            scanP->count++;
+            scanP->gain += prv_int_size(record.value.asInteger) - prv_int_size(record.value.asInteger - scanP->base);
+            break;
+        case LWM2M_TYPE_FLOAT:
+            // a base value would make them inexact
+            scanP->integersOnly = false;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static bool prv_encode_record(prv_encoder_t * encoderP,
+                              uint16_t * ids,
+                              int depth,
+                              lwm2m_tlv_t * tlvP)
+{
+    lwm2m_senml_record_t record;
+    char name[4 * 6];
+    size_t nameLen;
+    int entries;
+    int i;
+
+    if (!senml_decode_tlv(tlvP, &record)) return false;
+
+    nameLen = 0;
+    for (i = 0 ; i <= depth ; i++)
+    {
+        if (i != 0) name[nameLen++] = '/';
+        nameLen += prv_write_id(name + nameLen, ids[i]);
+    }
+
+    entries = 2;
+    if (encoderP->first)
+    {
+        entries++;
+        if (encoderP->baseTime != 0) entries++;
+        if (encoderP->hasBaseValue) entries++;
+    }
+    prv_write_head(encoderP, PRV_MAJOR_MAP, entries);
+
+    if (encoderP->first)
+    {
+        prv_write_int(encoderP, PRV_LABEL_BASE_NAME);
+        prv_write_data(encoderP, PRV_MAJOR_TEXT, encoderP->baseName, encoderP->baseNameLen);
+        if (encoderP->baseTime != 0)
+        {
+            prv_write_int(encoderP, PRV_LABEL_BASE_TIME);
+            prv_write_int(encoderP, encoderP->baseTime);
+        }
+        if (encoderP->hasBaseValue)
+        {
+            prv_write_int(encoderP, PRV_LABEL_BASE_VALUE);
+            prv_write_int(encoderP, encoderP->baseValue);
+        }
+        encoderP->first = false;
+    }
+
+    prv_write_int(encoderP, PRV_LABEL_NAME);
+    prv_write_data(encoderP, PRV_MAJOR_TEXT, name, nameLen);
+
+    switch (record.type)
+    {
+    case LWM2M_TYPE_INTEGER:
+        prv_write_int(encoderP, PRV_LABEL_VALUE);
+        prv_write_int(encoderP, record.value.asInteger - (encoderP->hasBaseValue ? encoderP->baseValue : 0));
+        break;
+    case LWM2M_TYPE_FLOAT:
+        prv_write_int(encoderP, PRV_LABEL_VALUE);
+        prv_write_float(encoderP, record.value.asFloat);
+        break;
+    case LWM2M_TYPE_BOOLEAN:
+        prv_write_int(encoderP, PRV_LABEL_BOOLEAN_VALUE);
+        prv_write_byte(encoderP, (PRV_MAJOR_SIMPLE << 5) | (record.value.asBoolean ? PRV_SIMPLE_TRUE : PRV_SIMPLE_FALSE));
+        break;
+    case LWM2M_TYPE_STRING:
+        prv_write_int(encoderP, PRV_LABEL_STRING_VALUE);
+        prv_write_data(encoderP, PRV_MAJOR_TEXT, record.value.asBuffer.buffer, record.value.asBuffer.length);
+        break;
+    default:
+        prv_write_int(encoderP, PRV_LABEL_DATA_VALUE);
+        prv_write_data(encoderP, PRV_MAJOR_BYTES, record.value.asBuffer.buffer, record.value.asBuffer.length);
+        break;
+    }
+
+    return true;
+}
+
+static bool prv_encode_list(prv_encoder_t * encoderP,
+                            uint16_t * ids,
+                            int depth,
+                            int size,
+                            lwm2m_tlv_t * tlvP)
+{
+    int i;
+
+    for (i = 0 ; i < size ; i++)
+    {
+        ids[depth] = tlvP[i].id;
+        if (tlvP[i].type == LWM2M_TYPE_OBJECT_INSTANCE
+         || tlvP[i].type == LWM2M_TYPE_MULTIPLE_RESOURCE)
+        {
+            if (!prv_encode_list(encoderP, ids, depth + 1, tlvP[i].length, (lwm2m_tlv_t *)tlvP[i].value)) return false;
+        }
+        else
+        {
+            if (!prv_encode_record(encoderP, ids, depth, tlvP + i)) return false;
+        }
+    }
+    return true;
+}
+
+int senml_cbor_serialize(lwm2m_uri_t * uriP,
+                         int size,
+                         lwm2m_tlv_t * tlvP,
+                         uint8_t ** bufferP)
+{
+    prv_encoder_t encoder;
+    prv_scan_t scan;
+    uint16_t ids[PRV_MAX_DEPTH];
+    time_t now;
+    int count;
+    int pass;
+
+    *bufferP = NULL;
+
+    count = prv_count_records(size, tlvP, 0);
+    if (count <= 0) return 0;
+
+    memset(&encoder, 0, sizeof(prv_encoder_t));
+    encoder.baseName[0] = '/';
+    encoder.baseNameLen = 1 + prv_write_id(encoder.baseName + 1, uriP->objectId);
+    encoder.baseName[encoder.baseNameLen++] = '/';
+    if (LWM2M_URI_IS_SET_INSTANCE(uriP))
+    {
+        encoder.baseNameLen += prv_write_id(encoder.baseName + encoder.baseNameLen, uriP->instanceId);
+        encoder.baseName[encoder.baseNameLen++] = '/';
+    }
+
+    now = lwm2m_gettime();
+    if (now >= PRV_ABSOLUTE_TIME_MIN)
+    {
+        encoder.baseTime = now;
+    }
+
+    memset(&scan, 0, sizeof(prv_scan_t));
+    scan.integersOnly = true;
+    prv_scan_values(size, tlvP, &scan);
+    if (scan.integersOnly && scan.count > 1)
+    {
+        scan.base = scan.min;
+        scan.count = 0;
+        scan.gain = 0;
+        prv_scan_values(size, tlvP, &scan);
+        if (scan.gain > 1 + prv_int_size(scan.base))
+        {
+            encoder.hasBaseValue = true;
+            encoder.baseValue = scan.base;
+        }
+    }
+
+    // first pass computes the length, second pass writes
+    for (pass = 0 ; pass < 2 ; pass++)
+    {
+        if (pass == 1)
+        {
+            *bufferP = (uint8_t *)lwm2m_malloc(encoder.index);
+            if (*bufferP == NULL) return 0;
+            encoder.buffer = *bufferP;
+        }
+        encoder.index = 0;
+        encoder.first = true;
+
+        prv_write_head(&encoder, PRV_MAJOR_ARRAY, count);
+        if (!prv_encode_list(&encoder, ids, 0, size, tlvP))
+        {
+            lwm2m_free(*bufferP);
+            *bufferP = NULL;
+            return 0;
+        }
+    }
+
+    return encoder.index;
+}
+
+
+/*
+ * Decoder
+ */
+
+static bool prv_read_head(prv_reader_t * readerP,
+                          uint8_t * majorP,
+                          uint8_t * infoP,
+                          uint64_t * valueP)
+{
+    int size;
+
+    if (readerP->index >= readerP->length) return false;
+
+    *majorP = readerP->buffer[readerP->index] >> 5;
+    *infoP = readerP->buffer[readerP->index] & 0x1F;
+    readerP->index++;
+
+    if (*infoP < 24)
+    {
+        *valueP = *infoP;
+        return true;
+    }
+    switch (*infoP)
+    {
+    case 24: size = 1; break;
+    case 25: size = 2; break;
+    case 26: size = 4; break;
+    case 27: size = 8; break;
+    default:
+        // indefinite lengths are not supported
+        return false;
+    }
+    if (readerP->index + size > readerP->length) return false;
+
+    *valueP = 0;
+    while (size > 0)
+    {
+        *valueP = (*valueP << 8) | readerP->buffer[readerP->index++];
+        size--;
+    }
+    return true;
+}
+
+static bool prv_skip(prv_reader_t * readerP,
+                     int depth)
+{
+    uint8_t major;
+    uint8_t info;
+    uint64_t value;
+
+    if (depth > PRV_MAX_DEPTH) return false;
+    if (!prv_read_head(readerP, &major, &info, &value)) return false;
+
+    switch (major)
+    {
+    case PRV_MAJOR_BYTES:
+    case PRV_MAJOR_TEXT:
+        if (value > readerP->length - readerP->index) return false;
+        readerP->index += value;
+        return true;
+
+    case PRV_MAJOR_MAP:
+        value *= 2;
+        // fall through
+    case PRV_MAJOR_ARRAY:
+        while (value > 0)
+        {
+            if (!prv_skip(readerP, depth + 1)) return false;
+            value--;
+        }
+        return true;
+
+    case PRV_MAJOR_TAG:
+        return prv_skip(readerP, depth + 1);
+
+    default:
+        return true;
+    }
+}
+
+static bool prv_read_data(prv_reader_t * readerP,
+                          uint8_t expectedMajor,
+                          uint8_t ** dataP,
+                          size_t * lengthP)
+{
+    uint8_t major;
+    uint8_t info;
+    uint64_t value;
+
+    if (!prv_read_head(readerP, &major, &info, &value)) return false;
+    if (major != expectedMajor) return false;
+    if (value > readerP->length - readerP->index) return false;
+
+    *dataP = readerP->buffer + readerP->index;
+    *lengthP = (size_t)value;
+    readerP->index += value;
+    return true;
+}
+
+static double prv_half_to_double(uint16_t half)
+{
+    int exponent;
+    int mantissa;
+    double value;
+
+    exponent = (half >> 10) & 0x1F;
+    mantissa = half & 0x3FF;
+    if (exponent == 0)
+    {
+        value = ldexp(mantissa, -24);
+    }
+    else if (exponent != 31)
+    {
+        value = ldexp(mantissa + 1024, exponent - 25);
+    }
+    else
+    {
+        value = mantissa == 0 ? INFINITY : NAN;
+    }
+    return (half & 0x8000) != 0 ? -value : value;
+}
+
+// numbers are read in recordP as LWM2M_TYPE_INTEGER or LWM2M_TYPE_FLOAT
+static bool prv_read_number(prv_reader_t * readerP,
+                            lwm2m_senml_record_t * recordP)
+{
+    uint8_t major;
+    uint8_t info;
+    uint64_t value;
+
+    if (!prv_read_head(readerP, &major, &info, &value)) return false;
+
+    switch (major)
+    {
+    case PRV_MAJOR_UNSIGNED:
+        if (value > INT64_MAX) return false;
+        recordP->type = LWM2M_TYPE_INTEGER;
+        recordP->value.asInteger = (int64_t)value;
+        return true;
+
+    case PRV_MAJOR_NEGATIVE:
+        if (value > INT64_MAX) return false;
+        recordP->type = LWM2M_TYPE_INTEGER;
+        recordP->value.asInteger = -1 - (int64_t)value;
+        return true;
+
+    case PRV_MAJOR_SIMPLE:
+        recordP->type = LWM2M_TYPE_FLOAT;
+        switch (info)
+        {
+        case PRV_SIMPLE_HALF:
+            recordP->value.asFloat = prv_half_to_double((uint16_t)value);
+            return true;
+        case PRV_SIMPLE_FLOAT:
+            {
+                uint32_t bits = (uint32_t)value;
+                float shortValue;
+
+                memcpy(&shortValue, &bits, sizeof(shortValue));
+                recordP->value.asFloat = shortValue;
+            }
+            return true;
+        case PRV_SIMPLE_DOUBLE:
+            memcpy(&recordP->value.asFloat, &value, sizeof(double));
+            return true;
+        default:
+            return false;
+        }
+
+    default:
+        return false;
+    }
+}
+
+static double prv_to_double(lwm2m_senml_record_t * numberP)
+{
+    return numberP->type == LWM2M_TYPE_INTEGER ? (double)numberP->value.asInteger : numberP->value.asFloat;
+}
+
+int lwm2m_senml_cbor_parse(uint8_t * buffer,
+                           size_t length,
+                           lwm2m_senml_callback_t callback,
+                           void * userData)
+{
+    prv_reader_t reader;
+    uint8_t major;
+    uint8_t info;
+    uint64_t count;
+    uint64_t i;
+    uint8_t baseName[LWM2M_SENML_NAME_MAX_LEN];
+    size_t baseNameLen;
+    double baseTime;
+    lwm2m_senml_record_t baseValue;
+
+    reader.buffer = buffer;
+    reader.length = length;
+    reader.index = 0;
+
+    if (!prv_read_head(&reader, &major, &info, &count)) return 0;
+    if (major != PRV_MAJOR_ARRAY) return 0;
+
+    baseNameLen = 0;
+    baseTime = 0;
+    baseValue.type = LWM2M_TYPE_UNDEFINED;
+
+    for (i = 0 ; i < count ; i++)
+    {
+        lwm2m_senml_record_t record;
+        lwm2m_senml_record_t number;
+        uint8_t * nameP = NULL;
+        size_t nameLen = 0;
+        uint64_t entries;
+
+        if (!prv_read_head(&reader, &major, &info, &entries)) return 0;
+        if (major != PRV_MAJOR_MAP) return 0;
+
+        memset(&record, 0, sizeof(lwm2m_senml_record_t));
+        record.type = LWM2M_TYPE_UNDEFINED;
+
+        while (entries > 0)
+        {
+            uint64_t label;
+            int64_t key;
+
+            entries--;
+            if (!prv_read_head(&reader, &major, &info, &label)) return 0;
+            if (major == PRV_MAJOR_UNSIGNED && label <= 0xFF)
+            {
+                key = (int64_t)label;
+            }
+            else if (major == PRV_MAJOR_NEGATIVE && label <= 0xFF)
+            {
+                key = -1 - (int64_t)label;
+            }
+            else
+            {
+                // unknown label, skip the value
+                if (major == PRV_MAJOR_TEXT || major == PRV_MAJOR_BYTES)
+                {
+                    if (label > reader.length - reader.index) return 0;
+                    reader.index += label;
+                }
+                if (!prv_skip(&reader, 0)) return 0;
+                continue;
+            }
+
+            switch (key)
+            {
+            case PRV_LABEL_BASE_NAME:
+                {
+                    uint8_t * dataP;
+
+                    if (!prv_read_data(&reader, PRV_MAJOR_TEXT, &dataP, &baseNameLen)) return 0;
+                    if (baseNameLen > LWM2M_SENML_NAME_MAX_LEN) return 0;
+                    memcpy(baseName, dataP, baseNameLen);
+                }
+                break;
+            case PRV_LABEL_BASE_TIME:
+                if (!prv_read_number(&reader, &number)) return 0;
+                baseTime = prv_to_double(&number);
+                break;
+            case PRV_LABEL_BASE_VALUE:
+                if (!prv_read_number(&reader, &baseValue)) return 0;
+                break;
+            case PRV_LABEL_NAME:
+                if (!prv_read_data(&reader, PRV_MAJOR_TEXT, &nameP, &nameLen)) return 0;
+                break;
+            case PRV_LABEL_TIME:
+                if (!prv_read_number(&reader, &number)) return 0;
+                record.time = prv_to_double(&number);
+                break;
+            case PRV_LABEL_VALUE:
+                if (!prv_read_number(&reader, &record)) return 0;
+                break;
+            case PRV_LABEL_STRING_VALUE:
+                record.type = LWM2M_TYPE_STRING;
+                if (!prv_read_data(&reader, PRV_MAJOR_TEXT, &record.value.asBuffer.buffer, &record.value.asBuffer.length)) return 0;
+                break;
+            case PRV_LABEL_DATA_VALUE:
+                record.type = LWM2M_TYPE_OPAQUE;
+                if (!prv_read_data(&reader, PRV_MAJOR_BYTES, &record.value.asBuffer.buffer, &record.value.asBuffer.length)) return 0;
+                break;
+            case PRV_LABEL_BOOLEAN_VALUE:
+                if (!prv_read_head(&reader, &major, &info, &label)) return 0;
+                if (major != PRV_MAJOR_SIMPLE || (info != PRV_SIMPLE_FALSE && info != PRV_SIMPLE_TRUE)) return 0;
+                record.type = LWM2M_TYPE_BOOLEAN;
+                record.value.asBoolean = info == PRV_SIMPLE_TRUE;
+                break;
+            default:
+                if (!prv_skip(&reader, 0)) return 0;
+                break;
+            }
+        }
+
+        // resolve the base fields
+        if (baseNameLen + nameLen > LWM2M_SENML_NAME_MAX_LEN) return 0;
+        memcpy(record.name, baseName, baseNameLen);
+        if (nameLen != 0)
+        {
+            memcpy(record.name + baseNameLen, nameP, nameLen);
+        }
+        record.name[baseNameLen + nameLen] = 0;
+        record.time += baseTime;
+        if (baseValue.type != LWM2M_TYPE_UNDEFINED)
+        {
+            if (record.type == LWM2M_TYPE_INTEGER && baseValue.type == LWM2M_TYPE_INTEGER)
+            {
+                record.value.asInteger += baseValue.value.asInteger;
+            }
+            else if (record.type == LWM2M_TYPE_INTEGER || record.type == LWM2M_TYPE_FLOAT)
+            {
+                record.value.asFloat = prv_to_double(&record) + prv_to_double(&baseValue);
+                record.type = LWM2M_TYPE_FLOAT;
+            }
+        }
+
+        if (callback != NULL && 0 != callback(&record, userData)) return 0;
+    }
+
+    if (reader.index != reader.length) return 0;
+
+    return (int)count;
+}
+
+
+/*
+ * Conversion of a pack to a lwm2m_tlv_t array for objects' write callbacks,
+ * shared with the JSON content format
+ */
+
+// parse "/object/instance/resource[/instance]", return the number of ids or 0
+static int prv_parse_name(const char * name,
+                          uint16_t * ids)
+{
+    int count;
+
+    count = 0;
+    while (*name == '/' && count < PRV_MAX_DEPTH)
+    {
+        uint32_t id;
+
+        name++;
+        if (*name < '0' || *name > '9') return 0;
+        id = 0;
+        while (*name >= '0' && *name <= '9')
+        {
+            id = id * 10 + (*name - '0');
+            if (id >= LWM2M_MAX_ID) return 0;
+            name++;
+        }
+        ids[count++] = (uint16_t)id;
+    }
+    return *name == 0 ? count : 0;
+}
+
+static bool prv_set_tlv(lwm2m_senml_record_t * recordP,
+                        lwm2m_tlv_t * tlvP)
+{
+    switch (recordP->type)
+    {
+    case LWM2M_TYPE_INTEGER:
+        lwm2m_tlv_encode_int(recordP->value.asInteger, tlvP);
+        break;
+    case LWM2M_TYPE_FLOAT:
+        lwm2m_tlv_encode_float(recordP->value.asFloat, tlvP);
+        break;
+    case LWM2M_TYPE_BOOLEAN:
+        lwm2m_tlv_encode_bool(recordP->value.asBoolean, tlvP);
+        break;
+    case LWM2M_TYPE_STRING:
+    case LWM2M_TYPE_OPAQUE:
+    case LWM2M_TYPE_OBJECT_LINK:
+        // points in the request payload
+        tlvP->flags = LWM2M_TLV_FLAG_STATIC_DATA;
+        tlvP->dataType = recordP->type;
+        tlvP->value = recordP->value.asBuffer.buffer;
+        tlvP->length = recordP->value.asBuffer.length;
+        return true;
+    default:
+        return false;
+    }
+    return tlvP->length != 0;
+}
+
+static int prv_count_callback(lwm2m_senml_record_t * recordP,
+                              void * userData)
+{
+    return 0;
+}
+
+static int prv_tlv_callback(lwm2m_senml_record_t * recordP,
+                            void * userData)
+{
+    prv_tlv_builder_t * builderP = (prv_tlv_builder_t *)userData;
+    uint16_t ids[PRV_MAX_DEPTH];
+    lwm2m_tlv_t * tlvP;
+    int count;
+    int i;
+
+    count = prv_parse_name(recordP->name, ids);
+    if (count < 3) return -1;
+    if (ids[0] != builderP->uriP->objectId) return -1;
+    if (LWM2M_URI_IS_SET_INSTANCE(builderP->uriP) && ids[1] != builderP->uriP->instanceId) return -1;
+    if (LWM2M_URI_IS_SET_RESOURCE(builderP->uriP) && ids[2] != builderP->uriP->resourceId) return -1;
+
+    if (count == 3)
+    {
+        tlvP = builderP->tlvP + builderP->size;
+        builderP->size++;
+        tlvP->type = LWM2M_TYPE_RESOURCE;
+        tlvP->id = ids[2];
+        return prv_set_tlv(recordP, tlvP) ? 0 : -1;
+    }
+
+    // resource instance, grouped in a multiple resource
+    for (i = 0 ; i < builderP->size ; i++)
+    {
+        if (builderP->tlvP[i].type == LWM2M_TYPE_MULTIPLE_RESOURCE
+         && builderP->tlvP[i].id == ids[2])
+        {
+            break;
+        }
+    }
+    if (i == builderP->size)
+    {
+        tlvP = builderP->tlvP + builderP->size;
+        tlvP->value = (uint8_t *)lwm2m_tlv_new(builderP->capacity);
+        if (tlvP->value == NULL) return -1;
+        builderP->size++;
+        tlvP->type = LWM2M_TYPE_MULTIPLE_RESOURCE;
+        tlvP->id = ids[2];
+        tlvP->length = 0;
+    }
+    tlvP = builderP->tlvP + i;
+
+    i = tlvP->length;
+    tlvP->length++;
+    tlvP = (lwm2m_tlv_t *)tlvP->value + i;
+    tlvP->type = LWM2M_TYPE_RESOURCE_INSTANCE;
+    tlvP->id = ids[3];
+    return prv_set_tlv(recordP, tlvP) ? 0 : -1;
+}
+
+// lwm2m_tlv_free() returns without freeing an empty array
+static void prv_free_builder(prv_tlv_builder_t * builderP)
+{
+    int i;
+
+    for (i = 0 ; i < builderP->size ; i++)
+    {
+        lwm2m_tlv_t * tlvP = builderP->tlvP + i;
+
+        if (tlvP->type == LWM2M_TYPE_MULTIPLE_RESOURCE && tlvP->length == 0)
+        {
+            lwm2m_free(tlvP->value);
+            tlvP->flags = LWM2M_TLV_FLAG_STATIC_DATA;
+            tlvP->value = NULL;
+        }
+    }
+    if (builderP->size == 0)
+    {
+        lwm2m_free(builderP->tlvP);
+    }
+    else
+    {
+        lwm2m_tlv_free(builderP->size, builderP->tlvP);
+    }
+}
+
+int senml_parse_tlv(lwm2m_uri_t * uriP,
+                    senml_parser_t parser,
+                    int count,
+                    uint8_t * buffer,
+                    size_t length,
+                    lwm2m_tlv_t ** dataP)
+{
+    prv_tlv_builder_t builder;
+
+    *dataP = NULL;
+
+    if (count <= 0) return 0;
+
+    builder.uriP = uriP;
+    builder.size = 0;
+    builder.capacity = count;
+    builder.tlvP = lwm2m_tlv_new(builder.capacity);
+    if (builder.tlvP == NULL) return 0;
+
+    if (0 == parser(buffer, length, prv_tlv_callback, &builder))
+    {
+        prv_free_builder(&builder);
+        return 0;
+    }
+
+    *dataP = builder.tlvP;
+    return builder.size;
+}
+
+int senml_cbor_parse_tlv(lwm2m_uri_t * uriP,
+                         uint8_t * buffer,
+                         size_t length,
+                         lwm2m_tlv_t ** dataP)
+{
+    int count;
+
+    count = lwm2m_senml_cbor_parse(buffer, length, prv_count_callback, NULL);
+
+    return senml_parse_tlv(uriP, lwm2m_senml_cbor_parse, count, buffer, length, dataP);
+}
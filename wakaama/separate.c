@@ -0,0 +1,312 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - initial API and implementation
+ *
+ *******************************************************************************/
+
+/************************************************************************
+ *  Separate responses (rfc7252 section 5.2.2).
+ *
+ *  An object callback returning COAP_PENDING defers the request: an empty
+ *  ACK is sent at once and the request is kept here. When the application
+ *  calls lwm2m_resource_ready(), the request is dispatched again and the
+ *  result is sent in a confirmable response carrying the original token,
+ *  retransmitted as a transaction until the server acknowledges it.
+ *
+ *  Requests still pending after LWM2M_PENDING_TIMEOUT are answered with
+ *  5.03 Service Unavailable.
+ */
+
+#include "internals.h"
+
+#ifdef LWM2M_CLIENT_MODE
+
+struct _lwm2m_pending_
+{
+    struct _lwm2m_pending_ * next;
+    void *              sessionH;
+    uint16_t            mid;
+    coap_message_type_t type;
+    uint8_t             code;
+    bool                observe;
+    bool                has_content_type;
+    uint16_t            content_type;
+    uint8_t             accept_num;
+    uint16_t            accept[COAP_MAX_ACCEPT_NUM];
+    uint8_t             token_len;
+    uint8_t             token[COAP_TOKEN_LEN];
+    lwm2m_uri_t         uri;
+    time_t              expiry;
+    size_t              payload_len;
+    uint8_t             payload[1];
+};
+
+static void prv_remove(lwm2m_context_t * contextP,
+                       lwm2m_pending_t * pendingP)
+{
+    if (contextP->pendingList == pendingP)
+    {
+        contextP->pendingList = pendingP->next;
+    }
+    else
+    {
+        lwm2m_pending_t * parentP;
+
+        parentP = contextP->pendingList;
+        while (parentP != NULL && parentP->next != pendingP)
+        {
+            parentP = parentP->next;
+        }
+        if (parentP != NULL)
+        {
+            parentP->next = pendingP->next;
+        }
+    }
+    lwm2m_free(pendingP);
+}
+
+// true if a request on uriP is concerned by a change of targetP
+static bool prv_uri_match(lwm2m_uri_t * uriP,
+                          lwm2m_uri_t * targetP)
+{
+    if (uriP->objectId != targetP->objectId) return false;
+    if (!LWM2M_URI_IS_SET_INSTANCE(uriP) || !LWM2M_URI_IS_SET_INSTANCE(targetP)) return true;
+    if (uriP->instanceId != targetP->instanceId) return false;
+    if (!LWM2M_URI_IS_SET_RESOURCE(uriP) || !LWM2M_URI_IS_SET_RESOURCE(targetP)) return true;
+    return uriP->resourceId == targetP->resourceId;
+}
+
+static lwm2m_server_t * prv_find_peer(lwm2m_context_t * contextP,
+                                      void * sessionH)
+{
+    lwm2m_server_t * serverP;
+
+    serverP = prv_findServer(contextP, sessionH);
+#ifdef LWM2M_BOOTSTRAP
+    if (NULL == serverP)
+    {
+        serverP = utils_findBootstrapServer(contextP, sessionH);
+    }
+#endif
+    return serverP;
+}
+
+static void prv_respond(lwm2m_context_t * contextP,
+                        lwm2m_pending_t * pendingP,
+                        coap_packet_t * response)
+{
+    if (COAP_TYPE_CON == pendingP->type)
+    {
+        lwm2m_transaction_t * transacP;
+        int result;
+
+        transacP = transaction_new(COAP_TYPE_CON, response->code, NULL, NULL, response->mid, 0, NULL, ENDPOINT_SERVER, prv_find_peer(contextP, pendingP->sessionH));
+        if (NULL == transacP)
+        {
+            LOG("Separate response MID %u dropped\r\n", response->mid);
+            return;
+        }
+        memcpy(transacP->message, response, sizeof(coap_packet_t));
+        contextP->transactionList = (lwm2m_transaction_t *)LWM2M_LIST_ADD(contextP->transactionList, transacP);
+        // the message is serialized on the first transmission, retransmissions
+        // don't need the payload which is freed by the caller
+        result = transaction_send(contextP, transacP);
+        if (0 < result)
+        {
+            transaction_remove(contextP, transacP);
+        }
+        else if (0 == result)
+        {
+            coap_set_payload(transacP->message, NULL, 0);
+        }
+    }
+    else
+    {
+        (void)message_send(contextP, response, pendingP->sessionH);
+    }
+}
+
+// dispatch the request again, return false if it is still pending
+static bool prv_resume(lwm2m_context_t * contextP,
+                       lwm2m_pending_t * pendingP)
+{
+    coap_packet_t message[1];
+    coap_packet_t response[1];
+    coap_status_t result;
+    int i;
+
+    coap_init_message(message, pendingP->type, pendingP->code, pendingP->mid);
+    coap_set_header_token(message, pendingP->token, pendingP->token_len);
+    if (pendingP->observe)
+    {
+        coap_set_header_observe(message, 0);
+    }
+    if (pendingP->has_content_type)
+    {
+        coap_set_header_content_type(message, pendingP->content_type);
+    }
+    for (i = 0 ; i < pendingP->accept_num ; i++)
+    {
+        coap_set_header_accept(message, pendingP->accept[i]);
+    }
+    coap_set_payload(message, pendingP->payload, pendingP->payload_len);
+
+    coap_init_message(response, pendingP->type, COAP_205_CONTENT, contextP->nextMID);
+    coap_set_header_token(response, pendingP->token, pendingP->token_len);
+
+    result = handle_dm_request(contextP, &pendingP->uri, pendingP->sessionH, message, response);
+    if (COAP_PENDING == result)
+    {
+        lwm2m_free(response->payload);
+        return false;
+    }
+
+    if (COAP_IGNORE != result)
+    {
+        contextP->nextMID++;
+        coap_set_status_code(response, result);
+        prv_respond(contextP, pendingP, response);
+    }
+    lwm2m_free(response->payload);
+
+    return true;
+}
+
+bool separate_is_pending(lwm2m_context_t * contextP,
+                         void * sessionH,
+                         uint16_t mid)
+{
+    lwm2m_pending_t * pendingP;
+
+    for (pendingP = contextP->pendingList ; pendingP != NULL ; pendingP = pendingP->next)
+    {
+        if (pendingP->sessionH == sessionH && pendingP->mid == mid)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+coap_status_t separate_store(lwm2m_context_t * contextP,
+                             lwm2m_uri_t * uriP,
+                             void * sessionH,
+                             coap_packet_t * message)
+{
+    lwm2m_pending_t * pendingP;
+    lwm2m_pending_t * lastP;
+    int count;
+
+    count = 0;
+    for (pendingP = contextP->pendingList ; pendingP != NULL ; pendingP = pendingP->next)
+    {
+        count++;
+    }
+    if (count >= LWM2M_PENDING_MAX) return COAP_503_SERVICE_UNAVAILABLE;
+
+    pendingP = (lwm2m_pending_t *)lwm2m_malloc(sizeof(lwm2m_pending_t) + message->payload_len);
+    if (pendingP == NULL) return COAP_503_SERVICE_UNAVAILABLE;
+
+    memset(pendingP, 0, sizeof(lwm2m_pending_t));
+    pendingP->sessionH = sessionH;
+    pendingP->mid = message->mid;
+    pendingP->type = message->type;
+    pendingP->code = message->code;
+    pendingP->observe = IS_OPTION(message, COAP_OPTION_OBSERVE);
+    pendingP->has_content_type = IS_OPTION(message, COAP_OPTION_CONTENT_TYPE);
+    pendingP->content_type = message->content_type;
+    pendingP->accept_num = message->accept_num;
+    memcpy(pendingP->accept, message->accept, sizeof(pendingP->accept));
+    pendingP->token_len = message->token_len;
+    memcpy(pendingP->token, message->token, message->token_len);
+    memcpy(&pendingP->uri, uriP, sizeof(lwm2m_uri_t));
+    pendingP->expiry = lwm2m_gettime() + LWM2M_PENDING_TIMEOUT;
+    pendingP->payload_len = message->payload_len;
+    if (0 != message->payload_len)
+    {
+        memcpy(pendingP->payload, message->payload, message->payload_len);
+    }
+
+    // keep the arrival order
+    if (contextP->pendingList == NULL)
+    {
+        contextP->pendingList = pendingP;
+    }
+    else
+    {
+        for (lastP = contextP->pendingList ; lastP->next != NULL ; lastP = lastP->next);
+        lastP->next = pendingP;
+    }
+
+    LOG("Request MID %u pending\r\n", message->mid);
+    return COAP_PENDING;
+}
+
+void separate_step(lwm2m_context_t * contextP,
+                   time_t currentTime,
+                   time_t * timeoutP)
+{
+    lwm2m_pending_t * pendingP;
+
+    pendingP = contextP->pendingList;
+    while (pendingP != NULL)
+    {
+        lwm2m_pending_t * nextP = pendingP->next;
+
+        if (pendingP->expiry <= currentTime)
+        {
+            coap_packet_t response[1];
+
+            LOG("Request MID %u timed out\r\n", pendingP->mid);
+            coap_init_message(response, pendingP->type, COAP_503_SERVICE_UNAVAILABLE, contextP->nextMID++);
+            coap_set_header_token(response, pendingP->token, pendingP->token_len);
+            prv_respond(contextP, pendingP, response);
+            prv_remove(contextP, pendingP);
+        }
+        else if (*timeoutP > pendingP->expiry - currentTime)
+        {
+            *timeoutP = pendingP->expiry - currentTime;
+        }
+        pendingP = nextP;
+    }
+}
+
+void separate_free_all(lwm2m_context_t * contextP)
+{
+    while (contextP->pendingList != NULL)
+    {
+        prv_remove(contextP, contextP->pendingList);
+    }
+}
+
+void lwm2m_resource_ready(lwm2m_context_t * contextP,
+                          lwm2m_uri_t * uriP)
+{
+    lwm2m_pending_t * pendingP;
+
+    pendingP = contextP->pendingList;
+    while (pendingP != NULL)
+    {
+        lwm2m_pending_t * nextP = pendingP->next;
+
+        if (prv_uri_match(&pendingP->uri, uriP)
+         && prv_resume(contextP, pendingP))
+        {
+            prv_remove(contextP, pendingP);
+        }
+        pendingP = nextP;
+    }
+}
+
+#endif
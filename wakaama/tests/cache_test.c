@@ -0,0 +1,284 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - host tests
+ *
+ *******************************************************************************/
+
+/*
+ * Values cache of the server, see cache.c: reads answered from the cache,
+ * Max-Age, invalidation by writes and ordering of the notifications.
+ */
+
+#include "host.h"
+
+static int sent;
+static int received;
+static int receivedStatus;
+static char receivedValue[64];
+
+static uint8_t prv_send(void * sessionH,
+                        uint8_t * buffer,
+                        size_t length,
+                        void * userData)
+{
+    sent++;
+    return COAP_NO_ERROR;
+}
+
+static void prv_result(uint16_t clientID,
+                       lwm2m_uri_t * uriP,
+                       int status,
+                       uint8_t * data,
+                       int dataLength,
+                       void * userData)
+{
+    received++;
+    receivedStatus = status;
+    memcpy(receivedValue, data, dataLength);
+    receivedValue[dataLength] = 0;
+}
+
+static lwm2m_uri_t prv_uri(int objectId,
+                           int instanceId,
+                           int resourceId)
+{
+    lwm2m_uri_t uri;
+
+    memset(&uri, 0, sizeof(uri));
+    uri.flag = LWM2M_URI_FLAG_OBJECT_ID;
+    uri.objectId = objectId;
+    if (instanceId >= 0)
+    {
+        uri.flag |= LWM2M_URI_FLAG_INSTANCE_ID;
+        uri.instanceId = instanceId;
+    }
+    if (resourceId >= 0)
+    {
+        uri.flag |= LWM2M_URI_FLAG_RESOURCE_ID;
+        uri.resourceId = resourceId;
+    }
+    return uri;
+}
+
+static void prv_register(lwm2m_context_t * contextP)
+{
+    coap_packet_t message;
+    coap_packet_t response;
+    lwm2m_uri_t uri;
+    multi_option_t query;
+    const char * objects = "</3/0>,</3303/0>,</3303/1>";
+
+    memset(&message, 0, sizeof(message));
+    memset(&response, 0, sizeof(response));
+    memset(&uri, 0, sizeof(uri));
+    message.code = COAP_POST;
+    message.payload = (uint8_t *)objects;
+    message.payload_len = strlen(objects);
+    query.next = NULL;
+    query.data = (uint8_t *)"ep=a";
+    query.len = 4;
+    query.is_static = 1;
+    message.uri_query = &query;
+
+    HOST_CHECK(handle_registration_request(contextP, &uri, (void *)1, &message, &response) == COAP_201_CREATED);
+    coap_free_header(&response);
+}
+
+static lwm2m_transaction_t * prv_lastTransaction(lwm2m_context_t * contextP)
+{
+    lwm2m_transaction_t * transacP = contextP->transactionList;
+
+    HOST_CHECK(transacP != NULL);
+    while (transacP->next != NULL) transacP = transacP->next;
+    return transacP;
+}
+
+// answers the last request sent, maxAge < 0 leaves the option out
+static void prv_answer(lwm2m_context_t * contextP,
+                       uint8_t code,
+                       const char * value,
+                       int maxAge,
+                       int observe)
+{
+    lwm2m_transaction_t * transacP = prv_lastTransaction(contextP);
+    coap_packet_t packet;
+
+    memset(&packet, 0, sizeof(packet));
+    packet.code = code;
+    if (value != NULL)
+    {
+        packet.payload = (uint8_t *)value;
+        packet.payload_len = strlen(value);
+    }
+    if (maxAge >= 0) coap_set_header_max_age(&packet, maxAge);
+    if (observe >= 0) coap_set_header_observe(&packet, observe);
+
+    transacP->callback(transacP, &packet);
+    transaction_remove(contextP, transacP);
+}
+
+static void prv_notify(lwm2m_context_t * contextP,
+                       const uint8_t * token,
+                       uint8_t code,
+                       const char * value,
+                       uint32_t observe)
+{
+    coap_packet_t message;
+    coap_packet_t response;
+
+    coap_init_message(&message, COAP_TYPE_NON, code, 0);
+    coap_set_header_token(&message, token, 4);
+    coap_set_header_observe(&message, observe);
+    if (value != NULL) coap_set_payload(&message, value, strlen(value));
+
+    HOST_CHECK(handle_observe_notify(contextP, (void *)1, &message, &response));
+}
+
+// returns true if the value was read from the cache
+static bool prv_readCached(lwm2m_context_t * contextP,
+                           lwm2m_uri_t * uriP,
+                           uint32_t maxAge)
+{
+    int before = sent;
+
+    received = 0;
+    HOST_CHECK(lwm2m_dm_read_cached(contextP, 0, uriP, maxAge, prv_result, NULL) == COAP_NO_ERROR);
+    if (sent != before)
+    {
+        HOST_CHECK(received == 0);
+        return false;
+    }
+    HOST_CHECK(received == 1 && receivedStatus == COAP_205_CONTENT);
+    return true;
+}
+
+static void prv_testReads(lwm2m_context_t * contextP)
+{
+    lwm2m_uri_t temperature = prv_uri(3303, 0, 5700);
+    lwm2m_uri_t other = prv_uri(3303, 1, 5700);
+    lwm2m_uri_t instance = prv_uri(3303, 0, -1);
+    int i;
+    int count;
+    lwm2m_cache_entry_t * entryP;
+
+    HOST_CHECK(!prv_readCached(contextP, &temperature, 30));
+    prv_answer(contextP, COAP_205_CONTENT, "21.5", 20, -1);
+    HOST_CHECK(received == 1 && !strcmp(receivedValue, "21.5"));
+    HOST_CHECK(prv_readCached(contextP, &temperature, 30) && !strcmp(receivedValue, "21.5"));
+
+    // older than the caller accepts
+    host_now += 10;
+    HOST_CHECK(!prv_readCached(contextP, &temperature, 5));
+    prv_answer(contextP, COAP_205_CONTENT, "22.0", 20, -1);
+    HOST_CHECK(prv_readCached(contextP, &temperature, 5) && !strcmp(receivedValue, "22.0"));
+
+    // Max-Age of 0, then the default of 60 s
+    host_now += 20;
+    HOST_CHECK(!prv_readCached(contextP, &temperature, 1000));
+    prv_answer(contextP, COAP_205_CONTENT, "23.0", 0, -1);
+    HOST_CHECK(!prv_readCached(contextP, &temperature, 1000));
+    prv_answer(contextP, COAP_205_CONTENT, "23.5", -1, -1);
+    host_now += 59;
+    HOST_CHECK(prv_readCached(contextP, &temperature, 1000) && !strcmp(receivedValue, "23.5"));
+
+    // errors are not stored
+    HOST_CHECK(!prv_readCached(contextP, &other, 100));
+    prv_answer(contextP, COAP_404_NOT_FOUND, NULL, -1, -1);
+    HOST_CHECK(!prv_readCached(contextP, &other, 100));
+    prv_answer(contextP, COAP_205_CONTENT, "1", -1, -1);
+
+    // a write on the instance drops its resources only
+    HOST_CHECK(lwm2m_dm_write(contextP, 0, &instance, (uint8_t *)"x", 1, prv_result, NULL) == COAP_NO_ERROR);
+    prv_answer(contextP, COAP_204_CHANGED, NULL, -1, -1);
+    HOST_CHECK(prv_readCached(contextP, &other, 100));
+    HOST_CHECK(!prv_readCached(contextP, &temperature, 100));
+    prv_answer(contextP, COAP_205_CONTENT, "24", -1, -1);
+
+    // a failed write keeps them
+    HOST_CHECK(lwm2m_dm_write(contextP, 0, &temperature, (uint8_t *)"x", 1, prv_result, NULL) == COAP_NO_ERROR);
+    prv_answer(contextP, COAP_405_METHOD_NOT_ALLOWED, NULL, -1, -1);
+    HOST_CHECK(prv_readCached(contextP, &temperature, 100));
+
+    // least recently used values go first
+    for (i = 0 ; i < LWM2M_CACHE_MAX_ENTRIES + 2 ; i++)
+    {
+        lwm2m_uri_t uri = prv_uri(3, 0, i);
+
+        HOST_CHECK(lwm2m_dm_read(contextP, 0, &uri, prv_result, NULL) == COAP_NO_ERROR);
+        prv_answer(contextP, COAP_205_CONTENT, "v", -1, -1);
+        HOST_CHECK(prv_readCached(contextP, &temperature, 100));
+    }
+    count = 0;
+    for (entryP = contextP->clientList->cacheList ; entryP != NULL ; entryP = entryP->next) count++;
+    HOST_CHECK(count == LWM2M_CACHE_MAX_ENTRIES);
+    HOST_CHECK(prv_readCached(contextP, &temperature, 100));
+    {
+        lwm2m_uri_t first = prv_uri(3, 0, 0);
+
+        HOST_CHECK(!prv_readCached(contextP, &first, 100));
+        prv_answer(contextP, COAP_205_CONTENT, "v", -1, -1);
+    }
+}
+
+static void prv_testNotifications(lwm2m_context_t * contextP)
+{
+    lwm2m_uri_t battery = prv_uri(3, 0, 9);
+    uint8_t token[4];
+    const uint8_t * tokenP;
+
+    HOST_CHECK(lwm2m_observe(contextP, 0, &battery, prv_result, NULL) == COAP_NO_ERROR);
+    HOST_CHECK(coap_get_header_token(prv_lastTransaction(contextP)->message, &tokenP) == 4);
+    memcpy(token, tokenP, 4);
+    prv_answer(contextP, COAP_205_CONTENT, "50", -1, 5);
+    HOST_CHECK(prv_readCached(contextP, &battery, 100) && !strcmp(receivedValue, "50"));
+
+    prv_notify(contextP, token, COAP_205_CONTENT, "49", 7);
+    HOST_CHECK(prv_readCached(contextP, &battery, 100) && !strcmp(receivedValue, "49"));
+
+    // late notification
+    prv_notify(contextP, token, COAP_205_CONTENT, "51", 6);
+    HOST_CHECK(prv_readCached(contextP, &battery, 100) && !strcmp(receivedValue, "49"));
+
+    // the 24-bit Observe value wraps around
+    prv_notify(contextP, token, COAP_205_CONTENT, "48", 0xFFFFF0);
+    HOST_CHECK(prv_readCached(contextP, &battery, 100) && !strcmp(receivedValue, "49"));
+    host_now += 129;
+    prv_notify(contextP, token, COAP_205_CONTENT, "48", 0xFFFFF0);
+    HOST_CHECK(prv_readCached(contextP, &battery, 100) && !strcmp(receivedValue, "48"));
+    prv_notify(contextP, token, COAP_205_CONTENT, "47", 3);
+    HOST_CHECK(prv_readCached(contextP, &battery, 100) && !strcmp(receivedValue, "47"));
+
+    // an error drops the value
+    prv_notify(contextP, token, COAP_404_NOT_FOUND, NULL, 4);
+    HOST_CHECK(!prv_readCached(contextP, &battery, 100));
+    prv_answer(contextP, COAP_205_CONTENT, "46", -1, -1);
+}
+
+int main(void)
+{
+    lwm2m_context_t * contextP;
+
+    contextP = lwm2m_init(NULL, prv_send, NULL);
+    HOST_CHECK(contextP != NULL);
+    prv_register(contextP);
+
+    prv_testReads(contextP);
+    prv_testNotifications(contextP);
+
+    lwm2m_close(contextP);
+    HOST_CHECK(host_live_blocks == 0);
+
+    printf("cache_test: ok\n");
+    return 0;
+}
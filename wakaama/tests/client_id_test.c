@@ -0,0 +1,137 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - host tests
+ *
+ *******************************************************************************/
+
+/*
+ * IDs of the registered clients, see lifetime_new_id(): every ID below
+ * LWM2M_MAX_ID is given once, the registrations beyond are rejected with
+ * 5.03 without touching the registered clients, and the IDs freed by a
+ * deregistration are given again, the lowest first.
+ */
+
+#include "host.h"
+
+static uint8_t prv_send(void * sessionH,
+                        uint8_t * buffer,
+                        size_t length,
+                        void * userData)
+{
+    return COAP_NO_ERROR;
+}
+
+// objectId < 0 targets /rd
+static coap_status_t prv_request(lwm2m_context_t * contextP,
+                                 coap_method_t method,
+                                 int objectId,
+                                 const char * query)
+{
+    coap_packet_t message;
+    coap_packet_t response;
+    lwm2m_uri_t uri;
+    multi_option_t option;
+    const char * objects = "</3/0>";
+    coap_status_t result;
+
+    memset(&message, 0, sizeof(message));
+    memset(&response, 0, sizeof(response));
+    memset(&uri, 0, sizeof(uri));
+    message.code = method;
+    if (method == COAP_POST)
+    {
+        message.payload = (uint8_t *)objects;
+        message.payload_len = strlen(objects);
+    }
+    if (objectId >= 0)
+    {
+        uri.flag = LWM2M_URI_FLAG_OBJECT_ID;
+        uri.objectId = objectId;
+    }
+    if (query != NULL)
+    {
+        option.next = NULL;
+        option.data = (uint8_t *)query;
+        option.len = strlen(query);
+        option.is_static = 1;
+        message.uri_query = &option;
+    }
+
+    result = handle_registration_request(contextP, &uri, NULL, &message, &response);
+    coap_free_header(&response);
+
+    return result;
+}
+
+static void prv_checkName(lwm2m_context_t * contextP,
+                          uint16_t clientID,
+                          const char * name)
+{
+    lwm2m_client_t * clientP = lifetime_get_client(contextP, clientID);
+
+    if (clientP == NULL || clientP->internalID != clientID || strcmp(clientP->name, name) != 0)
+    {
+        fprintf(stderr, "client %u is not %s\n", clientID, name);
+        exit(1);
+    }
+}
+
+int main(void)
+{
+    lwm2m_context_t * contextP;
+    lwm2m_client_t * clientP;
+    char query[32];
+    long count;
+    long i;
+
+    contextP = lwm2m_init(NULL, prv_send, NULL);
+    HOST_CHECK(contextP != NULL);
+
+    for (i = 0 ; i < LWM2M_MAX_ID ; i++)
+    {
+        snprintf(query, sizeof(query), "ep=n%ld", i);
+        HOST_CHECK(prv_request(contextP, COAP_POST, -1, query) == COAP_201_CREATED);
+    }
+    HOST_CHECK(prv_request(contextP, COAP_POST, -1, "ep=extra") == COAP_503_SERVICE_UNAVAILABLE);
+    // a client registering again keeps its ID
+    HOST_CHECK(prv_request(contextP, COAP_POST, -1, "ep=n0") == COAP_201_CREATED);
+    prv_checkName(contextP, 0, "n0");
+    prv_checkName(contextP, LWM2M_MAX_ID - 1, "n65534");
+
+    count = 0;
+    for (clientP = contextP->clientList ; clientP != NULL ; clientP = clientP->next)
+    {
+        HOST_CHECK(clientP->internalID == count);
+        count++;
+    }
+    HOST_CHECK(count == LWM2M_MAX_ID && contextP->lifetimeCount == LWM2M_MAX_ID);
+
+    // the lowest free ID first
+    HOST_CHECK(prv_request(contextP, COAP_DELETE, 100, NULL) == COAP_202_DELETED);
+    HOST_CHECK(prv_request(contextP, COAP_DELETE, 7, NULL) == COAP_202_DELETED);
+    HOST_CHECK(lifetime_get_client(contextP, 7) == NULL);
+    HOST_CHECK(prv_request(contextP, COAP_POST, -1, "ep=first") == COAP_201_CREATED);
+    HOST_CHECK(prv_request(contextP, COAP_POST, -1, "ep=second") == COAP_201_CREATED);
+    HOST_CHECK(prv_request(contextP, COAP_POST, -1, "ep=third") == COAP_503_SERVICE_UNAVAILABLE);
+    prv_checkName(contextP, 7, "first");
+    prv_checkName(contextP, 100, "second");
+    prv_checkName(contextP, 8, "n8");
+    HOST_CHECK(prv_request(contextP, COAP_PUT, 7, "lt=100") == COAP_204_CHANGED);
+
+    lwm2m_close(contextP);
+    HOST_CHECK(host_live_blocks == 0);
+
+    printf("client_id_test: ok\n");
+    return 0;
+}
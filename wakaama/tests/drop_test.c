@@ -0,0 +1,230 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - host tests
+ *
+ *******************************************************************************/
+
+/*
+ * Clients freed with requests in flight, see transaction_remove_peer():
+ * a client deregistering and a client whose lifetime expires while a read,
+ * an observe and a group read are sent to them. Their results are reported
+ * as 5.03 before the client is freed, and the late responses and the
+ * retransmissions must not touch the freed client (built with SANITIZE=1).
+ */
+
+#include "host.h"
+
+#define DROP_QUEUE  64
+
+typedef struct
+{
+    void *   sessionH;
+    uint16_t length;
+    uint8_t  buffer[128];
+} datagram_t;
+
+static lwm2m_context_t * contextP;
+static datagram_t queue[DROP_QUEUE];
+static int queueLength;
+static long unavailable;
+static long finished;
+
+static uint8_t prv_send(void * sessionH,
+                        uint8_t * buffer,
+                        size_t length,
+                        void * userData)
+{
+    datagram_t * datagramP;
+
+    HOST_CHECK(length <= sizeof(datagramP->buffer) && queueLength < DROP_QUEUE);
+    datagramP = queue + queueLength++;
+    datagramP->sessionH = sessionH;
+    datagramP->length = length;
+    memcpy(datagramP->buffer, buffer, length);
+
+    return COAP_NO_ERROR;
+}
+
+// answers the queued requests with piggybacked responses
+static void prv_deliver(void)
+{
+    datagram_t pending[DROP_QUEUE];
+    int count = queueLength;
+    int i;
+
+    memcpy(pending, queue, count * sizeof(datagram_t));
+    queueLength = 0;
+    for (i = 0 ; i < count ; i++)
+    {
+        coap_packet_t request;
+        coap_packet_t response;
+        uint8_t buffer[128];
+        size_t length;
+
+        if (coap_parse_message(&request, pending[i].buffer, pending[i].length) != NO_ERROR) continue;
+        if (request.type != COAP_TYPE_CON)
+        {
+            coap_free_header(&request);
+            continue;
+        }
+        coap_init_message(&response, COAP_TYPE_ACK, COAP_205_CONTENT, request.mid);
+        coap_set_header_token(&response, request.token, request.token_len);
+        if (IS_OPTION(&request, COAP_OPTION_OBSERVE)) coap_set_header_observe(&response, 1);
+        coap_set_payload(&response, "1", 1);
+        length = coap_serialize_message(&response, buffer);
+        coap_free_header(&request);
+
+        lwm2m_handle_packet(contextP, buffer, length, pending[i].sessionH);
+    }
+}
+
+static void prv_result(uint16_t clientID,
+                       lwm2m_uri_t * uriP,
+                       int status,
+                       uint8_t * data,
+                       int dataLength,
+                       void * userData)
+{
+    if (uriP == NULL) finished++;
+    else if (status == COAP_503_SERVICE_UNAVAILABLE) unavailable++;
+}
+
+static uint16_t prv_register(const char * name,
+                             const char * lifetime,
+                             intptr_t session)
+{
+    coap_packet_t message;
+    coap_packet_t response;
+    lwm2m_uri_t uri;
+    multi_option_t query[2];
+    lwm2m_client_t * clientP;
+    const char * objects = "</3/0>";
+
+    memset(&message, 0, sizeof(message));
+    memset(&response, 0, sizeof(response));
+    memset(&uri, 0, sizeof(uri));
+    message.code = COAP_POST;
+    message.payload = (uint8_t *)objects;
+    message.payload_len = strlen(objects);
+    query[0].next = query + 1;
+    query[0].data = (uint8_t *)name;
+    query[0].len = strlen(name);
+    query[0].is_static = 1;
+    query[1].next = NULL;
+    query[1].data = (uint8_t *)lifetime;
+    query[1].len = strlen(lifetime);
+    query[1].is_static = 1;
+    message.uri_query = query;
+
+    HOST_CHECK(handle_registration_request(contextP, &uri, (void *)session, &message, &response) == COAP_201_CREATED);
+    coap_free_header(&response);
+
+    for (clientP = contextP->clientList ; clientP->sessionH != (void *)session ; clientP = clientP->next);
+    return clientP->internalID;
+}
+
+static void prv_deregister(uint16_t clientID)
+{
+    coap_packet_t message;
+    coap_packet_t response;
+    lwm2m_uri_t uri;
+
+    memset(&message, 0, sizeof(message));
+    memset(&response, 0, sizeof(response));
+    memset(&uri, 0, sizeof(uri));
+    message.code = COAP_DELETE;
+    uri.flag = LWM2M_URI_FLAG_OBJECT_ID;
+    uri.objectId = clientID;
+
+    HOST_CHECK(handle_registration_request(contextP, &uri, NULL, &message, &response) == COAP_202_DELETED);
+    coap_free_header(&response);
+}
+
+// a read, an observe and a group read of both clients in flight
+static void prv_sendRequests(uint16_t clientID,
+                             uint16_t otherID)
+{
+    uint16_t clientIDs[2];
+    lwm2m_uri_t uri;
+
+    memset(&uri, 0, sizeof(uri));
+    uri.flag = LWM2M_URI_FLAG_OBJECT_ID | LWM2M_URI_FLAG_INSTANCE_ID | LWM2M_URI_FLAG_RESOURCE_ID;
+    uri.objectId = 3;
+    uri.instanceId = 0;
+    uri.resourceId = 13;
+    clientIDs[0] = clientID;
+    clientIDs[1] = otherID;
+
+    unavailable = 0;
+    finished = 0;
+    HOST_CHECK(lwm2m_dm_read(contextP, clientID, &uri, prv_result, NULL) == COAP_NO_ERROR);
+    uri.resourceId = 9;
+    HOST_CHECK(lwm2m_observe(contextP, clientID, &uri, prv_result, NULL) == COAP_NO_ERROR);
+    HOST_CHECK(lwm2m_dm_group_read(contextP, clientIDs, 2, &uri, prv_result, NULL) == COAP_NO_ERROR);
+    HOST_CHECK(queueLength == 2);
+}
+
+// the late responses are ignored and the retransmissions stop
+static void prv_checkDropped(void)
+{
+    lwm2m_transaction_t * transacP;
+    int i;
+
+    HOST_CHECK(unavailable == 3);
+    prv_deliver();
+    HOST_CHECK(finished == 1);
+    for (i = 0 ; i < 10 ; i++)
+    {
+        time_t timeout = 10;
+
+        host_now += 10;
+        host_offset_ms += 10000;
+        HOST_CHECK(lwm2m_step(contextP, &timeout) == 0);
+    }
+    HOST_CHECK(unavailable == 3);
+    for (transacP = contextP->transactionList ; transacP != NULL ; transacP = transacP->next)
+    {
+        HOST_CHECK(transacP->peerType != ENDPOINT_CLIENT);
+    }
+    queueLength = 0;
+}
+
+int main(void)
+{
+    uint16_t firstID;
+    uint16_t secondID;
+    time_t timeout = 10;
+
+    contextP = lwm2m_init(NULL, prv_send, NULL);
+    HOST_CHECK(contextP != NULL);
+    firstID = prv_register("ep=first", "lt=86400", 1);
+    secondID = prv_register("ep=second", "lt=86400", 2);
+
+    prv_sendRequests(firstID, secondID);
+    prv_deregister(firstID);
+    prv_checkDropped();
+
+    firstID = prv_register("ep=expiring", "lt=60", 3);
+    prv_sendRequests(firstID, secondID);
+    host_now += 61;
+    HOST_CHECK(lwm2m_step(contextP, &timeout) == 0);
+    HOST_CHECK(contextP->clientList->internalID == secondID && contextP->clientList->next == NULL);
+    prv_checkDropped();
+
+    lwm2m_close(contextP);
+    HOST_CHECK(host_live_blocks == 0);
+
+    printf("drop_test: ok\n");
+    return 0;
+}
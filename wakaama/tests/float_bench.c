@@ -0,0 +1,338 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - host tests
+ *
+ *******************************************************************************/
+
+/*
+ * Plain text floats against the conversions they replaced, kept below as
+ * prv_oldFloatToText() and prv_oldTextToFloat().
+ *
+ * Times lwm2m_float64ToPlainText(), utils_floatToText() and
+ * lwm2m_PlainTextToFloat64() on sensor readings with one to four decimals
+ * and on doubles spread over the int64_t range, and counts the values
+ * which do not read back exactly.
+ */
+
+#include "host.h"
+
+#include <float.h>
+
+#define BENCH_VALUES    200000
+#define OLD_STR_LENGTH  32
+#define OLD_PRECISION   16
+
+static size_t prv_oldIntToText(int64_t data,
+                               uint8_t * string,
+                               size_t length)
+{
+    int index;
+    bool minus;
+
+    if (data < 0)
+    {
+        minus = true;
+        data = 0 - data;
+    }
+    else
+    {
+        minus = false;
+    }
+
+    index = length - 1;
+    do
+    {
+        string[index] = '0' + data%10;
+        data /= 10;
+        index --;
+    } while (index >= 0 && data > 0);
+
+    if (data > 0) return 0;
+
+    if (minus == true)
+    {
+        if (index == 0) return 0;
+        string[index] = '-';
+    }
+    else
+    {
+        index++;
+    }
+
+    return length - index;
+}
+
+static size_t prv_oldFloatToText(double data,
+                                 uint8_t * string,
+                                 size_t length)
+{
+    uint8_t intString[OLD_STR_LENGTH];
+    size_t intLength;
+    uint8_t decString[OLD_STR_LENGTH];
+    size_t decLength;
+    size_t signLength;
+    int64_t intPart;
+    double decPart;
+    int i;
+
+    if (!(data > (double)INT64_MIN && data < (double)INT64_MAX)) return 0;
+
+    intPart = (int64_t)data;
+    decPart = data - intPart;
+    if (decPart < 0)
+    {
+        decPart = 1 - decPart;
+    }
+    else
+    {
+        decPart = 1 + decPart;
+    }
+
+    if (decPart <= 1 + FLT_EPSILON)
+    {
+        intLength = prv_oldIntToText(intPart, intString, OLD_STR_LENGTH);
+        if (intLength == 0 || intLength > length) return 0;
+        memcpy(string, intString + OLD_STR_LENGTH - intLength, intLength);
+        return intLength;
+    }
+
+    intLength = prv_oldIntToText(intPart, intString, OLD_STR_LENGTH);
+    if (intLength == 0) return 0;
+    signLength = (data < 0 && intPart == 0) ? 1 : 0;
+
+    i = 0;
+    do
+    {
+        decPart *= 10;
+        i++;
+    } while ((decPart - (int64_t)decPart > 0)
+          && (i < OLD_PRECISION));
+
+    decLength = prv_oldIntToText(decPart, decString, OLD_STR_LENGTH);
+    if (decLength <= 1) return 0;
+
+    if (signLength + intLength + decLength > length) return 0;
+
+    if (signLength != 0)
+    {
+        string[0] = '-';
+    }
+    memcpy(string + signLength, intString + OLD_STR_LENGTH - intLength, intLength);
+    string[signLength + intLength] = '.';
+    memcpy(string + signLength + intLength + 1, decString + OLD_STR_LENGTH - decLength + 1, decLength - 1);
+
+    return signLength + intLength + decLength;
+}
+
+// the former lwm2m_float64ToPlainText()
+static size_t prv_oldFloatToPlainText(double data,
+                                      uint8_t ** bufferP)
+{
+    uint8_t string[OLD_STR_LENGTH * 2];
+    size_t length;
+
+    length = prv_oldFloatToText(data, string, sizeof(string));
+    if (length == 0) return 0;
+
+    *bufferP = (uint8_t *)lwm2m_malloc(length);
+    if (NULL == *bufferP) return 0;
+
+    memcpy(*bufferP, string, length);
+
+    return length;
+}
+
+static int prv_oldTextToFloat(uint8_t * buffer,
+                              int length,
+                              double * dataP)
+{
+    double result;
+    int sign;
+    int i;
+
+    if (0 == length) return 0;
+
+    if (buffer[0] == '-')
+    {
+        sign = -1;
+        i = 1;
+    }
+    else
+    {
+        sign = 1;
+        i = 0;
+    }
+
+    result = 0;
+    while (i < length && buffer[i] != '.')
+    {
+        if ('0' <= buffer[i] && buffer[i] <= '9')
+        {
+            if (result > (DBL_MAX / 10)) return 0;
+            result *= 10;
+            result += (buffer[i] - '0');
+        }
+        else
+        {
+            return 0;
+        }
+        i++;
+    }
+    if (buffer[i] == '.')
+    {
+        double dec;
+
+        i++;
+        if (i == length) return 0;
+
+        dec = 0.1;
+        while (i < length)
+        {
+            if ('0' <= buffer[i] && buffer[i] <= '9')
+            {
+                if (result > (DBL_MAX - 1)) return 0;
+                result += (buffer[i] - '0') * dec;
+                dec /= 10;
+            }
+            else
+            {
+                return 0;
+            }
+            i++;
+        }
+    }
+
+    *dataP = result * sign;
+    return 1;
+}
+
+typedef size_t (* write_t)(double data, uint8_t * string, size_t length);
+typedef size_t (* write_alloc_t)(double data, uint8_t ** bufferP);
+typedef int (* read_t)(uint8_t * buffer, int length, double * dataP);
+
+static volatile size_t sink;
+
+static double prv_timeWrite(write_t writeFunc,
+                            const double * values)
+{
+    uint8_t text[64];
+    double start;
+    int i;
+
+    start = host_clock_ns();
+    for (i = 0 ; i < BENCH_VALUES ; i++)
+    {
+        sink += writeFunc(values[i], text, sizeof(text));
+    }
+    return (host_clock_ns() - start) / BENCH_VALUES;
+}
+
+static double prv_timeWriteAlloc(write_alloc_t writeFunc,
+                                 const double * values)
+{
+    double start;
+    int i;
+
+    start = host_clock_ns();
+    for (i = 0 ; i < BENCH_VALUES ; i++)
+    {
+        uint8_t * buffer = NULL;
+
+        sink += writeFunc(values[i], &buffer);
+        lwm2m_free(buffer);
+    }
+    return (host_clock_ns() - start) / BENCH_VALUES;
+}
+
+// texts of the values written by writeFunc, and the count of inexact round trips
+static double prv_timeRead(write_t writeFunc,
+                           read_t readFunc,
+                           const double * values,
+                           long * inexactP)
+{
+    static uint8_t texts[BENCH_VALUES][32];
+    static size_t lengths[BENCH_VALUES];
+    double start;
+    double duration;
+    int i;
+
+    for (i = 0 ; i < BENCH_VALUES ; i++)
+    {
+        lengths[i] = writeFunc(values[i], texts[i], sizeof(texts[i]));
+    }
+    start = host_clock_ns();
+    for (i = 0 ; i < BENCH_VALUES ; i++)
+    {
+        double result;
+
+        sink += readFunc(texts[i], lengths[i], &result);
+    }
+    duration = (host_clock_ns() - start) / BENCH_VALUES;
+
+    *inexactP = 0;
+    for (i = 0 ; i < BENCH_VALUES ; i++)
+    {
+        double result;
+
+        if (lengths[i] == 0 || readFunc(texts[i], lengths[i], &result) != 1 || result != values[i]) (*inexactP)++;
+    }
+    return duration;
+}
+
+static void prv_run(const char * name,
+                    const double * values)
+{
+    long oldInexact;
+    long newInexact;
+    double oldRead;
+    double newRead;
+
+    printf("%s:\n", name);
+    printf("  lwm2m_float64ToPlainText() %6.1f ns, before %6.1f ns\n",
+           prv_timeWriteAlloc(lwm2m_float64ToPlainText, values), prv_timeWriteAlloc(prv_oldFloatToPlainText, values));
+    printf("  utils_floatToText()        %6.1f ns, before %6.1f ns\n",
+           prv_timeWrite(utils_floatToText, values), prv_timeWrite(prv_oldFloatToText, values));
+    newRead = prv_timeRead(utils_floatToText, lwm2m_PlainTextToFloat64, values, &newInexact);
+    oldRead = prv_timeRead(prv_oldFloatToText, prv_oldTextToFloat, values, &oldInexact);
+    printf("  lwm2m_PlainTextToFloat64() %6.1f ns, before %6.1f ns\n", newRead, oldRead);
+    printf("  not read back exactly      %6ld, before %6ld of %d\n", newInexact, oldInexact, BENCH_VALUES);
+}
+
+int main(void)
+{
+    static const double scales[] = { 10, 100, 1000, 10000 };
+    double * values;
+    int i;
+
+    values = malloc(BENCH_VALUES * sizeof(double));
+    HOST_CHECK(values != NULL);
+
+    srand(1);
+    for (i = 0 ; i < BENCH_VALUES ; i++)
+    {
+        values[i] = (rand() % 200001 - 100000) / scales[i % 4];
+    }
+    prv_run("readings with 1 to 4 decimals", values);
+
+    for (i = 0 ; i < BENCH_VALUES ; i++)
+    {
+        values[i] = ((double)rand() / RAND_MAX - 0.5) * 1e18;
+    }
+    prv_run("doubles within the int64_t range", values);
+
+    free(values);
+    HOST_CHECK(host_live_blocks == 0);
+
+    return 0;
+}
@@ -0,0 +1,184 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - host tests
+ *
+ *******************************************************************************/
+
+/*
+ * Plain text floats, see utils_floatToText() and lwm2m_PlainTextToFloat64().
+ *
+ * Every finite double must read back with the same bits, the sign of -0.0
+ * included, with at most 17 significant digits and the same value for
+ * strtod(). Checked on the special values, then on FLOAT_VALUES random
+ * bit patterns and as many sensor-like decimals.
+ */
+
+#include "host.h"
+
+#include <float.h>
+#include <math.h>
+
+#define FLOAT_VALUES    2000000
+
+static uint64_t randomState = 88172645463325252ULL;
+
+static uint64_t prv_random(void)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 7;
+    randomState ^= randomState << 17;
+    return randomState;
+}
+
+static double prv_fromBits(uint64_t bits)
+{
+    double value;
+
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void prv_fail(double value,
+                     const char * text,
+                     size_t length,
+                     const char * reason)
+{
+    fprintf(stderr, "%.17g written as \"%.*s\": %s\n", value, (int)length, text, reason);
+    exit(1);
+}
+
+// significant digits of the text, without the zeros of the fixed notation
+static int prv_digits(const uint8_t * text,
+                      size_t length)
+{
+    int count = 0;
+    int zeros = 0;
+    size_t i;
+
+    for (i = 0 ; i < length && text[i] != 'e' ; i++)
+    {
+        if (text[i] < '0' || text[i] > '9') continue;
+        if (text[i] == '0')
+        {
+            zeros++;
+        }
+        else
+        {
+            // the zeros between two digits
+            if (count != 0) count += zeros;
+            count++;
+            zeros = 0;
+        }
+    }
+    return count;
+}
+
+static void prv_checkValue(double value)
+{
+    uint8_t text[32];
+    char string[33];
+    size_t length;
+    double result;
+
+    length = utils_floatToText(value, text, sizeof(text));
+    if (length == 0) prv_fail(value, "", 0, "not written");
+    if (lwm2m_PlainTextToFloat64(text, length, &result) != 1) prv_fail(value, (char *)text, length, "not read");
+    if (memcmp(&result, &value, sizeof(double)) != 0) prv_fail(value, (char *)text, length, "read back as another value");
+
+    memcpy(string, text, length);
+    string[length] = 0;
+    result = strtod(string, NULL);
+    if (memcmp(&result, &value, sizeof(double)) != 0) prv_fail(value, (char *)text, length, "another value for strtod()");
+
+    if (prv_digits(text, length) > 17) prv_fail(value, (char *)text, length, "more than 17 digits");
+}
+
+static void prv_checkText(double value,
+                          const char * expected)
+{
+    uint8_t text[32];
+    size_t length;
+
+    length = utils_floatToText(value, text, sizeof(text));
+    if (length != strlen(expected) || memcmp(text, expected, length) != 0)
+    {
+        prv_fail(value, (char *)text, length, expected);
+    }
+    prv_checkValue(value);
+}
+
+static void prv_checkSpecials(void)
+{
+    uint8_t text[32];
+    double result;
+
+    prv_checkText(0.0, "0");
+    prv_checkText(-0.0, "-0");
+    HOST_CHECK(lwm2m_PlainTextToFloat64((uint8_t *)"-0.000", 6, &result) == 1 && result == 0 && signbit(result));
+    prv_checkText(23.45, "23.45");
+    prv_checkText(-0.5, "-0.5");
+    prv_checkText(0.1, "0.1");
+    prv_checkText(1200, "1200");
+    prv_checkText(1e20, "100000000000000000000");
+    prv_checkText(1e21, "1e21");
+    prv_checkText(0.000001, "0.000001");
+    prv_checkText(1.25e-7, "1.25e-7");
+    prv_checkText(9007199254740993.0, "9007199254740992");
+    prv_checkValue(DBL_MAX);
+    prv_checkValue(-DBL_MAX);
+    prv_checkValue(DBL_MIN);
+    prv_checkValue(DBL_EPSILON);
+    prv_checkText(prv_fromBits(1), "5e-324");
+    prv_checkValue(prv_fromBits(0x000FFFFFFFFFFFFFULL));
+    prv_checkValue((double)INT64_MAX);
+    prv_checkValue((double)INT64_MIN);
+
+    // no representation, or no room
+    HOST_CHECK(utils_floatToText(INFINITY, text, sizeof(text)) == 0);
+    HOST_CHECK(utils_floatToText(-INFINITY, text, sizeof(text)) == 0);
+    HOST_CHECK(utils_floatToText(NAN, text, sizeof(text)) == 0);
+    HOST_CHECK(utils_floatToText(23.45, text, 4) == 0);
+    HOST_CHECK(utils_floatToText(-0.0, text, 1) == 0);
+    HOST_CHECK(utils_floatToText(-DBL_MIN, text, 24) == 24 && utils_floatToText(-DBL_MIN, text, 23) == 0);
+    HOST_CHECK(lwm2m_PlainTextToFloat64((uint8_t *)"1e309", 5, &result) == 0);
+}
+
+int main(void)
+{
+    long finite = 0;
+    long i;
+
+    prv_checkSpecials();
+
+    for (i = 0 ; i < FLOAT_VALUES ; i++)
+    {
+        double value = prv_fromBits(prv_random());
+
+        if (!isfinite(value)) continue;
+        prv_checkValue(value);
+        finite++;
+    }
+    // readings with one to four decimals
+    for (i = 0 ; i < FLOAT_VALUES ; i++)
+    {
+        static const double scales[] = { 10, 100, 1000, 10000 };
+        int64_t reading = (int64_t)(prv_random() % 2000001) - 1000000;
+
+        prv_checkValue(reading / scales[i % 4]);
+    }
+
+    printf("float_test: %ld bit patterns and %d decimals read back\n", finite, FLOAT_VALUES);
+    printf("float_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,140 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - host tests
+ *
+ *******************************************************************************/
+
+/*
+ * Content-Format of the reads of the client, see object_read(): the format
+ * returned is the one of the payload, not the requested one.
+ */
+
+#include "host.h"
+
+static const uint8_t samples[] = { 0x00, 0x15, 0xEB, 0x80 };
+
+static void * prv_connect(uint16_t secObjInstID,
+                          void * userData)
+{
+    return NULL;
+}
+
+static uint8_t prv_send(void * sessionH,
+                        uint8_t * buffer,
+                        size_t length,
+                        void * userData)
+{
+    return COAP_NO_ERROR;
+}
+
+// 5700 float, 5601 with two instances and 6001 opaque
+static uint8_t prv_read(uint16_t instanceId,
+                        int * numDataP,
+                        lwm2m_tlv_t ** dataArrayP,
+                        lwm2m_object_t * objectP)
+{
+    lwm2m_tlv_t * tlvP = *dataArrayP;
+
+    if (*numDataP != 1) return COAP_405_METHOD_NOT_ALLOWED;
+
+    switch (tlvP->id)
+    {
+    case 5700:
+        lwm2m_tlv_encode_float(21.5, tlvP);
+        return COAP_205_CONTENT;
+
+    case 5601:
+        {
+            lwm2m_tlv_t * subTlvP = lwm2m_tlv_new(2);
+
+            if (subTlvP == NULL) return COAP_500_INTERNAL_SERVER_ERROR;
+            subTlvP[0].type = subTlvP[1].type = LWM2M_TYPE_RESOURCE_INSTANCE;
+            subTlvP[0].id = 0;
+            lwm2m_tlv_encode_float(-1.0, subTlvP + 0);
+            subTlvP[1].id = 1;
+            lwm2m_tlv_encode_float(0.5, subTlvP + 1);
+            lwm2m_tlv_include(subTlvP, 2, tlvP);
+        }
+        return COAP_205_CONTENT;
+
+    case 6001:
+        tlvP->flags |= LWM2M_TLV_FLAG_STATIC_DATA;
+        tlvP->dataType = LWM2M_TYPE_OPAQUE;
+        tlvP->value = (uint8_t *)samples;
+        tlvP->length = sizeof(samples);
+        return COAP_205_CONTENT;
+
+    default:
+        return COAP_404_NOT_FOUND;
+    }
+}
+
+static void prv_checkRead(lwm2m_context_t * contextP,
+                          uint16_t resourceId,
+                          lwm2m_media_type_t requested,
+                          lwm2m_media_type_t expected)
+{
+    lwm2m_uri_t uri;
+    lwm2m_media_type_t format = requested;
+    uint8_t * buffer = NULL;
+    size_t length = 0;
+
+    memset(&uri, 0, sizeof(uri));
+    uri.flag = LWM2M_URI_FLAG_OBJECT_ID | LWM2M_URI_FLAG_INSTANCE_ID | LWM2M_URI_FLAG_RESOURCE_ID;
+    uri.objectId = 3313;
+    uri.instanceId = 0;
+    uri.resourceId = resourceId;
+
+    HOST_CHECK(object_read(contextP, &uri, &format, &buffer, &length) == COAP_205_CONTENT);
+    if (format != expected)
+    {
+        fprintf(stderr, "/3313/0/%u read as %u: payload in %u instead of %u\n", resourceId, requested, format, expected);
+        exit(1);
+    }
+    if (format == LWM2M_CONTENT_TEXT) HOST_CHECK(length == 4 && memcmp(buffer, "21.5", 4) == 0);
+    if (format == LWM2M_CONTENT_OPAQUE) HOST_CHECK(length == sizeof(samples) && memcmp(buffer, samples, length) == 0);
+    lwm2m_free(buffer);
+}
+
+int main(void)
+{
+    lwm2m_context_t * contextP;
+    lwm2m_object_t * objectP;
+
+    contextP = lwm2m_init(prv_connect, prv_send, NULL);
+    HOST_CHECK(contextP != NULL);
+    objectP = (lwm2m_object_t *)lwm2m_malloc(sizeof(lwm2m_object_t));
+    contextP->objectList = (lwm2m_object_t **)lwm2m_malloc(sizeof(lwm2m_object_t *));
+    HOST_CHECK(objectP != NULL && contextP->objectList != NULL);
+    memset(objectP, 0, sizeof(lwm2m_object_t));
+    objectP->objID = 3313;
+    objectP->readFunc = prv_read;
+    contextP->objectList[0] = objectP;
+    contextP->numObject = 1;
+
+    prv_checkRead(contextP, 5700, LWM2M_CONTENT_TEXT, LWM2M_CONTENT_TEXT);
+    prv_checkRead(contextP, 5700, LWM2M_CONTENT_TLV, LWM2M_CONTENT_TLV);
+    prv_checkRead(contextP, 5700, LWM2M_CONTENT_SENML_CBOR, LWM2M_CONTENT_SENML_CBOR);
+    // no plain text for several values
+    prv_checkRead(contextP, 5601, LWM2M_CONTENT_TEXT, LWM2M_CONTENT_TLV);
+    prv_checkRead(contextP, 5601, LWM2M_CONTENT_JSON, LWM2M_CONTENT_JSON);
+    prv_checkRead(contextP, 6001, LWM2M_CONTENT_TEXT, LWM2M_CONTENT_OPAQUE);
+    prv_checkRead(contextP, 6001, LWM2M_CONTENT_TLV, LWM2M_CONTENT_TLV);
+
+    lwm2m_close(contextP);
+    HOST_CHECK(host_live_blocks == 0);
+
+    printf("format_test: ok\n");
+    return 0;
+}
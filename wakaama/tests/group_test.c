@@ -0,0 +1,365 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - host tests
+ *
+ *******************************************************************************/
+
+/*
+ * Operations on groups of clients, see group.c.
+ *
+ * The sent datagrams are queued and answered by a simulated device, whose
+ * reads return its session number. Checks the results of a group read
+ * against a loop of lwm2m_dm_read(), the pacing by rate and window, the
+ * credit after a long pause at a high rate, the window shrinking on losses
+ * and lwm2m_close() with a group in flight. The clock of the rate is moved
+ * forward by host_offset_ms rather than waited for.
+ */
+
+#include "host.h"
+
+#define GROUP_CLIENTS   2000
+#define GROUP_QUEUE     (1 << 16)
+
+typedef struct
+{
+    void *   sessionH;
+    uint16_t length;
+    uint8_t  buffer[128];
+} datagram_t;
+
+static lwm2m_context_t * contextP;
+static datagram_t * queue;
+static size_t queueHead;
+static size_t queueTail;
+static long sent;
+static long answered;
+static long dropEvery;  // the device does not answer one request out of dropEvery
+static long results;
+static long errors;
+static long finished;
+static long maxTransactions;
+
+static uint8_t prv_send(void * sessionH,
+                        uint8_t * buffer,
+                        size_t length,
+                        void * userData)
+{
+    datagram_t * datagramP;
+
+    HOST_CHECK(length <= sizeof(datagramP->buffer));
+    HOST_CHECK(queueTail - queueHead < GROUP_QUEUE);
+    datagramP = queue + (queueTail++ % GROUP_QUEUE);
+    datagramP->sessionH = sessionH;
+    datagramP->length = length;
+    memcpy(datagramP->buffer, buffer, length);
+    sent++;
+
+    return COAP_NO_ERROR;
+}
+
+// answers a request with a piggybacked response
+static void prv_device(datagram_t * datagramP)
+{
+    coap_packet_t request;
+    coap_packet_t response;
+    uint8_t buffer[128];
+    char value[16];
+    size_t length;
+
+    if (coap_parse_message(&request, datagramP->buffer, datagramP->length) != NO_ERROR) return;
+    if (request.type != COAP_TYPE_CON || request.code < COAP_GET || request.code > COAP_DELETE
+     || (dropEvery != 0 && ++answered % dropEvery == 0))
+    {
+        coap_free_header(&request);
+        return;
+    }
+
+    coap_init_message(&response, COAP_TYPE_ACK, request.code == COAP_GET ? COAP_205_CONTENT : COAP_204_CHANGED, request.mid);
+    coap_set_header_token(&response, request.token, request.token_len);
+    if (request.code == COAP_GET)
+    {
+        snprintf(value, sizeof(value), "%ld", (long)(intptr_t)datagramP->sessionH);
+        coap_set_payload(&response, value, strlen(value));
+    }
+    length = coap_serialize_message(&response, buffer);
+    coap_free_header(&request);
+
+    lwm2m_handle_packet(contextP, buffer, length, datagramP->sessionH);
+}
+
+// delivers at most count queued datagrams, the answers sent meanwhile included
+static void prv_deliver(size_t count)
+{
+    while (queueHead < queueTail && count-- > 0)
+    {
+        datagram_t datagram = queue[queueHead++ % GROUP_QUEUE];
+
+        prv_device(&datagram);
+    }
+}
+
+static void prv_result(uint16_t clientID,
+                       lwm2m_uri_t * uriP,
+                       int status,
+                       uint8_t * data,
+                       int dataLength,
+                       void * userData)
+{
+    lwm2m_transaction_t * transacP;
+    long count = 0;
+
+    if (uriP == NULL)
+    {
+        finished++;
+        return;
+    }
+
+    results++;
+    if (status == COAP_205_CONTENT)
+    {
+        char value[16];
+
+        memcpy(value, data, dataLength);
+        value[dataLength] = 0;
+        if (atol(value) != clientID + 1) errors++;
+    }
+    else if (status != COAP_204_CHANGED)
+    {
+        errors++;
+    }
+
+    for (transacP = contextP->transactionList ; transacP != NULL ; transacP = transacP->next) count++;
+    if (count > maxTransactions) maxTransactions = count;
+}
+
+static void prv_register(int index)
+{
+    coap_packet_t message;
+    coap_packet_t response;
+    lwm2m_uri_t uri;
+    multi_option_t query;
+    char name[32];
+    const char * objects = "</3/0>,</3303/0>";
+
+    snprintf(name, sizeof(name), "ep=n%d", index);
+    memset(&message, 0, sizeof(message));
+    memset(&response, 0, sizeof(response));
+    memset(&uri, 0, sizeof(uri));
+    message.code = COAP_POST;
+    message.payload = (uint8_t *)objects;
+    message.payload_len = strlen(objects);
+    query.next = NULL;
+    query.data = (uint8_t *)name;
+    query.len = strlen(name);
+    query.is_static = 1;
+    message.uri_query = &query;
+
+    // the session of the client index is index + 1
+    HOST_CHECK(handle_registration_request(contextP, &uri, (void *)(intptr_t)(index + 1), &message, &response) == COAP_201_CREATED);
+    coap_free_header(&response);
+}
+
+static void prv_reset(void)
+{
+    sent = 0;
+    results = 0;
+    errors = 0;
+    finished = 0;
+    maxTransactions = 0;
+}
+
+// the loop of the application, timeoutP is the timeout of the last lwm2m_step()
+static void prv_wait(uint32_t stepMs,
+                     time_t stepS,
+                     time_t * timeoutP)
+{
+    *timeoutP = 0;
+    while (finished == 0)
+    {
+        prv_deliver(GROUP_QUEUE);
+        if (finished != 0) break;
+        host_offset_ms += stepMs;
+        host_now += stepS;
+        *timeoutP = 10;
+        HOST_CHECK(lwm2m_step(contextP, timeoutP) == 0);
+    }
+}
+
+static void prv_testRead(uint16_t * clientIDs,
+                         int count,
+                         lwm2m_uri_t * uriP)
+{
+    double start;
+    double groupTime;
+    double loopTime;
+    time_t timeout;
+    int i;
+
+    // an unknown client at the end
+    lwm2m_set_group_pacing(contextP, 10000000, 256);
+    prv_reset();
+    start = host_clock_ns();
+    HOST_CHECK(lwm2m_dm_group_read(contextP, clientIDs, count + 1, uriP, prv_result, NULL) == COAP_NO_ERROR);
+    prv_wait(0, 0, &timeout);
+    groupTime = host_clock_ns() - start;
+    HOST_CHECK(results == count + 1 && errors == 1 && finished == 1 && sent == count);
+    HOST_CHECK(contextP->transactionList == NULL && contextP->groupList == NULL && contextP->groupInFlight == 0);
+    HOST_CHECK(maxTransactions <= 256);
+
+    // the results are cached
+    prv_reset();
+    for (i = 0 ; i < count ; i++)
+    {
+        lwm2m_dm_read_cached(contextP, clientIDs[i], uriP, 100, prv_result, NULL);
+    }
+    HOST_CHECK(results == count && errors == 0 && sent == 0);
+
+    prv_reset();
+    start = host_clock_ns();
+    for (i = 0 ; i < count ; i++)
+    {
+        HOST_CHECK(lwm2m_dm_read(contextP, clientIDs[i], uriP, prv_result, NULL) == COAP_NO_ERROR);
+    }
+    prv_deliver(GROUP_QUEUE);
+    loopTime = host_clock_ns() - start;
+    HOST_CHECK(results == count && errors == 0);
+
+    printf("%d clients: group read %.1f ms, loop of lwm2m_dm_read() %.1f ms\n", count, groupTime / 1e6, loopTime / 1e6);
+}
+
+static void prv_testRate(uint16_t * clientIDs,
+                         int count,
+                         lwm2m_uri_t * uriP)
+{
+    uint32_t start;
+    uint32_t duration;
+    time_t timeout;
+
+    if (count > 1500) count = 1500;
+    lwm2m_set_group_pacing(contextP, 1000, 64);
+    prv_reset();
+    start = lwm2m_gettime_ms();
+    HOST_CHECK(lwm2m_dm_group_write(contextP, clientIDs, count, uriP, (uint8_t *)"1", 1, prv_result, NULL) == COAP_NO_ERROR);
+    HOST_CHECK(sent == 64);
+    while (finished == 0)
+    {
+        prv_wait(1, 0, &timeout);
+        // waiting for the rate only
+        HOST_CHECK(finished != 0 || timeout <= 1);
+    }
+    duration = lwm2m_gettime_ms() - start;
+    HOST_CHECK(results == count && errors == 0 && maxTransactions <= 64);
+    // the first window is sent at once
+    HOST_CHECK(duration >= count - 64 && duration < count - 64 + 100);
+    printf("rate of 1000/s: %d writes in %.2f s\n", count, duration / 1000.0);
+
+    // the write dropped the cached values
+    prv_reset();
+    lwm2m_dm_read_cached(contextP, clientIDs[0], uriP, 100, NULL, NULL);
+    HOST_CHECK(sent == 1);
+    prv_deliver(GROUP_QUEUE);
+}
+
+// with 10 s elapsed at 429497 requests per second, the credit overflows 32 bits
+static void prv_testHighRate(uint16_t * clientIDs,
+                             lwm2m_uri_t * uriP)
+{
+    time_t timeout;
+
+    lwm2m_set_group_pacing(contextP, 429497, 16);
+    prv_reset();
+    HOST_CHECK(lwm2m_dm_group_read(contextP, clientIDs, 64, uriP, prv_result, NULL) == COAP_NO_ERROR);
+    HOST_CHECK(sent == 16);
+
+    // each response is followed by a request
+    host_offset_ms += 10000;
+    prv_deliver(16);
+    HOST_CHECK(sent == 32);
+
+    prv_wait(0, 0, &timeout);
+    HOST_CHECK(results == 64 && errors == 0);
+}
+
+static void prv_testLosses(uint16_t * clientIDs,
+                           lwm2m_uri_t * uriP)
+{
+    uint16_t minWindow = 64;
+
+    lwm2m_set_group_pacing(contextP, 10000000, 64);
+    prv_reset();
+    dropEvery = 10;
+    answered = 0;
+    HOST_CHECK(lwm2m_dm_group_read(contextP, clientIDs, 200, uriP, prv_result, NULL) == COAP_NO_ERROR);
+    while (finished == 0)
+    {
+        time_t timeout;
+
+        prv_deliver(GROUP_QUEUE);
+        if (contextP->groupCwnd < minWindow) minWindow = contextP->groupCwnd;
+        if (finished != 0) break;
+        host_offset_ms += 2;
+        host_now += 1;
+        timeout = 10;
+        HOST_CHECK(lwm2m_step(contextP, &timeout) == 0);
+    }
+    dropEvery = 0;
+    HOST_CHECK(results == 200);
+    HOST_CHECK(minWindow < 64);
+    printf("1 request out of 10 lost: %ld not answered, window down to %u\n", errors, minWindow);
+}
+
+int main(int argc,
+         char * argv[])
+{
+    int count = (argc > 1) ? atoi(argv[1]) : GROUP_CLIENTS;
+    uint16_t * clientIDs;
+    lwm2m_uri_t uri;
+    int i;
+
+    HOST_CHECK(count >= 200 && count < 30000);
+    queue = malloc(GROUP_QUEUE * sizeof(datagram_t));
+    clientIDs = malloc((count + 1) * sizeof(uint16_t));
+    HOST_CHECK(queue != NULL && clientIDs != NULL);
+
+    contextP = lwm2m_init(NULL, prv_send, NULL);
+    HOST_CHECK(contextP != NULL);
+    for (i = 0 ; i < count ; i++)
+    {
+        prv_register(i);
+        clientIDs[i] = i;
+    }
+    clientIDs[count] = 60000;
+
+    memset(&uri, 0, sizeof(uri));
+    uri.flag = LWM2M_URI_FLAG_OBJECT_ID | LWM2M_URI_FLAG_INSTANCE_ID | LWM2M_URI_FLAG_RESOURCE_ID;
+    uri.objectId = 3;
+    uri.instanceId = 0;
+    uri.resourceId = 13;
+
+    prv_testRead(clientIDs, count, &uri);
+    prv_testRate(clientIDs, count, &uri);
+    prv_testHighRate(clientIDs, &uri);
+    prv_testLosses(clientIDs, &uri);
+
+    // closed with a group in flight
+    HOST_CHECK(lwm2m_dm_group_read(contextP, clientIDs, count, &uri, prv_result, NULL) == COAP_NO_ERROR);
+    lwm2m_close(contextP);
+    HOST_CHECK(host_live_blocks == 0);
+
+    free(clientIDs);
+    free(queue);
+
+    printf("group_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,85 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - host tests
+ *
+ *******************************************************************************/
+
+#include "host.h"
+
+#include <malloc.h>
+#include <time.h>
+
+long host_live_bytes;
+long host_live_blocks;
+time_t host_now = 1000;
+uint32_t host_offset_ms;
+
+// the 8 bytes are the usual allocator overhead, the counters are shared by the threads of shard_test
+void * lwm2m_malloc(size_t s)
+{
+    void * p = malloc(s);
+
+    if (p != NULL)
+    {
+        __atomic_add_fetch(&host_live_bytes, malloc_usable_size(p) + 8, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&host_live_blocks, 1, __ATOMIC_RELAXED);
+    }
+    return p;
+}
+
+void lwm2m_free(void * p)
+{
+    if (p != NULL)
+    {
+        __atomic_sub_fetch(&host_live_bytes, malloc_usable_size(p) + 8, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&host_live_blocks, 1, __ATOMIC_RELAXED);
+    }
+    free(p);
+}
+
+char * lwm2m_strdup(const char * str)
+{
+    char * copy = (char *)lwm2m_malloc(strlen(str) + 1);
+
+    if (copy != NULL) strcpy(copy, str);
+    return copy;
+}
+
+int lwm2m_strncmp(const char * s1,
+                  const char * s2,
+                  size_t n)
+{
+    return strncmp(s1, s2, n);
+}
+
+time_t lwm2m_gettime(void)
+{
+    return host_now;
+}
+
+uint32_t lwm2m_gettime_ms(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint32_t)(t.tv_sec * 1000 + t.tv_nsec / 1000000) + host_offset_ms;
+}
+
+double host_clock_ns(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
@@ -0,0 +1,51 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - host tests
+ *
+ *******************************************************************************/
+
+/*
+ * Platform functions of the library for the host tests and tools, see host.c.
+ */
+
+#ifndef HOST_H_
+#define HOST_H_
+
+#include "internals.h"
+
+#include <stdio.h>
+
+// bytes and blocks allocated by lwm2m_malloc() and not freed yet
+extern long host_live_bytes;
+extern long host_live_blocks;
+
+// value returned by lwm2m_gettime(), lwm2m_gettime_ms() follows the host clock
+extern time_t host_now;
+// added to lwm2m_gettime_ms(), to move the clock forward
+extern uint32_t host_offset_ms;
+
+// host monotonic clock, in ns
+double host_clock_ns(void);
+
+#define HOST_CHECK(X)                                                   \
+    do                                                                  \
+    {                                                                   \
+        if (!(X))                                                       \
+        {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #X); \
+            exit(1);                                                    \
+        }                                                               \
+    } while (0)
+
+#endif
@@ -0,0 +1,288 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - host tests
+ *
+ *******************************************************************************/
+
+/*
+ * LwM2M JSON content format, see json.c: an instance written then read
+ * back, the base fields and escapes of a hand written pack, rejected packs
+ * and mutations of a valid one. Whatever the input, the parser must leave
+ * no block allocated.
+ */
+
+#include "host.h"
+
+#define JSON_MUTATIONS  200000
+
+static const uint8_t opaque[] = { 0x00, 0x01, 0x02, 0xFF };
+
+static lwm2m_uri_t prv_uri(int objectId,
+                           int instanceId)
+{
+    lwm2m_uri_t uri;
+
+    memset(&uri, 0, sizeof(uri));
+    uri.flag = LWM2M_URI_FLAG_OBJECT_ID | LWM2M_URI_FLAG_INSTANCE_ID;
+    uri.objectId = objectId;
+    uri.instanceId = instanceId;
+    return uri;
+}
+
+// 5700 float, 5701 string to escape, 5601 integer, 5850 boolean, 5750 opaque and 6000 with two instances
+static lwm2m_tlv_t * prv_instance(int * sizeP)
+{
+    lwm2m_tlv_t * tlvP;
+    lwm2m_tlv_t * subTlvP;
+
+    *sizeP = 6;
+    tlvP = lwm2m_tlv_new(*sizeP);
+    subTlvP = lwm2m_tlv_new(2);
+    HOST_CHECK(tlvP != NULL && subTlvP != NULL);
+    tlvP[0].type = tlvP[1].type = tlvP[2].type = tlvP[3].type = tlvP[4].type = LWM2M_TYPE_RESOURCE;
+    subTlvP[0].type = subTlvP[1].type = LWM2M_TYPE_RESOURCE_INSTANCE;
+
+    tlvP[0].id = 5700;
+    lwm2m_tlv_encode_float(-0.125, tlvP + 0);
+    tlvP[1].id = 5701;
+    tlvP[1].flags = LWM2M_TLV_FLAG_STATIC_DATA;
+    tlvP[1].dataType = LWM2M_TYPE_STRING;
+    tlvP[1].value = (uint8_t *)"a\"b\\c\n\x01\xC3\xA9";
+    tlvP[1].length = 9;
+    tlvP[2].id = 5601;
+    lwm2m_tlv_encode_int(-INT64_MAX, tlvP + 2);
+    tlvP[3].id = 5850;
+    lwm2m_tlv_encode_bool(false, tlvP + 3);
+    tlvP[4].id = 5750;
+    tlvP[4].flags = LWM2M_TLV_FLAG_STATIC_DATA;
+    tlvP[4].dataType = LWM2M_TYPE_OPAQUE;
+    tlvP[4].value = (uint8_t *)opaque;
+    tlvP[4].length = sizeof(opaque);
+
+    subTlvP[0].id = 0;
+    lwm2m_tlv_encode_int(1, subTlvP + 0);
+    subTlvP[1].id = 7;
+    lwm2m_tlv_encode_float(1e300, subTlvP + 1);
+    tlvP[5].id = 6000;
+    lwm2m_tlv_include(subTlvP, 2, tlvP + 5);
+
+    return tlvP;
+}
+
+static void prv_checkRoundTrip(uint8_t ** bufferP,
+                               int * lengthP)
+{
+    lwm2m_uri_t uri = prv_uri(3303, 0);
+    lwm2m_tlv_t * tlvP;
+    lwm2m_tlv_t * parsedP;
+    uint8_t * copy;
+    int size;
+    int64_t value;
+    double number;
+    bool flag;
+
+    tlvP = prv_instance(&size);
+    *lengthP = json_serialize(&uri, size, tlvP, bufferP);
+    HOST_CHECK(*lengthP > 0);
+    lwm2m_tlv_free(size, tlvP);
+
+    // the strings are unescaped in place
+    copy = (uint8_t *)lwm2m_malloc(*lengthP);
+    HOST_CHECK(copy != NULL);
+    memcpy(copy, *bufferP, *lengthP);
+    size = json_parse_tlv(&uri, copy, *lengthP, &parsedP);
+    HOST_CHECK(size == 6);
+    HOST_CHECK(parsedP[0].id == 5700 && lwm2m_tlv_decode_float(parsedP + 0, &number) == 1 && number == -0.125);
+    HOST_CHECK(parsedP[1].id == 5701 && parsedP[1].length == 9 && memcmp(parsedP[1].value, "a\"b\\c\n\x01\xC3\xA9", 9) == 0);
+    HOST_CHECK(parsedP[2].id == 5601 && lwm2m_tlv_decode_int(parsedP + 2, &value) == 1 && value == -INT64_MAX);
+    HOST_CHECK(parsedP[3].id == 5850 && lwm2m_tlv_decode_bool(parsedP + 3, &flag) == 1 && !flag);
+    // without types in the format, opaque values come back as their base64 text
+    HOST_CHECK(parsedP[4].id == 5750 && parsedP[4].length == 8 && memcmp(parsedP[4].value, "AAEC/w==", 8) == 0);
+    HOST_CHECK(parsedP[5].id == 6000 && parsedP[5].type == LWM2M_TYPE_MULTIPLE_RESOURCE && parsedP[5].length == 2);
+    tlvP = (lwm2m_tlv_t *)parsedP[5].value;
+    HOST_CHECK(tlvP[1].id == 7 && lwm2m_tlv_decode_float(tlvP + 1, &number) == 1 && number == 1e300);
+    lwm2m_tlv_free(size, parsedP);
+
+    // written to another object
+    memcpy(copy, *bufferP, *lengthP);
+    uri = prv_uri(3304, 0);
+    HOST_CHECK(json_parse_tlv(&uri, copy, *lengthP, &parsedP) == 0);
+    lwm2m_free(copy);
+}
+
+static int prv_record(lwm2m_senml_record_t * recordP,
+                      void * userData)
+{
+    lwm2m_senml_record_t * recordsP = (lwm2m_senml_record_t *)userData;
+    int i;
+
+    for (i = 0 ; recordsP[i].name[0] != 0 ; i++);
+    HOST_CHECK(i < 5);
+    recordsP[i] = *recordP;
+    return 0;
+}
+
+// base fields after the records, members and values to skip, escapes in the names
+static void prv_checkPack(void)
+{
+    char pack[] = "{ \"e\" : [ {\"n\":\"5\\u0037\\u00300\", \"v\":-1.5e2, \"t\":-5, \"x\":{\"y\":[1,{}]}},\n"
+                  "  {\"sv\":\"\\u00e9\\/\\t\", \"n\":\"5701\"}, {\"n\":\"5850\",\"bv\":true},\n"
+                  "  {\"n\":\"5601\",\"v\":18446744073709551619}, {\"n\":\"5602\",\"v\":-9223372036854775808} ],\n"
+                  "  \"bt\" : 1000, \"ver\" : null, \"bn\" : \"/3303/0/\" }";
+    lwm2m_senml_record_t records[6];
+
+    memset(records, 0, sizeof(records));
+    HOST_CHECK(lwm2m_json_parse((uint8_t *)pack, strlen(pack), prv_record, records) == 5);
+    HOST_CHECK(strcmp(records[0].name, "/3303/0/5700") == 0);
+    HOST_CHECK(records[0].type == LWM2M_TYPE_FLOAT && records[0].value.asFloat == -150 && records[0].time == 995);
+    HOST_CHECK(strcmp(records[1].name, "/3303/0/5701") == 0 && records[1].type == LWM2M_TYPE_STRING);
+    HOST_CHECK(records[1].value.asBuffer.length == 4 && memcmp(records[1].value.asBuffer.buffer, "\xC3\xA9/\t", 4) == 0);
+    HOST_CHECK(records[2].type == LWM2M_TYPE_BOOLEAN && records[2].value.asBoolean && records[2].time == 1000);
+    // beyond the int64_t range, and its lowest value
+    HOST_CHECK(records[3].type == LWM2M_TYPE_FLOAT && records[3].value.asFloat == 18446744073709551619.0);
+    HOST_CHECK(records[4].type == LWM2M_TYPE_INTEGER && records[4].value.asInteger == INT64_MIN);
+}
+
+static void prv_checkRejected(const char * pack)
+{
+    lwm2m_uri_t uri = prv_uri(3303, 0);
+    lwm2m_tlv_t * parsedP;
+    uint8_t buffer[256];
+    long before = host_live_blocks;
+    size_t length = strlen(pack);
+
+    memcpy(buffer, pack, length);
+    if (json_parse_tlv(&uri, buffer, length, &parsedP) != 0)
+    {
+        fprintf(stderr, "%s: accepted\n", pack);
+        exit(1);
+    }
+    HOST_CHECK(parsedP == NULL);
+    if (host_live_blocks != before)
+    {
+        fprintf(stderr, "%s: %ld blocks leaked\n", pack, host_live_blocks - before);
+        exit(1);
+    }
+}
+
+static void prv_checkMalformed(void)
+{
+    static const char * const packs[] =
+    {
+        "",
+        "[]",
+        "{\"bn\":\"/3303/0/\"}",
+        "{\"bn\":\"/3303/0/\",\"e\":{}}",
+        "{\"bn\":\"/3303/0/\",\"e\":[]",
+        "{\"bn\":\"/3303/0/\",\"e\":[]} x",
+        "{\"bn\":\"/3303/0/\",\"e\":[{\"n\":\"5700\",\"v\":1},]}",
+        "{\"bn\":\"/3303/0/\",\"e\":[{\"n\":\"5700\",\"v\":1}{\"n\":\"5701\",\"v\":1}]}",
+        "{\"bn\":\"/3303/0/\",\"e\":[{\"n\":\"5700\" \"v\":1}]}",
+        "{\"bn\":\"/3303/0/\",\"e\":[{\"n\":\"5700\",\"v\":\"1\"}]}",
+        "{\"bn\":\"/3303/0/\",\"e\":[{\"n\":\"5700\",\"v\":1e999}]}",
+        "{\"bn\":\"/3303/0/\",\"e\":[{\"n\":\"5700\",\"v\":-}]}",
+        "{\"bn\":\"/3303/0/\",\"e\":[{\"n\":\"5700\",\"bv\":tru}]}",
+        "{\"bn\":\"/3303/0/\",\"e\":[{\"n\":\"5701\",\"sv\":\"a\\x\"}]}",
+        "{\"bn\":\"/3303/0/\",\"e\":[{\"n\":\"5701\",\"sv\":\"\\ud800\"}]}",
+        "{\"bn\":\"/3303/0/\",\"e\":[{\"n\":\"5701\",\"sv\":\"\\u12\"}]}",
+        "{\"bn\":\"/3303/0/\",\"e\":[{\"n\":\"5701\",\"sv\":\"a\nb\"}]}",
+        "{\"bn\":\"/3303/0/\",\"e\":[{\"n\":\"5701\",\"sv\":\"abc}]}",
+        "{\"bn\":\"/3303/0/\",\"e\":[{\"n\":\"5700\",\"x\":[[[[[[[[[1]]]]]]]]]}]}",
+        "{\"bn\":\"/3303/0/\",\"e\":[{\"n\":\"0123456789012345678901234567\",\"v\":1}]}",
+        "{\"bn\":\"/3303/0/\",\"e\":[{\"n\":\"70000\",\"v\":1}]}",
+        "{\"bn\":\"/3303/1/\",\"e\":[{\"n\":\"5700\",\"v\":1}]}",
+        "{\"bn\":\"/3303/0/\",\"e\":[{\"n\":\"6000/0\",\"v\":1},{\"n\":\"6000/1\",\"v\":1},{\"n\":\"x\",\"v\":1}]}",
+        "{\"bn\":\"/3303/0/\",\"e\":[{\"n\":\"6000/0\",\"v\":1},{\"n\":\"/3303/1/6000/1\",\"v\":1}]}",
+        "{\"bn\":\"/3303/0/\",\"e\":[{\"n\":\"5700\"}]}",
+        NULL
+    };
+    int i;
+
+    for (i = 0 ; packs[i] != NULL ; i++)
+    {
+        prv_checkRejected(packs[i]);
+    }
+}
+
+static void prv_checkMutations(const uint8_t * buffer,
+                               int length)
+{
+    lwm2m_uri_t uri = prv_uri(3303, 0);
+    uint8_t mutated[512];
+    long before = host_live_blocks;
+    int accepted = 0;
+    int i;
+
+    HOST_CHECK(length <= (int)sizeof(mutated));
+    srand(1);
+    for (i = 0 ; i < JSON_MUTATIONS ; i++)
+    {
+        static const char tokens[] = "{}[]:,\"\\0123456789-.eEtfnu \n";
+        lwm2m_tlv_t * parsedP;
+        int mutatedLength = length;
+        int changes = 1 + rand() % 4;
+        int size;
+
+        memcpy(mutated, buffer, length);
+        while (changes-- > 0)
+        {
+            switch (rand() % 4)
+            {
+            case 0:
+                mutated[rand() % mutatedLength] = rand();
+                break;
+            case 1:
+                // characters with a meaning in JSON
+                mutated[rand() % mutatedLength] = tokens[rand() % (sizeof(tokens) - 1)];
+                break;
+            case 2:
+                mutated[rand() % mutatedLength] ^= 1 << (rand() % 8);
+                break;
+            default:
+                mutatedLength = 1 + rand() % mutatedLength;
+                break;
+            }
+        }
+
+        size = json_parse_tlv(&uri, mutated, mutatedLength, &parsedP);
+        if (size > 0)
+        {
+            accepted++;
+            lwm2m_tlv_free(size, parsedP);
+        }
+        if (host_live_blocks != before)
+        {
+            fprintf(stderr, "mutation %d: %ld blocks leaked\n", i, host_live_blocks - before);
+            exit(1);
+        }
+    }
+    printf("json_test: %d of %d mutations accepted\n", accepted, JSON_MUTATIONS);
+}
+
+int main(void)
+{
+    uint8_t * buffer;
+    int length;
+
+    prv_checkRoundTrip(&buffer, &length);
+    prv_checkPack();
+    prv_checkMalformed();
+    prv_checkMutations(buffer, length);
+    lwm2m_free(buffer);
+
+    HOST_CHECK(host_live_blocks == 0);
+
+    printf("json_test: ok\n");
+    return 0;
+}
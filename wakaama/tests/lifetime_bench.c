@@ -0,0 +1,225 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - host tests
+ *
+ *******************************************************************************/
+
+/*
+ * Lifetime heap of the server, see lifetime.c.
+ *
+ * Registers clients with random lifetimes and updates them, then measures
+ * a lwm2m_step() with nothing due against the list sweep it replaced. The
+ * heap invariant is checked after the updates, the client list must stay
+ * sorted by ID through the expiry, and expiry and Deregister must leave
+ * both the heap and the client list empty.
+ */
+
+#include "host.h"
+
+static int deleted;
+
+static uint8_t prv_send(void * sessionH,
+                        uint8_t * buffer,
+                        size_t length,
+                        void * userData)
+{
+    return COAP_NO_ERROR;
+}
+
+static void prv_monitor(uint16_t clientID,
+                        lwm2m_uri_t * uriP,
+                        int status,
+                        uint8_t * data,
+                        int dataLength,
+                        void * userData)
+{
+    if (status == DELETED_2_02) deleted++;
+}
+
+// objectId < 0 targets /rd
+static coap_status_t prv_request(lwm2m_context_t * contextP,
+                                 coap_method_t method,
+                                 int objectId,
+                                 const char * query1,
+                                 const char * query2)
+{
+    coap_packet_t message;
+    coap_packet_t response;
+    lwm2m_uri_t uri;
+    multi_option_t option1;
+    multi_option_t option2;
+    coap_status_t result;
+
+    memset(&message, 0, sizeof(message));
+    memset(&response, 0, sizeof(response));
+    memset(&uri, 0, sizeof(uri));
+    message.code = method;
+    message.payload = (uint8_t *)"</3/0>";
+    message.payload_len = 6;
+    if (objectId >= 0)
+    {
+        uri.flag = LWM2M_URI_FLAG_OBJECT_ID;
+        uri.objectId = objectId;
+    }
+    if (query1 != NULL)
+    {
+        option1.next = NULL;
+        option1.data = (uint8_t *)query1;
+        option1.len = strlen(query1);
+        option1.is_static = 1;
+        message.uri_query = &option1;
+        if (query2 != NULL)
+        {
+            option2.next = NULL;
+            option2.data = (uint8_t *)query2;
+            option2.len = strlen(query2);
+            option2.is_static = 1;
+            option1.next = &option2;
+        }
+    }
+
+    result = handle_registration_request(contextP, &uri, NULL, &message, &response);
+    coap_free_header(&response);
+
+    return result;
+}
+
+// the lifetime part of the lwm2m_step() before the heap
+static void prv_listSweep(lwm2m_context_t * contextP,
+                          time_t currentTime,
+                          time_t * timeoutP)
+{
+    lwm2m_client_t * clientP;
+
+    for (clientP = contextP->clientList ; clientP != NULL ; clientP = clientP->next)
+    {
+        if (clientP->endOfLife <= currentTime) continue;
+        if (*timeoutP > clientP->endOfLife - currentTime) *timeoutP = clientP->endOfLife - currentTime;
+    }
+}
+
+static bool prv_heapIsValid(lwm2m_context_t * contextP)
+{
+    size_t i;
+
+    for (i = 0 ; i < contextP->lifetimeCount ; i++)
+    {
+        if (contextP->lifetimeHeap[i]->lifetimeIndex != i) return false;
+        if (i > 0 && contextP->lifetimeHeap[(i - 1) / 2]->endOfLife > contextP->lifetimeHeap[i]->endOfLife) return false;
+    }
+    return true;
+}
+
+static bool prv_listIsValid(lwm2m_context_t * contextP)
+{
+    lwm2m_client_t * clientP;
+    size_t count = 0;
+
+    for (clientP = contextP->clientList ; clientP != NULL ; clientP = clientP->next)
+    {
+        if (clientP->next != NULL && clientP->next->internalID <= clientP->internalID) return false;
+        if (lifetime_get_client(contextP, clientP->internalID) != clientP) return false;
+        count++;
+    }
+    return count == contextP->lifetimeCount;
+}
+
+static void prv_run(int count)
+{
+    lwm2m_context_t * contextP;
+    char query1[32];
+    char query2[32];
+    double start;
+    double registration;
+    double heapStep;
+    double listStep;
+    double update;
+    time_t heapTimeout;
+    time_t listTimeout;
+    int repeat;
+    int expired;
+    int i;
+
+    contextP = lwm2m_init(NULL, prv_send, NULL);
+    HOST_CHECK(contextP != NULL);
+    lwm2m_set_monitoring_callback(contextP, prv_monitor, NULL);
+    host_now = 1000;
+    deleted = 0;
+
+    start = host_clock_ns();
+    for (i = 0 ; i < count ; i++)
+    {
+        snprintf(query1, sizeof(query1), "ep=node%d", i);
+        snprintf(query2, sizeof(query2), "lt=%d", 60 + rand() % 86400);
+        HOST_CHECK(prv_request(contextP, COAP_POST, -1, query1, query2) == COAP_201_CREATED);
+    }
+    registration = (host_clock_ns() - start) / count;
+    // registering an existing name again
+    HOST_CHECK(prv_request(contextP, COAP_POST, -1, "ep=node0", "lt=30") == COAP_201_CREATED);
+
+    start = host_clock_ns();
+    for (i = 0 ; i < count ; i++)
+    {
+        snprintf(query2, sizeof(query2), "lt=%d", 60 + rand() % 86400);
+        (void)prv_request(contextP, COAP_PUT, rand() % count, query2, NULL);
+    }
+    update = (host_clock_ns() - start) / count;
+    HOST_CHECK(prv_heapIsValid(contextP));
+
+    repeat = (count >= 10000) ? 200 : 2000;
+    start = host_clock_ns();
+    for (i = 0 ; i < repeat ; i++)
+    {
+        heapTimeout = 100000;
+        HOST_CHECK(lwm2m_step(contextP, &heapTimeout) == 0);
+    }
+    heapStep = (host_clock_ns() - start) / repeat;
+    start = host_clock_ns();
+    for (i = 0 ; i < repeat ; i++)
+    {
+        listTimeout = 100000;
+        prv_listSweep(contextP, host_now, &listTimeout);
+    }
+    listStep = (host_clock_ns() - start) / repeat;
+    HOST_CHECK(heapTimeout == listTimeout);
+
+    // half of the lifetimes, then all of them
+    host_now += 43260;
+    heapTimeout = 100000;
+    lwm2m_step(contextP, &heapTimeout);
+    expired = deleted;
+    HOST_CHECK(prv_heapIsValid(contextP) && prv_listIsValid(contextP));
+    HOST_CHECK(contextP->lifetimeCount == (size_t)(count - expired));
+    HOST_CHECK(prv_request(contextP, COAP_DELETE, contextP->lifetimeHeap[0]->internalID, NULL, NULL) == COAP_202_DELETED);
+    host_now += 100000;
+    heapTimeout = 100000;
+    lwm2m_step(contextP, &heapTimeout);
+    HOST_CHECK(contextP->clientList == NULL);
+    HOST_CHECK(contextP->lifetimeCount == 0);
+
+    printf("%8d %14.0f %14.0f %14.0f %14.0f %8d/%d\n", count, registration, heapStep, listStep, update, expired, deleted);
+    lwm2m_close(contextP);
+}
+
+int main(void)
+{
+    srand(1);
+    printf("%8s %14s %14s %14s %14s %8s\n", "clients", "register ns", "step(heap) ns", "step(list) ns", "update ns", "expired");
+    prv_run(100);
+    prv_run(1000);
+    prv_run(10000);
+    prv_run(50000);
+
+    return 0;
+}
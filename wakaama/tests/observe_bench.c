@@ -0,0 +1,266 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - host tests
+ *
+ *******************************************************************************/
+
+/*
+ * Dispatch of the notifications through the observation slots of the
+ * server, see observe.c.
+ *
+ * Each client observes OBSERVE_PER_CLIENT instances. The rate of the full
+ * handle_observe_notify() is compared with the client then observation
+ * list searches it replaced. A token of a cancelled observation must get
+ * an RST once its slot is reused, while the new observation is pending
+ * and once it is registered.
+ */
+
+#include "host.h"
+
+#define OBSERVE_PER_CLIENT      3
+#define OBSERVE_NOTIFICATIONS   2000000
+
+static int sent;
+static long notified;
+
+static uint8_t prv_send(void * sessionH,
+                        uint8_t * buffer,
+                        size_t length,
+                        void * userData)
+{
+    sent++;
+    return COAP_NO_ERROR;
+}
+
+static void prv_result(uint16_t clientID,
+                       lwm2m_uri_t * uriP,
+                       int status,
+                       uint8_t * data,
+                       int dataLength,
+                       void * userData)
+{
+    notified++;
+}
+
+static void prv_register(lwm2m_context_t * contextP,
+                         int index)
+{
+    coap_packet_t message;
+    coap_packet_t response;
+    lwm2m_uri_t uri;
+    multi_option_t query;
+    char name[32];
+    const char * objects = "</3/0>,</3303/0>,</3303/1>,</3303/2>";
+
+    snprintf(name, sizeof(name), "ep=node%d", index);
+    memset(&message, 0, sizeof(message));
+    memset(&response, 0, sizeof(response));
+    memset(&uri, 0, sizeof(uri));
+    message.code = COAP_POST;
+    message.payload = (uint8_t *)objects;
+    message.payload_len = strlen(objects);
+    query.next = NULL;
+    query.data = (uint8_t *)name;
+    query.len = strlen(name);
+    query.is_static = 1;
+    message.uri_query = &query;
+
+    HOST_CHECK(handle_registration_request(contextP, &uri, NULL, &message, &response) == COAP_201_CREATED);
+    coap_free_header(&response);
+}
+
+// answers all the pending observe requests
+static void prv_answerAll(lwm2m_context_t * contextP)
+{
+    while (contextP->transactionList != NULL)
+    {
+        lwm2m_transaction_t * transacP = contextP->transactionList;
+        coap_packet_t packet;
+
+        memset(&packet, 0, sizeof(packet));
+        packet.code = COAP_205_CONTENT;
+        coap_set_header_observe(&packet, 0);
+
+        transacP->callback(transacP, &packet);
+        transaction_remove(contextP, transacP);
+    }
+}
+
+static void prv_token(lwm2m_context_t * contextP,
+                      lwm2m_observation_t * observationP,
+                      uint8_t * token)
+{
+    uint16_t generation = contextP->observationSlots[observationP->id].generation;
+
+    token[0] = observationP->id >> 8;
+    token[1] = observationP->id & 0xFF;
+    token[2] = generation >> 8;
+    token[3] = generation & 0xFF;
+}
+
+static void prv_notify(lwm2m_context_t * contextP,
+                       const uint8_t * token,
+                       uint32_t observe)
+{
+    coap_packet_t message;
+    coap_packet_t response;
+
+    memset(&response, 0, sizeof(response));
+    coap_init_message(&message, COAP_TYPE_NON, COAP_205_CONTENT, 1);
+    coap_set_header_token(&message, token, 4);
+    coap_set_header_observe(&message, observe);
+    message.payload = (uint8_t *)"22.5";
+    message.payload_len = 4;
+
+    handle_observe_notify(contextP, NULL, &message, &response);
+}
+
+// the dispatch before the slots
+static lwm2m_observation_t * prv_listFind(lwm2m_context_t * contextP,
+                                          uint16_t clientID,
+                                          uint16_t observationID)
+{
+    lwm2m_client_t * clientP;
+
+    clientP = (lwm2m_client_t *)lwm2m_list_find((lwm2m_list_t *)contextP->clientList, clientID);
+    if (clientP == NULL) return NULL;
+
+    return (lwm2m_observation_t *)lwm2m_list_find((lwm2m_list_t *)clientP->observationList, observationID);
+}
+
+static lwm2m_uri_t prv_uri(int instanceId)
+{
+    lwm2m_uri_t uri;
+
+    memset(&uri, 0, sizeof(uri));
+    uri.flag = LWM2M_URI_FLAG_OBJECT_ID | LWM2M_URI_FLAG_INSTANCE_ID;
+    uri.objectId = 3303;
+    uri.instanceId = instanceId;
+    return uri;
+}
+
+static void prv_checkStaleToken(lwm2m_context_t * contextP)
+{
+    lwm2m_client_t * clientP = contextP->clientList;
+    lwm2m_observation_t * observationP = clientP->observationList;
+    lwm2m_uri_t uri = prv_uri(observationP->uri.instanceId);
+    uint16_t oldId = observationP->id;
+    uint8_t oldToken[4];
+
+    prv_token(contextP, observationP, oldToken);
+    HOST_CHECK(lwm2m_observe_cancel(contextP, clientP->internalID, &uri, NULL, NULL) == 0);
+    HOST_CHECK(lwm2m_observe(contextP, clientP->internalID, &uri, prv_result, NULL) == 0);
+    HOST_CHECK(contextP->observationSlots[oldId].observationP != NULL);
+
+    notified = 0;
+    sent = 0;
+    prv_notify(contextP, oldToken, 5);
+    HOST_CHECK(notified == 0 && sent == 1);
+
+    prv_answerAll(contextP);
+    notified = 0;
+    sent = 0;
+    prv_notify(contextP, oldToken, 6);
+    HOST_CHECK(notified == 0 && sent == 1);
+}
+
+static void prv_run(int count)
+{
+    lwm2m_context_t * contextP;
+    lwm2m_client_t * clientP;
+    uint8_t (* tokens)[4];
+    uint16_t (* ids)[2];
+    int total = count * OBSERVE_PER_CLIENT;
+    long repeat;
+    long i;
+    int j;
+    double start;
+    double notifyRate;
+    double listRate;
+    volatile void * sink;
+
+    contextP = lwm2m_init(NULL, prv_send, NULL);
+    HOST_CHECK(contextP != NULL);
+    for (i = 0 ; i < count ; i++)
+    {
+        prv_register(contextP, i);
+    }
+    for (clientP = contextP->clientList ; clientP != NULL ; clientP = clientP->next)
+    {
+        for (j = 0 ; j < OBSERVE_PER_CLIENT ; j++)
+        {
+            lwm2m_uri_t uri = prv_uri(j);
+
+            HOST_CHECK(lwm2m_observe(contextP, clientP->internalID, &uri, prv_result, NULL) == 0);
+        }
+    }
+    prv_answerAll(contextP);
+
+    tokens = malloc(total * sizeof(tokens[0]));
+    ids = malloc(total * sizeof(ids[0]));
+    HOST_CHECK(tokens != NULL && ids != NULL);
+    j = 0;
+    for (clientP = contextP->clientList ; clientP != NULL ; clientP = clientP->next)
+    {
+        lwm2m_observation_t * observationP;
+
+        for (observationP = clientP->observationList ; observationP != NULL ; observationP = observationP->next)
+        {
+            HOST_CHECK(j < total);
+            prv_token(contextP, observationP, tokens[j]);
+            ids[j][0] = clientP->internalID;
+            ids[j][1] = observationP->id;
+            j++;
+        }
+    }
+    HOST_CHECK(j == total);
+
+    notified = 0;
+    sent = 0;
+    start = host_clock_ns();
+    for (i = 0 ; i < OBSERVE_NOTIFICATIONS ; i++)
+    {
+        prv_notify(contextP, tokens[(i * 7919) % total], i);
+    }
+    notifyRate = OBSERVE_NOTIFICATIONS / (host_clock_ns() - start) * 1e9;
+    HOST_CHECK(notified == OBSERVE_NOTIFICATIONS && sent == 0);
+
+    repeat = (count >= 10000) ? 20000 : 200000;
+    start = host_clock_ns();
+    for (i = 0 ; i < repeat ; i++)
+    {
+        int r = (i * 7919) % total;
+
+        sink = prv_listFind(contextP, ids[r][0], ids[r][1]);
+    }
+    listRate = repeat / (host_clock_ns() - start) * 1e9;
+    (void)sink;
+
+    prv_checkStaleToken(contextP);
+
+    printf("%8d %6d %16.1f %16.2f\n", count, total, notifyRate / 1e6, listRate / 1e6);
+    free(tokens);
+    free(ids);
+    lwm2m_close(contextP);
+}
+
+int main(void)
+{
+    printf("%8s %6s %16s %16s\n", "clients", "obs", "notify M/s", "lookup M/s");
+    prv_run(100);
+    prv_run(1000);
+    prv_run(10000);
+
+    return 0;
+}
@@ -0,0 +1,377 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - host tests
+ *
+ *******************************************************************************/
+
+/*
+ * Clients registry, see lwm2m_registry_restore().
+ *
+ * REGISTRY_CLIENTS clients register, some update their registration, some
+ * deregister, some expire while the server runs and some names register
+ * again on the freed IDs. A second context restored from the records must
+ * hold the same clients as the first one, but those expired while it was
+ * stopped, whatever the end of a last record partially written. Then a
+ * restored registry must behave as a registered one.
+ */
+
+#include "host.h"
+
+#define REGISTRY_CLIENTS    60000
+#define REGISTRY_PAYLOADS   4
+
+typedef struct
+{
+    uint8_t * buffer;
+    size_t    length;
+    size_t    size;
+} registry_t;
+
+static const char * payloads[REGISTRY_PAYLOADS] =
+{
+    "</1/0>,</3/0>",
+    "</1/0>,</3/0>,</5/0>",
+    "</lwm2m>;rt=\"oma.lwm2m\",</lwm2m/1/0>,</lwm2m/3/0>,</lwm2m/3303/0>,</lwm2m/3303/1>",
+    "</1/0>,</3/0>,</3303/0>,</3303/1>,</3303/2>",
+};
+
+static uint8_t prv_send(void * sessionH,
+                        uint8_t * buffer,
+                        size_t length,
+                        void * userData)
+{
+    return COAP_NO_ERROR;
+}
+
+// the records are appended as to a file
+static void prv_store(const uint8_t * record,
+                      size_t length,
+                      void * userData)
+{
+    registry_t * registryP = (registry_t *)userData;
+
+    if (registryP->length + length > registryP->size)
+    {
+        registryP->size = (registryP->size + length) * 2;
+        registryP->buffer = (uint8_t *)realloc(registryP->buffer, registryP->size);
+        HOST_CHECK(registryP->buffer != NULL);
+    }
+    memcpy(registryP->buffer + registryP->length, record, length);
+    registryP->length += length;
+}
+
+static size_t prv_encode(void * sessionH,
+                         uint8_t * buffer,
+                         size_t length,
+                         void * userData)
+{
+    uint32_t session = (uint32_t)(intptr_t)sessionH;
+
+    HOST_CHECK(length >= 4);
+    buffer[0] = session >> 24;
+    buffer[1] = session >> 16;
+    buffer[2] = session >> 8;
+    buffer[3] = session;
+    return 4;
+}
+
+static void * prv_decode(const uint8_t * buffer,
+                         size_t length,
+                         void * userData)
+{
+    HOST_CHECK(length == 4);
+    return (void *)(intptr_t)(((uint32_t)buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3]);
+}
+
+static coap_status_t prv_request(lwm2m_context_t * contextP,
+                                 coap_method_t method,
+                                 uint16_t clientID,
+                                 const char * name,
+                                 const char * lifetime,
+                                 const char * binding,
+                                 const char * payload,
+                                 intptr_t session)
+{
+    coap_packet_t message;
+    coap_packet_t response;
+    lwm2m_uri_t uri;
+    multi_option_t query[3];
+    multi_option_t ** tailP;
+    char text[128];
+    coap_status_t result;
+
+    memset(&message, 0, sizeof(message));
+    memset(&response, 0, sizeof(response));
+    memset(&uri, 0, sizeof(uri));
+    message.code = method;
+    if (method != COAP_POST)
+    {
+        uri.flag = LWM2M_URI_FLAG_OBJECT_ID;
+        uri.objectId = clientID;
+    }
+    if (payload != NULL)
+    {
+        // the payload is parsed in place
+        strcpy(text, payload);
+        message.payload = (uint8_t *)text;
+        message.payload_len = strlen(text);
+    }
+    memset(query, 0, sizeof(query));
+    tailP = &message.uri_query;
+    if (name != NULL)
+    {
+        query[0].data = (uint8_t *)name;
+        query[0].len = strlen(name);
+        *tailP = query;
+        tailP = &query[0].next;
+    }
+    if (lifetime != NULL)
+    {
+        query[1].data = (uint8_t *)lifetime;
+        query[1].len = strlen(lifetime);
+        *tailP = query + 1;
+        tailP = &query[1].next;
+    }
+    if (binding != NULL)
+    {
+        query[2].data = (uint8_t *)binding;
+        query[2].len = strlen(binding);
+        *tailP = query + 2;
+    }
+    query[0].is_static = query[1].is_static = query[2].is_static = 1;
+
+    result = handle_registration_request(contextP, &uri, (void *)session, &message, &response);
+    coap_free_header(&response);
+    return result;
+}
+
+static uint16_t prv_register(lwm2m_context_t * contextP,
+                             const char * name,
+                             const char * lifetime,
+                             const char * binding,
+                             const char * payload,
+                             intptr_t session)
+{
+    char query[32];
+    lwm2m_client_t * clientP;
+
+    snprintf(query, sizeof(query), "ep=%s", name);
+    HOST_CHECK(prv_request(contextP, COAP_POST, 0, query, lifetime, binding, payload, session) == COAP_201_CREATED);
+    clientP = lifetime_find_client(contextP, name);
+    HOST_CHECK(clientP != NULL);
+    return clientP->internalID;
+}
+
+static bool prv_sameObjects(lwm2m_client_object_t * objectP,
+                            lwm2m_client_object_t * otherP)
+{
+    while (objectP != NULL && otherP != NULL)
+    {
+        lwm2m_list_t * instanceP = objectP->instanceList;
+        lwm2m_list_t * otherInstanceP = otherP->instanceList;
+
+        if (objectP->id != otherP->id) return false;
+        while (instanceP != NULL && otherInstanceP != NULL)
+        {
+            if (instanceP->id != otherInstanceP->id) return false;
+            instanceP = instanceP->next;
+            otherInstanceP = otherInstanceP->next;
+        }
+        if (instanceP != otherInstanceP) return false;
+        objectP = objectP->next;
+        otherP = otherP->next;
+    }
+    return objectP == otherP;
+}
+
+static bool prv_sameString(const char * string,
+                           const char * other)
+{
+    if (string == NULL || other == NULL) return string == other;
+    return strcmp(string, other) == 0;
+}
+
+// restored holds the clients of contextP not expired, but those in excluded
+static long prv_checkRestored(lwm2m_context_t * contextP,
+                              lwm2m_context_t * restoredP,
+                              const char * excluded)
+{
+    lwm2m_client_t * clientP;
+    lwm2m_client_t * restoredClientP;
+    long count = 0;
+
+    restoredClientP = restoredP->clientList;
+    for (clientP = contextP->clientList ; clientP != NULL ; clientP = clientP->next)
+    {
+        if (clientP->endOfLife <= host_now) continue;
+        if (excluded != NULL && strcmp(clientP->name, excluded) == 0) continue;
+
+        HOST_CHECK(restoredClientP != NULL);
+        HOST_CHECK(restoredClientP->internalID == clientP->internalID);
+        HOST_CHECK(strcmp(restoredClientP->name, clientP->name) == 0);
+        HOST_CHECK(prv_sameString(restoredClientP->msisdn, clientP->msisdn));
+        HOST_CHECK(prv_sameString(restoredClientP->altPath, clientP->altPath));
+        HOST_CHECK(restoredClientP->lifetime == clientP->lifetime);
+        HOST_CHECK(restoredClientP->endOfLife == clientP->endOfLife);
+        HOST_CHECK(restoredClientP->binding == clientP->binding);
+        HOST_CHECK(restoredClientP->sessionH == clientP->sessionH);
+        HOST_CHECK(prv_sameObjects(restoredClientP->objectList, clientP->objectList));
+        HOST_CHECK(lifetime_get_client(restoredP, clientP->internalID) == restoredClientP);
+        HOST_CHECK(lifetime_find_client(restoredP, clientP->name) == restoredClientP);
+        // the clients registered with the same payload share their objects
+        if (restoredClientP != restoredP->clientList && prv_sameObjects(restoredClientP->objectList, restoredP->clientList->objectList))
+        {
+            HOST_CHECK(restoredClientP->sharedObjects == restoredP->clientList->sharedObjects);
+        }
+        restoredClientP = restoredClientP->next;
+        count++;
+    }
+    HOST_CHECK(restoredClientP == NULL);
+    HOST_CHECK(restoredP->lifetimeCount == (size_t)count);
+
+    return count;
+}
+
+static lwm2m_context_t * prv_restore(registry_t * registryP,
+                                     size_t length)
+{
+    lwm2m_context_t * contextP;
+
+    contextP = lwm2m_init(NULL, prv_send, NULL);
+    HOST_CHECK(contextP != NULL);
+    lwm2m_set_registry_callbacks(contextP, prv_store, prv_encode, prv_decode, registryP);
+    HOST_CHECK(lwm2m_registry_restore(contextP, registryP->buffer, length) == COAP_NO_ERROR);
+
+    return contextP;
+}
+
+int main(void)
+{
+    static uint16_t ids[REGISTRY_CLIENTS];
+    registry_t registry;
+    lwm2m_context_t * contextP;
+    lwm2m_context_t * restoredP;
+    char name[32];
+    uint16_t freeID;
+    size_t complete;
+    size_t torn;
+    long updated = 0;
+    long deregistered = 0;
+    long expired = 0;
+    long again = 0;
+    long count;
+    time_t timeout;
+    int i;
+
+    memset(&registry, 0, sizeof(registry));
+    contextP = lwm2m_init(NULL, prv_send, NULL);
+    HOST_CHECK(contextP != NULL);
+    lwm2m_set_registry_callbacks(contextP, prv_store, prv_encode, prv_decode, &registry);
+
+    // one client in ten expires while the server runs, one in ten while it is stopped
+    for (i = 0 ; i < REGISTRY_CLIENTS ; i++)
+    {
+        snprintf(name, sizeof(name), "client%d", i);
+        ids[i] = prv_register(contextP, name,
+                              (i % 10 == 0) ? "lt=60" : (i % 10 == 1) ? "lt=600" : "lt=86400",
+                              (i % 3 == 0) ? "b=UQ" : NULL,
+                              payloads[i % REGISTRY_PAYLOADS], i + 1);
+    }
+    for (i = 0 ; i < REGISTRY_CLIENTS ; i++)
+    {
+        if (i % 7 != 3) continue;
+        HOST_CHECK(prv_request(contextP, COAP_PUT, ids[i], NULL, "lt=172800", NULL,
+                               (i % 14 == 3) ? payloads[(i + 1) % REGISTRY_PAYLOADS] : NULL,
+                               REGISTRY_CLIENTS + i + 1) == COAP_204_CHANGED);
+        updated++;
+    }
+    for (i = 0 ; i < REGISTRY_CLIENTS ; i++)
+    {
+        if (i % 5 != 2) continue;
+        HOST_CHECK(prv_request(contextP, COAP_DELETE, ids[i], NULL, NULL, NULL, NULL, 0) == COAP_202_DELETED);
+        deregistered++;
+    }
+    host_now += 61;
+    timeout = 60;
+    expired = contextP->lifetimeCount;
+    HOST_CHECK(lwm2m_step(contextP, &timeout) == 0);
+    expired -= contextP->lifetimeCount;
+    // new names on the IDs freed
+    for (i = 0 ; i < REGISTRY_CLIENTS ; i += 97)
+    {
+        uint16_t id;
+
+        snprintf(name, sizeof(name), "again%d", i);
+        id = prv_register(contextP, name, "lt=86400", NULL, payloads[0], 2 * REGISTRY_CLIENTS + i + 1);
+        HOST_CHECK(id < REGISTRY_CLIENTS);
+        again++;
+    }
+    HOST_CHECK(contextP->lifetimeCount == REGISTRY_CLIENTS - deregistered - expired + again);
+
+    // the last record is partially written
+    complete = registry.length;
+    prv_register(contextP, "torn", "lt=86400", NULL, payloads[1], 3 * REGISTRY_CLIENTS);
+    torn = registry.length - complete;
+    HOST_CHECK(torn > 16);
+
+    host_now += 600;
+    restoredP = prv_restore(&registry, registry.length);
+    count = prv_checkRestored(contextP, restoredP, NULL);
+    lwm2m_close(restoredP);
+    for (i = 1 ; i < (int)torn ; i += (i < 16) ? 1 : 7)
+    {
+        restoredP = prv_restore(&registry, complete + i);
+        HOST_CHECK(prv_checkRestored(contextP, restoredP, "torn") == count - 1);
+        lwm2m_close(restoredP);
+    }
+    // the checksum of the last record is wrong
+    registry.buffer[registry.length - 3] ^= 0x20;
+    restoredP = prv_restore(&registry, registry.length);
+    HOST_CHECK(prv_checkRestored(contextP, restoredP, "torn") == count - 1);
+    HOST_CHECK(count < REGISTRY_CLIENTS - deregistered - expired + again);
+    HOST_CHECK(lwm2m_registry_restore(restoredP, registry.buffer, registry.length) == COAP_412_PRECONDITION_FAILED);
+
+    // the restored clients update, deregister and expire as registered ones
+    registry.length = 0;
+    lwm2m_registry_snapshot(restoredP);
+    complete = registry.length;
+    HOST_CHECK(prv_request(restoredP, COAP_PUT, ids[3], NULL, "lt=60", NULL, payloads[2], 1) == COAP_204_CHANGED);
+    HOST_CHECK(prv_request(restoredP, COAP_DELETE, ids[4], NULL, NULL, NULL, NULL, 0) == COAP_202_DELETED);
+    for (freeID = 0 ; lifetime_get_client(restoredP, freeID) != NULL ; freeID++);
+    HOST_CHECK(prv_request(restoredP, COAP_DELETE, freeID, NULL, NULL, NULL, NULL, 0) == COAP_400_BAD_REQUEST);
+    HOST_CHECK(prv_request(restoredP, COAP_POST, 0, "ep=client5", "lt=86400", NULL, payloads[0], 5) == COAP_201_CREATED);
+    HOST_CHECK(lifetime_find_client(restoredP, "client5")->sessionH == (void *)5);
+    HOST_CHECK(prv_register(restoredP, "torn", "lt=86400", NULL, payloads[1], 3 * REGISTRY_CLIENTS) == freeID);
+    host_now += 61;
+    timeout = 60;
+    HOST_CHECK(lwm2m_step(restoredP, &timeout) == 0);
+    HOST_CHECK(lifetime_get_client(restoredP, ids[3]) == NULL);
+    HOST_CHECK(restoredP->lifetimeCount == (size_t)count - 2);
+
+    // the snapshot and the records after it give the same registry again
+    HOST_CHECK(registry.length > complete);
+    lwm2m_close(contextP);
+    contextP = prv_restore(&registry, registry.length);
+    HOST_CHECK(prv_checkRestored(restoredP, contextP, NULL) == count - 2);
+
+    lwm2m_close(contextP);
+    lwm2m_close(restoredP);
+    free(registry.buffer);
+    HOST_CHECK(host_live_blocks == 0);
+
+    printf("registry_test: %d clients, %ld updated, %ld deregistered, %ld expired, %ld registered again, %ld restored\n",
+           REGISTRY_CLIENTS, updated, deregistered, expired, again, count);
+    printf("registry_test: ok\n");
+    return 0;
+}
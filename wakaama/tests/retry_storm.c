@@ -0,0 +1,212 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - host tests
+ *
+ *******************************************************************************/
+
+/*
+ * Registration storm after a server outage, with the delays of
+ * utils_retryDelay().
+ *
+ * STORM_CLIENTS clients registered with a STORM_LIFETIME lifetime send
+ * their updates while the server is down from STORM_OUTAGE_START to
+ * STORM_OUTAGE_END. Requests sent during the outage time out after
+ * STORM_EXCHANGE_TIMEOUT. The server then registers STORM_CAPACITY
+ * clients per second and answers 5.03 to the others.
+ * The previous policy, retrying one lifetime later, is run for reference.
+ * "after -1 s" means never within STORM_DURATION.
+ */
+
+#include "host.h"
+
+#define STORM_CLIENTS           10000
+#define STORM_DURATION          30000
+#define STORM_LIFETIME          300
+#define STORM_OUTAGE_START      100
+#define STORM_OUTAGE_END        1300
+#define STORM_CAPACITY          100     // registrations per second after the outage
+#define STORM_EXCHANGE_TIMEOUT  93      // MAX_TRANSMIT_WAIT of an unanswered confirmable request
+#define STORM_MAX_AGE           60      // hint of the 5.03 responses
+
+typedef enum
+{
+    POLICY_LIFETIME,
+    POLICY_BACKOFF,
+    POLICY_BACKOFF_MAX_AGE
+} storm_policy_t;
+
+typedef enum
+{
+    CLIENT_REGISTERED,
+    CLIENT_WAITING,
+    CLIENT_FAILED
+} storm_state_t;
+
+typedef struct
+{
+    lwm2m_context_t context;
+    storm_state_t   state;
+    uint8_t         retryCount;
+    long            next;       // time of the next request
+    long            timeout;    // of the request sent during the outage
+} storm_client_t;
+
+typedef struct
+{
+    int  peak;              // requests per second after the outage
+    int  overCapacity;      // seconds above the capacity
+    long back99;            // seconds after the outage until 99% are registered, -1 if never
+    long backAll;
+} storm_result_t;
+
+static storm_client_t clients[STORM_CLIENTS];
+static int arrivals[STORM_DURATION];
+
+static long prv_retry(storm_client_t * clientP,
+                      storm_policy_t policy,
+                      long now,
+                      bool serviceUnavailable)
+{
+    long delay;
+
+    if (policy == POLICY_LIFETIME) return now + STORM_LIFETIME;
+
+    delay = utils_retryDelay(&clientP->context, &clientP->retryCount);
+    if (policy == POLICY_BACKOFF_MAX_AGE && serviceUnavailable) delay += STORM_MAX_AGE;
+
+    return now + delay;
+}
+
+static void prv_run(storm_policy_t policy,
+                    storm_result_t * resultP)
+{
+    long now;
+    int i;
+
+    memset(arrivals, 0, sizeof(arrivals));
+    memset(resultP, 0, sizeof(storm_result_t));
+    resultP->back99 = -1;
+    resultP->backAll = -1;
+    for (i = 0 ; i < STORM_CLIENTS ; i++)
+    {
+        clients[i].state = CLIENT_REGISTERED;
+        clients[i].retryCount = 0;
+        clients[i].next = STORM_LIFETIME - 15;
+    }
+
+    for (now = 0 ; now < STORM_DURATION ; now++)
+    {
+        bool up = (now < STORM_OUTAGE_START || now >= STORM_OUTAGE_END);
+        int served = 0;
+        int registered = 0;
+
+        for (i = 0 ; i < STORM_CLIENTS ; i++)
+        {
+            storm_client_t * clientP = clients + i;
+
+            if (clientP->state == CLIENT_WAITING)
+            {
+                if (clientP->timeout > now) continue;
+                clientP->state = CLIENT_FAILED;
+                clientP->next = prv_retry(clientP, policy, now, false);
+            }
+            if (clientP->next > now) continue;
+
+            arrivals[now]++;
+            if (!up)
+            {
+                clientP->state = CLIENT_WAITING;
+                clientP->timeout = now + STORM_EXCHANGE_TIMEOUT;
+            }
+            else if (served < STORM_CAPACITY)
+            {
+                served++;
+                clientP->state = CLIENT_REGISTERED;
+                clientP->retryCount = 0;
+                clientP->next = now + STORM_LIFETIME - 15;
+            }
+            else
+            {
+                clientP->state = CLIENT_FAILED;
+                clientP->next = prv_retry(clientP, policy, now, true);
+            }
+        }
+
+        if (now < STORM_OUTAGE_END) continue;
+
+        for (i = 0 ; i < STORM_CLIENTS ; i++)
+        {
+            if (clients[i].state == CLIENT_REGISTERED) registered++;
+        }
+        if (arrivals[now] > resultP->peak) resultP->peak = arrivals[now];
+        if (arrivals[now] > STORM_CAPACITY) resultP->overCapacity++;
+        if (resultP->back99 < 0 && registered >= STORM_CLIENTS * 99 / 100) resultP->back99 = now - STORM_OUTAGE_END;
+        if (resultP->backAll < 0 && registered == STORM_CLIENTS) resultP->backAll = now - STORM_OUTAGE_END;
+    }
+}
+
+static void prv_print(const char * name,
+                      storm_result_t * resultP)
+{
+    int minute;
+
+    printf("%-28s peak %5d req/s, %4d s over capacity, 99%% back after %ld s, all back after %ld s\n",
+           name, resultP->peak, resultP->overCapacity, resultP->back99, resultP->backAll);
+    printf("    peak req/s of each minute after the outage:");
+    for (minute = 0 ; minute < 20 ; minute++)
+    {
+        int peak = 0;
+        int second;
+
+        for (second = 0 ; second < 60 ; second++)
+        {
+            int count = arrivals[STORM_OUTAGE_END + minute * 60 + second];
+
+            if (count > peak) peak = count;
+        }
+        printf(" %d", peak);
+    }
+    printf("\n");
+}
+
+int main(void)
+{
+    storm_result_t result;
+    int i;
+
+    for (i = 0 ; i < STORM_CLIENTS ; i++)
+    {
+        char name[16];
+
+        snprintf(name, sizeof(name), "dev%05d", i);
+        clients[i].context.endpointName = name;
+        utils_seedRandom(&clients[i].context);
+        clients[i].context.endpointName = NULL;
+    }
+
+    prv_run(POLICY_LIFETIME, &result);
+    prv_print("retry after one lifetime", &result);
+
+    prv_run(POLICY_BACKOFF, &result);
+    prv_print("jittered backoff", &result);
+    HOST_CHECK(result.overCapacity == 0);
+    HOST_CHECK(result.backAll >= 0);
+
+    prv_run(POLICY_BACKOFF_MAX_AGE, &result);
+    prv_print("jittered backoff + Max-Age", &result);
+    HOST_CHECK(result.overCapacity == 0);
+    HOST_CHECK(result.backAll >= 0);
+
+    return 0;
+}
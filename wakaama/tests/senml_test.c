@@ -0,0 +1,230 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - host tests
+ *
+ *******************************************************************************/
+
+/*
+ * SenML CBOR content format, see senml_cbor.c: an instance written then
+ * read back, rejected records and mutations of a valid pack. Whatever the
+ * input, the parser must leave no block allocated.
+ */
+
+#include "host.h"
+
+#define SENML_MUTATIONS 200000
+
+static lwm2m_uri_t prv_uri(int objectId,
+                           int instanceId)
+{
+    lwm2m_uri_t uri;
+
+    memset(&uri, 0, sizeof(uri));
+    uri.flag = LWM2M_URI_FLAG_OBJECT_ID | LWM2M_URI_FLAG_INSTANCE_ID;
+    uri.objectId = objectId;
+    uri.instanceId = instanceId;
+    return uri;
+}
+
+// 5700 float, 5701 string, 5601 integer, 5850 boolean and 6000 with two instances
+static lwm2m_tlv_t * prv_instance(int * sizeP)
+{
+    lwm2m_tlv_t * tlvP;
+    lwm2m_tlv_t * subTlvP;
+
+    *sizeP = 5;
+    tlvP = lwm2m_tlv_new(*sizeP);
+    subTlvP = lwm2m_tlv_new(2);
+    HOST_CHECK(tlvP != NULL && subTlvP != NULL);
+    tlvP[0].type = tlvP[1].type = tlvP[2].type = tlvP[3].type = LWM2M_TYPE_RESOURCE;
+    subTlvP[0].type = subTlvP[1].type = LWM2M_TYPE_RESOURCE_INSTANCE;
+
+    tlvP[0].id = 5700;
+    lwm2m_tlv_encode_float(21.5, tlvP + 0);
+    tlvP[1].id = 5701;
+    tlvP[1].flags = LWM2M_TLV_FLAG_STATIC_DATA;
+    tlvP[1].dataType = LWM2M_TYPE_STRING;
+    tlvP[1].value = (uint8_t *)"Cel";
+    tlvP[1].length = 3;
+    tlvP[2].id = 5601;
+    lwm2m_tlv_encode_int(-3, tlvP + 2);
+    tlvP[3].id = 5850;
+    lwm2m_tlv_encode_bool(true, tlvP + 3);
+
+    subTlvP[0].id = 0;
+    lwm2m_tlv_encode_int(1, subTlvP + 0);
+    subTlvP[1].id = 1;
+    lwm2m_tlv_encode_int(100000, subTlvP + 1);
+    tlvP[4].id = 6000;
+    lwm2m_tlv_include(subTlvP, 2, tlvP + 4);
+
+    return tlvP;
+}
+
+static void prv_checkRoundTrip(uint8_t ** bufferP,
+                               int * lengthP)
+{
+    lwm2m_uri_t uri = prv_uri(3303, 0);
+    lwm2m_tlv_t * tlvP;
+    lwm2m_tlv_t * parsedP;
+    int size;
+    int64_t value;
+    double number;
+    bool flag;
+
+    tlvP = prv_instance(&size);
+    *lengthP = senml_cbor_serialize(&uri, size, tlvP, bufferP);
+    HOST_CHECK(*lengthP > 0);
+    lwm2m_tlv_free(size, tlvP);
+
+    size = senml_cbor_parse_tlv(&uri, *bufferP, *lengthP, &parsedP);
+    HOST_CHECK(size == 5);
+    HOST_CHECK(parsedP[0].id == 5700 && lwm2m_tlv_decode_float(parsedP + 0, &number) == 1 && number == 21.5);
+    HOST_CHECK(parsedP[1].id == 5701 && parsedP[1].length == 3 && memcmp(parsedP[1].value, "Cel", 3) == 0);
+    HOST_CHECK(parsedP[2].id == 5601 && lwm2m_tlv_decode_int(parsedP + 2, &value) == 1 && value == -3);
+    HOST_CHECK(parsedP[3].id == 5850 && lwm2m_tlv_decode_bool(parsedP + 3, &flag) == 1 && flag);
+    HOST_CHECK(parsedP[4].id == 6000 && parsedP[4].type == LWM2M_TYPE_MULTIPLE_RESOURCE && parsedP[4].length == 2);
+    tlvP = (lwm2m_tlv_t *)parsedP[4].value;
+    HOST_CHECK(tlvP[1].id == 1 && lwm2m_tlv_decode_int(tlvP + 1, &value) == 1 && value == 100000);
+    lwm2m_tlv_free(size, parsedP);
+
+    // written to another object
+    uri = prv_uri(3304, 0);
+    HOST_CHECK(senml_cbor_parse_tlv(&uri, *bufferP, *lengthP, &parsedP) == 0);
+}
+
+static void prv_checkRejected(const char * name,
+                              const uint8_t * buffer,
+                              size_t length)
+{
+    lwm2m_uri_t uri = prv_uri(3303, 0);
+    lwm2m_tlv_t * parsedP;
+    long before = host_live_blocks;
+
+    if (senml_cbor_parse_tlv(&uri, (uint8_t *)buffer, length, &parsedP) != 0)
+    {
+        fprintf(stderr, "%s: accepted\n", name);
+        exit(1);
+    }
+    HOST_CHECK(parsedP == NULL);
+    if (host_live_blocks != before)
+    {
+        fprintf(stderr, "%s: %ld blocks leaked\n", name, host_live_blocks - before);
+        exit(1);
+    }
+}
+
+// [{0: name, 2: 1}, ...]
+static size_t prv_pack(uint8_t * buffer,
+                       const char * const * names,
+                       int count)
+{
+    size_t length = 0;
+    int i;
+
+    buffer[length++] = 0x80 + count;
+    for (i = 0 ; i < count ; i++)
+    {
+        size_t nameLength = strlen(names[i]);
+
+        buffer[length++] = 0xA2;
+        buffer[length++] = 0x00;
+        buffer[length++] = 0x60 + nameLength;
+        memcpy(buffer + length, names[i], nameLength);
+        length += nameLength;
+        buffer[length++] = 0x02;
+        buffer[length++] = 0x01;
+    }
+    return length;
+}
+
+static void prv_checkNames(void)
+{
+    static const char * const badId[] = { "/3303/0/70000" };
+    static const char * const badName[] = { "/3303/0/5700/", "/3303/0/5701" };
+    static const char * const badInstance[] = { "/3303/0/6000/0", "/3303/0/6000/1", "/3303/0/x" };
+    static const char * const badSecond[] = { "/3303/0/6000/0", "/3303/1/6000/1" };
+    uint8_t buffer[128];
+
+    prv_checkRejected("identifier of 70000", buffer, prv_pack(buffer, badId, 1));
+    prv_checkRejected("bad first name", buffer, prv_pack(buffer, badName, 2));
+    prv_checkRejected("bad name after an instance", buffer, prv_pack(buffer, badInstance, 3));
+    prv_checkRejected("other object instance", buffer, prv_pack(buffer, badSecond, 2));
+}
+
+static void prv_checkMutations(const uint8_t * buffer,
+                               int length)
+{
+    lwm2m_uri_t uri = prv_uri(3303, 0);
+    uint8_t mutated[256];
+    long before = host_live_blocks;
+    int accepted = 0;
+    int i;
+
+    HOST_CHECK(length <= (int)sizeof(mutated));
+    srand(1);
+    for (i = 0 ; i < SENML_MUTATIONS ; i++)
+    {
+        lwm2m_tlv_t * parsedP;
+        int mutatedLength = length;
+        int changes = 1 + rand() % 4;
+        int size;
+
+        memcpy(mutated, buffer, length);
+        while (changes-- > 0)
+        {
+            switch (rand() % 3)
+            {
+            case 0:
+                mutated[rand() % mutatedLength] = rand();
+                break;
+            case 1:
+                mutated[rand() % mutatedLength] ^= 1 << (rand() % 8);
+                break;
+            default:
+                mutatedLength = 1 + rand() % mutatedLength;
+                break;
+            }
+        }
+
+        size = senml_cbor_parse_tlv(&uri, mutated, mutatedLength, &parsedP);
+        if (size > 0)
+        {
+            accepted++;
+            lwm2m_tlv_free(size, parsedP);
+        }
+        if (host_live_blocks != before)
+        {
+            fprintf(stderr, "mutation %d: %ld blocks leaked\n", i, host_live_blocks - before);
+            exit(1);
+        }
+    }
+    printf("senml_test: %d of %d mutations accepted\n", accepted, SENML_MUTATIONS);
+}
+
+int main(void)
+{
+    uint8_t * buffer;
+    int length;
+
+    prv_checkRoundTrip(&buffer, &length);
+    prv_checkNames();
+    prv_checkMutations(buffer, length);
+    lwm2m_free(buffer);
+
+    HOST_CHECK(host_live_blocks == 0);
+
+    printf("senml_test: ok\n");
+    return 0;
+}
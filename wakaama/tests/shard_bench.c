@@ -0,0 +1,330 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - host tests
+ *
+ *******************************************************************************/
+
+/*
+ * Throughput of the sharded server runtime, see host/shard.c.
+ *
+ * A closed loop load over the loopback: each of BENCH_SOCKETS sockets has
+ * one request in flight and sends the next one on its answer. During
+ * BENCH_SECONDS the sockets register a new endpoint, deregister it and
+ * register again, then every client is observed and answers each ACK with
+ * the next CON notification. The rates are given for 1 to 8 workers; the
+ * load runs on the main thread, so the runtime gets the other cores.
+ */
+
+#include "host.h"
+#include "shard.h"
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define BENCH_SOCKETS   256
+#define BENCH_SECONDS   1.0
+#define BENCH_RESEND_NS 1e9
+#define BENCH_WAIT_NS   10e9
+
+typedef enum
+{
+    PEER_REGISTERING,
+    PEER_DEREGISTERING,
+    PEER_REGISTERED,
+    PEER_NOTIFYING,
+    PEER_DONE
+} peer_state_t;
+
+typedef struct
+{
+    int      sock;
+    peer_state_t state;
+    uint16_t mid;           // of the request in flight, each socket has its own so the server does not take one for a duplicate
+    double   sentAt;
+    uint8_t  buffer[128];
+    size_t   length;
+    char     location[16];
+    int      endpoints;
+    uint8_t  token[8];
+    uint8_t  tokenLen;
+    uint32_t observe;
+} peer_t;
+
+static peer_t peers[BENCH_SOCKETS];
+static bool running;
+static long registrations;
+static long acked;
+static long notified;
+static long observed;
+
+static void prv_send(peer_t * peerP,
+                     coap_packet_t * messageP)
+{
+    peerP->length = coap_serialize_message(messageP, peerP->buffer);
+    HOST_CHECK(peerP->length != 0);
+    HOST_CHECK(send(peerP->sock, peerP->buffer, peerP->length, 0) == (ssize_t)peerP->length);
+    peerP->sentAt = host_clock_ns();
+}
+
+static void prv_register(peer_t * peerP)
+{
+    coap_packet_t message;
+    char query[32];
+
+    coap_init_message(&message, COAP_TYPE_CON, COAP_POST, ++peerP->mid);
+    coap_set_header_uri_path(&message, "/rd");
+    snprintf(query, sizeof(query), "ep=b%d-%d&lt=300", (int)(peerP - peers), peerP->endpoints++);
+    coap_set_header_uri_query(&message, query);
+    coap_set_header_content_type(&message, APPLICATION_LINK_FORMAT);
+    coap_set_payload(&message, "</3/0>", 6);
+    prv_send(peerP, &message);
+    peerP->state = PEER_REGISTERING;
+}
+
+static void prv_deregister(peer_t * peerP)
+{
+    coap_packet_t message;
+
+    coap_init_message(&message, COAP_TYPE_CON, COAP_DELETE, ++peerP->mid);
+    coap_set_header_uri_path(&message, peerP->location);
+    prv_send(peerP, &message);
+    peerP->state = PEER_DEREGISTERING;
+}
+
+static void prv_notify(peer_t * peerP)
+{
+    coap_packet_t message;
+
+    coap_init_message(&message, COAP_TYPE_CON, COAP_205_CONTENT, ++peerP->mid);
+    coap_set_header_token(&message, peerP->token, peerP->tokenLen);
+    coap_set_header_observe(&message, ++peerP->observe);
+    coap_set_header_content_type(&message, LWM2M_CONTENT_TEXT);
+    coap_set_payload(&message, "21", 2);
+    prv_send(peerP, &message);
+    peerP->state = PEER_NOTIFYING;
+}
+
+// the answer to the observation: 2.05 then the first notification
+static void prv_observed(peer_t * peerP,
+                         coap_packet_t * requestP)
+{
+    coap_packet_t response;
+    uint8_t buffer[128];
+    size_t length;
+
+    coap_init_message(&response, COAP_TYPE_ACK, COAP_205_CONTENT, requestP->mid);
+    coap_set_header_token(&response, requestP->token, requestP->token_len);
+    coap_set_header_observe(&response, 1);
+    coap_set_header_content_type(&response, LWM2M_CONTENT_TEXT);
+    coap_set_payload(&response, "20", 2);
+    length = coap_serialize_message(&response, buffer);
+    HOST_CHECK(length != 0);
+    HOST_CHECK(send(peerP->sock, buffer, length, 0) == (ssize_t)length);
+
+    memcpy(peerP->token, requestP->token, requestP->token_len);
+    peerP->tokenLen = requestP->token_len;
+    peerP->observe = 1;
+    prv_notify(peerP);
+}
+
+static void prv_handle(peer_t * peerP,
+                       coap_packet_t * messageP)
+{
+    if (messageP->type == COAP_TYPE_CON && messageP->code == COAP_GET)
+    {
+        if (peerP->state == PEER_REGISTERED) prv_observed(peerP, messageP);
+        return;
+    }
+    if (messageP->type != COAP_TYPE_ACK || messageP->mid != peerP->mid) return;
+
+    switch (peerP->state)
+    {
+    case PEER_REGISTERING:
+    {
+        char * location;
+
+        HOST_CHECK(messageP->code == COAP_201_CREATED);
+        location = coap_get_multi_option_as_string(messageP->location_path);
+        HOST_CHECK(location != NULL && strlen(location) < sizeof(peerP->location));
+        strcpy(peerP->location, location);
+        lwm2m_free(location);
+        registrations++;
+        if (running) prv_deregister(peerP);
+        else peerP->state = PEER_REGISTERED;
+        break;
+    }
+
+    case PEER_DEREGISTERING:
+        HOST_CHECK(messageP->code == COAP_202_DELETED);
+        prv_register(peerP);
+        break;
+
+    case PEER_NOTIFYING:
+        acked++;
+        if (running) prv_notify(peerP);
+        else peerP->state = PEER_DONE;
+        break;
+
+    default:
+        break;
+    }
+}
+
+// runs the load until every socket is in state
+static void prv_load(struct pollfd * fds,
+                     peer_state_t state)
+{
+    double start = host_clock_ns();
+    int waiting = BENCH_SOCKETS;
+
+    while (waiting > 0)
+    {
+        double now = host_clock_ns();
+        int i;
+
+        HOST_CHECK(now - start < BENCH_WAIT_NS + BENCH_SECONDS * 1e9);
+        if (running && now - start >= BENCH_SECONDS * 1e9) running = false;
+        if (poll(fds, BENCH_SOCKETS, 1) < 0) continue;
+
+        waiting = 0;
+        for (i = 0 ; i < BENCH_SOCKETS ; i++)
+        {
+            peer_t * peerP = peers + i;
+
+            if (fds[i].revents & POLLIN)
+            {
+                uint8_t buffer[256];
+                ssize_t length;
+
+                while ((length = recv(peerP->sock, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0)
+                {
+                    coap_packet_t message;
+
+                    if (coap_parse_message(&message, buffer, length) != NO_ERROR) continue;
+                    prv_handle(peerP, &message);
+                    coap_free_header(&message);
+                }
+            }
+            if (peerP->state != state)
+            {
+                waiting++;
+                if ((peerP->state == PEER_REGISTERING || peerP->state == PEER_DEREGISTERING || peerP->state == PEER_NOTIFYING)
+                 && now - peerP->sentAt > BENCH_RESEND_NS)
+                {
+                    HOST_CHECK(send(peerP->sock, peerP->buffer, peerP->length, 0) == (ssize_t)peerP->length);
+                    peerP->sentAt = now;
+                }
+            }
+        }
+    }
+}
+
+static void prv_result(uint16_t clientID,
+                       lwm2m_uri_t * uriP,
+                       int status,
+                       uint8_t * data,
+                       int dataLength,
+                       void * userData)
+{
+    if (status == 0) __atomic_add_fetch(&observed, 1, __ATOMIC_RELEASE);
+    else __atomic_add_fetch(&notified, 1, __ATOMIC_RELAXED);
+}
+
+// observes the temperature of every client of the worker
+static void prv_observeAll(lwm2m_context_t * contextP,
+                           void * arg)
+{
+    lwm2m_client_t * clientP;
+    lwm2m_uri_t uri;
+
+    memset(&uri, 0, sizeof(uri));
+    uri.flag = LWM2M_URI_FLAG_OBJECT_ID | LWM2M_URI_FLAG_INSTANCE_ID | LWM2M_URI_FLAG_RESOURCE_ID;
+    uri.objectId = 3;
+    uri.instanceId = 0;
+    uri.resourceId = 9;
+    for (clientP = contextP->clientList ; clientP != NULL ; clientP = clientP->next)
+    {
+        HOST_CHECK(lwm2m_observe(contextP, clientP->internalID, &uri, prv_result, NULL) == 0);
+    }
+}
+
+static void prv_run(int shardCount)
+{
+    lwm2m_shard_runtime_t * runtimeP;
+    struct pollfd fds[BENCH_SOCKETS];
+    struct sockaddr_in addr;
+    double start;
+    double registerRate;
+    double notifyRate;
+    int i;
+
+    runtimeP = lwm2m_shard_start("0", shardCount, true, NULL, NULL);
+    HOST_CHECK(runtimeP != NULL);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(lwm2m_shard_port(runtimeP));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    memset(peers, 0, sizeof(peers));
+    for (i = 0 ; i < BENCH_SOCKETS ; i++)
+    {
+        peers[i].sock = socket(AF_INET, SOCK_DGRAM, 0);
+        HOST_CHECK(peers[i].sock >= 0);
+        HOST_CHECK(connect(peers[i].sock, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+        fds[i].fd = peers[i].sock;
+        fds[i].events = POLLIN;
+    }
+
+    registrations = 0;
+    running = true;
+    start = host_clock_ns();
+    for (i = 0 ; i < BENCH_SOCKETS ; i++) prv_register(peers + i);
+    prv_load(fds, PEER_REGISTERED);
+    registerRate = registrations / (host_clock_ns() - start) * 1e9;
+
+    observed = 0;
+    notified = 0;
+    for (i = 0 ; i < shardCount ; i++)
+    {
+        HOST_CHECK(lwm2m_shard_call(runtimeP, i, prv_observeAll, NULL) == COAP_NO_ERROR);
+    }
+    acked = 0;
+    running = true;
+    start = host_clock_ns();
+    prv_load(fds, PEER_DONE);
+    notifyRate = acked / (host_clock_ns() - start) * 1e9;
+    HOST_CHECK(__atomic_load_n(&observed, __ATOMIC_ACQUIRE) == BENCH_SOCKETS);
+
+    lwm2m_shard_stop(runtimeP);
+    // a notification is taken for the response to the observation if its ACK was dropped by a full socket
+    HOST_CHECK(notified <= acked && acked - notified <= BENCH_SOCKETS);
+    for (i = 0 ; i < BENCH_SOCKETS ; i++) close(peers[i].sock);
+    HOST_CHECK(host_live_blocks == 0);
+
+    printf("%6d %10ld %14.0f %14.0f\n", shardCount, registrations, registerRate, notifyRate);
+}
+
+int main(void)
+{
+    printf("%d cores, %d sockets\n", (int)sysconf(_SC_NPROCESSORS_ONLN), BENCH_SOCKETS);
+    printf("%6s %10s %14s %14s\n", "shards", "endpoints", "register/s", "notify/s");
+    prv_run(1);
+    prv_run(2);
+    prv_run(4);
+    prv_run(8);
+
+    return 0;
+}
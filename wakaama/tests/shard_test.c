@@ -0,0 +1,338 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - host tests
+ *
+ *******************************************************************************/
+
+/*
+ * Sharded server runtime, see host/shard.c.
+ *
+ * SHARD_CLIENTS clients register over UDP on the loopback with
+ * SHARD_WORKERS workers, each from its own port. The reads, writes and
+ * observations requested from the main thread must reach every client
+ * through its worker and call back on the thread of that worker, and the
+ * requests to an unknown worker or client must be refused.
+ */
+
+#include "host.h"
+#include "shard.h"
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define SHARD_WORKERS   3
+#define SHARD_CLIENTS   24
+#define SHARD_WAIT_NS   5e9
+
+static lwm2m_shard_runtime_t * runtimeP;
+static uint16_t port;
+static int socks[SHARD_CLIENTS];
+static int stopClients;
+
+static lwm2m_shard_client_t clients[SHARD_CLIENTS];
+static int registered;
+static int initialized;
+static int perShard[SHARD_WORKERS];
+static int reads;
+static int writes;
+static int notifications;
+static int refused;
+static int calls;
+static int wrongThread;
+
+static void prv_sendTo(int sock,
+                       coap_packet_t * messageP)
+{
+    uint8_t buffer[256];
+    size_t length;
+    struct sockaddr_in addr;
+
+    length = coap_serialize_message(messageP, buffer);
+    HOST_CHECK(length != 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    HOST_CHECK(sendto(sock, buffer, length, 0, (struct sockaddr *)&addr, sizeof(addr)) == (ssize_t)length);
+}
+
+static void prv_wait(int * counterP,
+                     int expected)
+{
+    double start = host_clock_ns();
+
+    while (__atomic_load_n(counterP, __ATOMIC_ACQUIRE) < expected)
+    {
+        HOST_CHECK(host_clock_ns() - start < SHARD_WAIT_NS);
+        usleep(1000);
+    }
+}
+
+// the clients answer the requests: 2.05 with their index to a GET, followed by a notification if observed, 2.04 otherwise
+static void * prv_runClients(void * arg)
+{
+    struct pollfd fds[SHARD_CLIENTS];
+    int i;
+
+    for (i = 0 ; i < SHARD_CLIENTS ; i++)
+    {
+        fds[i].fd = socks[i];
+        fds[i].events = POLLIN;
+    }
+    while (!__atomic_load_n(&stopClients, __ATOMIC_ACQUIRE))
+    {
+        if (poll(fds, SHARD_CLIENTS, 10) <= 0) continue;
+        for (i = 0 ; i < SHARD_CLIENTS ; i++)
+        {
+            uint8_t buffer[256];
+            coap_packet_t request;
+            coap_packet_t response;
+            char text[8];
+            uint32_t observe;
+            ssize_t length;
+
+            if ((fds[i].revents & POLLIN) == 0) continue;
+            length = recv(socks[i], buffer, sizeof(buffer), 0);
+            if (length <= 0) continue;
+            if (coap_parse_message(&request, buffer, length) != NO_ERROR) continue;
+            if (request.type != COAP_TYPE_CON || request.code == COAP_201_CREATED)
+            {
+                coap_free_header(&request);
+                continue;
+            }
+
+            snprintf(text, sizeof(text), "%d", i);
+            coap_init_message(&response, COAP_TYPE_ACK, (request.code == COAP_GET) ? COAP_205_CONTENT : COAP_204_CHANGED, request.mid);
+            coap_set_header_token(&response, request.token, request.token_len);
+            if (request.code == COAP_GET)
+            {
+                coap_set_header_content_type(&response, LWM2M_CONTENT_TEXT);
+                coap_set_payload(&response, text, strlen(text));
+            }
+            observe = IS_OPTION(&request, COAP_OPTION_OBSERVE);
+            if (observe) coap_set_header_observe(&response, 1);
+            prv_sendTo(socks[i], &response);
+
+            if (observe)
+            {
+                coap_init_message(&response, COAP_TYPE_NON, COAP_205_CONTENT, coap_get_mid());
+                coap_set_header_token(&response, request.token, request.token_len);
+                coap_set_header_observe(&response, 2);
+                coap_set_header_content_type(&response, LWM2M_CONTENT_TEXT);
+                coap_set_payload(&response, text, strlen(text));
+                prv_sendTo(socks[i], &response);
+            }
+            coap_free_header(&request);
+        }
+    }
+    return NULL;
+}
+
+static void prv_monitor(uint16_t clientID,
+                        lwm2m_uri_t * uriP,
+                        int status,
+                        uint8_t * data,
+                        int dataLength,
+                        void * userData)
+{
+    int shard = lwm2m_shard_current();
+    int index;
+
+    if (status != COAP_201_CREATED) return;
+    HOST_CHECK(shard >= 0 && shard < SHARD_WORKERS);
+    __atomic_add_fetch(perShard + shard, 1, __ATOMIC_RELAXED);
+    index = __atomic_fetch_add(&registered, 1, __ATOMIC_ACQ_REL);
+    HOST_CHECK(index < SHARD_CLIENTS);
+    __atomic_store_n(clients + index, LWM2M_SHARD_CLIENT(shard, clientID), __ATOMIC_RELEASE);
+}
+
+static void prv_init(lwm2m_context_t * contextP,
+                     int shard,
+                     void * userData)
+{
+    HOST_CHECK(lwm2m_shard_current() == shard && userData == &initialized);
+    lwm2m_set_monitoring_callback(contextP, prv_monitor, NULL);
+    __atomic_add_fetch(&initialized, 1, __ATOMIC_RELEASE);
+}
+
+// userData is the client expected
+static void prv_checkThread(uint16_t clientID,
+                            void * userData)
+{
+    lwm2m_shard_client_t client = (lwm2m_shard_client_t)(uintptr_t)userData;
+
+    if (lwm2m_shard_current() != LWM2M_SHARD_INDEX(client)
+     || clientID != LWM2M_SHARD_CLIENT_ID(client))
+    {
+        __atomic_add_fetch(&wrongThread, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static void prv_readResult(uint16_t clientID,
+                           lwm2m_uri_t * uriP,
+                           int status,
+                           uint8_t * data,
+                           int dataLength,
+                           void * userData)
+{
+    prv_checkThread(clientID, userData);
+    HOST_CHECK(status == COAP_205_CONTENT && dataLength > 0);
+    __atomic_add_fetch(&reads, 1, __ATOMIC_RELEASE);
+}
+
+static void prv_writeResult(uint16_t clientID,
+                            lwm2m_uri_t * uriP,
+                            int status,
+                            uint8_t * data,
+                            int dataLength,
+                            void * userData)
+{
+    prv_checkThread(clientID, userData);
+    HOST_CHECK(status == COAP_204_CHANGED);
+    __atomic_add_fetch(&writes, 1, __ATOMIC_RELEASE);
+}
+
+// the response to the request, then the notification
+static void prv_notify(uint16_t clientID,
+                       lwm2m_uri_t * uriP,
+                       int status,
+                       uint8_t * data,
+                       int dataLength,
+                       void * userData)
+{
+    prv_checkThread(clientID, userData);
+    HOST_CHECK((status == 0 || status == 2) && dataLength > 0);
+    __atomic_add_fetch(&notifications, 1, __ATOMIC_RELEASE);
+}
+
+static void prv_refused(uint16_t clientID,
+                        lwm2m_uri_t * uriP,
+                        int status,
+                        uint8_t * data,
+                        int dataLength,
+                        void * userData)
+{
+    HOST_CHECK(status == COAP_404_NOT_FOUND && lwm2m_shard_current() == 0);
+    __atomic_add_fetch(&refused, 1, __ATOMIC_RELEASE);
+}
+
+static void prv_call(lwm2m_context_t * contextP,
+                     void * arg)
+{
+    HOST_CHECK(lwm2m_shard_current() == (int)(intptr_t)arg);
+    HOST_CHECK(contextP->clientList != NULL || perShard[(intptr_t)arg] == 0);
+    __atomic_add_fetch(&calls, 1, __ATOMIC_RELEASE);
+}
+
+static void prv_register(int index)
+{
+    coap_packet_t message;
+    char query[32];
+
+    coap_init_message(&message, COAP_TYPE_CON, COAP_POST, coap_get_mid());
+    coap_set_header_uri_path(&message, "/rd");
+    snprintf(query, sizeof(query), "ep=shard%d&lt=300", index);
+    coap_set_header_uri_query(&message, query);
+    coap_set_header_content_type(&message, APPLICATION_LINK_FORMAT);
+    coap_set_payload(&message, "</3/0>", 6);
+    // the options are freed by coap_serialize_message()
+    prv_sendTo(socks[index], &message);
+}
+
+int main(void)
+{
+    pthread_t clientThread;
+    lwm2m_uri_t uri;
+    int used;
+    int i;
+
+    runtimeP = lwm2m_shard_start("0", SHARD_WORKERS, true, prv_init, &initialized);
+    HOST_CHECK(runtimeP != NULL);
+    port = lwm2m_shard_port(runtimeP);
+    HOST_CHECK(port != 0);
+    HOST_CHECK(lwm2m_shard_current() == -1);
+    prv_wait(&initialized, SHARD_WORKERS);
+
+    for (i = 0 ; i < SHARD_CLIENTS ; i++)
+    {
+        socks[i] = socket(AF_INET, SOCK_DGRAM, 0);
+        HOST_CHECK(socks[i] >= 0);
+        prv_register(i);
+    }
+    prv_wait(&registered, SHARD_CLIENTS);
+    HOST_CHECK(pthread_create(&clientThread, NULL, prv_runClients, NULL) == 0);
+
+    // the addresses are spread over the workers
+    used = 0;
+    for (i = 0 ; i < SHARD_WORKERS ; i++)
+    {
+        if (perShard[i] != 0) used++;
+    }
+    HOST_CHECK(used >= 2);
+
+    memset(&uri, 0, sizeof(uri));
+    uri.flag = LWM2M_URI_FLAG_OBJECT_ID | LWM2M_URI_FLAG_INSTANCE_ID | LWM2M_URI_FLAG_RESOURCE_ID;
+    uri.objectId = 3;
+    uri.instanceId = 0;
+    uri.resourceId = 13;
+    for (i = 0 ; i < SHARD_CLIENTS ; i++)
+    {
+        lwm2m_shard_client_t client = __atomic_load_n(clients + i, __ATOMIC_ACQUIRE);
+
+        HOST_CHECK(lwm2m_shard_dm_read(runtimeP, client, &uri, prv_readResult, (void *)(uintptr_t)client) == COAP_NO_ERROR);
+    }
+    prv_wait(&reads, SHARD_CLIENTS);
+
+    uri.resourceId = 14;
+    for (i = 0 ; i < SHARD_CLIENTS ; i++)
+    {
+        lwm2m_shard_client_t client = clients[i];
+
+        HOST_CHECK(lwm2m_shard_dm_write(runtimeP, client, &uri, (uint8_t *)"+02", 3, prv_writeResult, (void *)(uintptr_t)client) == COAP_NO_ERROR);
+    }
+    prv_wait(&writes, SHARD_CLIENTS);
+
+    uri.resourceId = 9;
+    for (i = 0 ; i < SHARD_CLIENTS ; i++)
+    {
+        lwm2m_shard_client_t client = clients[i];
+
+        HOST_CHECK(lwm2m_shard_observe(runtimeP, client, &uri, prv_notify, (void *)(uintptr_t)client) == COAP_NO_ERROR);
+    }
+    prv_wait(&notifications, 2 * SHARD_CLIENTS);
+
+    HOST_CHECK(lwm2m_shard_dm_read(runtimeP, LWM2M_SHARD_CLIENT(SHARD_WORKERS, 0), &uri, prv_refused, NULL) == COAP_400_BAD_REQUEST);
+    HOST_CHECK(lwm2m_shard_dm_read(runtimeP, LWM2M_SHARD_CLIENT(0, 0xFFFF), &uri, prv_refused, NULL) == COAP_NO_ERROR);
+    prv_wait(&refused, 1);
+    for (i = 0 ; i < SHARD_WORKERS ; i++)
+    {
+        HOST_CHECK(lwm2m_shard_call(runtimeP, i, prv_call, (void *)(intptr_t)i) == COAP_NO_ERROR);
+    }
+    HOST_CHECK(lwm2m_shard_call(runtimeP, -1, prv_call, NULL) == COAP_400_BAD_REQUEST);
+    prv_wait(&calls, SHARD_WORKERS);
+    HOST_CHECK(wrongThread == 0);
+
+    lwm2m_shard_stop(runtimeP);
+    __atomic_store_n(&stopClients, 1, __ATOMIC_RELEASE);
+    pthread_join(clientThread, NULL);
+    for (i = 0 ; i < SHARD_CLIENTS ; i++) close(socks[i]);
+    HOST_CHECK(host_live_blocks == 0);
+
+    printf("shard_test: %d clients on %d workers (%d, %d, %d)\n", SHARD_CLIENTS, SHARD_WORKERS, perShard[0], perShard[1], perShard[2]);
+    printf("shard_test: ok\n");
+    return 0;
+}
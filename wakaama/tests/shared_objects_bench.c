@@ -0,0 +1,195 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - host tests
+ *
+ *******************************************************************************/
+
+/*
+ * Heap used per client by the object lists shared between the clients
+ * registering the same payload, see registration.c.
+ *
+ * Registers SHARED_CLIENTS clients, or the count given on the command line,
+ * with one payload of 7 objects and 10 instances. It then checks an
+ * alternative path, an update with a new payload, a re-registration and a
+ * garbage payload, and that deregistering every client frees the lists.
+ */
+
+#include "host.h"
+
+#define SHARED_CLIENTS  20000
+#define SHARED_PAYLOAD  "</1/0>,</3/0>,</4/0>,</5/0>,</6/0>,</3303/0>,</3303/1>,</3303/2>,</3311/0>,</3311/1>"
+
+static uint8_t prv_send(void * sessionH,
+                        uint8_t * buffer,
+                        size_t length,
+                        void * userData)
+{
+    return COAP_NO_ERROR;
+}
+
+// objectId < 0 targets /rd
+static coap_status_t prv_request(lwm2m_context_t * contextP,
+                                 coap_method_t method,
+                                 int objectId,
+                                 const char * query,
+                                 const char * payload)
+{
+    coap_packet_t message;
+    coap_packet_t response;
+    lwm2m_uri_t uri;
+    multi_option_t option;
+    uint8_t buffer[256];
+    coap_status_t result;
+
+    memset(&message, 0, sizeof(message));
+    memset(&response, 0, sizeof(response));
+    memset(&uri, 0, sizeof(uri));
+    message.code = method;
+    if (payload != NULL)
+    {
+        // not in a string literal, the payload must be compared by value
+        message.payload_len = strlen(payload);
+        memcpy(buffer, payload, message.payload_len);
+        message.payload = buffer;
+    }
+    if (objectId >= 0)
+    {
+        uri.flag = LWM2M_URI_FLAG_OBJECT_ID;
+        uri.objectId = objectId;
+    }
+    if (query != NULL)
+    {
+        option.next = NULL;
+        option.data = (uint8_t *)query;
+        option.len = strlen(query);
+        option.is_static = 1;
+        message.uri_query = &option;
+    }
+
+    result = handle_registration_request(contextP, &uri, NULL, &message, &response);
+    coap_free_header(&response);
+
+    return result;
+}
+
+static int prv_countObjects(lwm2m_client_t * clientP,
+                            int * instanceCountP)
+{
+    lwm2m_client_object_t * objectP;
+    int count = 0;
+
+    *instanceCountP = 0;
+    for (objectP = clientP->objectList ; objectP != NULL ; objectP = objectP->next)
+    {
+        lwm2m_list_t * instanceP;
+
+        count++;
+        for (instanceP = objectP->instanceList ; instanceP != NULL ; instanceP = instanceP->next)
+        {
+            (*instanceCountP)++;
+        }
+    }
+    return count;
+}
+
+static lwm2m_client_t * prv_findClient(lwm2m_context_t * contextP,
+                                       const char * name)
+{
+    lwm2m_client_t * clientP;
+
+    for (clientP = contextP->clientList ; clientP != NULL ; clientP = clientP->next)
+    {
+        if (strcmp(clientP->name, name) == 0) return clientP;
+    }
+    return NULL;
+}
+
+static void prv_checkUpdates(lwm2m_context_t * contextP)
+{
+    lwm2m_client_t * clientP;
+    int instanceCount;
+
+    HOST_CHECK(prv_request(contextP, COAP_POST, -1, "ep=alt", "</lwm2m>;rt=\"oma.lwm2m\",</lwm2m/3/0>,</lwm2m/4/0>") == COAP_201_CREATED);
+    clientP = prv_findClient(contextP, "alt");
+    HOST_CHECK(clientP != NULL);
+    HOST_CHECK(clientP->altPath != NULL && strcmp(clientP->altPath, "/lwm2m") == 0);
+    HOST_CHECK(prv_countObjects(clientP, &instanceCount) == 2);
+
+    clientP = prv_findClient(contextP, "node000000");
+    HOST_CHECK(prv_request(contextP, COAP_PUT, clientP->internalID, "lt=100", "</3/0>,</9/0>,</9/1>") == COAP_204_CHANGED);
+    HOST_CHECK(prv_countObjects(clientP, &instanceCount) == 2 && instanceCount == 3);
+
+    clientP = prv_findClient(contextP, "node000001");
+    HOST_CHECK(prv_request(contextP, COAP_PUT, clientP->internalID, "lt=100", NULL) == COAP_204_CHANGED);
+    HOST_CHECK(prv_countObjects(clientP, &instanceCount) == 7 && instanceCount == 10);
+
+    HOST_CHECK(prv_request(contextP, COAP_POST, -1, "ep=node000002", "</3/0>") == COAP_201_CREATED);
+    HOST_CHECK(prv_request(contextP, COAP_POST, -1, "ep=bad", "garbage") != COAP_201_CREATED);
+}
+
+int main(int argc,
+         char * argv[])
+{
+    lwm2m_context_t * contextP;
+    lwm2m_client_t * clientP;
+    int count = (argc > 1) ? atoi(argv[1]) : SHARED_CLIENTS;
+    long baseBytes;
+    long baseBlocks;
+    long perClient;
+    double start;
+    double duration;
+    int instanceCount;
+    int i;
+
+    contextP = lwm2m_init(NULL, prv_send, NULL);
+    HOST_CHECK(contextP != NULL && count > 2);
+
+    baseBytes = host_live_bytes;
+    baseBlocks = host_live_blocks;
+    start = host_clock_ns();
+    for (i = 0 ; i < count ; i++)
+    {
+        char query[32];
+
+        snprintf(query, sizeof(query), "ep=node%06d", i);
+        HOST_CHECK(prv_request(contextP, COAP_POST, -1, query, SHARED_PAYLOAD) == COAP_201_CREATED);
+    }
+    duration = host_clock_ns() - start;
+    perClient = (host_live_bytes - baseBytes) / count;
+    printf("%d clients: %ld B and %.1f allocations per client, %.2f us per registration\n",
+           count, perClient, (double)(host_live_blocks - baseBlocks) / count, duration / count / 1000);
+
+    clientP = contextP->clientList;
+    HOST_CHECK(prv_countObjects(clientP, &instanceCount) == 7 && instanceCount == 10);
+    HOST_CHECK(clientP->altPath == NULL);
+
+    prv_checkUpdates(contextP);
+
+    while (contextP->clientList != NULL)
+    {
+        HOST_CHECK(prv_request(contextP, COAP_DELETE, contextP->clientList->internalID, NULL, NULL) == COAP_202_DELETED);
+    }
+    if (contextP->sharedObjectsTable != NULL)
+    {
+        for (i = 0 ; i < LWM2M_SHARED_OBJECTS_BUCKETS ; i++)
+        {
+            HOST_CHECK(contextP->sharedObjectsTable[i] == NULL);
+        }
+    }
+
+    lwm2m_close(contextP);
+    HOST_CHECK(host_live_blocks == 0);
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 agent and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent <agent@local> - host tests
+ *
+ *******************************************************************************/
+
+/*
+ * Table driven objects, see object_table.c: the static resources read from
+ * the image give the same payloads as when they are encoded on each read.
+ */
+
+#include "host.h"
+
+#define PRV_LONG_TEXT   "a text longer than 255 bytes, so that its TLV header takes two length bytes: " \
+                        "0123456789012345678901234567890123456789012345678901234567890123456789" \
+                        "0123456789012345678901234567890123456789012345678901234567890123456789" \
+                        "0123456789012345678901234567890123456789012345678901234567890123456789"
+
+static int64_t dynamicValue = 5;
+
+static uint8_t prv_read(uint16_t instanceId,
+                        lwm2m_tlv_t * tlvP,
+                        lwm2m_object_t * objectP)
+{
+    lwm2m_tlv_encode_int(dynamicValue, tlvP);
+    return COAP_205_CONTENT;
+}
+
+static const lwm2m_resource_desc_t resources[] =
+{
+    LWM2M_RESOURCE_STATIC_STRING(0, "Cel"),
+    LWM2M_RESOURCE_STATIC_STRING(1, "a text of more than 7 bytes"),
+    LWM2M_RESOURCE_STATIC_INT(2, -70000),
+    LWM2M_RESOURCE_STATIC_FLOAT(3, -1.5),
+    LWM2M_RESOURCE_STATIC_STRING(300, PRV_LONG_TEXT),
+    LWM2M_RESOURCE_STATIC_INT(301, 42),
+    LWM2M_RESOURCE(5700, LWM2M_TYPE_INTEGER, LWM2M_RES_READ, prv_read, NULL),
+    LWM2M_RESOURCE_STATIC_STRING(5701, "")
+};
+
+// the payload of a read encoding every value
+static int prv_expected(uint8_t * buffer,
+                        size_t length)
+{
+    int index = 0;
+
+    index += lwm2m_opaqueToTLV(LWM2M_TYPE_RESOURCE, (uint8_t *)"Cel", 3, 0, buffer + index, length - index);
+    index += lwm2m_opaqueToTLV(LWM2M_TYPE_RESOURCE, (uint8_t *)"a text of more than 7 bytes", 27, 1, buffer + index, length - index);
+    index += lwm2m_intToTLV(LWM2M_TYPE_RESOURCE, -70000, 2, buffer + index, length - index);
+    index += lwm2m_floatToTLV(LWM2M_TYPE_RESOURCE, -1.5, 3, buffer + index, length - index);
+    index += lwm2m_opaqueToTLV(LWM2M_TYPE_RESOURCE, (uint8_t *)PRV_LONG_TEXT, strlen(PRV_LONG_TEXT), 300, buffer + index, length - index);
+    index += lwm2m_intToTLV(LWM2M_TYPE_RESOURCE, 42, 301, buffer + index, length - index);
+    index += lwm2m_intToTLV(LWM2M_TYPE_RESOURCE, dynamicValue, 5700, buffer + index, length - index);
+    index += lwm2m_opaqueToTLV(LWM2M_TYPE_RESOURCE, (uint8_t *)"", 0, 5701, buffer + index, length - index);
+
+    return index;
+}
+
+static void prv_checkRead(lwm2m_object_t * objectP)
+{
+    uint8_t expected[1024];
+    int expectedLength;
+    lwm2m_tlv_t * tlvP = NULL;
+    int size = 0;
+    uint8_t * buffer;
+    int length;
+
+    HOST_CHECK(objectP->readFunc(0, &size, &tlvP, objectP) == COAP_205_CONTENT);
+    HOST_CHECK(size == 8);
+    length = lwm2m_tlv_serialize(size, tlvP, &buffer);
+    expectedLength = prv_expected(expected, sizeof(expected));
+    HOST_CHECK(length == expectedLength);
+    HOST_CHECK(memcmp(buffer, expected, length) == 0);
+
+    // the other formats use the value
+    HOST_CHECK(tlvP[0].length == 3 && memcmp(tlvP[0].value, "Cel", 3) == 0);
+    HOST_CHECK(tlvP[4].length == strlen(PRV_LONG_TEXT) && memcmp(tlvP[4].value, PRV_LONG_TEXT, tlvP[4].length) == 0);
+    {
+        int64_t value;
+
+        HOST_CHECK(lwm2m_tlv_decode_int(tlvP + 2, &value) == 1 && value == -70000);
+        HOST_CHECK(lwm2m_tlv_decode_int(tlvP + 5, &value) == 1 && value == 42);
+    }
+
+    lwm2m_free(buffer);
+    lwm2m_tlv_free(size, tlvP);
+}
+
+int main(void)
+{
+    lwm2m_object_t object;
+    lwm2m_list_t instance;
+    long before;
+
+    memset(&object, 0, sizeof(object));
+    memset(&instance, 0, sizeof(instance));
+    object.objID = 1024;
+    object.instanceList = &instance;
+
+    before = host_live_bytes;
+    HOST_CHECK(lwm2m_object_set_resources(&object, resources, sizeof(resources) / sizeof(resources[0])));
+    HOST_CHECK(object.resourceImage != NULL);
+    // the texts stay in the table
+    HOST_CHECK(host_live_bytes - before < 200);
+    prv_checkRead(&object);
+
+    // without image, the values are encoded on each read
+    object_table_free(&object);
+    prv_checkRead(&object);
+
+    HOST_CHECK(host_live_blocks == 0);
+
+    printf("table_test: ok\n");
+    return 0;
+}
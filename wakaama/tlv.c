@@ -30,9 +30,128 @@
 #endif
 #endif
 
-#define _PRV_64BIT_BUFFER_SIZE 8
 #define _PRV_TLV_TYPE_MASK 0xC0
 
+/*
+ * Value primitives
+ *
+ * Values are written big endian straight to their destination: the byte
+ * order is swapped in a register (REV on Cortex-M3, bswap on x86) and
+ * stored at once. Integer widths come from the count of leading zeros
+ * (CLZ) instead of a loop over the bytes.
+ */
+
+#ifdef __GNUC__
+#define _PRV_CLZ64(X)    __builtin_clzll(X)
+#define _PRV_BSWAP32(X)  __builtin_bswap32(X)
+#define _PRV_BSWAP64(X)  __builtin_bswap64(X)
+#else
+static int _PRV_CLZ64(uint64_t value)
+{
+    int count = 0;
+
+    while ((value & 0x8000000000000000ULL) == 0)
+    {
+        value <<= 1;
+        count++;
+    }
+    return count;
+}
+#define _PRV_BSWAP32(X)  ((((X) & 0xFF) << 24) | (((X) & 0xFF00) << 8) | (((X) >> 8) & 0xFF00) | ((X) >> 24))
+#define _PRV_BSWAP64(X)  (((uint64_t)_PRV_BSWAP32((uint32_t)(X)) << 32) | _PRV_BSWAP32((uint32_t)((X) >> 32)))
+#endif
+
+static inline void prv_writeBE32(uint8_t * buffer,
+                                 uint32_t value)
+{
+#ifndef LWM2M_BIG_ENDIAN
+    value = _PRV_BSWAP32(value);
+#endif
+    memcpy(buffer, &value, 4);
+}
+
+static inline void prv_writeBE64(uint8_t * buffer,
+                                 uint64_t value)
+{
+#ifndef LWM2M_BIG_ENDIAN
+    value = _PRV_BSWAP64(value);
+#endif
+    memcpy(buffer, &value, 8);
+}
+
+// TLV integers are 1, 2, 4 or 8 bytes long, the first bit is the sign
+static inline size_t prv_intLength(int64_t data)
+{
+    static const uint8_t lengths[9] = { 1, 1, 2, 4, 4, 8, 8, 8, 8 };
+    uint64_t magnitude;
+    int bits;
+
+    magnitude = data < 0 ? 0 - (uint64_t)data : (uint64_t)data;
+    // significant bits plus the sign bit
+    bits = 65 - _PRV_CLZ64(magnitude | 1);
+    // INT64_MIN has no sign-magnitude form, it is sent on 8 bytes like the others
+    if (bits > 64) bits = 64;
+
+    return lengths[(bits + 7) >> 3];
+}
+
+static inline void prv_writeInt(uint8_t * buffer,
+                                int64_t data,
+                                size_t length)
+{
+    uint64_t magnitude;
+
+    magnitude = data < 0 ? 0 - (uint64_t)data : (uint64_t)data;
+    switch (length)
+    {
+    case 1:
+        buffer[0] = (uint8_t)magnitude;
+        break;
+    case 2:
+        buffer[0] = (uint8_t)(magnitude >> 8);
+        buffer[1] = (uint8_t)magnitude;
+        break;
+    case 4:
+        prv_writeBE32(buffer, (uint32_t)magnitude);
+        break;
+    default:
+        prv_writeBE64(buffer, magnitude);
+        break;
+    }
+    if (data < 0)
+    {
+        buffer[0] |= 0x80;
+    }
+}
+
+// doubles are sent as 32-bit floats unless out of their range
+static inline size_t prv_floatLength(double data)
+{
+    return (data > FLT_MAX || data < (0 - FLT_MAX)) ? 8 : 4;
+}
+
+static inline void prv_writeFloat(uint8_t * buffer,
+                                  double data,
+                                  size_t length)
+{
+    if (length == 4)
+    {
+        float temp;
+        uint32_t bits;
+
+        temp = (float)data;
+        memcpy(&bits, &temp, 4);
+        prv_writeBE32(buffer, bits);
+    }
+    else
+    {
+        uint64_t bits;
+
+        memcpy(&bits, &data, 8);
+        prv_writeBE64(buffer, bits);
+    }
+}
+
 static int prv_getHeaderLength(uint16_t id,
                                size_t dataLen)
 {
@@ -112,53 +231,12 @@ static int prv_create_header(uint8_t * header,
     return header_len;
 }
 
-static void prv_encodeInt(int64_t data,
-                          uint8_t data_buffer[_PRV_64BIT_BUFFER_SIZE],
-                          size_t * lengthP)
+int tlv_create_header(uint8_t * header,
+                      lwm2m_tlv_type_t type,
+                      uint16_t id,
+                      size_t length)
 {
-    uint64_t value;
-    int negative = 0;
-    size_t length = 0;
-
-    memset(data_buffer, 0, _PRV_64BIT_BUFFER_SIZE);
-
-    if (data < 0)
-    {
-        negative = 1;
-        value = 0 - data;
-    }
-    else
-    {
-        value = data;
-    }
-
-    do
-    {
-        length++;
-        data_buffer[_PRV_64BIT_BUFFER_SIZE - length] = (value >> (8*(length-1))) & 0xFF;
-    } while (value > (((uint64_t)1 << ((8 * length)-1)) - 1));
-
-    // TLV integer length is 1, 2, 4 or 8
-    switch (length)
-    {
-    case 3:
-        length = 4;
-        break;
-    case 5:
-    case 6:
-    case 7:
-        length = 8;
-        break;
-    default:
-        break;
-    }
-
-    if (1 == negative)
-    {
-        data_buffer[_PRV_64BIT_BUFFER_SIZE - length] |= 0x80;
-    }
-
-    *lengthP = length;
+    return prv_create_header(header, type, id, length);
 }
 
 int lwm2m_opaqueToTLV(lwm2m_tlv_type_t type,
@@ -168,16 +246,14 @@ int lwm2m_opaqueToTLV(lwm2m_tlv_type_t type,
                       uint8_t * buffer,
                       size_t buffer_len)
 {
-    uint8_t header[LWM2M_TLV_HEADER_MAX_LENGTH];
     size_t header_len;
 
-    header_len = prv_create_header(header, type, id, data_len);
-
+    header_len = prv_getHeaderLength(id, data_len);
     if (buffer_len < data_len + header_len) return 0;
 
-    memmove(buffer, header, header_len);
-
+    // dataP may be in buffer
     memmove(buffer + header_len, dataP, data_len);
+    prv_create_header(buffer, type, id, data_len);
 
     return header_len + data_len;
 }
@@ -197,15 +273,42 @@ int lwm2m_intToTLV(lwm2m_tlv_type_t type,
                    uint8_t * buffer,
                    size_t buffer_len)
 {
-    uint8_t data_buffer[_PRV_64BIT_BUFFER_SIZE];
-    size_t length = 0;
+    size_t length;
+    size_t header_len;
+
+    if (type != LWM2M_TYPE_RESOURCE_INSTANCE && type != LWM2M_TYPE_RESOURCE)
+        return 0;
+
+    length = prv_intLength(data);
+    header_len = prv_getHeaderLength(id, length);
+    if (buffer_len < header_len + length) return 0;
+
+    prv_create_header(buffer, type, id, length);
+    prv_writeInt(buffer + header_len, data, length);
+
+    return header_len + length;
+}
+
+int lwm2m_floatToTLV(lwm2m_tlv_type_t type,
+                     double data,
+                     uint16_t id,
+                     uint8_t * buffer,
+                     size_t buffer_len)
+{
+    size_t length;
+    size_t header_len;
 
     if (type != LWM2M_TYPE_RESOURCE_INSTANCE && type != LWM2M_TYPE_RESOURCE)
         return 0;
 
-    prv_encodeInt(data, data_buffer, &length);
+    length = prv_floatLength(data);
+    header_len = prv_getHeaderLength(id, length);
+    if (buffer_len < header_len + length) return 0;
 
-    return lwm2m_opaqueToTLV(type, data_buffer + (_PRV_64BIT_BUFFER_SIZE - length), length, id, buffer, buffer_len);
+    prv_create_header(buffer, type, id, length);
+    prv_writeFloat(buffer + header_len, data, length);
+
+    return header_len + length;
 }
 
 int lwm2m_decodeTLV(uint8_t * buffer,
@@ -471,77 +574,68 @@ static int prv_getLength(int size,
 }
 
 
-int lwm2m_tlv_serialize(int size,
-                        lwm2m_tlv_t * tlvP,
-                        uint8_t ** bufferP)
+// write the records in buffer, the length is known from prv_getLength()
+static int prv_serializeInto(int size,
+                             lwm2m_tlv_t * tlvP,
+                             uint8_t * buffer)
 {
-    int length;
     int index;
     int i;
 
-    *bufferP = NULL;
-    length = prv_getLength(size, tlvP);
-    if (length <= 0) return length;
-
-    *bufferP = (uint8_t *)lwm2m_malloc(length);
-    if (*bufferP == NULL) return 0;
-
     index = 0;
-    for (i = 0 ; i < size && length != 0 ; i++)
+    for (i = 0 ; i < size ; i++)
     {
-        int headerLen;
-
         switch (tlvP[i].type)
         {
         case LWM2M_TYPE_OBJECT_INSTANCE:
         case LWM2M_TYPE_MULTIPLE_RESOURCE:
             {
-                uint8_t * tmpBuffer;
-                int tmpLength;
+                int subLength;
 
-                tmpLength = lwm2m_tlv_serialize(tlvP[i].length, (lwm2m_tlv_t *)tlvP[i].value, &tmpBuffer);
-                if (tmpLength == 0)
-                {
-                    length = 0;
-                }
-                else
-                {
-                    headerLen = prv_create_header((uint8_t*)(*bufferP) + index, tlvP[i].type, tlvP[i].id, tmpLength);
-                    index += headerLen;
-                    memcpy(*bufferP + index, tmpBuffer, tmpLength);
-                    index += tmpLength;
-                    lwm2m_free(tmpBuffer);
-                }
+                subLength = prv_getLength(tlvP[i].length, (lwm2m_tlv_t *)tlvP[i].value);
+                index += prv_create_header(buffer + index, tlvP[i].type, tlvP[i].id, subLength);
+                index += prv_serializeInto(tlvP[i].length, (lwm2m_tlv_t *)tlvP[i].value, buffer + index);
             }
             break;
 
         case LWM2M_TYPE_RESOURCE_INSTANCE:
         case LWM2M_TYPE_RESOURCE:
+            if ((tlvP[i].flags & LWM2M_TLV_FLAG_ENCODED) != 0)
             {
-                headerLen = prv_create_header((uint8_t*)(*bufferP) + index, tlvP[i].type, tlvP[i].id, tlvP[i].length);
-                if (headerLen == 0)
-                {
-                    length = 0;
-                }
-                else
-                {
-                    index += headerLen;
-                    memcpy(*bufferP + index, tlvP[i].value, tlvP[i].length);
-                    index += tlvP[i].length;
-                }
+                memcpy(buffer + index, tlvP[i].data + 1, tlvP[i].data[0]);
+                index += tlvP[i].data[0];
             }
+            else
+            {
+                index += prv_create_header(buffer + index, tlvP[i].type, tlvP[i].id, tlvP[i].length);
+            }
+            memcpy(buffer + index, tlvP[i].value, tlvP[i].length);
+            index += tlvP[i].length;
             break;
 
         default:
-            length = 0;
             break;
         }
     }
 
-    if (length == 0)
-    {
-        lwm2m_free(*bufferP);
-    }
+    return index;
+}
+
+int lwm2m_tlv_serialize(int size,
+                        lwm2m_tlv_t * tlvP,
+                        uint8_t ** bufferP)
+{
+    int length;
+
+    *bufferP = NULL;
+    length = prv_getLength(size, tlvP);
+    if (length <= 0) return length;
+
+    *bufferP = (uint8_t *)lwm2m_malloc(length);
+    if (*bufferP == NULL) return 0;
+
+    prv_serializeInto(size, tlvP, *bufferP);
+
     return length;
 }
 
@@ -570,6 +664,27 @@ void lwm2m_tlv_free(int size,
     lwm2m_free(tlvP);
 }
 
+// short values are stored in tlvP->data, longer texts are allocated
+static void prv_setText(lwm2m_tlv_t * tlvP,
+                        uint8_t * text,
+                        size_t length)
+{
+    if (length <= sizeof(tlvP->data))
+    {
+        memcpy(tlvP->data, text, length);
+        tlvP->value = tlvP->data;
+        tlvP->flags |= LWM2M_TLV_FLAG_STATIC_DATA;
+    }
+    else
+    {
+        tlvP->value = (uint8_t *)lwm2m_malloc(length);
+        if (tlvP->value == NULL) return;
+        memcpy(tlvP->value, text, length);
+        tlvP->flags &= ~LWM2M_TLV_FLAG_STATIC_DATA;
+    }
+    tlvP->length = length;
+}
+
 void lwm2m_tlv_encode_int(int64_t data,
                           lwm2m_tlv_t * tlvP)
 {
@@ -578,25 +693,16 @@ void lwm2m_tlv_encode_int(int64_t data,
 
     if ((tlvP->flags & LWM2M_TLV_FLAG_TEXT_FORMAT) != 0)
     {
-        tlvP->flags &= ~LWM2M_TLV_FLAG_STATIC_DATA;
-        tlvP->length = lwm2m_int64ToPlainText(data, &tlvP->value);
+        uint8_t text[20 + 1];
+
+        prv_setText(tlvP, text, utils_intToText(data, text, sizeof(text)));
     }
     else
     {
-        uint8_t buffer[_PRV_64BIT_BUFFER_SIZE];
-        size_t length = 0;
-
-        prv_encodeInt(data, buffer, &length);
-
-        tlvP->value = (uint8_t *)lwm2m_malloc(length);
-        if (tlvP->value != NULL)
-        {
-            memcpy(tlvP->value,
-                   buffer + (_PRV_64BIT_BUFFER_SIZE - length),
-                   length);
-            tlvP->flags &= ~LWM2M_TLV_FLAG_STATIC_DATA;
-            tlvP->length = length;
-        }
+        tlvP->length = prv_intLength(data);
+        prv_writeInt(tlvP->data, data, tlvP->length);
+        tlvP->value = tlvP->data;
+        tlvP->flags |= LWM2M_TLV_FLAG_STATIC_DATA;
     }
 }
 
@@ -635,64 +741,16 @@ void lwm2m_tlv_encode_float(double data,
 
     if ((tlvP->flags & LWM2M_TLV_FLAG_TEXT_FORMAT) != 0)
     {
-        tlvP->flags &= ~LWM2M_TLV_FLAG_STATIC_DATA;
-        tlvP->length = lwm2m_float64ToPlainText(data, &tlvP->value);
+        uint8_t text[32];
+
+        prv_setText(tlvP, text, utils_floatToText(data, text, sizeof(text)));
     }
     else
     {
-        size_t length = 0;
-
-        if (data > FLT_MAX || data < (0 - FLT_MAX))
-        {
-            length = 8;
-        }
-        else
-        {
-            length = 4;
-        }
-
-        tlvP->value = (uint8_t *)lwm2m_malloc(length);
-        if (tlvP->value != NULL)
-        {
-            if (length == 4)
-            {
-                float temp;
-
-                temp = data;
-#ifdef LWM2M_BIG_ENDIAN
-                memcpy(tlvP->value, &temp, length);
-#else
-#ifdef LWM2M_LITTLE_ENDIAN
-                {
-                    int i;
-
-                    for (i = 0 ; i < 4 ; i++)
-                    {
-                        tlvP->value[i] = ((uint8_t *)&temp)[3 - i];
-                    }
-                }
-#endif
-#endif
-            }
-            else
-            {
-#ifdef LWM2M_BIG_ENDIAN
-                memcpy(tlvP->value, &data, length);
-#else
-#ifdef LWM2M_LITTLE_ENDIAN
-                size_t i;
-
-                for (i = 0 ; i < length ; i++)
-                {
-                    tlvP->value[i] = ((uint8_t *)&data)[7 - i];
-                }
-#endif
-#endif
-            }
-
-            tlvP->flags &= ~LWM2M_TLV_FLAG_STATIC_DATA;
-            tlvP->length = length;
-        }
+        tlvP->length = prv_floatLength(data);
+        prv_writeFloat(tlvP->data, data, tlvP->length);
+        tlvP->value = tlvP->data;
+        tlvP->flags |= LWM2M_TLV_FLAG_STATIC_DATA;
     }
 }
 
@@ -707,6 +765,17 @@ int lwm2m_tlv_decode_float(lwm2m_tlv_t * tlvP,
     {
         result = lwm2m_PlainTextToFloat64(tlvP->value, tlvP->length, dataP);
     }
+    else if (tlvP->dataType == LWM2M_TYPE_INTEGER)
+    {
+        // integral values are sent as integers in some formats
+        int64_t value;
+
+        result = lwm2m_tlv_decode_int(tlvP, &value);
+        if (result == 1)
+        {
+            *dataP = value;
+        }
+    }
     else
     {
         result = lwm2m_opaqueToFloat(tlvP->value, tlvP->length, dataP);
@@ -726,37 +795,19 @@ int lwm2m_tlv_decode_float(lwm2m_tlv_t * tlvP,
 void lwm2m_tlv_encode_bool(bool data,
                           lwm2m_tlv_t * tlvP)
 {
-    tlvP->length = 0;
     tlvP->dataType = LWM2M_TYPE_BOOLEAN;
 
-    tlvP->value = (uint8_t *)lwm2m_malloc(1);
-    if (tlvP->value != NULL)
+    if ((tlvP->flags & LWM2M_TLV_FLAG_TEXT_FORMAT) != 0)
     {
-        if (data == true)
-        {
-            if ((tlvP->flags & LWM2M_TLV_FLAG_TEXT_FORMAT) != 0)
-            {
-                tlvP->value[0] = '1';
-            }
-            else
-            {
-                tlvP->value[0] = 1;
-            }
-        }
-        else
-        {
-            if ((tlvP->flags & LWM2M_TLV_FLAG_TEXT_FORMAT) != 0)
-            {
-                tlvP->value[0] = '0';
-            }
-            else
-            {
-                tlvP->value[0] = 0;
-            }
-        }
-        tlvP->flags &= ~LWM2M_TLV_FLAG_STATIC_DATA;
-        tlvP->length = 1;
+        tlvP->data[0] = data ? '1' : '0';
+    }
+    else
+    {
+        tlvP->data[0] = data ? 1 : 0;
     }
+    tlvP->value = tlvP->data;
+    tlvP->flags |= LWM2M_TLV_FLAG_STATIC_DATA;
+    tlvP->length = 1;
 }
 
 int lwm2m_tlv_decode_bool(lwm2m_tlv_t * tlvP,
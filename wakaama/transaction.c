@@ -108,11 +108,165 @@ Contains code snippets which are:
 
 
 /*
- * Modulo mask (+1 and +0.5 for rounding) for a random number to get the tick number for the random
- * retransmission time between COAP_RESPONSE_TIMEOUT and COAP_RESPONSE_TIMEOUT*COAP_RESPONSE_RANDOM_FACTOR.
+ * Transmission parameters (rfc7252 section 4.8), times in ms.
+ * The first retransmission timeout is drawn between RTO and RTO * ACK_RANDOM_FACTOR, where RTO is
+ * estimated per peer (draft-ietf-core-cocoa) and starts at ACK_TIMEOUT. It then backs off
+ * exponentially until MAX_RETRANSMIT retransmissions.
  */
-#define COAP_RESPONSE_TIMEOUT_TICKS         (CLOCK_SECOND * COAP_RESPONSE_TIMEOUT)
-#define COAP_RESPONSE_TIMEOUT_BACKOFF_MASK  ((CLOCK_SECOND * COAP_RESPONSE_TIMEOUT * (COAP_RESPONSE_RANDOM_FACTOR - 1)) + 1.5)
+#define COAP_ACK_TIMEOUT_MS             (COAP_RESPONSE_TIMEOUT * 1000)
+#define COAP_ACK_RANDOM_FACTOR_PERCENT  150
+#define COAP_NSTART                     1
+#define COAP_RTO_MAX_MS                 60000
+// RTT samples of exchanges with more retransmissions are too ambiguous to be used
+#define COCOA_WEAK_MAX_TRANSMISSIONS    3
+
+static void * prv_get_session(lwm2m_transaction_t * transacP)
+{
+    switch (transacP->peerType)
+    {
+#ifdef LWM2M_BOOTSTRAP_SERVER_MODE
+    case ENDPOINT_UNKNOWN:
+        return transacP->peerP;
+#endif
+#ifdef LWM2M_SERVER_MODE
+    case ENDPOINT_CLIENT:
+        return ((lwm2m_client_t *)transacP->peerP)->sessionH;
+#endif
+#ifdef LWM2M_CLIENT_MODE
+    case ENDPOINT_SERVER:
+        if (NULL != transacP->peerP)
+        {
+            return ((lwm2m_server_t *)transacP->peerP)->sessionH;
+        }
+        return NULL;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+// peers without state (e.g. bootstrapping clients) use the default parameters
+static lwm2m_peer_cc_t * prv_get_cc(lwm2m_transaction_t * transacP)
+{
+    switch (transacP->peerType)
+    {
+#ifdef LWM2M_SERVER_MODE
+    case ENDPOINT_CLIENT:
+        return &((lwm2m_client_t *)transacP->peerP)->cc;
+#endif
+#ifdef LWM2M_CLIENT_MODE
+    case ENDPOINT_SERVER:
+        if (NULL != transacP->peerP)
+        {
+            return &((lwm2m_server_t *)transacP->peerP)->cc;
+        }
+        return NULL;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+static uint32_t prv_get_rto(lwm2m_peer_cc_t * ccP,
+                            uint32_t now)
+{
+    if (NULL == ccP || 0 == ccP->rto) return COAP_ACK_TIMEOUT_MS;
+
+    // age RTOs which have not been updated for a while back to the default
+    if (ccP->rto < 1000 && now - ccP->rtoUpdate > 16 * ccP->rto)
+    {
+        ccP->rto *= 2;
+        ccP->rtoUpdate = now;
+    }
+    else if (ccP->rto > 3000 && now - ccP->rtoUpdate > 4 * ccP->rto)
+    {
+        ccP->rto = (COAP_ACK_TIMEOUT_MS + ccP->rto) / 2;
+        ccP->rtoUpdate = now;
+    }
+    return ccP->rto;
+}
+
+static uint32_t prv_backoff(uint32_t rto,
+                            uint32_t timeout)
+{
+    // variable backoff factor: retry small RTOs less aggressively, large ones sooner
+    if (rto < 1000)
+    {
+        timeout *= 3;
+    }
+    else if (rto > 3000)
+    {
+        timeout += timeout / 2;
+    }
+    else
+    {
+        timeout *= 2;
+    }
+    return timeout < COAP_RTO_MAX_MS ? timeout : COAP_RTO_MAX_MS;
+}
+
+static void prv_rtt_sample(lwm2m_transaction_t * transacP,
+                           uint32_t now)
+{
+    lwm2m_peer_cc_t * ccP = prv_get_cc(transacP);
+    uint32_t rtt = now - transacP->first_send_time;
+    uint32_t * srttP;
+    uint32_t * rttvarP;
+    uint32_t estimate;
+    uint32_t rto;
+    bool strong;
+
+    if (NULL == ccP || 0 == transacP->retrans_counter) return;
+    if (COCOA_WEAK_MAX_TRANSMISSIONS < transacP->retrans_counter) return;
+    strong = (1 == transacP->retrans_counter);
+
+    srttP = strong ? &ccP->strongRtt : &ccP->weakRtt;
+    rttvarP = strong ? &ccP->strongRttVar : &ccP->weakRttVar;
+    if (0 == *srttP)
+    {
+        *srttP = rtt;
+        *rttvarP = rtt / 2;
+    }
+    else
+    {
+        uint32_t delta = *srttP > rtt ? *srttP - rtt : rtt - *srttP;
+
+        // rfc6298, alpha = 1/8 and beta = 1/4
+        *rttvarP = (3 * *rttvarP + delta) / 4;
+        *srttP = (7 * *srttP + rtt) / 8;
+    }
+
+    rto = ccP->rto != 0 ? ccP->rto : COAP_ACK_TIMEOUT_MS;
+    if (strong)
+    {
+        estimate = *srttP + 4 * *rttvarP;
+        rto = (estimate + rto) / 2;
+    }
+    else
+    {
+        estimate = *srttP + *rttvarP;
+        rto = (estimate + 3 * rto) / 4;
+    }
+
+    ccP->rto = rto < COAP_RTO_MAX_MS ? rto : COAP_RTO_MAX_MS;
+    ccP->rtoUpdate = now;
+    ccP->lastRtt = rtt;
+}
+
+// the exchange no longer counts in the peer's outstanding interactions
+static void prv_release_nstart(lwm2m_transaction_t * transacP)
+{
+    lwm2m_peer_cc_t * ccP;
+
+    if (!transacP->outstanding) return;
+    transacP->outstanding = false;
+
+    ccP = prv_get_cc(transacP);
+    if (NULL != ccP && 0 < ccP->inFlight)
+    {
+        ccP->inFlight--;
+    }
+}
 
 static int prv_check_addr(void * leftSessionH,
                           void * rightSessionH)
@@ -267,10 +421,36 @@ void transaction_free(lwm2m_transaction_t * transacP)
 void transaction_remove(lwm2m_context_t * contextP,
                         lwm2m_transaction_t * transacP)
 {
+    prv_release_nstart(transacP);
     contextP->transactionList = (lwm2m_transaction_t *) LWM2M_LIST_RM(contextP->transactionList, transacP->mID, NULL);
     transaction_free(transacP);
 }
 
+// the results of the exchanges with a peer about to be freed are reported as timeouts
+void transaction_remove_peer(lwm2m_context_t * contextP,
+                             void * peerP)
+{
+    lwm2m_transaction_t * transacP;
+
+    transacP = contextP->transactionList;
+    while (NULL != transacP)
+    {
+        if (transacP->peerP != peerP)
+        {
+            transacP = transacP->next;
+            continue;
+        }
+
+        if (transacP->callback)
+        {
+            transacP->callback(transacP, NULL);
+        }
+        transaction_remove(contextP, transacP);
+        // the callback may have sent other requests
+        transacP = contextP->transactionList;
+    }
+}
+
 bool transaction_handle_response(lwm2m_context_t * contextP,
                                  void * fromSessionH,
                                  coap_packet_t * message,
@@ -286,32 +466,7 @@ bool transaction_handle_response(lwm2m_context_t * contextP,
     {
         void * targetSessionH;
 
-        targetSessionH = NULL;
-        switch (transacP->peerType)
-        {
-#ifdef LWM2M_BOOTSTRAP_SERVER_MODE
-        case ENDPOINT_UNKNOWN:
-            targetSessionH = transacP->peerP;
-            break;
-#endif
-#ifdef LWM2M_SERVER_MODE
-        case ENDPOINT_CLIENT:
-            targetSessionH = ((lwm2m_client_t *)transacP->peerP)->sessionH;
-            break;
-#endif
-
-#ifdef LWM2M_CLIENT_MODE
-        case ENDPOINT_SERVER:
-            if (NULL != transacP->peerP) 
-            {
-                targetSessionH = ((lwm2m_server_t *)transacP->peerP)->sessionH;
-            }
-            break;
-#endif
-
-        default:
-            break;
-        }
+        targetSessionH = prv_get_session(transacP);
 
         if (prv_check_addr(fromSessionH, targetSessionH))
         {
@@ -324,6 +479,8 @@ bool transaction_handle_response(lwm2m_context_t * contextP,
     	                found = true;
         	            transacP->ack_received = true;
             	        reset = COAP_TYPE_RST == message->type;
+                        prv_rtt_sample(transacP, lwm2m_gettime_ms());
+                        prv_release_nstart(transacP);
             	    }
                 }
             }
@@ -344,7 +501,7 @@ bool transaction_handle_response(lwm2m_context_t * contextP,
 	                if ((COAP_401_UNAUTHORIZED == message->code) && (COAP_MAX_RETRANSMIT > transacP->retrans_counter))
     	            {
         	            transacP->ack_received = false;
-            	        transacP->retrans_time += COAP_RESPONSE_TIMEOUT;
+            	        transacP->retrans_time += COAP_ACK_TIMEOUT_MS;
                 	    return true;
                 	}
 				}       
@@ -358,18 +515,15 @@ bool transaction_handle_response(lwm2m_context_t * contextP,
             // if we found our guy, exit
             if (found)
             {
-                time_t tv_sec = lwm2m_gettime();
-                if (0 <= tv_sec)
-                {
-                    transacP->retrans_time = tv_sec;
-                }
+                // wait for the separate response
+                transacP->retrans_time = lwm2m_gettime_ms();
                 if (transacP->response_timeout)
                 {
-                    transacP->retrans_time += transacP->response_timeout;
+                    transacP->retrans_time += transacP->response_timeout * 1000;
                 }
                 else
                 {
-                    transacP->retrans_time += COAP_RESPONSE_TIMEOUT * transacP->retrans_counter;
+                    transacP->retrans_time += COAP_ACK_TIMEOUT_MS * transacP->retrans_counter;
                 }
                 return true;
             }
@@ -402,62 +556,47 @@ int transaction_send(lwm2m_context_t * contextP,
 
     if (!transacP->ack_received)
     {
-        long unsigned timeout = COAP_RESPONSE_TIMEOUT;
+        uint32_t now = lwm2m_gettime_ms();
+        lwm2m_peer_cc_t * ccP = prv_get_cc(transacP);
+        bool confirmable = COAP_TYPE_CON == ((coap_packet_t *)(transacP->message))->type;
+        uint32_t rto = prv_get_rto(ccP, now);
 
         if (0 == transacP->retrans_counter)
         {
-            time_t tv_sec = lwm2m_gettime();
-            if (0 <= tv_sec)
-            {
-                transacP->retrans_time = tv_sec;
-                transacP->retrans_counter = 1;
-            }
-            else
+            if (confirmable && NULL != ccP)
             {
-                maxRetriesReached = true;
+                if (COAP_NSTART <= ccP->inFlight)
+                {
+                    // wait for an outstanding exchange with this peer to complete
+                    transacP->retrans_time = now;
+                    return 0;
+                }
+                ccP->inFlight++;
+                transacP->outstanding = true;
+                ccP->transmissions++;
             }
+            transacP->first_send_time = now;
+            transacP->retrans_timeout = rto + utils_random(contextP) % (rto * (COAP_ACK_RANDOM_FACTOR_PERCENT - 100) / 100 + 1);
         }
-        else
+        else if (COAP_MAX_RETRANSMIT >= transacP->retrans_counter)
         {
-            timeout = COAP_RESPONSE_TIMEOUT * transacP->retrans_counter;
+            transacP->retrans_timeout = prv_backoff(rto, transacP->retrans_timeout);
+            if (NULL != ccP) ccP->retransmissions++;
         }
 
         if (COAP_MAX_RETRANSMIT >= transacP->retrans_counter)
         {
-            void * targetSessionH = NULL;
-
-            switch (transacP->peerType)
-            {
-#ifdef LWM2M_BOOTSTRAP_SERVER_MODE
-            case ENDPOINT_UNKNOWN:
-                targetSessionH = transacP->peerP;
-                break;
-#endif
-#ifdef LWM2M_SERVER_MODE
-            case ENDPOINT_CLIENT:
-                targetSessionH = ((lwm2m_client_t *)transacP->peerP)->sessionH;
-                break;
-#endif
-#ifdef LWM2M_CLIENT_MODE
-            case ENDPOINT_SERVER:
-                if (NULL != transacP->peerP)
-                {
-                    targetSessionH = ((lwm2m_server_t *)transacP->peerP)->sessionH;
-                }
-                break;
-#endif
-            default:
-                return COAP_500_INTERNAL_SERVER_ERROR;
-            }
+            void * targetSessionH = prv_get_session(transacP);
 
             contextP->bufferSendCallback(targetSessionH,
                                          transacP->buffer, transacP->buffer_len, contextP->userData);
 
-            transacP->retrans_time += timeout;
+            transacP->retrans_time = now + transacP->retrans_timeout;
             ++transacP->retrans_counter;
         }
         else
         {
+            if (NULL != ccP) ccP->timeouts++;
             maxRetriesReached = true;
         }
     }
@@ -474,3 +613,39 @@ int transaction_send(lwm2m_context_t * contextP,
 
     return 0;
 }
+
+#ifdef LWM2M_CLIENT_MODE
+int lwm2m_get_server_transmission_stats(lwm2m_context_t * contextP,
+                                        uint16_t shortServerID,
+                                        lwm2m_peer_cc_t * statsP)
+{
+    lwm2m_server_t * targetP;
+
+    targetP = contextP->serverList;
+    while (targetP != NULL && targetP->shortID != shortServerID)
+    {
+        targetP = targetP->next;
+    }
+    if (targetP == NULL) return COAP_404_NOT_FOUND;
+
+    memcpy(statsP, &targetP->cc, sizeof(lwm2m_peer_cc_t));
+    if (0 == statsP->rto) statsP->rto = COAP_ACK_TIMEOUT_MS;
+    return COAP_NO_ERROR;
+}
+#endif
+
+#ifdef LWM2M_SERVER_MODE
+int lwm2m_get_client_transmission_stats(lwm2m_context_t * contextP,
+                                        uint16_t clientID,
+                                        lwm2m_peer_cc_t * statsP)
+{
+    lwm2m_client_t * clientP;
+
+    clientP = lifetime_get_client(contextP, clientID);
+    if (clientP == NULL) return COAP_404_NOT_FOUND;
+
+    memcpy(statsP, &clientP->cc, sizeof(lwm2m_peer_cc_t));
+    if (0 == statsP->rto) statsP->rto = COAP_ACK_TIMEOUT_MS;
+    return COAP_NO_ERROR;
+}
+#endif
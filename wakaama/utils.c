@@ -51,6 +51,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <float.h>
+#include <math.h>
 
 
 int lwm2m_PlainTextToInt64(uint8_t * buffer,
@@ -73,7 +74,7 @@ int lwm2m_PlainTextToInt64(uint8_t * buffer,
     {
         if ('0' <= buffer[i] && buffer[i] <= '9')
         {
-            if (result > (UINT64_MAX / 10)) return 0;
+            if (result > (UINT64_MAX - (buffer[i] - '0')) / 10) return 0;
             result *= 10;
             result += buffer[i] - '0';
         }
@@ -84,7 +85,8 @@ int lwm2m_PlainTextToInt64(uint8_t * buffer,
         i++;
     }
 
-    if (result > INT64_MAX) return 0;
+    // INT64_MIN has no positive counterpart
+    if (result > (uint64_t)INT64_MAX + (sign == -1 ? 1 : 0)) return 0;
 
     if (sign == -1)
     {
@@ -98,179 +100,636 @@ int lwm2m_PlainTextToInt64(uint8_t * buffer,
     return 1;
 }
 
+/*
+ * Numbers as text
+ *
+ * Floats are written with the shortest digits reading back as the same
+ * double. Values with up to PRV_FIXED_DECIMALS decimals, most sensor
+ * readings, are found with a few integer operations; the others go through
+ * Grisu2 (F. Loitsch, "Printing Floating-Point Numbers Quickly and
+ * Accurately with Integers", 2010) which is shortest for all but a few
+ * doubles and always reads back exactly.
+ *
+ * Floats are read exactly with a single multiplication or division when
+ * the mantissa and the power of ten are exact doubles, which covers any
+ * value written with up to 15 significant digits and reasonable exponents.
+ * Other values fall back to strtod().
+ */
+
+// doubles are exact integers up to 2^53
+#define PRV_MAX_EXACT_INT   ((uint64_t)1 << 53)
+#define PRV_FIXED_DECIMALS  4
+// "-" + 17 digits + "e-308", or the fixed notation of 1e21 - 1
+#define PRV_FLOAT_MAX_LEN   25
+// longest text given to strtod()
+#define PRV_PARSE_MAX_LEN   64
+
+// powers of ten exactly representable as doubles
+static const double prv_exact_pow10[] =
+{
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const uint64_t prv_int_pow10[] =
+{
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL,
+    1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+    1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+    1000000000000000000ULL, 10000000000000000000ULL
+};
+
+// "do it yourself" floating point: f * 2^e
+typedef struct
+{
+    uint64_t f;
+    int      e;
+} prv_diyfp_t;
+
+// 10^k for k = -348 to 340 by steps of 8, normalized and rounded to nearest
+static const struct
+{
+    uint64_t f;
+    int16_t  e;
+} prv_cached_pow10[] =
+{
+    { 0xFA8FD5A0081C0288ULL, -1220 }, // 1e-348
+    { 0xBAAEE17FA23EBF76ULL, -1193 }, // 1e-340
+    { 0x8B16FB203055AC76ULL, -1166 }, // 1e-332
+    { 0xCF42894A5DCE35EAULL, -1140 }, // 1e-324
+    { 0x9A6BB0AA55653B2DULL, -1113 }, // 1e-316
+    { 0xE61ACF033D1A45DFULL, -1087 }, // 1e-308
+    { 0xAB70FE17C79AC6CAULL, -1060 }, // 1e-300
+    { 0xFF77B1FCBEBCDC4FULL, -1034 }, // 1e-292
+    { 0xBE5691EF416BD60CULL, -1007 }, // 1e-284
+    { 0x8DD01FAD907FFC3CULL,  -980 }, // 1e-276
+    { 0xD3515C2831559A83ULL,  -954 }, // 1e-268
+    { 0x9D71AC8FADA6C9B5ULL,  -927 }, // 1e-260
+    { 0xEA9C227723EE8BCBULL,  -901 }, // 1e-252
+    { 0xAECC49914078536DULL,  -874 }, // 1e-244
+    { 0x823C12795DB6CE57ULL,  -847 }, // 1e-236
+    { 0xC21094364DFB5637ULL,  -821 }, // 1e-228
+    { 0x9096EA6F3848984FULL,  -794 }, // 1e-220
+    { 0xD77485CB25823AC7ULL,  -768 }, // 1e-212
+    { 0xA086CFCD97BF97F4ULL,  -741 }, // 1e-204
+    { 0xEF340A98172AACE5ULL,  -715 }, // 1e-196
+    { 0xB23867FB2A35B28EULL,  -688 }, // 1e-188
+    { 0x84C8D4DFD2C63F3BULL,  -661 }, // 1e-180
+    { 0xC5DD44271AD3CDBAULL,  -635 }, // 1e-172
+    { 0x936B9FCEBB25C996ULL,  -608 }, // 1e-164
+    { 0xDBAC6C247D62A584ULL,  -582 }, // 1e-156
+    { 0xA3AB66580D5FDAF6ULL,  -555 }, // 1e-148
+    { 0xF3E2F893DEC3F126ULL,  -529 }, // 1e-140
+    { 0xB5B5ADA8AAFF80B8ULL,  -502 }, // 1e-132
+    { 0x87625F056C7C4A8BULL,  -475 }, // 1e-124
+    { 0xC9BCFF6034C13053ULL,  -449 }, // 1e-116
+    { 0x964E858C91BA2655ULL,  -422 }, // 1e-108
+    { 0xDFF9772470297EBDULL,  -396 }, // 1e-100
+    { 0xA6DFBD9FB8E5B88FULL,  -369 }, // 1e-92
+    { 0xF8A95FCF88747D94ULL,  -343 }, // 1e-84
+    { 0xB94470938FA89BCFULL,  -316 }, // 1e-76
+    { 0x8A08F0F8BF0F156BULL,  -289 }, // 1e-68
+    { 0xCDB02555653131B6ULL,  -263 }, // 1e-60
+    { 0x993FE2C6D07B7FACULL,  -236 }, // 1e-52
+    { 0xE45C10C42A2B3B06ULL,  -210 }, // 1e-44
+    { 0xAA242499697392D3ULL,  -183 }, // 1e-36
+    { 0xFD87B5F28300CA0EULL,  -157 }, // 1e-28
+    { 0xBCE5086492111AEBULL,  -130 }, // 1e-20
+    { 0x8CBCCC096F5088CCULL,  -103 }, // 1e-12
+    { 0xD1B71758E219652CULL,   -77 }, // 1e-4
+    { 0x9C40000000000000ULL,   -50 }, // 1e4
+    { 0xE8D4A51000000000ULL,   -24 }, // 1e12
+    { 0xAD78EBC5AC620000ULL,     3 }, // 1e20
+    { 0x813F3978F8940984ULL,    30 }, // 1e28
+    { 0xC097CE7BC90715B3ULL,    56 }, // 1e36
+    { 0x8F7E32CE7BEA5C70ULL,    83 }, // 1e44
+    { 0xD5D238A4ABE98068ULL,   109 }, // 1e52
+    { 0x9F4F2726179A2245ULL,   136 }, // 1e60
+    { 0xED63A231D4C4FB27ULL,   162 }, // 1e68
+    { 0xB0DE65388CC8ADA8ULL,   189 }, // 1e76
+    { 0x83C7088E1AAB65DBULL,   216 }, // 1e84
+    { 0xC45D1DF942711D9AULL,   242 }, // 1e92
+    { 0x924D692CA61BE758ULL,   269 }, // 1e100
+    { 0xDA01EE641A708DEAULL,   295 }, // 1e108
+    { 0xA26DA3999AEF774AULL,   322 }, // 1e116
+    { 0xF209787BB47D6B85ULL,   348 }, // 1e124
+    { 0xB454E4A179DD1877ULL,   375 }, // 1e132
+    { 0x865B86925B9BC5C2ULL,   402 }, // 1e140
+    { 0xC83553C5C8965D3DULL,   428 }, // 1e148
+    { 0x952AB45CFA97A0B3ULL,   455 }, // 1e156
+    { 0xDE469FBD99A05FE3ULL,   481 }, // 1e164
+    { 0xA59BC234DB398C25ULL,   508 }, // 1e172
+    { 0xF6C69A72A3989F5CULL,   534 }, // 1e180
+    { 0xB7DCBF5354E9BECEULL,   561 }, // 1e188
+    { 0x88FCF317F22241E2ULL,   588 }, // 1e196
+    { 0xCC20CE9BD35C78A5ULL,   614 }, // 1e204
+    { 0x98165AF37B2153DFULL,   641 }, // 1e212
+    { 0xE2A0B5DC971F303AULL,   667 }, // 1e220
+    { 0xA8D9D1535CE3B396ULL,   694 }, // 1e228
+    { 0xFB9B7CD9A4A7443CULL,   720 }, // 1e236
+    { 0xBB764C4CA7A44410ULL,   747 }, // 1e244
+    { 0x8BAB8EEFB6409C1AULL,   774 }, // 1e252
+    { 0xD01FEF10A657842CULL,   800 }, // 1e260
+    { 0x9B10A4E5E9913129ULL,   827 }, // 1e268
+    { 0xE7109BFBA19C0C9DULL,   853 }, // 1e276
+    { 0xAC2820D9623BF429ULL,   880 }, // 1e284
+    { 0x80444B5E7AA7CF85ULL,   907 }, // 1e292
+    { 0xBF21E44003ACDD2DULL,   933 }, // 1e300
+    { 0x8E679C2F5E44FF8FULL,   960 }, // 1e308
+    { 0xD433179D9C8CB841ULL,   986 }, // 1e316
+    { 0x9E19DB92B4E31BA9ULL,  1013 }, // 1e324
+    { 0xEB96BF6EBADF77D9ULL,  1039 }, // 1e332
+    { 0xAF87023B9BF0EE6BULL,  1066 }  // 1e340
+};
+
 int lwm2m_PlainTextToFloat64(uint8_t * buffer,
                              int length,
                              double * dataP)
 {
+    uint64_t mantissa;
+    int digits;
+    int exponent;
+    bool exact;
+    bool hasDigits;
+    bool minus;
     double result;
-    int sign;
     int i;
 
     if (0 == length) return 0;
 
+    i = 0;
+    minus = false;
     if (buffer[0] == '-')
     {
-        sign = -1;
+        minus = true;
         i = 1;
     }
-    else
-    {
-        sign = 1;
-        i = 0;
-    }
 
-    result = 0;
-    while (i < length && buffer[i] != '.')
+    // keep the first 19 significant digits in mantissa, value is
+    // mantissa * 10^exponent
+    mantissa = 0;
+    digits = 0;
+    exponent = 0;
+    exact = true;
+    hasDigits = false;
+    while (i < length && buffer[i] >= '0' && buffer[i] <= '9')
     {
-        if ('0' <= buffer[i] && buffer[i] <= '9')
+        hasDigits = true;
+        if (digits < 19)
         {
-            if (result > (DBL_MAX / 10)) return 0;
-            result *= 10;
-            result += (buffer[i] - '0');
+            mantissa = mantissa * 10 + (buffer[i] - '0');
+            if (mantissa != 0) digits++;
         }
         else
         {
-            return 0;
+            exponent++;
+            if (buffer[i] != '0') exact = false;
         }
         i++;
     }
-    if (buffer[i] == '.')
+    if (i < length && buffer[i] == '.')
     {
-        double dec;
-
         i++;
         if (i == length) return 0;
-
-        dec = 0.1;
-        while (i < length)
+        while (i < length && buffer[i] >= '0' && buffer[i] <= '9')
         {
-            if ('0' <= buffer[i] && buffer[i] <= '9')
+            hasDigits = true;
+            if (digits < 19)
             {
-                if (result > (DBL_MAX - 1)) return 0;
-                result += (buffer[i] - '0') * dec;
-                dec /= 10;
+                mantissa = mantissa * 10 + (buffer[i] - '0');
+                if (mantissa != 0) digits++;
+                exponent--;
             }
-            else
+            else if (buffer[i] != '0')
             {
-                return 0;
+                exact = false;
             }
             i++;
         }
     }
+    if (!hasDigits) return 0;
+    if (i < length && (buffer[i] == 'e' || buffer[i] == 'E'))
+    {
+        bool negative = false;
+        int value = 0;
 
-    *dataP = result * sign;
+        i++;
+        if (i < length && (buffer[i] == '-' || buffer[i] == '+'))
+        {
+            negative = buffer[i] == '-';
+            i++;
+        }
+        if (i == length) return 0;
+        while (i < length && buffer[i] >= '0' && buffer[i] <= '9')
+        {
+            if (value < 10000) value = value * 10 + (buffer[i] - '0');
+            i++;
+        }
+        exponent += negative ? -value : value;
+    }
+    if (i != length) return 0;
+
+    if (mantissa == 0)
+    {
+        result = minus ? -0.0 : 0.0;
+    }
+    else if (exact && mantissa <= PRV_MAX_EXACT_INT && exponent >= -22 && exponent <= 22)
+    {
+        // both operands are exact, the result is correctly rounded
+        if (exponent < 0)
+        {
+            result = (double)mantissa / prv_exact_pow10[-exponent];
+        }
+        else
+        {
+            result = (double)mantissa * prv_exact_pow10[exponent];
+        }
+        if (minus) result = -result;
+    }
+    else
+    {
+        char string[PRV_PARSE_MAX_LEN + 1];
+
+        if (length > PRV_PARSE_MAX_LEN) return 0;
+        memcpy(string, buffer, length);
+        string[length] = 0;
+        result = strtod(string, NULL);
+        if (result > DBL_MAX || result < -DBL_MAX) return 0;
+    }
+
+    *dataP = result;
     return 1;
 }
 
-static size_t prv_intToText(int64_t data,
-                            uint8_t * string,
-                            size_t length)
+size_t utils_intToText(int64_t data,
+                       uint8_t * string,
+                       size_t length)
 {
-    int index;
-    bool minus;
+    uint8_t digits[20];
+    uint64_t magnitude;
+    uint32_t low;
+    size_t index;
+    size_t signLength;
 
     if (data < 0)
     {
-        minus = true;
-        data = 0 - data;
+        magnitude = 0 - (uint64_t)data;
+        signLength = 1;
     }
     else
     {
-        minus = false;
+        magnitude = (uint64_t)data;
+        signLength = 0;
     }
 
-    index = length - 1;
+    index = sizeof(digits);
+    // 64-bit divisions are library calls on 32-bit targets, finish with 32-bit ones
+    while (magnitude > 0xFFFFFFFF)
+    {
+        digits[--index] = '0' + (uint8_t)(magnitude % 10);
+        magnitude /= 10;
+    }
+    low = (uint32_t)magnitude;
     do
     {
-        string[index] = '0' + data%10;
-        data /= 10;
-        index --;
-    } while (index >= 0 && data > 0);
+        digits[--index] = '0' + (uint8_t)(low % 10);
+        low /= 10;
+    } while (low != 0);
 
-    if (data > 0) return 0;
+    if (signLength + sizeof(digits) - index > length) return 0;
 
-    if (minus == true)
+    if (signLength != 0)
     {
-        if (index == 0) return 0;
-        string[index] = '-';
+        string[0] = '-';
     }
-    else
+    memcpy(string + signLength, digits + index, sizeof(digits) - index);
+
+    return signLength + sizeof(digits) - index;
+}
+
+static void prv_normalize(prv_diyfp_t * valueP)
+{
+    if ((valueP->f >> 32) == 0) { valueP->f <<= 32; valueP->e -= 32; }
+    if ((valueP->f >> 48) == 0) { valueP->f <<= 16; valueP->e -= 16; }
+    if ((valueP->f >> 56) == 0) { valueP->f <<= 8;  valueP->e -= 8; }
+    if ((valueP->f >> 60) == 0) { valueP->f <<= 4;  valueP->e -= 4; }
+    if ((valueP->f >> 62) == 0) { valueP->f <<= 2;  valueP->e -= 2; }
+    if ((valueP->f >> 63) == 0) { valueP->f <<= 1;  valueP->e -= 1; }
+}
+
+// upper 64 bits of the product, rounded
+static prv_diyfp_t prv_multiply(prv_diyfp_t x,
+                                prv_diyfp_t y)
+{
+    prv_diyfp_t result;
+    uint64_t a, b, c, d;
+    uint64_t ac, bc, ad, bd;
+    uint64_t middle;
+
+    a = x.f >> 32;
+    b = x.f & 0xFFFFFFFF;
+    c = y.f >> 32;
+    d = y.f & 0xFFFFFFFF;
+    ac = a * c;
+    bc = b * c;
+    ad = a * d;
+    bd = b * d;
+    middle = (bd >> 32) + (ad & 0xFFFFFFFF) + (bc & 0xFFFFFFFF) + (1U << 31);
+
+    result.f = ac + (ad >> 32) + (bc >> 32) + (middle >> 32);
+    result.e = x.e + y.e + 64;
+    return result;
+}
+
+// move the last digit towards the exact value while staying in the rounding interval
+static void prv_grisu_round(char * buffer,
+                            int length,
+                            uint64_t delta,
+                            uint64_t rest,
+                            uint64_t tenKappa,
+                            uint64_t distance)
+{
+    while (rest < distance
+        && delta - rest >= tenKappa
+        && (rest + tenKappa < distance || distance - rest > rest + tenKappa - distance))
     {
-        index++;
+        buffer[length - 1]--;
+        rest += tenKappa;
     }
-
-    return length - index;
 }
 
-size_t lwm2m_int64ToPlainText(int64_t data,
-                              uint8_t ** bufferP)
+// write the shortest digits within delta below high, closest to value,
+// return their number and add their decimal exponent to *kP
+static int prv_grisu_digits(prv_diyfp_t value,
+                            prv_diyfp_t high,
+                            uint64_t delta,
+                            char * buffer,
+                            int * kP)
 {
-#define _PRV_STR_LENGTH 32
-    uint8_t string[_PRV_STR_LENGTH];
-    size_t length;
+    int shift = -high.e;
+    uint64_t one = (uint64_t)1 << shift;
+    uint64_t distance = high.f - value.f;
+    uint32_t integral = (uint32_t)(high.f >> shift);
+    uint64_t fractional = high.f & (one - 1);
+    int kappa;
+    int length;
+
+    kappa = 1;
+    while (kappa < 10 && integral >= prv_int_pow10[kappa]) kappa++;
+
+    length = 0;
+    while (kappa > 0)
+    {
+        uint32_t digit;
+        uint64_t rest;
 
-    length = prv_intToText(data, string, _PRV_STR_LENGTH);
-    if (length == 0) return 0;
+        digit = integral / (uint32_t)prv_int_pow10[kappa - 1];
+        integral %= (uint32_t)prv_int_pow10[kappa - 1];
+        if (digit != 0 || length != 0)
+        {
+            buffer[length++] = '0' + (char)digit;
+        }
+        kappa--;
+        rest = ((uint64_t)integral << shift) + fractional;
+        if (rest <= delta)
+        {
+            *kP += kappa;
+            prv_grisu_round(buffer, length, delta, rest, prv_int_pow10[kappa] << shift, distance);
+            return length;
+        }
+    }
 
-    *bufferP = (uint8_t *)lwm2m_malloc(length);
-    if (NULL == *bufferP) return 0;
+    while (true)
+    {
+        char digit;
+
+        fractional *= 10;
+        delta *= 10;
+        digit = (char)(fractional >> shift);
+        if (digit != 0 || length != 0)
+        {
+            buffer[length++] = '0' + digit;
+        }
+        fractional &= one - 1;
+        kappa--;
+        if (fractional < delta)
+        {
+            *kP += kappa;
+            prv_grisu_round(buffer, length, delta, fractional, one, -kappa < 20 ? distance * prv_int_pow10[-kappa] : 0);
+            return length;
+        }
+    }
+}
 
-    memcpy(*bufferP, string + _PRV_STR_LENGTH - length, length);
+// positive finite values only, value is buffer * 10^(*kP)
+static int prv_grisu2(double data,
+                      char * buffer,
+                      int * kP)
+{
+    uint64_t bits;
+    uint64_t fraction;
+    int biasedExponent;
+    prv_diyfp_t value;
+    prv_diyfp_t high;
+    prv_diyfp_t low;
+    prv_diyfp_t power;
+    double dk;
+    int k;
+    int index;
 
-    return length;
+    memcpy(&bits, &data, sizeof(bits));
+    fraction = bits & 0x000FFFFFFFFFFFFFULL;
+    biasedExponent = (int)((bits >> 52) & 0x7FF);
+    if (biasedExponent != 0)
+    {
+        value.f = fraction | 0x0010000000000000ULL;
+        value.e = biasedExponent - 1075;
+    }
+    else
+    {
+        value.f = fraction;
+        value.e = -1074;
+    }
+
+    // boundaries of the rounding interval, the lower one is closer at powers of two
+    high.f = (value.f << 1) + 1;
+    high.e = value.e - 1;
+    prv_normalize(&high);
+    if (fraction == 0 && biasedExponent > 1)
+    {
+        low.f = (value.f << 2) - 1;
+        low.e = value.e - 2;
+    }
+    else
+    {
+        low.f = (value.f << 1) - 1;
+        low.e = value.e - 1;
+    }
+    low.f <<= low.e - high.e;
+    low.e = high.e;
+    prv_normalize(&value);
+
+    // cached power bringing the exponent of the products in [-60, -32]
+    dk = (-61 - high.e) * 0.30102999566398114 + 347;
+    k = (int)dk;
+    if (dk - k > 0.0) k++;
+    index = (k >> 3) + 1;
+    *kP = -(-348 + index * 8);
+    power.f = prv_cached_pow10[index].f;
+    power.e = prv_cached_pow10[index].e;
+
+    value = prv_multiply(value, power);
+    high = prv_multiply(high, power);
+    low = prv_multiply(low, power);
+    // stay inside the interval despite the rounding of the products
+    low.f++;
+    high.f--;
+
+    return prv_grisu_digits(value, high, high.f - low.f, buffer, kP);
 }
 
+// values with a few decimals, return 0 if the fixed notation does not read back exactly
+static int prv_fixed_digits(double data,
+                            char * buffer,
+                            int * kP)
+{
+    int decimals;
 
-size_t lwm2m_float64ToPlainText(double data,
-                                uint8_t ** bufferP)
+    if (data >= (double)PRV_MAX_EXACT_INT / prv_exact_pow10[PRV_FIXED_DECIMALS]) return 0;
+
+    for (decimals = 0 ; decimals <= PRV_FIXED_DECIMALS ; decimals++)
+    {
+        uint64_t scaled;
+
+        scaled = (uint64_t)(data * prv_exact_pow10[decimals] + 0.5);
+        if (scaled != 0 && (double)scaled / prv_exact_pow10[decimals] == data)
+        {
+            *kP = -decimals;
+            return (int)utils_intToText((int64_t)scaled, (uint8_t *)buffer, 17);
+        }
+    }
+    return 0;
+}
+
+size_t utils_floatToText(double data,
+                         uint8_t * string,
+                         size_t length)
 {
-#define _PRV_PRECISION 16
-    uint8_t intString[_PRV_STR_LENGTH];
-    size_t intLength;
-    uint8_t decString[_PRV_STR_LENGTH];
-    size_t decLength;
-    int64_t intPart;
-    double decPart;
+    char digits[18];
+    char text[PRV_FLOAT_MAX_LEN];
+    int digitsLength;
+    int k;
+    int point;
+    int index;
     int i;
 
-    intPart = (int64_t)data;
-    decPart = data - intPart;
-    if (decPart < 0)
+    // NaN and infinities have no representation
+    if (!(data >= -DBL_MAX && data <= DBL_MAX)) return 0;
+
+    if (data == 0)
     {
-        decPart = 1 - decPart;
+        // -0.0 keeps its sign
+        index = signbit(data) ? 1 : 0;
+        if (length < (size_t)index + 1) return 0;
+        if (index != 0) string[0] = '-';
+        string[index] = '0';
+        return index + 1;
     }
-    else
+
+    index = 0;
+    if (data < 0)
     {
-        decPart = 1 + decPart;
+        text[index++] = '-';
+        data = -data;
     }
 
-    if (decPart <= 1 + FLT_EPSILON)
+    digitsLength = prv_fixed_digits(data, digits, &k);
+    if (digitsLength == 0)
     {
-        return lwm2m_int64ToPlainText(intPart, bufferP);
+        digitsLength = prv_grisu2(data, digits, &k);
     }
 
-    intLength = prv_intToText(intPart, intString, _PRV_STR_LENGTH);
-    if (intLength == 0) return 0;
-
-    i = 0;
-    do
+    // position of the decimal point relative to the digits
+    point = digitsLength + k;
+    if (k >= 0 && point <= 21)
     {
-        decPart *= 10;
-        i++;
-    } while ((decPart - (int64_t)decPart > 0)
-          && (i < _PRV_PRECISION));
+        // integral: 1200
+        memcpy(text + index, digits, digitsLength);
+        index += digitsLength;
+        for (i = 0 ; i < k ; i++) text[index++] = '0';
+    }
+    else if (point > 0 && point <= 21)
+    {
+        // 23.5
+        memcpy(text + index, digits, point);
+        index += point;
+        text[index++] = '.';
+        memcpy(text + index, digits + point, digitsLength - point);
+        index += digitsLength - point;
+    }
+    else if (point > -6 && point <= 0)
+    {
+        // 0.00125
+        text[index++] = '0';
+        text[index++] = '.';
+        for (i = point ; i < 0 ; i++) text[index++] = '0';
+        memcpy(text + index, digits, digitsLength);
+        index += digitsLength;
+    }
+    else
+    {
+        // 1.25e-7
+        text[index++] = digits[0];
+        if (digitsLength > 1)
+        {
+            text[index++] = '.';
+            memcpy(text + index, digits + 1, digitsLength - 1);
+            index += digitsLength - 1;
+        }
+        text[index++] = 'e';
+        index += utils_intToText(point - 1, (uint8_t *)text + index, sizeof(text) - index);
+    }
+
+    if ((size_t)index > length) return 0;
+    memcpy(string, text, index);
+
+    return index;
+}
+
+size_t lwm2m_int64ToPlainText(int64_t data,
+                              uint8_t ** bufferP)
+{
+    uint8_t string[20 + 1];
+    size_t length;
+
+    length = utils_intToText(data, string, sizeof(string));
+    if (length == 0) return 0;
+
+    *bufferP = (uint8_t *)lwm2m_malloc(length);
+    if (NULL == *bufferP) return 0;
+
+    memcpy(*bufferP, string, length);
+
+    return length;
+}
 
-    decLength = prv_intToText(decPart, decString, _PRV_STR_LENGTH);
-    if (decLength <= 1) return 0;
 
-    *bufferP = (uint8_t *)lwm2m_malloc(intLength + 1 + decLength);
+size_t lwm2m_float64ToPlainText(double data,
+                                uint8_t ** bufferP)
+{
+    uint8_t string[PRV_FLOAT_MAX_LEN];
+    size_t length;
+
+    length = utils_floatToText(data, string, sizeof(string));
+    if (length == 0) return 0;
+
+    *bufferP = (uint8_t *)lwm2m_malloc(length);
     if (NULL == *bufferP) return 0;
 
-    memcpy(*bufferP, intString + _PRV_STR_LENGTH - intLength, intLength);
-    (*bufferP)[intLength] = '.';
-    memcpy(*bufferP + intLength + 1, decString + _PRV_STR_LENGTH - decLength + 1, decLength - 1);
+    memcpy(*bufferP, string, length);
 
-    return intLength + decLength;   // +1 for dot, -1 for extra "1" in decPart
+    return length;
 }
 
 
@@ -337,6 +796,51 @@ lwm2m_binding_t lwm2m_stringToBinding(uint8_t * buffer,
     return BINDING_UNKNOWN;
 }
 
+// FNV-1a
+uint32_t utils_hash(const uint8_t * data,
+                    size_t length)
+{
+    uint32_t hash;
+    size_t i;
+
+    hash = 2166136261u;
+    for (i = 0 ; i < length ; i++)
+    {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+// seed from the clocks and the address of the context, which differs between
+// the contexts of a process
+void utils_initRandom(lwm2m_context_t * contextP)
+{
+    uint32_t seed[4];
+    uintptr_t address = (uintptr_t)contextP;
+    uint32_t hash;
+
+    seed[0] = (uint32_t)time(NULL);
+    seed[1] = lwm2m_gettime_ms();
+    seed[2] = (uint32_t)address;
+    seed[3] = (uint32_t)((uint64_t)address >> 32);
+    hash = utils_hash((uint8_t *)seed, sizeof(seed));
+    contextP->randomState = (hash != 0) ? hash : 1;
+}
+
+// xorshift32
+uint32_t utils_random(lwm2m_context_t * contextP)
+{
+    uint32_t x = contextP->randomState;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    contextP->randomState = x;
+
+    return x;
+}
+
 #ifdef LWM2M_CLIENT_MODE
 lwm2m_server_t * prv_findServer(lwm2m_context_t * contextP,
                                 void * fromSessionH)
@@ -352,6 +856,41 @@ lwm2m_server_t * prv_findServer(lwm2m_context_t * contextP,
 
     return targetP;
 }
+
+// mix in the endpoint name: clients restarted in the same second by a power
+// outage must not draw the same retry delays
+void utils_seedRandom(lwm2m_context_t * contextP)
+{
+    uint32_t hash;
+
+    hash = utils_hash((uint8_t *)contextP->endpointName, strlen(contextP->endpointName));
+    hash ^= contextP->randomState;
+    contextP->randomState = (hash != 0) ? hash : 1;
+}
+
+// exponential backoff with full jitter: a delay drawn in [1, min(max, base * 2^attempt)]
+time_t utils_retryDelay(lwm2m_context_t * contextP,
+                        uint8_t * attemptP)
+{
+    uint32_t window;
+    uint8_t i;
+
+    window = LWM2M_RETRY_BASE_DELAY;
+    for (i = 0 ; i < *attemptP && window < LWM2M_RETRY_MAX_DELAY ; i++)
+    {
+        window <<= 1;
+    }
+    if (window > LWM2M_RETRY_MAX_DELAY)
+    {
+        window = LWM2M_RETRY_MAX_DELAY;
+    }
+    else if (*attemptP < 0xFF)
+    {
+        (*attemptP)++;
+    }
+
+    return 1 + utils_random(contextP) % window;
+}
 #endif
 
 lwm2m_server_t * utils_findBootstrapServer(lwm2m_context_t * contextP,
@@ -406,6 +945,63 @@ int prv_isAltPathValid(const char * altPath)
     return 1;
 }
 
+static bool prv_isFormatSupported(lwm2m_uri_t * uriP,
+                                  unsigned int format)
+{
+    switch (format)
+    {
+    case LWM2M_CONTENT_TEXT:
+        return LWM2M_URI_IS_SET_RESOURCE(uriP);
+    case LWM2M_CONTENT_TLV:
+    case LWM2M_CONTENT_SENML_CBOR:
+    case LWM2M_CONTENT_JSON:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// pick the first supported format of the Accept option, plain text for a
+// single resource and TLV otherwise when there is none
+bool utils_getAcceptFormat(coap_packet_t * message,
+                           lwm2m_uri_t * uriP,
+                           lwm2m_media_type_t * formatP)
+{
+    const uint16_t * accept;
+    int count;
+    int i;
+
+    count = coap_get_header_accept(message, &accept);
+    if (count == 0)
+    {
+        *formatP = LWM2M_URI_IS_SET_RESOURCE(uriP) ? LWM2M_CONTENT_TEXT : LWM2M_CONTENT_TLV;
+        return true;
+    }
+    for (i = 0 ; i < count ; i++)
+    {
+        if (prv_isFormatSupported(uriP, accept[i]))
+        {
+            *formatP = (lwm2m_media_type_t)accept[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool utils_getContentFormat(coap_packet_t * message,
+                            lwm2m_uri_t * uriP,
+                            lwm2m_media_type_t * formatP)
+{
+    if (!IS_OPTION(message, COAP_OPTION_CONTENT_TYPE))
+    {
+        *formatP = LWM2M_URI_IS_SET_RESOURCE(uriP) ? LWM2M_CONTENT_TEXT : LWM2M_CONTENT_TLV;
+        return true;
+    }
+    if (!prv_isFormatSupported(uriP, message->content_type)) return false;
+    *formatP = (lwm2m_media_type_t)message->content_type;
+    return true;
+}
+
 #ifndef LWM2M_EMBEDDED_MODE
 #include <mbed/rtc_api.h>
 time_t lwm2m_gettime(void)
@@ -413,4 +1009,32 @@ time_t lwm2m_gettime(void)
 
     return rtc_read();
 }
+
+#include <mbed/us_ticker_api.h>
+#include "cmsis.h"
+// extends the 32 bits microsecond ticker, which wraps around every 71 minutes:
+// this must be called more often than that, lwm2m_step() does.
+// The extension is shared by all the contexts, which may be stepped from different threads.
+uint32_t lwm2m_gettime_ms(void)
+{
+    static uint32_t lastTick = 0;
+    static uint32_t remainder = 0;
+    static uint32_t ms = 0;
+    uint32_t primask;
+    uint32_t tick;
+    uint32_t elapsed;
+    uint32_t result;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    tick = us_ticker_read();
+    elapsed = tick - lastTick + remainder;
+    lastTick = tick;
+    ms += elapsed / 1000;
+    remainder = elapsed % 1000;
+    result = ms;
+    __set_PRIMASK(primask);
+
+    return result;
+}
 #endif